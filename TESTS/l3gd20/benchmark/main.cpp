@@ -0,0 +1,426 @@
+/**
+ * Driver benchmark.
+ *
+ * It runs public driver calls and prints a CSV row per call with averaged bus and CPU costs:
+ *
+ * bench,platform,cache,operation,calls,transactions_per_call,bytes_per_call,samples_per_call,ns_per_call,ns_per_sample,cycles_per_call
+ *
+ * Rows have "bench," prefix, so they can be extracted from the test output with `grep '^bench,'`.
+ *
+ * Bus transactions and bytes on the wire (SPI command byte and data bytes) are counted with
+ * a counting SPI transport. CPU time is measured with a separate driver without counting:
+ *
+ * - on target it uses the SPI bus directly and the DWT cycle counter, so times include SPI transfers;
+ * - on host it uses the simulated device as register transport and std::chrono::steady_clock,
+ *   so times show driver overhead mostly. The cycles column is empty.
+ *
+ * The test fails if a call exceeds its bus transaction budget.
+ */
+#include "greentea-client/test_env.h"
+#include "l3gd20_driver.h"
+#include "l3gd20_integrator.h"
+#include "mbed.h"
+#include "rtos.h"
+#include "unity.h"
+#include "utest.h"
+#if defined(MBED_HOST)
+#include "l3gd20_sim.h"
+#endif
+
+using namespace utest::v1;
+using namespace l3gd20;
+
+/*
+ * CPU time measurement
+ */
+
+#if defined(MBED_HOST)
+#define BENCHMARK_PLATFORM "host"
+
+static void cpu_timer_init()
+{
+}
+
+static uint64_t cpu_timer_read()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double cpu_ticks_to_ns(double ticks)
+{
+    return ticks;
+}
+#elif defined(DWT) && defined(CoreDebug)
+#define BENCHMARK_PLATFORM "target"
+#define BENCHMARK_CYCLES 1
+
+static void cpu_timer_init()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static uint32_t cpu_timer_read()
+{
+    return DWT->CYCCNT;
+}
+
+static double cpu_ticks_to_ns(double ticks)
+{
+    return ticks * 1e9 / SystemCoreClock;
+}
+#else
+#error "Benchmark requires DWT cycle counter"
+#endif
+
+// note: unsigned subtraction handles DWT counter wraparound
+#define CPU_TICKS_ELAPSED(start) ((uint64_t)(cpu_timer_read() - (start)))
+
+/**
+ * SPI register transport that counts bus transactions and bytes on the wire.
+ */
+class CountingSpiTransport : public RegisterTransport {
+public:
+    CountingSpiTransport(PinName mosi, PinName miso, PinName sclk, PinName ssel)
+        : _bus(mosi, miso, sclk, ssel)
+        , _transactions(0)
+        , _bytes(0)
+    {
+    }
+
+    virtual void read_registers(uint8_t reg, uint8_t *data, uint8_t length)
+    {
+        _count(length);
+        _bus.read_registers(reg, data, length);
+    }
+
+    virtual void write_registers(uint8_t reg, const uint8_t *data, uint8_t length)
+    {
+        _count(length);
+        _bus.write_registers(reg, data, length);
+    }
+
+    virtual int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback)
+    {
+        _count(length);
+        return _bus.read_registers_async(reg, data, length, callback);
+    }
+
+    uint32_t get_transactions()
+    {
+        return _transactions;
+    }
+
+    uint32_t get_bytes()
+    {
+        return _bytes;
+    }
+
+private:
+    SpiBus _bus;
+    uint32_t _transactions;
+    uint32_t _bytes;
+
+    void _count(uint8_t length)
+    {
+        _transactions++;
+        // command byte and data
+        _bytes += 1 + length;
+    }
+};
+
+/*
+ * Benchmarked calls
+ */
+
+struct BenchmarkCall {
+    const char *name;
+    // run call and return number of produced samples
+    int (*run)(L3GD20Gyroscope *gyro, int i);
+    // untimed preparation before each call or NULL
+    void (*prepare)(L3GD20Gyroscope *gyro);
+    int n_calls;
+    // bus transaction budgets per call without and with register cache
+    int max_transactions;
+    int max_transactions_cached;
+};
+
+static int16_t fifo_samples[L3GD20Gyroscope::FIFO_SIZE][3];
+static int16_t fifo_view_buffer[L3GD20Gyroscope::FIFO_VIEW_BUFFER_SIZE / 2];
+static float fifo_data[L3GD20Gyroscope::FIFO_SIZE][3];
+static float fifo_data_x[L3GD20Gyroscope::FIFO_SIZE];
+static float fifo_data_y[L3GD20Gyroscope::FIFO_SIZE];
+static float fifo_data_z[L3GD20Gyroscope::FIFO_SIZE];
+static int32_t fifo_data_q16[L3GD20Gyroscope::FIFO_SIZE][3];
+
+// rates of a fast rotation for integration
+static const float INTEGRATION_ODR = 760.0f;
+static float integration_rates[L3GD20Gyroscope::FIFO_SIZE][3];
+static int32_t integration_rates_q16[L3GD20Gyroscope::FIFO_SIZE][3];
+static int16_t integration_samples[L3GD20Gyroscope::FIFO_SIZE][3];
+static const float INTEGRATION_SENSITIVITY = 0.00875f * 3.14159265f / 180.0f;
+static OrientationIntegrator float_integrator(INTEGRATION_ODR);
+static OrientationIntegrator coning_integrator(INTEGRATION_ODR);
+static FixedOrientationIntegrator fixed_integrator(INTEGRATION_ODR);
+static float per_sample_q[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+
+static void init_integration_rates()
+{
+    for (int i = 0; i < L3GD20Gyroscope::FIFO_SIZE; i++) {
+        integration_rates[i][0] = 10.0f * sinf(0.1f * i);
+        integration_rates[i][1] = 5.0f * cosf(0.1f * i);
+        integration_rates[i][2] = 1.0f;
+        for (int j = 0; j < 3; j++) {
+            integration_rates_q16[i][j] = (int32_t)(integration_rates[i][j] * 65536.0f);
+            integration_samples[i][j] = (int16_t)(integration_rates[i][j] / INTEGRATION_SENSITIVITY);
+        }
+    }
+    coning_integrator.set_coning_mode(OrientationIntegrator::CONING_4_SAMPLE);
+}
+
+/**
+ * Per sample integration with rotation axis/angle, quaternion product and normalization
+ * (former kernel of the example 4), as a baseline for OrientationIntegrator.
+ */
+static void integrate_per_sample(float q[4], const float (*rates)[3], int n, float dt)
+{
+    for (int i = 0; i < n; i++) {
+        const float *w = rates[i];
+        float norm = sqrtf(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+        float half_angle = norm * dt / 2;
+        float k = sinf(half_angle) / norm;
+        float dq[4] = { cosf(half_angle), w[0] * k, w[1] * k, w[2] * k };
+        float qw = q[0] * dq[0] - q[1] * dq[1] - q[2] * dq[2] - q[3] * dq[3];
+        float qx = q[0] * dq[1] + q[1] * dq[0] + q[2] * dq[3] - q[3] * dq[2];
+        float qy = q[0] * dq[2] - q[1] * dq[3] + q[2] * dq[0] + q[3] * dq[1];
+        float qz = q[0] * dq[3] + q[1] * dq[2] - q[2] * dq[1] + q[3] * dq[0];
+        float norm_k = 1.0f / sqrtf(qw * qw + qx * qx + qy * qy + qz * qz);
+        q[0] = qw * norm_k;
+        q[1] = qx * norm_k;
+        q[2] = qy * norm_k;
+        q[3] = qz * norm_k;
+    }
+}
+
+static void prepare_full_fifo(L3GD20Gyroscope *gyro)
+{
+    gyro->set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    // FIFO is filled in 42 ms at 760 Hz
+    ThisThread::sleep_for(50ms);
+}
+
+static void prepare_fifo_enabled(L3GD20Gyroscope *gyro)
+{
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+}
+
+static const int N_CALLS = 100;
+static const int N_FIFO_CALLS = 10;
+
+static const BenchmarkCall benchmark_calls[] = {
+    // initialization and raw register access
+    { "init", [](L3GD20Gyroscope *gyro, int i) { gyro->init(); return 0; }, NULL, N_CALLS, 3, 5 },
+    { "resync", [](L3GD20Gyroscope *gyro, int i) { gyro->resync(); return 0; }, NULL, N_CALLS, 1, 4 },
+    { "read_register", [](L3GD20Gyroscope *gyro, int i) { gyro->read_register(L3GD20Gyroscope::CTRL_REG1_ADDR); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "write_register", [](L3GD20Gyroscope *gyro, int i) { gyro->write_register(L3GD20Gyroscope::REFERENCE_REG_ADDR, i); return 0; }, NULL, N_CALLS, 1, 1 },
+    // data reading
+    { "read_data", [](L3GD20Gyroscope *gyro, int i) { float data[3]; gyro->read_data(data); return 1; }, NULL, N_CALLS, 1, 1 },
+    { "read_data_dps", [](L3GD20Gyroscope *gyro, int i) { float data[3]; gyro->read_data_dps(data); return 1; }, NULL, N_CALLS, 1, 1 },
+    { "read_data_q16", [](L3GD20Gyroscope *gyro, int i) { int32_t data[3]; gyro->read_data_q16(data); return 1; }, NULL, N_CALLS, 1, 1 },
+    { "read_data_16", [](L3GD20Gyroscope *gyro, int i) { int16_t data[3]; gyro->read_data_16(data); return 1; }, NULL, N_CALLS, 1, 1 },
+    { "read_temperature_8", [](L3GD20Gyroscope *gyro, int i) { gyro->read_temperature_8(); return 0; }, NULL, N_CALLS, 1, 1 },
+    // FIFO draining
+    { "read_fifo", [](L3GD20Gyroscope *gyro, int i) { return gyro->read_fifo(fifo_samples); }, prepare_full_fifo, N_FIFO_CALLS, 2, 2 },
+    { "read_fifo_temperature", [](L3GD20Gyroscope *gyro, int i) { int8_t t; return gyro->read_fifo(fifo_samples, &t); }, prepare_full_fifo, N_FIFO_CALLS, 2, 2 },
+    { "read_fifo_view", [](L3GD20Gyroscope *gyro, int i) { return gyro->read_fifo_view(fifo_view_buffer, sizeof(fifo_view_buffer), true).n_samples; }, prepare_full_fifo, N_FIFO_CALLS, 2, 2 },
+    // FIFO block conversion
+    { "convert_data", [](L3GD20Gyroscope *gyro, int i) { gyro->convert_data(fifo_samples, fifo_data, L3GD20Gyroscope::FIFO_SIZE); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    { "convert_data_planar", [](L3GD20Gyroscope *gyro, int i) { gyro->convert_data(fifo_samples, fifo_data_x, fifo_data_y, fifo_data_z, L3GD20Gyroscope::FIFO_SIZE); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    { "convert_data_q16", [](L3GD20Gyroscope *gyro, int i) { gyro->convert_data_q16(fifo_samples, fifo_data_q16, L3GD20Gyroscope::FIFO_SIZE); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    // FIFO block integration
+    { "integrate", [](L3GD20Gyroscope *gyro, int i) { float_integrator.update(integration_rates, L3GD20Gyroscope::FIFO_SIZE); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    { "integrate_coning_4", [](L3GD20Gyroscope *gyro, int i) { coning_integrator.update(integration_rates, L3GD20Gyroscope::FIFO_SIZE); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    { "integrate_raw_coning_4", [](L3GD20Gyroscope *gyro, int i) { coning_integrator.update(integration_samples, L3GD20Gyroscope::FIFO_SIZE, INTEGRATION_SENSITIVITY); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    { "integrate_q16", [](L3GD20Gyroscope *gyro, int i) { fixed_integrator.update(integration_rates_q16, L3GD20Gyroscope::FIFO_SIZE); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    { "integrate_per_sample", [](L3GD20Gyroscope *gyro, int i) { integrate_per_sample(per_sample_q, integration_rates, L3GD20Gyroscope::FIFO_SIZE, 1.0f / INTEGRATION_ODR); return (int)L3GD20Gyroscope::FIFO_SIZE; }, NULL, N_CALLS, 0, 0 },
+    { "clear_fifo", [](L3GD20Gyroscope *gyro, int i) { gyro->clear_fifo(); return 0; }, prepare_fifo_enabled, N_CALLS, 5, 2 },
+    // complete configuration
+    { "apply", [](L3GD20Gyroscope *gyro, int i) { gyro->apply(L3GD20Gyroscope::GyroConfig()); return 0; }, NULL, N_CALLS, 2, 0 },
+    { "get_config", [](L3GD20Gyroscope *gyro, int i) { gyro->get_config(); return 0; }, NULL, N_CALLS, 2, 0 },
+    // setters
+    { "set_gyroscope_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->set_gyroscope_mode(L3GD20Gyroscope::G_ENABLE); return 0; }, NULL, N_CALLS, 2, 1 },
+    { "set_output_data_rate", [](L3GD20Gyroscope *gyro, int i) { gyro->set_output_data_rate(i & 1 ? L3GD20Gyroscope::ODR_190_HZ : L3GD20Gyroscope::ODR_95_HZ); return 0; }, NULL, N_CALLS, 2, 1 },
+    { "set_low_pass_filter_cutoff_freq_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->set_low_pass_filter_cutoff_freq_mode(i & 1 ? L3GD20Gyroscope::LPF_CF1 : L3GD20Gyroscope::LPF_CF0); return 0; }, NULL, N_CALLS, 2, 1 },
+    { "set_high_pass_filter_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->set_high_pass_filter_mode(i & 1 ? L3GD20Gyroscope::HPF_ENABLE : L3GD20Gyroscope::HPF_DISABLE); return 0; }, NULL, N_CALLS, 2, 1 },
+    { "set_high_pass_filter_cutoff_freq_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->set_high_pass_filter_cutoff_freq_mode(i & 1 ? L3GD20Gyroscope::HPF_CF1 : L3GD20Gyroscope::HPF_CF0); return 0; }, NULL, N_CALLS, 2, 1 },
+    { "set_full_scale", [](L3GD20Gyroscope *gyro, int i) { gyro->set_full_scale(i & 1 ? L3GD20Gyroscope::FULL_SCALE_500 : L3GD20Gyroscope::FULL_SCALE_250); return 0; }, NULL, N_CALLS, 2, 1 },
+    { "set_fifo_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->set_fifo_mode(i & 1 ? L3GD20Gyroscope::FIFO_ENABLE : L3GD20Gyroscope::FIFO_DISABLE); return 0; }, NULL, N_CALLS, 7, 3 },
+    { "set_fifo_watermark", [](L3GD20Gyroscope *gyro, int i) { gyro->set_fifo_watermark(i & 0x0F); return 0; }, NULL, N_CALLS, 2, 1 },
+    { "set_data_ready_interrupt_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->set_data_ready_interrupt_mode(i & 1 ? L3GD20Gyroscope::DRDY_ENABLE : L3GD20Gyroscope::DRDY_DISABLE); return 0; }, NULL, N_CALLS, 3, 1 },
+    // getters
+    { "get_register_cache_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->get_register_cache_mode(); return 0; }, NULL, N_CALLS, 0, 0 },
+    { "get_gyroscope_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->get_gyroscope_mode(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_output_data_rate", [](L3GD20Gyroscope *gyro, int i) { gyro->get_output_data_rate(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_output_data_rate_hz", [](L3GD20Gyroscope *gyro, int i) { gyro->get_output_data_rate_hz(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_low_pass_filter_cutoff_freq_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->get_low_pass_filter_cutoff_freq_mode(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_low_pass_filter_cut_off_frequency", [](L3GD20Gyroscope *gyro, int i) { gyro->get_low_pass_filter_cut_off_frequency(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_high_pass_filter_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->get_high_pass_filter_mode(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_high_pass_filter_cutoff_freq_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->get_high_pass_filter_cutoff_freq_mode(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_high_pass_filter_cut_off_frequency", [](L3GD20Gyroscope *gyro, int i) { gyro->get_high_pass_filter_cut_off_frequency(); return 0; }, NULL, N_CALLS, 2, 0 },
+    { "get_full_scale", [](L3GD20Gyroscope *gyro, int i) { gyro->get_full_scale(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_sensitivity", [](L3GD20Gyroscope *gyro, int i) { gyro->get_sensitivity(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_sensitivity_dps", [](L3GD20Gyroscope *gyro, int i) { gyro->get_sensitivity_dps(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_fifo_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->get_fifo_mode(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_fifo_watermark", [](L3GD20Gyroscope *gyro, int i) { gyro->get_fifo_watermark(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_data_ready_interrupt_mode", [](L3GD20Gyroscope *gyro, int i) { gyro->get_data_ready_interrupt_mode(); return 0; }, NULL, N_CALLS, 1, 0 },
+    { "get_temperature_sensor_sensitivity", [](L3GD20Gyroscope *gyro, int i) { gyro->get_temperature_sensor_sensitivity(); return 0; }, NULL, N_CALLS, 0, 0 }
+};
+
+/*
+ * Benchmark runner
+ */
+
+static CountingSpiTransport *counting_transport;
+// driver with counting transport to collect bus statistics
+static L3GD20Gyroscope *counted_gyro;
+// driver to measure CPU time
+static L3GD20Gyroscope *timed_gyro;
+#if defined(MBED_HOST)
+// simulated device is used as mock transport of the timed driver on host
+static sim::SimulatedL3GD20 *mock_device;
+#endif
+
+static void reset_gyro(L3GD20Gyroscope *gyro, L3GD20Gyroscope::RegisterCacheMode cache_mode)
+{
+    TEST_ASSERT_EQUAL(0, gyro->init());
+    gyro->set_register_cache_mode(cache_mode);
+    // load register cache, so the first call isn't penalized
+    gyro->get_config();
+}
+
+static void run_benchmark(L3GD20Gyroscope::RegisterCacheMode cache_mode)
+{
+    const bool cached = cache_mode == L3GD20Gyroscope::REG_CACHE_ENABLE;
+
+    for (size_t k = 0; k < sizeof(benchmark_calls) / sizeof(benchmark_calls[0]); k++) {
+        const BenchmarkCall &bc = benchmark_calls[k];
+        uint32_t transactions = 0;
+        uint32_t bytes = 0;
+        int samples = 0;
+        uint64_t ticks = 0;
+
+        // bus statistics
+        reset_gyro(counted_gyro, cache_mode);
+        for (int i = 0; i < bc.n_calls; i++) {
+            if (bc.prepare) {
+                bc.prepare(counted_gyro);
+            }
+            uint32_t transactions_start = counting_transport->get_transactions();
+            uint32_t bytes_start = counting_transport->get_bytes();
+            bc.run(counted_gyro, i);
+            transactions += counting_transport->get_transactions() - transactions_start;
+            bytes += counting_transport->get_bytes() - bytes_start;
+        }
+
+        // CPU time
+        reset_gyro(timed_gyro, cache_mode);
+        if (bc.prepare) {
+            for (int i = 0; i < bc.n_calls; i++) {
+                bc.prepare(timed_gyro);
+                auto start = cpu_timer_read();
+                samples += bc.run(timed_gyro, i);
+                ticks += CPU_TICKS_ELAPSED(start);
+            }
+        } else {
+            auto start = cpu_timer_read();
+            for (int i = 0; i < bc.n_calls; i++) {
+                samples += bc.run(timed_gyro, i);
+            }
+            ticks += CPU_TICKS_ELAPSED(start);
+        }
+
+        float ns_per_call = cpu_ticks_to_ns(ticks) / bc.n_calls;
+        float ns_per_sample = samples ? cpu_ticks_to_ns(ticks) / samples : 0.0f;
+#if defined(BENCHMARK_CYCLES)
+        char cycles_str[16];
+        snprintf(cycles_str, sizeof(cycles_str), "%.1f", (double)ticks / bc.n_calls);
+#else
+        const char *cycles_str = "";
+#endif
+        printf("bench,%s,%s,%s,%d,%.2f,%.2f,%.2f,%.1f,%.1f,%s\n",
+               BENCHMARK_PLATFORM, cached ? "on" : "off", bc.name, bc.n_calls,
+               (float)transactions / bc.n_calls, (float)bytes / bc.n_calls, (float)samples / bc.n_calls,
+               ns_per_call, ns_per_sample, cycles_str);
+
+        // check bus budget
+        int max_transactions = cached ? bc.max_transactions_cached : bc.max_transactions;
+        TEST_ASSERT_MESSAGE(transactions <= (uint32_t)(max_transactions * bc.n_calls), bc.name);
+    }
+
+    // leave device in the default state
+    reset_gyro(counted_gyro, L3GD20Gyroscope::REG_CACHE_DISABLE);
+}
+
+utest::v1::status_t test_setup_handler(const size_t number_of_cases)
+{
+    cpu_timer_init();
+    init_integration_rates();
+    counting_transport = new CountingSpiTransport(MBED_CONF_L3GD20_DRIVER_TEST_SPI_MOSI, MBED_CONF_L3GD20_DRIVER_TEST_SPI_MISO, MBED_CONF_L3GD20_DRIVER_TEST_SPI_SCLK, MBED_CONF_L3GD20_DRIVER_TEST_SPI_CS);
+    counted_gyro = new L3GD20Gyroscope(counting_transport);
+#if defined(MBED_HOST)
+    mock_device = new sim::SimulatedL3GD20();
+    timed_gyro = new L3GD20Gyroscope(mock_device);
+#else
+    timed_gyro = new L3GD20Gyroscope(MBED_CONF_L3GD20_DRIVER_TEST_SPI_MOSI, MBED_CONF_L3GD20_DRIVER_TEST_SPI_MISO, MBED_CONF_L3GD20_DRIVER_TEST_SPI_SCLK, MBED_CONF_L3GD20_DRIVER_TEST_SPI_CS);
+#endif
+    printf("bench,platform,cache,operation,calls,transactions_per_call,bytes_per_call,samples_per_call,ns_per_call,ns_per_sample,cycles_per_call\n");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void test_teardown_handler(const size_t passed, const size_t failed, const failure_t failure)
+{
+    delete timed_gyro;
+#if defined(MBED_HOST)
+    delete mock_device;
+#endif
+    delete counted_gyro;
+    delete counting_transport;
+    return greentea_test_teardown_handler(passed, failed, failure);
+}
+
+/**
+ * Benchmark driver calls without register cache.
+ */
+void test_benchmark_uncached()
+{
+    run_benchmark(L3GD20Gyroscope::REG_CACHE_DISABLE);
+}
+
+/**
+ * Benchmark driver calls with register cache.
+ */
+void test_benchmark_cached()
+{
+    run_benchmark(L3GD20Gyroscope::REG_CACHE_ENABLE);
+}
+
+// test cases description
+#define BenchmarkCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    BenchmarkCase(test_benchmark_uncached),
+    BenchmarkCase(test_benchmark_cached)
+};
+Specification specification(test_setup_handler, cases, test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    // host handshake
+    // note: should be invoked here or in the test_setup_handler
+    GREENTEA_SETUP(60, "default_auto");
+    // run tests
+    return !Harness::run(specification);
+}
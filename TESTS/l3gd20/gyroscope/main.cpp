@@ -1,5 +1,7 @@
 #include "greentea-client/test_env.h"
+#include "l3gd20_async_reader.h"
 #include "l3gd20_driver.h"
+#include "l3gd20_integrator.h"
 #include "math.h"
 #include "mbed.h"
 #include "rtos.h"
@@ -112,6 +114,61 @@ void test_multiple_start_stop()
     }
 }
 
+/**
+ * Test sleep mode and axes selection.
+ */
+void test_sleep_mode_and_axes()
+{
+    gyro->set_gyroscope_mode(gyro->G_SLEEP);
+    TEST_ASSERT_EQUAL(gyro->G_SLEEP, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(0, gyro->get_axes());
+
+    // axes enabling wakes gyroscope up
+    gyro->set_axes(gyro->AXIS_X_ENABLE | gyro->AXIS_Z_ENABLE);
+    TEST_ASSERT_EQUAL(gyro->G_ENABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(gyro->AXIS_X_ENABLE | gyro->AXIS_Z_ENABLE, gyro->get_axes());
+    L3GD20Gyroscope::GyroConfig config = gyro->get_config();
+    TEST_ASSERT_EQUAL(gyro->G_ENABLE, config.gyroscope_mode);
+    TEST_ASSERT_EQUAL(gyro->AXIS_X_ENABLE | gyro->AXIS_Z_ENABLE, config.axes);
+
+    // power down and power up keep axes
+    gyro->set_gyroscope_mode(gyro->G_DISABLE);
+    TEST_ASSERT_EQUAL(gyro->G_DISABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(gyro->AXIS_X_ENABLE | gyro->AXIS_Z_ENABLE, gyro->get_axes());
+    gyro->set_gyroscope_mode(gyro->G_ENABLE);
+    TEST_ASSERT_EQUAL(gyro->G_ENABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(gyro->AXIS_X_ENABLE | gyro->AXIS_Z_ENABLE, gyro->get_axes());
+
+    // mode and axes selection
+    gyro->set_gyroscope_mode(gyro->G_DISABLE, gyro->AXIS_Y_ENABLE);
+    TEST_ASSERT_EQUAL(gyro->G_DISABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(gyro->AXIS_Y_ENABLE, gyro->get_axes());
+    gyro->set_gyroscope_mode(gyro->G_ENABLE, gyro->AXIS_X_ENABLE);
+    TEST_ASSERT_EQUAL(gyro->G_ENABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(gyro->AXIS_X_ENABLE, gyro->get_axes());
+    gyro->set_gyroscope_mode(gyro->G_SLEEP, gyro->AXIS_X_ENABLE);
+    TEST_ASSERT_EQUAL(gyro->G_SLEEP, gyro->get_gyroscope_mode());
+
+    // configuration with axes selection
+    config.gyroscope_mode = gyro->G_ENABLE;
+    config.axes = gyro->AXIS_Y_ENABLE;
+    gyro->apply(config);
+    TEST_ASSERT_EQUAL(gyro->G_ENABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(gyro->AXIS_Y_ENABLE, gyro->get_axes());
+    config.gyroscope_mode = gyro->G_DISABLE;
+    config.axes = gyro->AXIS_Z_ENABLE;
+    gyro->apply(config);
+    TEST_ASSERT_EQUAL(gyro->G_DISABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(gyro->AXIS_Z_ENABLE, gyro->get_config().axes);
+    config.gyroscope_mode = gyro->G_SLEEP;
+    gyro->apply(config);
+    TEST_ASSERT_EQUAL(gyro->G_SLEEP, gyro->get_config().gyroscope_mode);
+
+    // all axes are enabled, if none of them is set
+    gyro->set_gyroscope_mode(gyro->G_ENABLE);
+    TEST_ASSERT_EQUAL(gyro->AXIS_ALL_ENABLE, gyro->get_axes());
+}
+
 float abs_vec3(float vec3[3])
 {
     return sqrtf(vec3[0] * vec3[0] + vec3[1] * vec3[1] + vec3[2] * vec3[2]);
@@ -237,15 +294,696 @@ void test_fifo_interrupt_usage()
     TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, interrupt_counter.angle);
 }
 
+/**
+ * Test FIFO burst reading.
+ */
+void test_fifo_burst_reading()
+{
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    int n;
+    float angle = 0.0f;
+    float dt;
+
+    // gyroscope preparation
+    gyro->set_output_data_rate(L3GD20Gyroscope::ODR_95_HZ);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    dt = 1.0f / gyro->get_output_data_rate_hz();
+
+    // collect samples
+    ThisThread::sleep_for(200ms);
+    n = gyro->read_fifo(samples);
+    TEST_ASSERT(n > 15);
+    TEST_ASSERT(n < 22);
+    for (int i = 0; i < n; i++) {
+        float w[3];
+        for (int j = 0; j < 3; j++) {
+            w[j] = samples[i][j] * gyro->get_sensitivity();
+        }
+        angle += abs_vec3(w) * dt;
+    }
+    TEST_ASSERT_NOT_EQUAL(0.0f, angle);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, angle);
+
+    // FIFO should be empty after reading
+    n = gyro->read_fifo(samples);
+    TEST_ASSERT(n <= 1);
+
+    // check buffer size limit
+    ThisThread::sleep_for(100ms);
+    n = gyro->read_fifo(samples, 4);
+    TEST_ASSERT_EQUAL(4, n);
+
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+}
+
+/**
+ * Test FIFO status, overrun and empty interrupts.
+ */
+void test_fifo_overrun_interrupts()
+{
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    DigitalIn int2_pin(MBED_CONF_L3GD20_DRIVER_TEST_DRDY);
+    L3GD20Gyroscope::FIFOStatus status;
+
+    // gyroscope preparation
+    gyro->set_output_data_rate(L3GD20Gyroscope::ODR_95_HZ);
+    gyro->set_fifo_watermark(8);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    gyro->set_fifo_interrupt_mode(L3GD20Gyroscope::FIFO_INT_OVERRUN);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_INT_OVERRUN, gyro->get_fifo_interrupt_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::DRDY_DISABLE, gyro->get_data_ready_interrupt_mode());
+    uint32_t overrun_count = gyro->get_fifo_overrun_count();
+
+    // watermark is reached, but FIFO isn't full
+    ThisThread::sleep_for(200ms);
+    status = gyro->read_fifo_status();
+    TEST_ASSERT(status.level > 15);
+    TEST_ASSERT(status.level < 22);
+    TEST_ASSERT_TRUE(status.watermark);
+    TEST_ASSERT_FALSE(status.overrun);
+    TEST_ASSERT_FALSE(status.empty);
+    TEST_ASSERT_EQUAL(0, int2_pin.read());
+
+    // FIFO overrun
+    ThisThread::sleep_for(200ms);
+    status = gyro->read_fifo_status();
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_SIZE, status.level);
+    TEST_ASSERT_TRUE(status.overrun);
+    TEST_ASSERT_EQUAL(1, int2_pin.read());
+    TEST_ASSERT_EQUAL(overrun_count, gyro->get_fifo_overrun_count());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_SIZE, gyro->read_fifo(samples));
+    TEST_ASSERT_TRUE(gyro->get_last_fifo_status().overrun);
+    TEST_ASSERT_EQUAL(overrun_count + 1, gyro->get_fifo_overrun_count());
+    TEST_ASSERT_EQUAL(0, int2_pin.read());
+
+    // overrun interrupt doesn't depend on data ready interrupt mode
+    gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
+    gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_INT_OVERRUN, gyro->get_fifo_interrupt_mode());
+
+    // empty interrupt
+    gyro->set_fifo_interrupt_mode(L3GD20Gyroscope::FIFO_INT_EMPTY);
+    gyro->read_fifo(samples);
+    TEST_ASSERT_FALSE(gyro->get_last_fifo_status().overrun);
+    TEST_ASSERT_EQUAL(overrun_count + 1, gyro->get_fifo_overrun_count());
+    status = gyro->read_fifo_status();
+    if (status.empty) {
+        // the next sample can be produced after reading
+        TEST_ASSERT_EQUAL(0, status.level);
+        TEST_ASSERT_EQUAL(1, int2_pin.read());
+    }
+    ThisThread::sleep_for(50ms);
+    status = gyro->read_fifo_status();
+    TEST_ASSERT_FALSE(status.empty);
+    TEST_ASSERT_EQUAL(0, int2_pin.read());
+
+    // default configuration disables FIFO interrupts
+    gyro->apply(L3GD20Gyroscope::GyroConfig());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_INT_DISABLE, gyro->get_fifo_interrupt_mode());
+    TEST_ASSERT_TRUE(gyro->read_fifo_status().empty);
+}
+
+/**
+ * Test driver statistics.
+ */
+void test_driver_stats()
+{
+    if (!STATS_ENABLED) {
+        TEST_IGNORE_MESSAGE("Driver statistics is disabled");
+        return;
+    }
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    gyro->set_output_data_rate(L3GD20Gyroscope::ODR_95_HZ);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    gyro->reset_stats();
+    L3GD20Gyroscope::Stats stats = gyro->get_stats();
+    TEST_ASSERT_EQUAL(0, stats.bus.register_reads);
+    TEST_ASSERT_EQUAL(0, stats.samples_read);
+
+    // FIFO reading: FIFO_SRC_REG and burst reading of the samples
+    ThisThread::sleep_for(100ms);
+    int n = gyro->read_fifo(samples);
+    int16_t data[3];
+    gyro->read_data_16(data);
+    gyro->add_irq_masked_time(20);
+    gyro->add_irq_masked_time(50);
+    stats = gyro->get_stats();
+    TEST_ASSERT(n > 0);
+    TEST_ASSERT_EQUAL(1, stats.bus.register_reads);
+    TEST_ASSERT_EQUAL(2, stats.bus.burst_reads);
+    TEST_ASSERT_EQUAL(1 + n * 6 + 6, stats.bus.bytes_read);
+    TEST_ASSERT_EQUAL(0, stats.bus.register_writes);
+    TEST_ASSERT_EQUAL(n + 1, stats.samples_read);
+    TEST_ASSERT_EQUAL(1, stats.fifo_level_histogram[n]);
+    TEST_ASSERT_EQUAL(2, stats.irq_masked_count);
+    TEST_ASSERT_EQUAL(70, stats.irq_masked_time_us);
+    TEST_ASSERT_EQUAL(50, stats.max_irq_masked_time_us);
+
+    // register update with cache
+    gyro->set_register_cache_mode(L3GD20Gyroscope::REG_CACHE_ENABLE);
+    gyro->resync();
+    gyro->reset_stats();
+    gyro->set_fifo_watermark(4);
+    stats = gyro->get_stats();
+    TEST_ASSERT_EQUAL(0, stats.bus.register_reads);
+    TEST_ASSERT_EQUAL(1, stats.bus.cache_hits);
+    TEST_ASSERT_EQUAL(1, stats.bus.register_writes);
+    TEST_ASSERT_EQUAL(1, stats.bus.bytes_written);
+    gyro->set_register_cache_mode(L3GD20Gyroscope::REG_CACHE_DISABLE);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+}
+
+/**
+ * Test block conversion of raw samples.
+ */
+void test_block_conversion()
+{
+    const int n_max = L3GD20Gyroscope::FIFO_SIZE;
+    int16_t samples[n_max][3];
+    float data[n_max][3];
+    float x[n_max];
+    float y[n_max];
+    float z[n_max];
+
+    // synthetic samples with extreme values
+    for (int i = 0; i < n_max; i++) {
+        for (int j = 0; j < 3; j++) {
+            samples[i][j] = (int16_t)(i * 2113 + j * 7919 - 32768);
+        }
+    }
+    samples[0][0] = INT16_MIN;
+    samples[0][1] = INT16_MAX;
+    samples[0][2] = 0;
+
+    // check all block sizes to cover vectorized and scalar parts
+    for (int n = 1; n <= n_max; n++) {
+        float rps = gyro->get_sensitivity();
+        float dps = gyro->get_sensitivity_dps();
+        gyro->convert_data(samples, data, n);
+        gyro->convert_data_dps(samples, x, y, z, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < 3; j++) {
+                TEST_ASSERT_EQUAL_FLOAT(rps * samples[i][j], data[i][j]);
+            }
+            TEST_ASSERT_EQUAL_FLOAT(dps * samples[i][0], x[i]);
+            TEST_ASSERT_EQUAL_FLOAT(dps * samples[i][1], y[i]);
+            TEST_ASSERT_EQUAL_FLOAT(dps * samples[i][2], z[i]);
+        }
+    }
+
+    // check that conversion follows full scale
+    gyro->set_full_scale(L3GD20Gyroscope::FULL_SCALE_2000);
+    gyro->convert_data_dps(samples, data, 1);
+    TEST_ASSERT_EQUAL_FLOAT(0.07f * INT16_MAX, data[0][1]);
+    gyro->set_full_scale(L3GD20Gyroscope::FULL_SCALE_250);
+
+    // convert FIFO block
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    ThisThread::sleep_for(200ms);
+    int n = gyro->read_fifo(samples);
+    TEST_ASSERT(n > 15);
+    gyro->convert_data(samples, x, y, z, n);
+    for (int i = 0; i < n; i++) {
+        float w[3] = { x[i], y[i], z[i] };
+        TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, abs_vec3(w));
+    }
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+}
+
+/**
+ * Test fixed-point conversion of raw samples.
+ */
+void test_fixed_point_conversion()
+{
+    const L3GD20Gyroscope::FullScale fs_modes[] = {
+        L3GD20Gyroscope::FULL_SCALE_250,
+        L3GD20Gyroscope::FULL_SCALE_500,
+        L3GD20Gyroscope::FULL_SCALE_1000,
+        L3GD20Gyroscope::FULL_SCALE_2000
+    };
+    const int n = 8;
+    const float q16_lsb = 1.0f / 65536.0f;
+    int16_t samples[n][3];
+    int32_t data_q16[n][3];
+    float data[n][3];
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) {
+            samples[i][j] = (int16_t)(i * 9001 + j * 3001 - 32768);
+        }
+    }
+    samples[0][0] = INT16_MIN;
+    samples[0][1] = INT16_MAX;
+    samples[0][2] = -1;
+
+    for (size_t k = 0; k < sizeof(fs_modes) / sizeof(fs_modes[0]); k++) {
+        gyro->set_full_scale(fs_modes[k]);
+
+        // rad/s
+        gyro->convert_data_q16(samples, data_q16, n);
+        gyro->convert_data(samples, data, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < 3; j++) {
+                TEST_ASSERT_FLOAT_WITHIN(q16_lsb + 2e-5f * fabsf(data[i][j]), data[i][j], data_q16[i][j] * q16_lsb);
+            }
+        }
+
+        // dps
+        gyro->convert_data_dps_q16(samples, data_q16, n);
+        gyro->convert_data_dps(samples, data, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < 3; j++) {
+                TEST_ASSERT_FLOAT_WITHIN(q16_lsb + 1e-5f * fabsf(data[i][j]), data[i][j], data_q16[i][j] * q16_lsb);
+            }
+        }
+    }
+    gyro->set_full_scale(L3GD20Gyroscope::FULL_SCALE_250);
+
+    // motionless device data
+    int32_t w_q16[3];
+    gyro->read_data_q16(w_q16);
+    for (int j = 0; j < 3; j++) {
+        TEST_ASSERT_INT_WITHIN(65536 / 10, 0, w_q16[j]);
+    }
+    gyro->read_data_dps_q16(w_q16);
+    for (int j = 0; j < 3; j++) {
+        TEST_ASSERT_INT_WITHIN(5 * 65536, 0, w_q16[j]);
+    }
+}
+
+/**
+ * Rotate quaternion by angular rates in the body frame with exact per sample rotations (reference implementation).
+ */
+static void integrate_exact(double q[4], const float (*rates)[3], int n, double dt)
+{
+    for (int i = 0; i < n; i++) {
+        double v[3] = { rates[i][0] * dt / 2, rates[i][1] * dt / 2, rates[i][2] * dt / 2 };
+        double a = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        double k = a > 0.0 ? sin(a) / a : 1.0;
+        double dq[4] = { cos(a), v[0] * k, v[1] * k, v[2] * k };
+        double w = q[0] * dq[0] - q[1] * dq[1] - q[2] * dq[2] - q[3] * dq[3];
+        double x = q[0] * dq[1] + q[1] * dq[0] + q[2] * dq[3] - q[3] * dq[2];
+        double y = q[0] * dq[2] - q[1] * dq[3] + q[2] * dq[0] + q[3] * dq[1];
+        double z = q[0] * dq[3] + q[1] * dq[2] - q[2] * dq[1] + q[3] * dq[0];
+        q[0] = w;
+        q[1] = x;
+        q[2] = y;
+        q[3] = z;
+    }
+}
+
+/**
+ * Test floating point rate integration.
+ */
+void test_orientation_integrator()
+{
+    const float odr = 760.0f;
+    const int block_size = 32;
+    float rates[block_size][3];
+    float q[4];
+    OrientationIntegrator integrator(odr);
+
+    // identity quaternion
+    integrator.get_quaternion(q);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, q[0]);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, q[1]);
+
+    // rotate by 90 degrees around z axis and then by 90 degrees around x axis of the body frame
+    for (int axis = 2; axis >= 0; axis -= 2) {
+        for (int i = 0; i < block_size; i++) {
+            rates[i][0] = 0.0f;
+            rates[i][1] = 0.0f;
+            rates[i][2] = 0.0f;
+            rates[i][axis] = M_PI / 2;
+        }
+        for (int i = 0; i < (int)odr; i += block_size) {
+            int n = (int)odr - i < block_size ? (int)odr - i : block_size;
+            integrator.update(rates, n);
+        }
+    }
+    // expected: [cos(pi/4), 0, 0, sin(pi/4)] * [cos(pi/4), sin(pi/4), 0, 0] = [0.5, 0.5, 0.5, 0.5]
+    integrator.get_quaternion(q);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.5f, q[i]);
+    }
+
+    // fast rotation with varying axis (2000 dps peak rate) in comparison with exact rotations
+    double q_ref[4] = { 1.0, 0.0, 0.0, 0.0 };
+    integrator.reset();
+    for (int k = 0; k < (int)odr * 2; k += block_size) {
+        for (int i = 0; i < block_size; i++) {
+            float t = (k + i) / odr;
+            rates[i][0] = 34.9f * sinf(2.0f * (float)M_PI * 3.0f * t);
+            rates[i][1] = 20.0f * cosf(2.0f * (float)M_PI * 5.0f * t);
+            rates[i][2] = 10.0f;
+        }
+        integrator.update(rates, block_size);
+        integrate_exact(q_ref, rates, block_size, 1.0 / odr);
+    }
+    integrator.get_quaternion(q);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, q_ref[i], q[i]);
+    }
+
+    // integrate motionless device data
+    integrator.reset();
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    float data[L3GD20Gyroscope::FIFO_SIZE][3];
+    integrator.set_sample_rate(gyro->get_output_data_rate_hz());
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    ThisThread::sleep_for(200ms);
+    int n = gyro->read_fifo(samples);
+    TEST_ASSERT(n > 15);
+    gyro->convert_data(samples, data, n);
+    integrator.update(data, n);
+    integrator.get_quaternion(q);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, q[0]);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+}
+
+/**
+ * Test coning compensation and integration of raw samples.
+ */
+void test_coning_compensation()
+{
+    const float odr = 760.0f;
+    const int block_size = 24;
+    const int n_modes = 4;
+    // coning motion: w = [a * f * cos(f * t), a * f * sin(f * t), 0] with 0.01 rad amplitude and 40 Hz frequency
+    const double a = 0.01;
+    const double f = 2 * M_PI * 40.0;
+    const double dt = 1.0 / odr;
+    const int n_substeps = 100;
+    float rates[block_size][3];
+    float q[4];
+    double q_ref[4] = { 1.0, 0.0, 0.0, 0.0 };
+    float errors[n_modes];
+    OrientationIntegrator integrators[n_modes] = {
+        OrientationIntegrator(odr), OrientationIntegrator(odr), OrientationIntegrator(odr), OrientationIntegrator(odr)
+    };
+    for (int m = 0; m < n_modes; m++) {
+        integrators[m].set_coning_mode((OrientationIntegrator::ConingMode)(m + 1));
+        TEST_ASSERT_EQUAL(m + 1, integrators[m].get_coning_mode());
+    }
+
+    for (int k = 0; k < block_size * 64; k += block_size) {
+        for (int i = 0; i < block_size; i++) {
+            // samples are mean rates of the sample periods
+            double t = (k + i) * dt;
+            rates[i][0] = a * (sin(f * (t + dt)) - sin(f * t)) / dt;
+            rates[i][1] = -a * (cos(f * (t + dt)) - cos(f * t)) / dt;
+            rates[i][2] = 0.0f;
+            // reference orientation with small steps
+            for (int j = 0; j < n_substeps; j++) {
+                double ts = t + (j + 0.5) * dt / n_substeps;
+                float rate[1][3] = { { (float)(a * f * cos(f * ts)), (float)(a * f * sin(f * ts)), 0.0f } };
+                integrate_exact(q_ref, rate, 1, dt / n_substeps);
+            }
+        }
+        for (int m = 0; m < n_modes; m++) {
+            integrators[m].update(rates, block_size);
+        }
+    }
+
+    for (int m = 0; m < n_modes; m++) {
+        integrators[m].get_quaternion(q);
+        errors[m] = 0.0f;
+        for (int i = 0; i < 4; i++) {
+            errors[m] = fmaxf(errors[m], fabsf(q[i] - (float)q_ref[i]));
+        }
+    }
+    // coning compensation reduces error of the per sample integration significantly
+    TEST_ASSERT(errors[1] < errors[0] / 10);
+    TEST_ASSERT(errors[2] < errors[0] / 10);
+    TEST_ASSERT(errors[3] < errors[0] / 100);
+
+    // raw samples with bias give the same result as converted ones
+    int16_t samples[block_size][3];
+    const float sensitivity = gyro->get_sensitivity();
+    const float bias[3] = { 0.01f, -0.02f, 0.03f };
+    for (int i = 0; i < block_size; i++) {
+        for (int j = 0; j < 3; j++) {
+            samples[i][j] = (int16_t)(i * 1000 - j * 3000);
+            rates[i][j] = samples[i][j] * sensitivity - bias[j];
+        }
+    }
+    float q_raw[4];
+    for (int m = 0; m < n_modes; m++) {
+        integrators[m].reset();
+        integrators[m].update(rates, block_size);
+        integrators[m].get_quaternion(q);
+        integrators[m].reset();
+        integrators[m].update(samples, block_size, sensitivity, bias);
+        integrators[m].get_quaternion(q_raw);
+        for (int i = 0; i < 4; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f, q[i], q_raw[i]);
+        }
+    }
+}
+
+/**
+ * Test fixed-point rate integration.
+ */
+void test_fixed_orientation_integrator()
+{
+    const float odr = 760.0f;
+    const int block_size = 32;
+    // 90 dps in rad/s (Q16.16)
+    const int32_t rate_q16 = (int32_t)(M_PI / 2 * 65536);
+    const float q_lsb = 1.0f / FixedOrientationIntegrator::QUATERNION_ONE;
+    int32_t rates[block_size][3];
+    int32_t q[4];
+    FixedOrientationIntegrator integrator(odr);
+
+    // identity quaternion
+    integrator.get_quaternion(q);
+    TEST_ASSERT_EQUAL(FixedOrientationIntegrator::QUATERNION_ONE, q[0]);
+    TEST_ASSERT_EQUAL(0, q[1]);
+
+    // rotate by 90 degrees around z axis and then by 90 degrees around x axis of the body frame
+    for (int axis = 2; axis >= 0; axis -= 2) {
+        for (int i = 0; i < block_size; i++) {
+            rates[i][0] = 0;
+            rates[i][1] = 0;
+            rates[i][2] = 0;
+            rates[i][axis] = rate_q16;
+        }
+        for (int i = 0; i < (int)odr; i += block_size) {
+            int n = (int)odr - i < block_size ? (int)odr - i : block_size;
+            integrator.update(rates, n);
+        }
+    }
+
+    // expected: [cos(pi/4), 0, 0, sin(pi/4)] * [cos(pi/4), sin(pi/4), 0, 0] = [0.5, 0.5, 0.5, 0.5]
+    integrator.get_quaternion(q);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.5f, q[i] * q_lsb);
+    }
+
+    // integrate motionless device data
+    integrator.reset();
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    integrator.set_sample_rate(gyro->get_output_data_rate_hz());
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    ThisThread::sleep_for(200ms);
+    int n = gyro->read_fifo(samples);
+    TEST_ASSERT(n > 15);
+    gyro->convert_data_q16(samples, rates, n);
+    integrator.update(rates, n);
+    integrator.get_quaternion(q);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, q[0] * q_lsb);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+}
+
+/**
+ * Test register cache usage.
+ */
+void test_register_cache()
+{
+    gyro->set_register_cache_mode(L3GD20Gyroscope::REG_CACHE_ENABLE);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::REG_CACHE_ENABLE, gyro->get_register_cache_mode());
+
+    // check that setters and getters are consistent
+    gyro->set_output_data_rate(L3GD20Gyroscope::ODR_380_HZ);
+    gyro->set_full_scale(L3GD20Gyroscope::FULL_SCALE_500);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_380_HZ, gyro->get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FULL_SCALE_500, gyro->get_full_scale());
+
+    // check that device state matches cache
+    gyro->resync();
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_380_HZ, gyro->get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FULL_SCALE_500, gyro->get_full_scale());
+
+    // check direct register modification
+    gyro->write_register(L3GD20Gyroscope::CTRL_REG1_ADDR, L3GD20Gyroscope::ODR_190_HZ | L3GD20Gyroscope::G_ENABLE);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_190_HZ, gyro->get_output_data_rate());
+
+    gyro->set_register_cache_mode(L3GD20Gyroscope::REG_CACHE_DISABLE);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::REG_CACHE_DISABLE, gyro->get_register_cache_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_190_HZ, gyro->get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FULL_SCALE_500, gyro->get_full_scale());
+}
+
+/**
+ * Test complete configuration applying.
+ */
+void test_apply_config()
+{
+    L3GD20Gyroscope::GyroConfig config;
+    config.output_data_rate = L3GD20Gyroscope::ODR_760_HZ;
+    config.low_pass_filter_cutoff_freq_mode = L3GD20Gyroscope::LPF_CF2;
+    config.high_pass_filter_mode = L3GD20Gyroscope::HPF_ENABLE;
+    config.high_pass_filter_cutoff_freq_mode = L3GD20Gyroscope::HPF_CF5;
+    config.full_scale = L3GD20Gyroscope::FULL_SCALE_2000;
+    config.fifo_mode = L3GD20Gyroscope::FIFO_ENABLE;
+    config.fifo_watermark = 12;
+    config.data_ready_interrupt_mode = L3GD20Gyroscope::DRDY_ENABLE;
+    config.fifo_interrupt_mode = L3GD20Gyroscope::FIFO_INT_OVERRUN;
+    gyro->apply(config);
+
+    // check parameters
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::G_ENABLE, gyro->get_gyroscope_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_760_HZ, gyro->get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::LPF_CF2, gyro->get_low_pass_filter_cutoff_freq_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::HPF_ENABLE, gyro->get_high_pass_filter_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::HPF_CF5, gyro->get_high_pass_filter_cutoff_freq_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FULL_SCALE_2000, gyro->get_full_scale());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_ENABLE, gyro->get_fifo_mode());
+    TEST_ASSERT_EQUAL(12, gyro->get_fifo_watermark());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::DRDY_ENABLE, gyro->get_data_ready_interrupt_mode());
+
+    // check configuration reading
+    L3GD20Gyroscope::GyroConfig current_config = gyro->get_config();
+    TEST_ASSERT_EQUAL(config.output_data_rate, current_config.output_data_rate);
+    TEST_ASSERT_EQUAL(config.low_pass_filter_cutoff_freq_mode, current_config.low_pass_filter_cutoff_freq_mode);
+    TEST_ASSERT_EQUAL(config.high_pass_filter_cutoff_freq_mode, current_config.high_pass_filter_cutoff_freq_mode);
+    TEST_ASSERT_EQUAL(config.full_scale, current_config.full_scale);
+    TEST_ASSERT_EQUAL(config.fifo_watermark, current_config.fifo_watermark);
+    TEST_ASSERT_EQUAL(config.fifo_interrupt_mode, current_config.fifo_interrupt_mode);
+
+    // restore default configuration
+    gyro->apply(L3GD20Gyroscope::GyroConfig());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_DISABLE, gyro->get_fifo_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::DRDY_DISABLE, gyro->get_data_ready_interrupt_mode());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_95_HZ, gyro->get_output_data_rate());
+}
+
+/**
+ * Test driver with compile-time bus selection.
+ */
+void test_spi_bus_driver()
+{
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    int n;
+    L3GD20GyroscopeSPI spi_gyro(MBED_CONF_L3GD20_DRIVER_TEST_SPI_MOSI, MBED_CONF_L3GD20_DRIVER_TEST_SPI_MISO, MBED_CONF_L3GD20_DRIVER_TEST_SPI_SCLK, MBED_CONF_L3GD20_DRIVER_TEST_SPI_CS);
+
+    TEST_ASSERT_EQUAL(0, spi_gyro.init());
+    spi_gyro.set_output_data_rate(L3GD20Gyroscope::ODR_190_HZ);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_190_HZ, spi_gyro.get_output_data_rate());
+    // check that both drivers see the same device state
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_190_HZ, gyro->get_output_data_rate());
+
+    spi_gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    spi_gyro.clear_fifo();
+    ThisThread::sleep_for(50ms);
+    n = spi_gyro.read_fifo(samples);
+    TEST_ASSERT(n > 5);
+    TEST_ASSERT(n < 14);
+    spi_gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+}
+
+#if DEVICE_SPI_ASYNCH
+struct async_block_counter_t {
+    int block_count;
+    int sample_count;
+    int max_deviation;
+    int reference[3];
+};
+
+static async_block_counter_t async_block_counter;
+
+static void on_async_block(const int16_t (*samples)[3], int n)
+{
+    async_block_counter.block_count++;
+    async_block_counter.sample_count += n;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) {
+            int deviation = abs(samples[i][j] - async_block_counter.reference[j]);
+            if (deviation > async_block_counter.max_deviation) {
+                async_block_counter.max_deviation = deviation;
+            }
+        }
+    }
+}
+
+/**
+ * Test asynchronous FIFO reading.
+ */
+void test_async_fifo_reader()
+{
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    memset(&async_block_counter, 0, sizeof(async_block_counter));
+
+    // reference level of the motionless device
+    gyro->set_output_data_rate(L3GD20Gyroscope::ODR_95_HZ);
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro->clear_fifo();
+    ThisThread::sleep_for(200ms);
+    int n = gyro->read_fifo(samples);
+    TEST_ASSERT(n > 15);
+    for (int j = 0; j < 3; j++) {
+        int sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += samples[i][j];
+        }
+        async_block_counter.reference[j] = sum / n;
+    }
+
+    // asynchronously read samples should have the same level
+    AsyncFifoReader reader(gyro, MBED_CONF_L3GD20_DRIVER_TEST_DRDY);
+    TEST_ASSERT_EQUAL(0, reader.start(8, on_async_block));
+    ThisThread::sleep_for(500ms);
+    reader.stop();
+    gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+
+    TEST_ASSERT_INT_WITHIN(1, 5, async_block_counter.block_count);
+    TEST_ASSERT_EQUAL(8 * async_block_counter.block_count, async_block_counter.sample_count);
+    TEST_ASSERT_EQUAL(0, reader.get_error_count());
+    // noise of the motionless device is below 1 dps (114 LSB), but a byte shift corrupts the samples
+    TEST_ASSERT(async_block_counter.max_deviation < 200);
+}
+#endif
+
 // test cases description
 #define GyroCase(test_fun) Case(#test_fun, case_setup_handler, test_fun, greentea_case_teardown_handler, greentea_case_failure_continue_handler)
 Case cases[] = {
     GyroCase(test_init_state_enabled),
     GyroCase(test_init_state_disabled),
     GyroCase(test_multiple_start_stop),
+    GyroCase(test_sleep_mode_and_axes),
     GyroCase(test_simple_data_reading),
     GyroCase(test_simple_interrupt_usage),
-    GyroCase(test_fifo_interrupt_usage)
+    GyroCase(test_fifo_interrupt_usage),
+    GyroCase(test_fifo_burst_reading),
+#if DEVICE_SPI_ASYNCH
+    GyroCase(test_async_fifo_reader),
+#endif
+    GyroCase(test_fifo_overrun_interrupts),
+    GyroCase(test_driver_stats),
+    GyroCase(test_block_conversion),
+    GyroCase(test_fixed_point_conversion),
+    GyroCase(test_orientation_integrator),
+    GyroCase(test_coning_compensation),
+    GyroCase(test_fixed_orientation_integrator),
+    GyroCase(test_register_cache),
+    GyroCase(test_apply_config),
+    GyroCase(test_spi_bus_driver)
 };
 Specification specification(test_setup_handler, cases, test_teardown_handler);
 
@@ -3,12 +3,29 @@
  *
  * Interrupt and FIFO usage.
  *
- * This sample integrates data, using quaternion math to show current rotation.
+ * FIFO is read by GyroStream, that owns a high priority thread, which is woken by the watermark
+ * interrupt, drains FIFO with a single burst transaction and passes contiguous blocks to the processing.
+ * This sample integrates data with OrientationIntegrator to show current rotation.
+ * Each 4 samples are integrated as a single rotation with coning compensation.
+ * Gyroscope bias is estimated during acquisition, when device is motionless, and it's tracked
+ * as a function of the on-chip temperature sensor output, that is read with FIFO data.
+ * The sample period is measured by the stream with SampleTimestamper, as actual output data rate
+ * can deviate from the nominal one by several percents.
+ * If FLASHIAP component is enabled, the calibration is persisted in the last flash sector
+ * with CalibrationStore, so bias and output data rate are known immediately after reboot.
  * See: http://stanford.edu/class/ee267/lectures/lecture10.pdf for more details.
  */
+#include "l3gd20_bias_estimator.h"
+#include "l3gd20_calibration_store.h"
 #include "l3gd20_driver.h"
+#include "l3gd20_gyro_stream.h"
+#include "l3gd20_integrator.h"
+#include "l3gd20_temperature_bias.h"
 #include "math.h"
 #include "mbed.h"
+#if COMPONENT_FLASHIAP
+#include "FlashIAPBlockDevice.h"
+#endif
 
 /**
  * Pin map:
@@ -29,63 +46,36 @@ class GyroProcessor {
 public:
     GyroProcessor(L3GD20Gyroscope *gyro, int block_size, PinName drdy_pin, PinName indicator)
         : _gyro(gyro)
-        , _drdy_int(drdy_pin)
+        , _stream(gyro, drdy_pin, osPriorityHigh7)
         , _indicator_out(indicator)
         , _block_size(block_size)
-        , _sensor_queue()
-        , _sensor_thread(osPriorityHigh7)
-        , _calibrate_event(&_sensor_queue, callback(this, &GyroProcessor::_calibrate_callback))
-        , _process_block_event(&_sensor_queue, callback(this, &GyroProcessor::_process_block))
+        , _integrator(gyro->get_output_data_rate_hz())
     {
-        // configure gyroscope
-        _drdy_int.disable_irq();
-
-        _w_offset[0] = 0.0f;
-        _w_offset[1] = 0.0f;
-        _w_offset[2] = 0.0f;
     }
 
     /**
-     * Calibrate gyroscope to eliminate offset error.
-     *
-     * During calibration it shouldn't be moved.
+     * Start processing.
      *
-     * @param calibration_time
+     * @param calibration stored calibration or NULL
      */
-    void calibrate(float calibration_time)
+    void start_async(const CalibrationStore::Calibration *calibration = NULL)
     {
-        _dt = 1.0f / _gyro->get_output_data_rate_hz();
-        _calibration_samples_count = 0;
-        _w_offset[0] = 0.0f;
-        _w_offset[1] = 0.0f;
-        _w_offset[2] = 0.0f;
-        _drdy_int.rise(callback(&_calibrate_event, &Event<void()>::call));
-
-        _gyro->set_fifo_watermark(_block_size);
-        _gyro->clear_fifo();
-        _gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
-        _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
-        _drdy_int.enable_irq();
-        _sensor_queue.dispatch(calibration_time * 1000);
-        _drdy_int.disable_irq();
-        _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
-
-        if (_calibration_samples_count) {
-            for (int i = 0; i < 3; i++) {
-                _w_offset[i] /= _calibration_samples_count;
-                _w_offset[i] = -_w_offset[i];
-            }
+        _sensitivity = _gyro->get_sensitivity();
+        _integrator.set_sample_rate(_gyro->get_output_data_rate_hz());
+        // block size should be multiple of 4 samples
+        _integrator.set_coning_mode(OrientationIntegrator::CONING_4_SAMPLE);
+        _integrator.reset();
+        _bias_estimator.reset();
+        _bias_model.reset();
+        float odr_hz = 0.0f;
+        if (calibration != NULL) {
+            _bias_estimator.set_bias(calibration->bias);
+            _bias_model.learn(calibration->temperature, calibration->bias);
+            odr_hz = calibration->odr_hz;
         }
-    }
-
-    void start_async()
-    {
-        _dt = 1.0f / _gyro->get_output_data_rate_hz();
-        _gyro->set_fifo_watermark(_block_size);
-        _gyro->clear_fifo();
-        _gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
-        _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
-        _drdy_int.enable_irq();
+        _calibration.full_scale = _gyro->get_full_scale();
+        _calibration.odr = _gyro->get_output_data_rate();
+        _stationary_window_count = 0;
 
         // start quaternion
         q[0] = 1.0f;
@@ -93,9 +83,11 @@ public:
         q[2] = 0.0f;
         q[3] = 0.0f;
 
-        // run processing thread
-        _drdy_int.rise(callback(&_process_block_event, &Event<void()>::call));
-        _sensor_thread.start(callback(&_sensor_queue, &EventQueue::dispatch_forever));
+        // run acquisition thread, that reads FIFO on watermark interrupt and invokes block processing
+        int err = _stream.start(_block_size, callback(this, &GyroProcessor::_process_block), odr_hz);
+        if (err) {
+            MBED_ERROR(MBED_ERROR_INITIALIZATION_FAILED, "Gyroscope stream start failed");
+        }
     }
 
     /**
@@ -114,125 +106,69 @@ public:
         _quaternion_to_roration(current_q, angle_ptr, vec);
     }
 
+    /**
+     * Get current calibration.
+     *
+     * @param calibration
+     * @return number of stationary windows, that are used for bias estimation
+     */
+    int get_calibration(CalibrationStore::Calibration *calibration)
+    {
+        _mutex.lock();
+        *calibration = _calibration;
+        int stationary_window_count = _stationary_window_count;
+        _mutex.unlock();
+        return stationary_window_count;
+    }
+
 private:
     L3GD20Gyroscope *_gyro;
-    InterruptIn _drdy_int;
+    GyroStream _stream;
     DigitalOut _indicator_out;
 
     int _block_size;
-    float _dt;
+    float _sensitivity;
     Mutex _mutex;
 
-    EventQueue _sensor_queue;
-    Thread _sensor_thread;
-
-    Event<void()> _calibrate_event;
-    Event<void()> _process_block_event;
+    OrientationIntegrator _integrator;
+    BiasEstimator _bias_estimator;
+    TemperatureBiasModel _bias_model;
 
     // quaternion that describe current rotation
     float q[4];
+    // current calibration
+    CalibrationStore::Calibration _calibration;
+    int _stationary_window_count;
 
-    // calibration constains
-    float _w_offset[3];
-    int _calibration_samples_count;
-
-    void _calibrate_callback()
-    {
-        // disable drdy irq to prevent accident interrupt during FIFO reading
-        _drdy_int.disable_irq();
-        float w[3];
-
-        for (int i = 0; i < _block_size; i++) {
-            // read data
-            _gyro->read_data(w);
-
-            // accumulate offset
-            _w_offset[0] += w[0];
-            _w_offset[1] += w[1];
-            _w_offset[2] += w[2];
-
-            _calibration_samples_count++;
-        }
-        _drdy_int.enable_irq();
-    }
-
-    void _process_block()
+    void _process_block(const GyroStream::Block &block)
     {
-        // disable drdy irq to prevent accident interrupt during FIFO reading
-        _drdy_int.disable_irq();
         _indicator_out = !_indicator_out;
-        float w[3];
-        float angle;
-        float delta_q[4];
-        float current_q[4];
-        memcpy(current_q, q, sizeof(float) * 4);
-
-        for (int i = 0; i < _block_size; i++) {
-            // read data
-            _gyro->read_data(w);
-
-            // compensate offset
-            w[0] += _w_offset[0];
-            w[1] += _w_offset[1];
-            w[2] += _w_offset[2];
-
-            // get rotation quaternion from current gyroscope data
-            // notes:
-            //  - we assumes, that (w[0] * dt, w[1] * dt, w[2] * dt)
-            //    represents Euler angles and using simplified formula,
-            //    convert them into quaternion form
-            //  - due small angles, the Euler angles rotation order isn't important
-            angle = sqrtf(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]) * _dt;
-            _roration_to_quaternion(angle, w, delta_q);
-            // integrate
-            _prodution_quaterniona(current_q, delta_q, current_q);
-            // normalize quaternion
-            _normalize_quaternion(current_q);
+        // the sample period is measured by the stream timestamper
+        _integrator.set_sample_rate(block.odr_hz);
+
+        // learn bias at the current temperature, if device is motionless
+        float bias[3];
+        if (_bias_estimator.update(block.samples, block.n_samples, _sensitivity)) {
+            _bias_estimator.get_window_mean(bias);
+            _bias_model.learn(block.temperature, bias);
         }
+        if (!_bias_model.get_bias(block.temperature, bias)) {
+            _bias_estimator.get_bias(bias);
+        }
+        // integrate raw samples with bias compensation
+        _integrator.update(block.samples, block.n_samples, _sensitivity, bias);
         _indicator_out = !_indicator_out;
-        _drdy_int.enable_irq();
 
         // update quaternion value
         _mutex.lock();
-        memcpy(q, current_q, sizeof(float) * 4);
+        _integrator.get_quaternion(q);
+        _bias_estimator.get_bias(_calibration.bias);
+        _calibration.temperature = block.temperature;
+        _calibration.odr_hz = block.odr_hz;
+        _stationary_window_count = _bias_estimator.get_stationary_window_count();
         _mutex.unlock();
     }
 
-    /**
-     * Calculate quaternion production.
-     *
-     * out = p * q
-     *
-     * @param p
-     * @param q
-     * @param out
-     */
-    void _prodution_quaterniona(const float p[4], const float q[4], float out[4])
-    {
-        float ow = p[0] * q[0] - p[1] * q[1] - p[2] * q[2] - p[3] * q[3];
-        float ox = p[0] * q[1] + p[1] * q[0] + p[2] * q[3] - p[3] * q[2];
-        float oy = p[0] * q[2] - p[1] * q[3] + p[2] * q[0] + p[3] * q[1];
-        float oz = p[0] * q[3] + p[1] * q[2] - p[2] * q[1] + p[3] * q[0];
-        out[0] = ow;
-        out[1] = ox;
-        out[2] = oy;
-        out[3] = oz;
-    }
-
-    /**
-     * Normalize quaternion.
-     *
-     * @param p
-     */
-    void _normalize_quaternion(float q[4])
-    {
-        float k = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
-        q[0] *= k;
-        q[1] *= k;
-        q[2] *= k;
-        q[3] *= k;
-    }
-
     /**
      * Convert quaternion to rotation axis and angle.
      *
@@ -258,35 +194,6 @@ private:
 
         *angle_ptr = 2 * half_angle;
     }
-    /**
-     * Convert rotation to quaternion.
-     *
-     * @param angle
-     * @param r
-     * @param q
-     */
-    void _roration_to_quaternion(const float angle, const float r[3], float q[4])
-    {
-        float half_angle = angle / 2;
-        float norm_k = 1.0f / sqrtf(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
-        float norm_r[3];
-        for (int i = 0; i < 3; i++) {
-            float r_a = r[i] * norm_k;
-            if (!(r_a > -1)) {
-                r_a = -1;
-            }
-            if (!(r_a < 1)) {
-                r_a = 1;
-            }
-            norm_r[i] = r_a;
-        }
-        // calculate quaternion
-        float sin_half_angle = sinf(half_angle);
-        q[0] = cosf(half_angle);
-        q[1] = sin_half_angle * norm_r[0];
-        q[2] = sin_half_angle * norm_r[1];
-        q[3] = sin_half_angle * norm_r[2];
-    }
 };
 
 DigitalOut led(LED2);
@@ -364,11 +271,28 @@ int main()
     // create helper object to read and process gyroscope data
     int block_size = 24;
     GyroProcessor gyro_processor(&gyroscope, block_size, L3GD20_SPI_INT2, LED5);
-    // run calibration
+    // skip noisy data after device enabling
     ThisThread::sleep_for(100ms);
-    gyro_processor.calibrate(0.9f);
-    // run data processing
+
+#if COMPONENT_FLASHIAP
+    // use the last flash sector to store calibration (it shouldn't be used by application image)
+    FlashIAP flash;
+    flash.init();
+    uint32_t flash_end = flash.get_flash_start() + flash.get_flash_size();
+    uint32_t sector_size = flash.get_sector_size(flash_end - 1);
+    flash.deinit();
+    FlashIAPBlockDevice block_device(flash_end - sector_size, sector_size);
+    block_device.init();
+    CalibrationStore calibration_store(&block_device);
+    CalibrationStore::Calibration calibration;
+    bool calibration_saved = false;
+    err = calibration_store.load(&calibration, gyroscope.get_full_scale(), gyroscope.get_output_data_rate());
+    // run data processing (bias is estimated on the fly, so the device can be moved)
+    gyro_processor.start_async(err ? NULL : &calibration);
+#else
+    // run data processing (bias is estimated on the fly, so the device can be moved)
     gyro_processor.start_async();
+#endif
 
     // rotation data
     float angle;
@@ -390,5 +314,13 @@ int main()
         ThisThread::sleep_for(16ms);
         led = !led;
         ThisThread::sleep_for(16ms);
+
+#if COMPONENT_FLASHIAP
+        // save calibration once per boot to limit flash wear
+        if (!calibration_saved && gyro_processor.get_calibration(&calibration) >= BiasEstimator::AVERAGING_WINDOWS) {
+            calibration_store.save(calibration);
+            calibration_saved = true;
+        }
+#endif
     }
 }
@@ -0,0 +1,76 @@
+/**
+ * Example of the L3GD20 usage with STM32F3Discovery board.
+ *
+ * Asynchronous FIFO reading.
+ *
+ * FIFO blocks are read from the watermark interrupt without any thread, and
+ * processed results are passed to the main thread.
+ */
+#include "l3gd20_async_reader.h"
+#include "l3gd20_driver.h"
+#include "math.h"
+#include "mbed.h"
+
+/**
+ * Pin map:
+ *
+ * - L3GD20_SPI_MOSI_PIN - SPI MOSI of the L3GD20
+ * - L3GD20_SPI_MISO_PIN - SPI MISO of the L3GD20
+ * - L3GD20_SPI_SCLK_PIN - SPI SCLK of the L3GD20
+ * - L3GD20_SPI_SSEL_PIN - SPI SSEL of the L3GD20
+ * - L3GD20_SPI_INT2 - INT2 pin of the L3GD20
+ */
+#define L3GD20_SPI_MOSI_PIN PA_7
+#define L3GD20_SPI_MISO_PIN PA_6
+#define L3GD20_SPI_SCLK_PIN PA_5
+#define L3GD20_SPI_SSEL_PIN PE_3
+#define L3GD20_SPI_INT2 PE_1
+
+DigitalOut led(LED2);
+
+// accumulated angles (rad)
+static volatile float angles[3];
+static volatile int blocks_count;
+static float dt;
+static float sensitivity;
+
+void process_block(const int16_t (*samples)[3], int n)
+{
+    // note: this function is invoked from an ISR context
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) {
+            angles[j] += samples[i][j] * sensitivity * dt;
+        }
+    }
+    blocks_count++;
+}
+
+int main()
+{
+    // create separate spi instance
+    SPI spi(L3GD20_SPI_MOSI_PIN, L3GD20_SPI_MISO_PIN, L3GD20_SPI_SCLK_PIN);
+    spi.frequency(10000000);
+    L3GD20Gyroscope gyroscope(&spi, L3GD20_SPI_SSEL_PIN);
+    // initialize device
+    int err = gyroscope.init();
+    if (err) {
+        MBED_ERROR(MBED_ERROR_INITIALIZATION_FAILED, "Gyroscope initialization failed");
+    }
+    gyroscope.set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    dt = 1.0f / gyroscope.get_output_data_rate_hz();
+    sensitivity = gyroscope.get_sensitivity();
+
+    // run asynchronous reading
+    AsyncFifoReader reader(&gyroscope, L3GD20_SPI_INT2);
+    err = reader.start(24, process_block);
+    if (err) {
+        MBED_ERROR(MBED_ERROR_INITIALIZATION_FAILED, "Asynchronous reading start failed");
+    }
+
+    while (true) {
+        printf("blocks: %05d | x: %+7.2f deg, y: %+7.2f deg, z: %+7.2f deg\n", blocks_count,
+               angles[0] * 57.3f, angles[1] * 57.3f, angles[2] * 57.3f);
+        led = !led;
+        ThisThread::sleep_for(100ms);
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * Mbed OS BlockDevice interface shim for host (Linux) builds.
+ */
+#ifndef MBED_HOST_SHIM_BLOCK_DEVICE_H
+#define MBED_HOST_SHIM_BLOCK_DEVICE_H
+
+#include "mbed.h"
+
+namespace mbed {
+
+typedef uint64_t bd_addr_t;
+typedef uint64_t bd_size_t;
+
+enum bd_error {
+    BD_ERROR_OK = 0,
+    BD_ERROR_DEVICE_ERROR = -4001
+};
+
+class BlockDevice {
+public:
+    virtual ~BlockDevice()
+    {
+    }
+
+    virtual int init() = 0;
+    virtual int deinit() = 0;
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size) = 0;
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size) = 0;
+
+    virtual int erase(bd_addr_t addr, bd_size_t size)
+    {
+        return 0;
+    }
+
+    virtual bd_size_t get_read_size() const = 0;
+    virtual bd_size_t get_program_size() const = 0;
+
+    virtual bd_size_t get_erase_size() const
+    {
+        return get_program_size();
+    }
+
+    virtual bd_size_t get_erase_size(bd_addr_t addr) const
+    {
+        return get_erase_size();
+    }
+
+    virtual int get_erase_value() const
+    {
+        return -1;
+    }
+
+    virtual bd_size_t size() const = 0;
+
+    bool is_valid_read(bd_addr_t addr, bd_size_t size) const
+    {
+        return addr % get_read_size() == 0 && size % get_read_size() == 0 && addr + size <= this->size();
+    }
+
+    bool is_valid_program(bd_addr_t addr, bd_size_t size) const
+    {
+        return addr % get_program_size() == 0 && size % get_program_size() == 0 && addr + size <= this->size();
+    }
+
+    bool is_valid_erase(bd_addr_t addr, bd_size_t size) const
+    {
+        return addr % get_erase_size(addr) == 0 && (addr + size) % get_erase_size(addr + size - 1) == 0 && addr + size <= this->size();
+    }
+};
+}
+
+#endif // MBED_HOST_SHIM_BLOCK_DEVICE_H
@@ -0,0 +1,103 @@
+/**
+ * Mbed OS HeapBlockDevice shim for host (Linux) builds.
+ *
+ * Like the original one, it has undefined erase value: erase doesn't modify content,
+ * and never programmed areas are read as zeros.
+ */
+#ifndef MBED_HOST_SHIM_HEAP_BLOCK_DEVICE_H
+#define MBED_HOST_SHIM_HEAP_BLOCK_DEVICE_H
+
+#include "blockdevice/BlockDevice.h"
+#include <vector>
+
+namespace mbed {
+
+class HeapBlockDevice : public BlockDevice {
+public:
+    HeapBlockDevice(bd_size_t size, bd_size_t block = 512)
+        : HeapBlockDevice(size, block, block, block)
+    {
+    }
+
+    HeapBlockDevice(bd_size_t size, bd_size_t read, bd_size_t program, bd_size_t erase)
+        : _read_size(read)
+        , _program_size(program)
+        , _erase_size(erase)
+        , _size(size)
+        , _init_ref_count(0)
+    {
+    }
+
+    virtual int init()
+    {
+        if (_init_ref_count++ == 0) {
+            _data.assign(_size, 0);
+        }
+        return BD_ERROR_OK;
+    }
+
+    virtual int deinit()
+    {
+        if (_init_ref_count > 0) {
+            _init_ref_count--;
+        }
+        return BD_ERROR_OK;
+    }
+
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (!_init_ref_count || !is_valid_read(addr, size)) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        memcpy(buffer, _data.data() + addr, size);
+        return BD_ERROR_OK;
+    }
+
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (!_init_ref_count || !is_valid_program(addr, size)) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        memcpy(_data.data() + addr, buffer, size);
+        return BD_ERROR_OK;
+    }
+
+    virtual int erase(bd_addr_t addr, bd_size_t size)
+    {
+        if (!_init_ref_count || !is_valid_erase(addr, size)) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        return BD_ERROR_OK;
+    }
+
+    virtual bd_size_t get_read_size() const
+    {
+        return _read_size;
+    }
+
+    virtual bd_size_t get_program_size() const
+    {
+        return _program_size;
+    }
+
+    virtual bd_size_t get_erase_size() const
+    {
+        return _erase_size;
+    }
+
+    virtual bd_size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    bd_size_t _read_size;
+    bd_size_t _program_size;
+    bd_size_t _erase_size;
+    bd_size_t _size;
+    int _init_ref_count;
+    std::vector<uint8_t> _data;
+};
+}
+
+#endif // MBED_HOST_SHIM_HEAP_BLOCK_DEVICE_H
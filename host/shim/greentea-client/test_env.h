@@ -0,0 +1,9 @@
+#ifndef MBED_HOST_GREENTEA_TEST_ENV_H
+#define MBED_HOST_GREENTEA_TEST_ENV_H
+
+/**
+ * Host tests don't use greentea host side, so setup only prints test name.
+ */
+#define GREENTEA_SETUP(timeout, host_test) printf("{{__testcase_setup;%s;%d}}\n", (host_test), (int)(timeout))
+
+#endif // MBED_HOST_GREENTEA_TEST_ENV_H
@@ -0,0 +1,724 @@
+/**
+ * Minimal Mbed OS API shim for host (Linux) builds.
+ *
+ * It provides only the API subset that is used by the driver, its tests and examples.
+ * Peripherals are connected to simulated devices (see mbed_host namespace):
+ *
+ * - SPI bytes are routed to the SPI slaves, whose ssel pin is low;
+ * - I2C transactions are routed to the I2C slaves by address;
+ * - InterruptIn reads pin levels from the pin sources;
+ * - LowPowerTimeout callbacks are invoked with the time step resolution.
+ *
+ * Time is simulated: it's advanced by ThisThread::sleep_for, wait_us and mbed_host::advance_time_us only.
+ * Pin interrupts and shared event queue are processed during time advancing. Asynchronous transfers
+ * exchange data immediately, but their callbacks are invoked from the next event processing step.
+ *
+ * Threads are cooperative: Thread::start invokes the thread function immediately, so it should return.
+ * The supported thread function is EventQueue::dispatch_forever, that registers the queue for dispatching
+ * during time advancing in the context of the thread.
+ */
+#ifndef MBED_HOST_SHIM_H
+#define MBED_HOST_SHIM_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// host build marker, so tests can select host specific code (e.g. CPU time measurement)
+#define MBED_HOST 1
+
+/*
+ * Pins
+ */
+
+typedef enum {
+    PA_0 = 0x00, PA_1, PA_2, PA_3, PA_4, PA_5, PA_6, PA_7,
+    PA_8, PA_9, PA_10, PA_11, PA_12, PA_13, PA_14, PA_15,
+    PB_0 = 0x10, PB_1, PB_2, PB_3, PB_4, PB_5, PB_6, PB_7,
+    PB_8, PB_9, PB_10, PB_11, PB_12, PB_13, PB_14, PB_15,
+    PC_0 = 0x20, PC_1, PC_2, PC_3, PC_4, PC_5, PC_6, PC_7,
+    PC_8, PC_9, PC_10, PC_11, PC_12, PC_13, PC_14, PC_15,
+    PD_0 = 0x30, PD_1, PD_2, PD_3, PD_4, PD_5, PD_6, PD_7,
+    PD_8, PD_9, PD_10, PD_11, PD_12, PD_13, PD_14, PD_15,
+    PE_0 = 0x40, PE_1, PE_2, PE_3, PE_4, PE_5, PE_6, PE_7,
+    PE_8, PE_9, PE_10, PE_11, PE_12, PE_13, PE_14, PE_15,
+    PIN_COUNT,
+    NC = -1
+} PinName;
+
+/*
+ * Errors
+ */
+
+#define MBED_SUCCESS 0
+#define MBED_ERROR_CODE_UNKNOWN 1
+#define MBED_ERROR_CODE_INVALID_ARGUMENT 2
+#define MBED_ERROR_CODE_INITIALIZATION_FAILED 3
+#define MBED_ERROR_CODE_READ_FAILED 4
+#define MBED_ERROR_CODE_WRITE_FAILED 5
+#define MBED_ERROR_CODE_UNSUPPORTED 6
+#define MBED_ERROR_CODE_EBUSY 7
+#define MBED_ERROR_CODE_ENOMEM 8
+#define MBED_ERROR_CODE_TIME_OUT 9
+#define MBED_ERROR_CODE_ALREADY_INITIALIZED 10
+#define MBED_ERROR_CODE_ITEM_NOT_FOUND 11
+#define MBED_ERROR_CODE_INVALID_DATA_DETECTED 12
+#define MBED_ERROR_CODE_INVALID_SIZE 13
+#define MBED_ERROR_CODE_INVALID_FORMAT 14
+
+#define MBED_MODULE_UNKNOWN 0
+#define MBED_MODULE_DRIVER 1
+#define MBED_MODULE_DRIVER_SPI 2
+#define MBED_MODULE_DRIVER_I2C 3
+
+#define MBED_MAKE_ERROR(module, error_code) (-(((module) << 16) | (error_code)))
+#define MBED_ERROR_UNKNOWN MBED_MAKE_ERROR(MBED_MODULE_UNKNOWN, MBED_ERROR_CODE_UNKNOWN)
+#define MBED_ERROR_INVALID_ARGUMENT MBED_MAKE_ERROR(MBED_MODULE_UNKNOWN, MBED_ERROR_CODE_INVALID_ARGUMENT)
+#define MBED_ERROR_INITIALIZATION_FAILED MBED_MAKE_ERROR(MBED_MODULE_UNKNOWN, MBED_ERROR_CODE_INITIALIZATION_FAILED)
+#define MBED_ERROR_UNSUPPORTED MBED_MAKE_ERROR(MBED_MODULE_UNKNOWN, MBED_ERROR_CODE_UNSUPPORTED)
+
+#define MBED_ERROR(error_status, error_msg) mbed_host::fatal_error((error_status), (error_msg), __FILE__, __LINE__)
+#define MBED_ASSERT(expr) ((expr) ? (void)0 : mbed_host::fatal_error(MBED_ERROR_UNKNOWN, "assertion failed: " #expr, __FILE__, __LINE__))
+#define MBED_STATIC_ASSERT(expr, msg) static_assert(expr, msg)
+#define MBED_ALIGN(N) __attribute__((aligned(N)))
+#define MBED_FORCEINLINE inline __attribute__((always_inline))
+#define MBED_UNUSED __attribute__((unused))
+
+/*
+ * Asynchronous API support
+ */
+
+#define DEVICE_SPI_ASYNCH 1
+#define DEVICE_I2C_ASYNCH 1
+
+#define SPI_EVENT_ERROR (1 << 1)
+#define SPI_EVENT_COMPLETE (1 << 2)
+#define SPI_EVENT_RX_OVERFLOW (1 << 3)
+#define SPI_EVENT_ALL (SPI_EVENT_ERROR | SPI_EVENT_COMPLETE | SPI_EVENT_RX_OVERFLOW)
+
+#define I2C_EVENT_ERROR (1 << 1)
+#define I2C_EVENT_ERROR_NO_SLAVE (1 << 2)
+#define I2C_EVENT_TRANSFER_COMPLETE (1 << 3)
+#define I2C_EVENT_TRANSFER_EARLY_NACK (1 << 4)
+#define I2C_EVENT_ALL (I2C_EVENT_ERROR | I2C_EVENT_TRANSFER_COMPLETE | I2C_EVENT_ERROR_NO_SLAVE | I2C_EVENT_TRANSFER_EARLY_NACK)
+
+/*
+ * Critical section
+ *
+ * Host simulation is single threaded, so critical sections do nothing.
+ */
+
+inline void core_util_critical_section_enter()
+{
+}
+
+inline void core_util_critical_section_exit()
+{
+}
+
+namespace mbed {
+
+/*
+ * Utilities
+ */
+
+template <typename T>
+class NonCopyable {
+protected:
+    NonCopyable()
+    {
+    }
+    ~NonCopyable()
+    {
+    }
+
+private:
+    NonCopyable(const NonCopyable &);
+    NonCopyable &operator=(const NonCopyable &);
+};
+
+template <typename F>
+class Callback;
+
+/**
+ * Callback class based on std::function.
+ */
+template <typename R, typename... ArgTs>
+class Callback<R(ArgTs...)> {
+public:
+    Callback()
+    {
+    }
+
+    Callback(std::nullptr_t)
+    {
+    }
+
+    template <typename F>
+    Callback(F f)
+        : _func(f)
+    {
+    }
+
+    template <typename T, typename U>
+    Callback(U *obj, R (T::*method)(ArgTs...))
+        : _func([obj, method](ArgTs... args) -> R { return (obj->*method)(args...); })
+    {
+    }
+
+    template <typename T, typename U>
+    Callback(const U *obj, R (T::*method)(ArgTs...) const)
+        : _func([obj, method](ArgTs... args) -> R { return (obj->*method)(args...); })
+    {
+    }
+
+    R call(ArgTs... args) const
+    {
+        return _func(args...);
+    }
+
+    R operator()(ArgTs... args) const
+    {
+        return _func(args...);
+    }
+
+    explicit operator bool() const
+    {
+        return (bool)_func;
+    }
+
+private:
+    std::function<R(ArgTs...)> _func;
+};
+
+template <typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(R (*func)(ArgTs...))
+{
+    return Callback<R(ArgTs...)>(func);
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(U *obj, R (T::*method)(ArgTs...))
+{
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(const U *obj, R (T::*method)(ArgTs...) const)
+{
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+typedef Callback<void(int)> event_callback_t;
+
+/*
+ * Peripherals
+ */
+
+class DigitalOut {
+public:
+    DigitalOut(PinName pin, int value = 0);
+    void write(int value);
+    int read();
+    DigitalOut &operator=(int value)
+    {
+        write(value);
+        return *this;
+    }
+    operator int()
+    {
+        return read();
+    }
+
+private:
+    PinName _pin;
+};
+
+class DigitalIn {
+public:
+    DigitalIn(PinName pin);
+    int read();
+    operator int()
+    {
+        return read();
+    }
+
+private:
+    PinName _pin;
+};
+
+class InterruptIn : private NonCopyable<InterruptIn> {
+public:
+    InterruptIn(PinName pin);
+    ~InterruptIn();
+    int read();
+    operator int()
+    {
+        return read();
+    }
+    void rise(Callback<void()> func);
+    void fall(Callback<void()> func);
+    void enable_irq();
+    void disable_irq();
+
+    /**
+     * Check pin level and invoke edge handlers (host simulation only).
+     */
+    void process();
+
+private:
+    PinName _pin;
+    Callback<void()> _rise;
+    Callback<void()> _fall;
+    bool _irq_enabled;
+    int _level;
+};
+
+class SPI : private NonCopyable<SPI> {
+public:
+    SPI(PinName mosi, PinName miso, PinName sclk, PinName ssel = NC);
+    ~SPI();
+    void format(int bits, int mode = 0);
+    void frequency(int hz = 1000000);
+    int write(int value);
+    int write(const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length);
+    void set_default_write_value(char data);
+    void lock();
+    void unlock();
+
+    template <typename Type>
+    int transfer(const Type *tx_buffer, int tx_length, Type *rx_buffer, int rx_length,
+                 const event_callback_t &callback, int event = SPI_EVENT_COMPLETE)
+    {
+        return _transfer((const char *)tx_buffer, tx_length, (char *)rx_buffer, rx_length, callback, event);
+    }
+
+    /**
+     * Abort asynchronous transfer, so its callback isn't invoked.
+     */
+    void abort_transfer();
+
+    int get_frequency()
+    {
+        return _hz;
+    }
+
+private:
+    int _hz;
+    char _write_fill;
+    int _transfer(const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length,
+                  const event_callback_t &callback, int event);
+};
+
+class I2C : private NonCopyable<I2C> {
+public:
+    I2C(PinName sda, PinName scl);
+    ~I2C();
+    void frequency(int hz);
+    int read(int address, char *data, int length, bool repeated = false);
+    int write(int address, const char *data, int length, bool repeated = false);
+    int transfer(int address, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length,
+                 const event_callback_t &callback, int event = I2C_EVENT_TRANSFER_COMPLETE, bool repeated = false);
+    /**
+     * Abort asynchronous transfer, so its callback isn't invoked.
+     */
+    void abort_transaction();
+    void lock();
+    void unlock();
+};
+
+/*
+ * Events
+ */
+
+template <typename F>
+class Event;
+
+class EventQueue : private NonCopyable<EventQueue> {
+public:
+    EventQueue();
+    ~EventQueue();
+
+    /**
+     * Post callback to the queue.
+     *
+     * @return event id
+     */
+    int call(Callback<void()> func);
+
+    /**
+     * Cancel posted callback.
+     *
+     * @param id event id
+     * @return true if the callback has been cancelled before dispatching
+     */
+    bool cancel(int id);
+
+    template <typename F>
+    Event<F> event(Callback<F> func)
+    {
+        return Event<F>(this, func);
+    }
+
+    /**
+     * Register the queue for dispatching during time advancing in the context of the current thread.
+     *
+     * Unlike Mbed OS, it returns immediately.
+     */
+    void dispatch_forever();
+
+    /**
+     * Unregister the queue, that is dispatched with dispatch_forever.
+     */
+    void break_dispatch();
+
+    /**
+     * Dispatch all posted events (host simulation only).
+     */
+    void dispatch_posted();
+
+    /**
+     * Get number of posted, but not dispatched events (host simulation only).
+     */
+    int get_posted_count();
+
+private:
+    std::deque<std::pair<int, Callback<void()> > > _events;
+    int _last_id;
+};
+
+template <>
+class Event<void()> {
+public:
+    Event(EventQueue *queue, Callback<void()> func)
+        : _queue(queue)
+        , _func(func)
+        , _id(0)
+    {
+    }
+
+    int call()
+    {
+        _id = _queue->call(_func);
+        return _id;
+    }
+
+    int post()
+    {
+        return call();
+    }
+
+    /**
+     * Cancel the last posted event.
+     */
+    void cancel()
+    {
+        if (_id) {
+            _queue->cancel(_id);
+        }
+    }
+
+private:
+    EventQueue *_queue;
+    Callback<void()> _func;
+    int _id;
+};
+
+/**
+ * Shared event queue. It's dispatched during time advancing.
+ */
+EventQueue *mbed_event_queue();
+
+/*
+ * Time
+ */
+
+void wait_us(int us);
+
+class Timer : private NonCopyable<Timer> {
+public:
+    Timer();
+    void start();
+    void stop();
+    void reset();
+    std::chrono::microseconds elapsed_time() const;
+
+private:
+    bool _running;
+    uint64_t _start_us;
+    uint64_t _elapsed_us;
+};
+
+/**
+ * Low power timer. It's the same as Timer in host simulation.
+ */
+class LowPowerTimer : public Timer {
+};
+
+/**
+ * Low power timeout. The callback is invoked from the interrupt context during time advancing.
+ */
+class LowPowerTimeout : private NonCopyable<LowPowerTimeout> {
+public:
+    LowPowerTimeout();
+    ~LowPowerTimeout();
+    void attach(Callback<void()> func, std::chrono::microseconds t);
+    void detach();
+
+    // host simulation only
+    void process();
+
+private:
+    Callback<void()> _func;
+    uint64_t _expiration_us;
+    bool _attached;
+};
+
+/*
+ * CRC
+ */
+
+enum crc_polynomial_t : uint32_t {
+    POLY_32BIT_ANSI = 0x04C11DB7
+};
+
+/**
+ * Software CRC calculation. Only reflected CRC-32 (POLY_32BIT_ANSI) is supported.
+ */
+template <uint32_t polynomial = POLY_32BIT_ANSI, int width = 32>
+class MbedCRC {
+public:
+    MBED_STATIC_ASSERT(polynomial == POLY_32BIT_ANSI && width == 32, "Only 32-bit ANSI CRC is supported");
+
+    int32_t compute(const void *buffer, size_t size, uint32_t *crc)
+    {
+        const uint8_t *data = (const uint8_t *)buffer;
+        uint32_t value = 0xFFFFFFFF;
+        for (size_t i = 0; i < size; i++) {
+            value ^= data[i];
+            for (int j = 0; j < 8; j++) {
+                value = (value >> 1) ^ (0xEDB88320 & (0 - (value & 1)));
+            }
+        }
+        *crc = ~value;
+        return 0;
+    }
+};
+}
+
+/*
+ * RTOS
+ */
+
+typedef enum {
+    osPriorityIdle = 1,
+    osPriorityLow = 8,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh = 40,
+    osPriorityHigh7 = 47,
+    osPriorityRealtime = 48
+} osPriority;
+
+typedef int32_t osStatus;
+#define osOK 0
+#define osError -1
+#define osErrorParameter -4
+
+typedef void *osThreadId_t;
+
+#define OS_STACK_SIZE 4096
+
+namespace rtos {
+
+/**
+ * Cooperative thread (see the file description).
+ */
+class Thread : private mbed::NonCopyable<Thread> {
+public:
+    Thread(osPriority priority = osPriorityNormal, uint32_t stack_size = OS_STACK_SIZE,
+           unsigned char *stack_mem = nullptr, const char *name = nullptr);
+    osStatus start(mbed::Callback<void()> task);
+    osStatus join();
+    osThreadId_t get_id() const;
+    osPriority get_priority() const;
+    uint32_t stack_size() const;
+    const char *get_name() const;
+
+private:
+    osPriority _priority;
+    uint32_t _stack_size;
+    const char *_name;
+    bool _started;
+};
+
+/**
+ * Mutex. Host simulation is single threaded, so it does nothing.
+ */
+class Mutex : private mbed::NonCopyable<Mutex> {
+public:
+    void lock()
+    {
+    }
+    bool trylock()
+    {
+        return true;
+    }
+    void unlock()
+    {
+    }
+};
+
+/**
+ * Counting semaphore. Acquiring of the unavailable semaphore advances time, until it's released
+ * by an interrupt or dispatched event.
+ */
+class Semaphore : private mbed::NonCopyable<Semaphore> {
+public:
+    Semaphore(int32_t count = 0);
+    void acquire();
+    osStatus release();
+
+private:
+    int32_t _count;
+};
+
+struct Kernel {
+    struct Clock {
+        typedef std::chrono::milliseconds duration;
+        typedef duration::rep rep;
+        typedef duration::period period;
+        typedef std::chrono::time_point<Clock> time_point;
+        static const bool is_steady = true;
+        static time_point now();
+    };
+};
+
+namespace ThisThread {
+    void sleep_for(std::chrono::milliseconds duration);
+    osThreadId_t get_id();
+}
+}
+
+/**
+ * Host simulation control.
+ */
+namespace mbed_host {
+
+/**
+ * SPI slave device interface.
+ */
+class SpiSlave {
+public:
+    virtual ~SpiSlave()
+    {
+    }
+    virtual void spi_select() = 0;
+    virtual uint8_t spi_transfer(uint8_t mosi) = 0;
+    virtual void spi_deselect() = 0;
+};
+
+/**
+ * I2C slave device interface.
+ */
+class I2cSlave {
+public:
+    virtual ~I2cSlave()
+    {
+    }
+    /**
+     * Write transaction.
+     *
+     * @return true if data is acknowledged.
+     */
+    virtual bool i2c_write(const uint8_t *data, int length) = 0;
+    /**
+     * Read transaction.
+     *
+     * @return true if device is acknowledged.
+     */
+    virtual bool i2c_read(uint8_t *data, int length) = 0;
+};
+
+/**
+ * Connect SPI slave with ssel pin \p ssel.
+ */
+void attach_spi_slave(PinName ssel, SpiSlave *slave);
+
+/**
+ * Connect I2C slave with (8-bit) address \p address.
+ */
+void attach_i2c_slave(int address, I2cSlave *slave);
+
+/**
+ * Disconnect SPI/I2C slave.
+ */
+void detach_slave(void *slave);
+
+/**
+ * Connect pin level source, like an interrupt output of the simulated device.
+ */
+void set_pin_source(PinName pin, mbed::Callback<int()> source);
+
+/**
+ * Get current pin level.
+ */
+int get_pin_level(PinName pin);
+
+/**
+ * Get simulated time in microseconds.
+ */
+uint64_t get_time_us();
+
+/**
+ * Advance simulated time.
+ *
+ * Pin interrupts and shared event queue are processed with mbed_host::set_time_step_us step.
+ */
+void advance_time_us(uint64_t us);
+
+/**
+ * Set time step of the simulation (default is 50 us).
+ */
+void set_time_step_us(uint32_t step_us);
+
+/**
+ * Process transfer completions, pin interrupts, shared event queue and thread queues without time advancing.
+ */
+void process_events();
+
+/**
+ * Invoke asynchronous transfer \p callback of the bus \p owner with \p event from the next process_events call
+ * like a transfer completion interrupt.
+ */
+void post_transfer_completion(const void *owner, const mbed::Callback<void(int)> &callback, int event);
+
+/**
+ * Drop pending transfer completion of the bus \p owner.
+ */
+void cancel_transfer_completion(const void *owner);
+
+/**
+ * Make the next \p count EventQueue::call invocations fail like on event memory exhaustion (they return 0).
+ */
+void fail_event_allocations(int count);
+
+/**
+ * Fatal error handler. It prints error and aborts process.
+ */
+[[noreturn]] void fatal_error(int error_status, const char *error_msg, const char *file, int line);
+}
+
+using namespace mbed;
+using namespace rtos;
+using namespace std;
+using namespace std::chrono_literals;
+
+#endif // MBED_HOST_SHIM_H
@@ -0,0 +1,717 @@
+#include "mbed.h"
+#include <algorithm>
+#include <vector>
+
+using namespace mbed;
+
+/*
+ * Simulation state
+ */
+
+namespace {
+
+// pending asynchronous transfer completion
+struct TransferCompletion {
+    uint32_t id;
+    const void *owner;
+    Callback<void(int)> callback;
+    int event;
+};
+
+struct SimulationState {
+    uint64_t time_us = 0;
+    uint32_t time_step_us = 50;
+    bool processing = false;
+    int pin_levels[PIN_COUNT] = {};
+    Callback<int()> pin_sources[PIN_COUNT];
+    std::vector<std::pair<PinName, mbed_host::SpiSlave *> > spi_slaves;
+    std::vector<std::pair<int, mbed_host::I2cSlave *> > i2c_slaves;
+    std::vector<InterruptIn *> interrupts;
+    std::vector<LowPowerTimeout *> timeouts;
+    std::vector<TransferCompletion> transfer_completions;
+    uint32_t next_transfer_completion_id = 0;
+    // queues, that are dispatched with EventQueue::dispatch_forever, and their threads
+    std::vector<std::pair<EventQueue *, osThreadId_t> > thread_queues;
+    osThreadId_t current_thread = nullptr;
+    // number of the next event allocations, that fail
+    int failed_event_allocations = 0;
+};
+
+SimulationState &state()
+{
+    static SimulationState sim_state;
+    return sim_state;
+}
+
+void set_pin_level(PinName pin, int value)
+{
+    if (pin == NC) {
+        return;
+    }
+    SimulationState &s = state();
+    int old_value = s.pin_levels[pin];
+    value = value ? 1 : 0;
+    s.pin_levels[pin] = value;
+    if (old_value == value) {
+        return;
+    }
+    for (auto &entry : s.spi_slaves) {
+        if (entry.first == pin) {
+            if (value) {
+                entry.second->spi_deselect();
+            } else {
+                entry.second->spi_select();
+            }
+        }
+    }
+}
+
+uint8_t spi_transfer_byte(uint8_t value)
+{
+    // all selected slaves receive byte, the response of the last one is used
+    uint8_t res = 0xFF;
+    for (auto &entry : state().spi_slaves) {
+        if (state().pin_levels[entry.first] == 0) {
+            res = entry.second->spi_transfer(value);
+        }
+    }
+    return res;
+}
+
+mbed_host::I2cSlave *find_i2c_slave(int address)
+{
+    for (auto &entry : state().i2c_slaves) {
+        if (entry.first == (address & 0xFE)) {
+            return entry.second;
+        }
+    }
+    return NULL;
+}
+}
+
+/*
+ * mbed_host
+ */
+
+void mbed_host::attach_spi_slave(PinName ssel, SpiSlave *slave)
+{
+    if (state().pin_levels[ssel] == 0) {
+        // ssel should be high by default
+        state().pin_levels[ssel] = 1;
+    }
+    state().spi_slaves.push_back(std::make_pair(ssel, slave));
+}
+
+void mbed_host::attach_i2c_slave(int address, I2cSlave *slave)
+{
+    state().i2c_slaves.push_back(std::make_pair(address & 0xFE, slave));
+}
+
+void mbed_host::detach_slave(void *slave)
+{
+    SimulationState &s = state();
+    s.spi_slaves.erase(std::remove_if(s.spi_slaves.begin(), s.spi_slaves.end(),
+                                      [slave](const std::pair<PinName, SpiSlave *> &entry) { return (void *)entry.second == slave; }),
+                       s.spi_slaves.end());
+    s.i2c_slaves.erase(std::remove_if(s.i2c_slaves.begin(), s.i2c_slaves.end(),
+                                      [slave](const std::pair<int, I2cSlave *> &entry) { return (void *)entry.second == slave; }),
+                       s.i2c_slaves.end());
+}
+
+void mbed_host::set_pin_source(PinName pin, Callback<int()> source)
+{
+    state().pin_sources[pin] = source;
+}
+
+int mbed_host::get_pin_level(PinName pin)
+{
+    if (pin == NC) {
+        return 0;
+    }
+    SimulationState &s = state();
+    if (s.pin_sources[pin]) {
+        return s.pin_sources[pin].call() ? 1 : 0;
+    }
+    return s.pin_levels[pin];
+}
+
+uint64_t mbed_host::get_time_us()
+{
+    return state().time_us;
+}
+
+void mbed_host::set_time_step_us(uint32_t step_us)
+{
+    state().time_step_us = step_us ? step_us : 1;
+}
+
+void mbed_host::post_transfer_completion(const void *owner, const Callback<void(int)> &callback, int event)
+{
+    SimulationState &s = state();
+    s.transfer_completions.push_back({s.next_transfer_completion_id++, owner, callback, event});
+}
+
+void mbed_host::cancel_transfer_completion(const void *owner)
+{
+    std::vector<TransferCompletion> &completions = state().transfer_completions;
+    completions.erase(std::remove_if(completions.begin(), completions.end(),
+                                     [owner](const TransferCompletion &completion) { return completion.owner == owner; }),
+                      completions.end());
+}
+
+void mbed_host::fail_event_allocations(int count)
+{
+    state().failed_event_allocations = count;
+}
+
+void mbed_host::process_events()
+{
+    SimulationState &s = state();
+    if (s.processing) {
+        // nested invocation from an event handler
+        return;
+    }
+    s.processing = true;
+    // note: transfers, that are started by the event handlers, are completed with the next invocation
+    uint32_t completion_id_end = s.next_transfer_completion_id;
+
+    // timeouts (the list can be changed by the callbacks)
+    std::vector<LowPowerTimeout *> timeouts = s.timeouts;
+    for (LowPowerTimeout *timeout : timeouts) {
+        if (std::find(s.timeouts.begin(), s.timeouts.end(), timeout) != s.timeouts.end()) {
+            timeout->process();
+        }
+    }
+    // pin interrupts
+    for (size_t i = 0; i < s.interrupts.size(); i++) {
+        s.interrupts[i]->process();
+    }
+    // transfer completions, that are posted before this invocation and aren't aborted
+    while (!s.transfer_completions.empty() && (int32_t)(s.transfer_completions.front().id - completion_id_end) < 0) {
+        TransferCompletion completion = s.transfer_completions.front();
+        s.transfer_completions.erase(s.transfer_completions.begin());
+        completion.callback.call(completion.event);
+    }
+    // shared event queue
+    mbed_event_queue()->dispatch_posted();
+    // thread queues (the list can be changed by the dispatched events)
+    std::vector<std::pair<EventQueue *, osThreadId_t> > thread_queues = s.thread_queues;
+    for (auto &entry : thread_queues) {
+        if (std::find(s.thread_queues.begin(), s.thread_queues.end(), entry) == s.thread_queues.end()) {
+            continue;
+        }
+        osThreadId_t caller_thread = s.current_thread;
+        s.current_thread = entry.second;
+        entry.first->dispatch_posted();
+        s.current_thread = caller_thread;
+    }
+    // pin interrupts again, so the pulses, that are produced by the event handlers within a time step
+    // (e.g. by interrupt source clearing), aren't lost like with hardware edge detection
+    for (size_t i = 0; i < s.interrupts.size(); i++) {
+        s.interrupts[i]->process();
+    }
+
+    s.processing = false;
+}
+
+void mbed_host::advance_time_us(uint64_t us)
+{
+    SimulationState &s = state();
+    uint64_t end_time = s.time_us + us;
+    process_events();
+    while (s.time_us < end_time) {
+        uint64_t step = std::min<uint64_t>(s.time_step_us, end_time - s.time_us);
+        s.time_us += step;
+        process_events();
+    }
+}
+
+void mbed_host::fatal_error(int error_status, const char *error_msg, const char *file, int line)
+{
+    fprintf(stderr, "\n++ MbedOS Error Info ++\nError Status: 0x%X\nLocation: %s:%d\nError Message: %s\n-- MbedOS Error Info --\n",
+            (unsigned)error_status, file, line, error_msg);
+    fflush(stderr);
+    abort();
+}
+
+/*
+ * DigitalOut/DigitalIn
+ */
+
+DigitalOut::DigitalOut(PinName pin, int value)
+    : _pin(pin)
+{
+    write(value);
+}
+
+void DigitalOut::write(int value)
+{
+    set_pin_level(_pin, value);
+}
+
+int DigitalOut::read()
+{
+    return mbed_host::get_pin_level(_pin);
+}
+
+DigitalIn::DigitalIn(PinName pin)
+    : _pin(pin)
+{
+}
+
+int DigitalIn::read()
+{
+    return mbed_host::get_pin_level(_pin);
+}
+
+/*
+ * InterruptIn
+ */
+
+InterruptIn::InterruptIn(PinName pin)
+    : _pin(pin)
+    , _irq_enabled(true)
+{
+    _level = mbed_host::get_pin_level(pin);
+    state().interrupts.push_back(this);
+}
+
+InterruptIn::~InterruptIn()
+{
+    std::vector<InterruptIn *> &interrupts = state().interrupts;
+    interrupts.erase(std::remove(interrupts.begin(), interrupts.end(), this), interrupts.end());
+}
+
+int InterruptIn::read()
+{
+    return mbed_host::get_pin_level(_pin);
+}
+
+void InterruptIn::rise(Callback<void()> func)
+{
+    _rise = func;
+}
+
+void InterruptIn::fall(Callback<void()> func)
+{
+    _fall = func;
+}
+
+void InterruptIn::enable_irq()
+{
+    _irq_enabled = true;
+}
+
+void InterruptIn::disable_irq()
+{
+    _irq_enabled = false;
+}
+
+void InterruptIn::process()
+{
+    int level = read();
+    if (level == _level) {
+        return;
+    }
+    _level = level;
+    // note: edges are lost if interrupt is disabled
+    if (!_irq_enabled) {
+        return;
+    }
+    if (level && _rise) {
+        _rise.call();
+    } else if (!level && _fall) {
+        _fall.call();
+    }
+}
+
+/*
+ * SPI
+ */
+
+SPI::SPI(PinName mosi, PinName miso, PinName sclk, PinName ssel)
+    : _hz(1000000)
+    , _write_fill(0xFF)
+{
+}
+
+SPI::~SPI()
+{
+    abort_transfer();
+}
+
+void SPI::format(int bits, int mode)
+{
+}
+
+void SPI::frequency(int hz)
+{
+    _hz = hz;
+}
+
+int SPI::write(int value)
+{
+    return spi_transfer_byte(value);
+}
+
+int SPI::write(const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length)
+{
+    int length = std::max(tx_length, rx_length);
+    for (int i = 0; i < length; i++) {
+        uint8_t res = spi_transfer_byte(i < tx_length ? tx_buffer[i] : _write_fill);
+        if (i < rx_length) {
+            rx_buffer[i] = res;
+        }
+    }
+    return length;
+}
+
+void SPI::set_default_write_value(char data)
+{
+    _write_fill = data;
+}
+
+void SPI::abort_transfer()
+{
+    mbed_host::cancel_transfer_completion(this);
+}
+
+void SPI::lock()
+{
+}
+
+void SPI::unlock()
+{
+}
+
+int SPI::_transfer(const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length,
+                   const event_callback_t &callback, int event)
+{
+    // note: data is exchanged immediately, but callback is invoked later like from an interrupt
+    write(tx_buffer, tx_length, rx_buffer, rx_length);
+    mbed_host::post_transfer_completion(this, callback, SPI_EVENT_COMPLETE & event);
+    return 0;
+}
+
+/*
+ * I2C
+ */
+
+I2C::I2C(PinName sda, PinName scl)
+{
+}
+
+I2C::~I2C()
+{
+    abort_transaction();
+}
+
+void I2C::frequency(int hz)
+{
+}
+
+int I2C::read(int address, char *data, int length, bool repeated)
+{
+    mbed_host::I2cSlave *slave = find_i2c_slave(address);
+    if (slave == NULL || !slave->i2c_read((uint8_t *)data, length)) {
+        return -1;
+    }
+    return 0;
+}
+
+int I2C::write(int address, const char *data, int length, bool repeated)
+{
+    mbed_host::I2cSlave *slave = find_i2c_slave(address);
+    if (slave == NULL || !slave->i2c_write((const uint8_t *)data, length)) {
+        return -1;
+    }
+    return 0;
+}
+
+int I2C::transfer(int address, const char *tx_buffer, int tx_length, char *rx_buffer, int rx_length,
+                  const event_callback_t &callback, int event, bool repeated)
+{
+    // note: data is exchanged immediately, but callback is invoked later like from an interrupt
+    int res = 0;
+    if (tx_length > 0) {
+        res = write(address, tx_buffer, tx_length, rx_length > 0);
+    }
+    if (res == 0 && rx_length > 0) {
+        res = read(address, rx_buffer, rx_length, repeated);
+    }
+    int transfer_event = res ? I2C_EVENT_ERROR_NO_SLAVE : I2C_EVENT_TRANSFER_COMPLETE;
+    mbed_host::post_transfer_completion(this, callback, transfer_event & event);
+    return 0;
+}
+
+void I2C::abort_transaction()
+{
+    mbed_host::cancel_transfer_completion(this);
+}
+
+void I2C::lock()
+{
+}
+
+void I2C::unlock()
+{
+}
+
+/*
+ * EventQueue
+ */
+
+EventQueue::EventQueue()
+    : _last_id(0)
+{
+}
+
+EventQueue::~EventQueue()
+{
+    break_dispatch();
+}
+
+void EventQueue::dispatch_forever()
+{
+    SimulationState &s = state();
+    break_dispatch();
+    s.thread_queues.push_back(std::make_pair(this, s.current_thread));
+}
+
+void EventQueue::break_dispatch()
+{
+    std::vector<std::pair<EventQueue *, osThreadId_t> > &queues = state().thread_queues;
+    for (size_t i = 0; i < queues.size(); i++) {
+        if (queues[i].first == this) {
+            queues.erase(queues.begin() + i);
+            return;
+        }
+    }
+}
+
+int EventQueue::call(Callback<void()> func)
+{
+    SimulationState &s = state();
+    if (s.failed_event_allocations > 0) {
+        s.failed_event_allocations--;
+        return 0;
+    }
+    _events.push_back(std::make_pair(++_last_id, func));
+    return _last_id;
+}
+
+bool EventQueue::cancel(int id)
+{
+    for (size_t i = 0; i < _events.size(); i++) {
+        if (_events[i].first == id) {
+            _events.erase(_events.begin() + i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void EventQueue::dispatch_posted()
+{
+    while (!_events.empty()) {
+        Callback<void()> func = _events.front().second;
+        _events.pop_front();
+        func.call();
+    }
+}
+
+int EventQueue::get_posted_count()
+{
+    return _events.size();
+}
+
+EventQueue *mbed::mbed_event_queue()
+{
+    static EventQueue shared_queue;
+    return &shared_queue;
+}
+
+/*
+ * Time
+ */
+
+void mbed::wait_us(int us)
+{
+    mbed_host::advance_time_us(us);
+}
+
+mbed::Timer::Timer()
+    : _running(false)
+    , _start_us(0)
+    , _elapsed_us(0)
+{
+}
+
+void mbed::Timer::start()
+{
+    if (!_running) {
+        _running = true;
+        _start_us = mbed_host::get_time_us();
+    }
+}
+
+void mbed::Timer::stop()
+{
+    if (_running) {
+        _elapsed_us += mbed_host::get_time_us() - _start_us;
+        _running = false;
+    }
+}
+
+void mbed::Timer::reset()
+{
+    _start_us = mbed_host::get_time_us();
+    _elapsed_us = 0;
+}
+
+std::chrono::microseconds mbed::Timer::elapsed_time() const
+{
+    uint64_t elapsed_us = _elapsed_us;
+    if (_running) {
+        elapsed_us += mbed_host::get_time_us() - _start_us;
+    }
+    return std::chrono::microseconds(elapsed_us);
+}
+
+mbed::LowPowerTimeout::LowPowerTimeout()
+    : _expiration_us(0)
+    , _attached(false)
+{
+}
+
+mbed::LowPowerTimeout::~LowPowerTimeout()
+{
+    detach();
+}
+
+void mbed::LowPowerTimeout::attach(Callback<void()> func, std::chrono::microseconds t)
+{
+    detach();
+    _func = func;
+    _expiration_us = mbed_host::get_time_us() + t.count();
+    _attached = true;
+    state().timeouts.push_back(this);
+}
+
+void mbed::LowPowerTimeout::detach()
+{
+    if (!_attached) {
+        return;
+    }
+    _attached = false;
+    std::vector<LowPowerTimeout *> &timeouts = state().timeouts;
+    timeouts.erase(std::remove(timeouts.begin(), timeouts.end(), this), timeouts.end());
+}
+
+void mbed::LowPowerTimeout::process()
+{
+    if (!_attached || mbed_host::get_time_us() < _expiration_us) {
+        return;
+    }
+    detach();
+    _func.call();
+}
+
+rtos::Kernel::Clock::time_point rtos::Kernel::Clock::now()
+{
+    return time_point(duration(mbed_host::get_time_us() / 1000));
+}
+
+void rtos::ThisThread::sleep_for(std::chrono::milliseconds duration)
+{
+    mbed_host::advance_time_us(duration.count() * 1000);
+}
+
+osThreadId_t rtos::ThisThread::get_id()
+{
+    // main thread has a non-null id too
+    static int main_thread;
+    osThreadId_t thread_id = state().current_thread;
+    return thread_id ? thread_id : &main_thread;
+}
+
+/*
+ * RTOS
+ */
+
+rtos::Thread::Thread(osPriority priority, uint32_t stack_size, unsigned char *stack_mem, const char *name)
+    : _priority(priority)
+    , _stack_size(stack_size)
+    , _name(name)
+    , _started(false)
+{
+}
+
+osStatus rtos::Thread::start(Callback<void()> task)
+{
+    if (_started) {
+        return osErrorParameter;
+    }
+    _started = true;
+    SimulationState &s = state();
+    osThreadId_t caller_thread = s.current_thread;
+    s.current_thread = this;
+    task.call();
+    s.current_thread = caller_thread;
+    return osOK;
+}
+
+osStatus rtos::Thread::join()
+{
+    // the thread queue should be stopped by EventQueue::break_dispatch
+    for (auto &entry : state().thread_queues) {
+        if (entry.second == this) {
+            mbed_host::fatal_error(MBED_ERROR_UNKNOWN, "Thread queue is still dispatched", __FILE__, __LINE__);
+        }
+    }
+    return osOK;
+}
+
+osThreadId_t rtos::Thread::get_id() const
+{
+    return _started ? (osThreadId_t)this : nullptr;
+}
+
+osPriority rtos::Thread::get_priority() const
+{
+    return _priority;
+}
+
+uint32_t rtos::Thread::stack_size() const
+{
+    return _stack_size;
+}
+
+const char *rtos::Thread::get_name() const
+{
+    return _name;
+}
+
+rtos::Semaphore::Semaphore(int32_t count)
+    : _count(count)
+{
+}
+
+void rtos::Semaphore::acquire()
+{
+    SimulationState &s = state();
+    while (_count <= 0) {
+        if (s.processing) {
+            // events aren't processed in the nested context, so nothing can release the semaphore
+            mbed_host::fatal_error(MBED_ERROR_UNKNOWN, "Semaphore is acquired from an event handler", __FILE__, __LINE__);
+        }
+        mbed_host::advance_time_us(s.time_step_us);
+    }
+    _count--;
+}
+
+osStatus rtos::Semaphore::release()
+{
+    _count++;
+    return osOK;
+}
@@ -0,0 +1,4 @@
+#ifndef MBED_HOST_RTOS_H
+#define MBED_HOST_RTOS_H
+#include "mbed.h"
+#endif // MBED_HOST_RTOS_H
@@ -0,0 +1,51 @@
+/**
+ * Minimal Unity assertion API for host tests.
+ *
+ * A failed assertion terminates current test case.
+ */
+#ifndef MBED_HOST_UNITY_H
+#define MBED_HOST_UNITY_H
+#include <math.h>
+#include <stdint.h>
+
+namespace utest {
+namespace v1 {
+    /**
+     * Report assertion failure and terminate current test case.
+     */
+    [[noreturn]] void unity_fail(const char *msg, const char *file, int line);
+}
+}
+
+#define TEST_FAIL_MESSAGE(msg) utest::v1::unity_fail((msg), __FILE__, __LINE__)
+#define TEST_ASSERT_MESSAGE(condition, msg) \
+    do {                                    \
+        if (!(condition)) {                 \
+            TEST_FAIL_MESSAGE(msg);         \
+        }                                   \
+    } while (0)
+#define TEST_ASSERT(condition) TEST_ASSERT_MESSAGE((condition), "Expression evaluated to FALSE: " #condition)
+#define TEST_ASSERT_TRUE(condition) TEST_ASSERT(condition)
+#define TEST_ASSERT_FALSE(condition) TEST_ASSERT(!(condition))
+#define TEST_ASSERT_EQUAL(expected, actual) \
+    TEST_ASSERT_MESSAGE((int64_t)(expected) == (int64_t)(actual), "Expected " #expected " Was " #actual)
+#define TEST_ASSERT_EQUAL_INT(expected, actual) TEST_ASSERT_EQUAL(expected, actual)
+#define TEST_ASSERT_EQUAL_UINT8(expected, actual) TEST_ASSERT_EQUAL((uint8_t)(expected), (uint8_t)(actual))
+#define TEST_ASSERT_EQUAL_HEX8(expected, actual) TEST_ASSERT_EQUAL_UINT8(expected, actual)
+#define TEST_ASSERT_NOT_EQUAL(expected, actual) \
+    TEST_ASSERT_MESSAGE((expected) != (actual), "Expected Not-Equal " #expected " " #actual)
+#define TEST_ASSERT_INT_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_MESSAGE(llabs((int64_t)(actual) - (int64_t)(expected)) <= (int64_t)(delta), "Values Not Within Delta " #expected " " #actual)
+#define TEST_ASSERT_FLOAT_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_MESSAGE(fabs((double)(actual) - (double)(expected)) <= (double)(delta), "Values Not Within Delta " #expected " " #actual)
+#define TEST_ASSERT_EQUAL_FLOAT(expected, actual) TEST_ASSERT_FLOAT_WITHIN(1e-5 * fabs((double)(expected)) + 1e-12, expected, actual)
+#define TEST_ASSERT_EQUAL_INT16_ARRAY(expected, actual, num_elements)                      \
+    do {                                                                                   \
+        for (int unity_i = 0; unity_i < (int)(num_elements); unity_i++) {                  \
+            TEST_ASSERT_MESSAGE((expected)[unity_i] == (actual)[unity_i], "Arrays differ"); \
+        }                                                                                  \
+    } while (0)
+#define TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, actual, num_elements) TEST_ASSERT_EQUAL_INT16_ARRAY(expected, actual, num_elements)
+#define TEST_IGNORE_MESSAGE(msg) printf("IGNORE: %s\n", (msg))
+
+#endif // MBED_HOST_UNITY_H
@@ -0,0 +1,133 @@
+/**
+ * Minimal utest API for host tests.
+ *
+ * It supports test cases with setup, teardown and failure handlers, that are
+ * declared in the same way as for greentea tests.
+ */
+#ifndef MBED_HOST_UTEST_H
+#define MBED_HOST_UTEST_H
+#include "unity.h"
+#include <stddef.h>
+
+namespace utest {
+namespace v1 {
+
+    enum status_t {
+        STATUS_CONTINUE = 0,
+        STATUS_IGNORE = 1,
+        STATUS_ABORT = -1
+    };
+
+    enum failure_reason_t {
+        REASON_NONE = 0,
+        REASON_ASSERTION = 1,
+        REASON_CASE_SETUP = 2,
+        REASON_TEST_SETUP = 3
+    };
+
+    struct failure_t {
+        failure_t(failure_reason_t reason = REASON_NONE)
+            : reason(reason)
+        {
+        }
+        failure_reason_t reason;
+    };
+
+    class Case;
+
+    typedef status_t (*test_setup_handler_t)(const size_t number_of_cases);
+    typedef void (*test_teardown_handler_t)(const size_t passed, const size_t failed, const failure_t failure);
+    typedef status_t (*case_setup_handler_t)(const Case *const source, const size_t index_of_case);
+    typedef void (*case_handler_t)(void);
+    typedef status_t (*case_teardown_handler_t)(const Case *const source, const size_t passed, const size_t failed, const failure_t reason);
+    typedef status_t (*case_failure_handler_t)(const Case *const source, const failure_t reason);
+
+    class Case {
+    public:
+        Case(const char *description, const case_handler_t handler)
+            : description(description)
+            , setup_handler(NULL)
+            , handler(handler)
+            , teardown_handler(NULL)
+            , failure_handler(NULL)
+        {
+        }
+
+        Case(const char *description, const case_handler_t handler, const case_failure_handler_t failure_handler)
+            : description(description)
+            , setup_handler(NULL)
+            , handler(handler)
+            , teardown_handler(NULL)
+            , failure_handler(failure_handler)
+        {
+        }
+
+        Case(const char *description, const case_setup_handler_t setup_handler, const case_handler_t handler,
+             const case_teardown_handler_t teardown_handler = NULL, const case_failure_handler_t failure_handler = NULL)
+            : description(description)
+            , setup_handler(setup_handler)
+            , handler(handler)
+            , teardown_handler(teardown_handler)
+            , failure_handler(failure_handler)
+        {
+        }
+
+        const char *get_description() const
+        {
+            return description;
+        }
+
+        const char *description;
+        case_setup_handler_t setup_handler;
+        case_handler_t handler;
+        case_teardown_handler_t teardown_handler;
+        case_failure_handler_t failure_handler;
+    };
+
+    class Specification {
+    public:
+        template <size_t N>
+        Specification(test_setup_handler_t setup_handler, Case (&cases)[N], test_teardown_handler_t teardown_handler = NULL)
+            : setup_handler(setup_handler)
+            , cases(cases)
+            , length(N)
+            , teardown_handler(teardown_handler)
+        {
+        }
+
+        template <size_t N>
+        Specification(Case (&cases)[N])
+            : setup_handler(NULL)
+            , cases(cases)
+            , length(N)
+            , teardown_handler(NULL)
+        {
+        }
+
+        test_setup_handler_t setup_handler;
+        const Case *cases;
+        size_t length;
+        test_teardown_handler_t teardown_handler;
+    };
+
+    class Harness {
+    public:
+        /**
+         * Run all test cases.
+         *
+         * @return true if all tests are passed.
+         */
+        static bool run(const Specification &specification);
+    };
+}
+}
+
+// default greentea handlers
+utest::v1::status_t greentea_test_setup_handler(const size_t number_of_cases);
+void greentea_test_teardown_handler(const size_t passed, const size_t failed, const utest::v1::failure_t failure);
+utest::v1::status_t greentea_case_setup_handler(const utest::v1::Case *const source, const size_t index_of_case);
+utest::v1::status_t greentea_case_teardown_handler(const utest::v1::Case *const source, const size_t passed, const size_t failed, const utest::v1::failure_t failure);
+utest::v1::status_t greentea_case_failure_continue_handler(const utest::v1::Case *const source, const utest::v1::failure_t reason);
+utest::v1::status_t greentea_case_failure_abort_handler(const utest::v1::Case *const source, const utest::v1::failure_t reason);
+
+#endif // MBED_HOST_UTEST_H
@@ -0,0 +1,95 @@
+#include "utest.h"
+#include <stdio.h>
+
+using namespace utest::v1;
+
+namespace {
+struct assertion_failure {
+};
+}
+
+void utest::v1::unity_fail(const char *msg, const char *file, int line)
+{
+    printf("%s:%d: FAIL: %s\n", file, line, msg);
+    throw assertion_failure();
+}
+
+bool Harness::run(const Specification &specification)
+{
+    size_t passed_cases = 0;
+    size_t failed_cases = 0;
+    failure_t test_failure;
+
+    if (specification.setup_handler && specification.setup_handler(specification.length) != STATUS_CONTINUE) {
+        printf(">>> Test setup failed\n");
+        test_failure = failure_t(REASON_TEST_SETUP);
+        failed_cases = specification.length;
+    }
+
+    for (size_t i = 0; i < specification.length && test_failure.reason == REASON_NONE; i++) {
+        const Case &test_case = specification.cases[i];
+        failure_t case_failure;
+        printf("\n>>> Running case #%u: '%s'...\n", (unsigned)(i + 1), test_case.description);
+
+        if (test_case.setup_handler && test_case.setup_handler(&test_case, i) != STATUS_CONTINUE) {
+            case_failure = failure_t(REASON_CASE_SETUP);
+        } else {
+            try {
+                test_case.handler();
+            } catch (const assertion_failure &) {
+                case_failure = failure_t(REASON_ASSERTION);
+            }
+        }
+
+        size_t passed = case_failure.reason == REASON_NONE ? 1 : 0;
+        size_t failed = 1 - passed;
+        status_t status = STATUS_CONTINUE;
+        if (failed && test_case.failure_handler) {
+            status = test_case.failure_handler(&test_case, case_failure);
+        }
+        if (test_case.teardown_handler) {
+            test_case.teardown_handler(&test_case, passed, failed, case_failure);
+        }
+        printf(">>> '%s': %u passed, %u failed\n", test_case.description, (unsigned)passed, (unsigned)failed);
+        passed_cases += passed;
+        failed_cases += failed;
+        if (status == STATUS_ABORT) {
+            test_failure = case_failure;
+        }
+    }
+
+    if (specification.teardown_handler) {
+        specification.teardown_handler(passed_cases, failed_cases, test_failure);
+    }
+    printf("\n>>> Test cases: %u passed, %u failed\n", (unsigned)passed_cases, (unsigned)failed_cases);
+    return failed_cases == 0;
+}
+
+status_t greentea_test_setup_handler(const size_t number_of_cases)
+{
+    return STATUS_CONTINUE;
+}
+
+void greentea_test_teardown_handler(const size_t passed, const size_t failed, const failure_t failure)
+{
+}
+
+status_t greentea_case_setup_handler(const Case *const source, const size_t index_of_case)
+{
+    return STATUS_CONTINUE;
+}
+
+status_t greentea_case_teardown_handler(const Case *const source, const size_t passed, const size_t failed, const failure_t failure)
+{
+    return STATUS_CONTINUE;
+}
+
+status_t greentea_case_failure_continue_handler(const Case *const source, const failure_t reason)
+{
+    return STATUS_CONTINUE;
+}
+
+status_t greentea_case_failure_abort_handler(const Case *const source, const failure_t reason)
+{
+    return STATUS_ABORT;
+}
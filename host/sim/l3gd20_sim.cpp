@@ -0,0 +1,742 @@
+#include "l3gd20_sim.h"
+
+using namespace l3gd20::sim;
+
+// register map
+static const uint8_t WHO_AM_I_ADDR = 0x0F;
+static const uint8_t CTRL_REG1_ADDR = 0x20;
+static const uint8_t CTRL_REG2_ADDR = 0x21;
+static const uint8_t CTRL_REG3_ADDR = 0x22;
+static const uint8_t CTRL_REG4_ADDR = 0x23;
+static const uint8_t CTRL_REG5_ADDR = 0x24;
+static const uint8_t REFERENCE_ADDR = 0x25;
+static const uint8_t OUT_TEMP_ADDR = 0x26;
+static const uint8_t STATUS_REG_ADDR = 0x27;
+static const uint8_t OUT_X_L_ADDR = 0x28;
+static const uint8_t OUT_Z_H_ADDR = 0x2D;
+static const uint8_t FIFO_CTRL_REG_ADDR = 0x2E;
+static const uint8_t FIFO_SRC_REG_ADDR = 0x2F;
+static const uint8_t INT1_CFG_ADDR = 0x30;
+static const uint8_t INT1_SRC_ADDR = 0x31;
+static const uint8_t INT1_TSH_XH_ADDR = 0x32;
+static const uint8_t INT1_DURATION_ADDR = 0x38;
+
+static const uint8_t DEVICE_ID = 0xD4;
+
+// CTRL_REG1 bits (note: L3GD20 uses "Zen Xen Yen" order)
+static const uint8_t CTRL_REG1_PD = 0x08;
+static const uint8_t CTRL_REG1_ZEN = 0x04;
+static const uint8_t CTRL_REG1_XEN = 0x02;
+static const uint8_t CTRL_REG1_YEN = 0x01;
+static const uint8_t AXIS_ENABLE_BITS[3] = { CTRL_REG1_XEN, CTRL_REG1_YEN, CTRL_REG1_ZEN };
+static const float ODR_HZ_MAP[4] = { 95.0f, 190.0f, 380.0f, 760.0f };
+
+// CTRL_REG3 bits
+static const uint8_t CTRL_REG3_I1_INT1 = 0x80;
+static const uint8_t CTRL_REG3_H_LACTIVE = 0x20;
+static const uint8_t CTRL_REG3_I2_DRDY = 0x08;
+static const uint8_t CTRL_REG3_I2_WTM = 0x04;
+static const uint8_t CTRL_REG3_I2_ORUN = 0x02;
+static const uint8_t CTRL_REG3_I2_EMPTY = 0x01;
+
+// CTRL_REG4 bits
+static const uint8_t CTRL_REG4_BLE = 0x40;
+static const uint8_t CTRL_REG4_FS_MASK = 0x30;
+static const float SENSITIVITY_MDPS_MAP[4] = { 8.75f, 17.5f, 70.0f, 70.0f };
+
+// CTRL_REG5 bits
+static const uint8_t CTRL_REG5_BOOT = 0x80;
+static const uint8_t CTRL_REG5_FIFO_EN = 0x40;
+
+// STATUS_REG bits
+static const uint8_t STATUS_ZYXOR = 0x80;
+static const uint8_t STATUS_ZYXDA = 0x08;
+
+// FIFO_CTRL_REG/FIFO_SRC_REG bits
+static const uint8_t FIFO_CTRL_FM_MASK = 0xE0;
+static const uint8_t FIFO_CTRL_FM_BYPASS = 0x00;
+static const uint8_t FIFO_CTRL_FM_FIFO = 0x20;
+static const uint8_t FIFO_CTRL_FM_STREAM_TO_FIFO = 0x60;
+static const uint8_t FIFO_CTRL_FM_BYPASS_TO_STREAM = 0x80;
+static const uint8_t FIFO_CTRL_WTM_MASK = 0x1F;
+static const uint8_t FIFO_SRC_WTM = 0x80;
+static const uint8_t FIFO_SRC_OVRN = 0x40;
+static const uint8_t FIFO_SRC_EMPTY = 0x20;
+
+// INT1_CFG/INT1_SRC/INT1_DURATION bits
+static const uint8_t INT1_CFG_AND_OR = 0x80;
+static const uint8_t INT1_CFG_LIR = 0x40;
+static const uint8_t INT1_CFG_EVENTS_MASK = 0x3F;
+static const uint8_t INT1_SRC_IA = 0x40;
+static const uint8_t INT1_DURATION_WAIT = 0x80;
+static const uint8_t INT1_DURATION_MASK = 0x7F;
+
+/*
+ * Trajectories
+ */
+
+ConstantTrajectory::ConstantTrajectory(double x, double y, double z)
+{
+    _rate[0] = x;
+    _rate[1] = y;
+    _rate[2] = z;
+}
+
+void ConstantTrajectory::get_angular_rate(double t, double rate[3])
+{
+    for (int i = 0; i < 3; i++) {
+        rate[i] = _rate[i];
+    }
+}
+
+SineTrajectory::SineTrajectory(const double amplitude[3], const double frequency[3], const double phase[3], const double offset[3])
+{
+    for (int i = 0; i < 3; i++) {
+        _amplitude[i] = amplitude[i];
+        _frequency[i] = frequency[i];
+        _phase[i] = phase ? phase[i] : 0.0;
+        _offset[i] = offset ? offset[i] : 0.0;
+    }
+}
+
+void SineTrajectory::get_angular_rate(double t, double rate[3])
+{
+    for (int i = 0; i < 3; i++) {
+        rate[i] = _offset[i] + _amplitude[i] * sin(2 * M_PI * _frequency[i] * t + _phase[i]);
+    }
+}
+
+SegmentTrajectory::SegmentTrajectory()
+    : _n_segments(0)
+{
+}
+
+int SegmentTrajectory::add_segment(double duration, double x, double y, double z)
+{
+    if (_n_segments >= MAX_SEGMENTS) {
+        return MBED_ERROR_CODE_ENOMEM;
+    }
+    double start_time = _n_segments ? _end_time[_n_segments - 1] : 0.0;
+    _end_time[_n_segments] = start_time + duration;
+    _rate[_n_segments][0] = x;
+    _rate[_n_segments][1] = y;
+    _rate[_n_segments][2] = z;
+    _n_segments++;
+    return MBED_SUCCESS;
+}
+
+void SegmentTrajectory::get_angular_rate(double t, double rate[3])
+{
+    for (int i = 0; i < _n_segments; i++) {
+        if (t < _end_time[i]) {
+            rate[0] = _rate[i][0];
+            rate[1] = _rate[i][1];
+            rate[2] = _rate[i][2];
+            return;
+        }
+    }
+    rate[0] = rate[1] = rate[2] = 0.0;
+}
+
+/*
+ * SimulatedL3GD20
+ */
+
+SimulatedL3GD20::SimulatedL3GD20()
+    : _trajectory(NULL)
+    , _noise_rms(0.0)
+    , _noise_state(1)
+    , _odr_deviation(0.0)
+    , _power_down_turn_on_us(0)
+    , _sleep_turn_on_us(0)
+    , _int1_pin(NC)
+    , _int2_pin(NC)
+    , _spi_read(false)
+    , _spi_increment(false)
+    , _spi_byte_index(0)
+    , _spi_addr(0)
+    , _i2c_increment(false)
+    , _i2c_addr(0)
+{
+    _bias[0] = _bias[1] = _bias[2] = 0.0;
+    _bias_tc[0] = _bias_tc[1] = _bias_tc[2] = 0.0;
+    power_on_reset();
+}
+
+SimulatedL3GD20::~SimulatedL3GD20()
+{
+    abort_async();
+    mbed_host::detach_slave(static_cast<mbed_host::SpiSlave *>(this));
+    mbed_host::detach_slave(static_cast<mbed_host::I2cSlave *>(this));
+    if (_int1_pin != NC) {
+        mbed_host::set_pin_source(_int1_pin, nullptr);
+    }
+    if (_int2_pin != NC) {
+        mbed_host::set_pin_source(_int2_pin, nullptr);
+    }
+}
+
+void SimulatedL3GD20::attach_spi(PinName ssel)
+{
+    mbed_host::attach_spi_slave(ssel, this);
+}
+
+void SimulatedL3GD20::attach_i2c(int address)
+{
+    mbed_host::attach_i2c_slave(address, this);
+}
+
+void SimulatedL3GD20::connect_int2(PinName pin)
+{
+    _int2_pin = pin;
+    mbed_host::set_pin_source(pin, callback(this, &SimulatedL3GD20::get_int2_level));
+}
+
+void SimulatedL3GD20::connect_int1(PinName pin)
+{
+    _int1_pin = pin;
+    mbed_host::set_pin_source(pin, callback(this, &SimulatedL3GD20::get_int1_level));
+}
+
+void SimulatedL3GD20::set_trajectory(Trajectory *trajectory)
+{
+    _update();
+    _trajectory = trajectory;
+}
+
+void SimulatedL3GD20::set_bias(double x, double y, double z)
+{
+    _update();
+    _bias[0] = x;
+    _bias[1] = y;
+    _bias[2] = z;
+}
+
+void SimulatedL3GD20::set_bias_temperature_coefficient(double x, double y, double z)
+{
+    _update();
+    _bias_tc[0] = x;
+    _bias_tc[1] = y;
+    _bias_tc[2] = z;
+}
+
+void SimulatedL3GD20::set_noise(double rms_dps, uint32_t seed)
+{
+    _update();
+    _noise_rms = rms_dps;
+    _noise_state = seed ? seed : 1;
+}
+
+void SimulatedL3GD20::set_odr_deviation(double deviation)
+{
+    _update();
+    // continue sampling from the last sample with new rate
+    _sampling_start_us = _get_sample_time(_sampling_index);
+    _sampling_index = 0;
+    _odr_deviation = deviation;
+}
+
+void SimulatedL3GD20::set_turn_on_delay(uint32_t power_down_us, uint32_t sleep_us)
+{
+    _power_down_turn_on_us = power_down_us;
+    _sleep_turn_on_us = sleep_us;
+}
+
+void SimulatedL3GD20::set_temperature(int8_t out_temp)
+{
+    _update();
+    _regs[OUT_TEMP_ADDR] = (uint8_t)out_temp;
+}
+
+void SimulatedL3GD20::power_on_reset()
+{
+    memset(_regs, 0, sizeof(_regs));
+    _regs[CTRL_REG1_ADDR] = CTRL_REG1_ZEN | CTRL_REG1_XEN | CTRL_REG1_YEN;
+    _powered = false;
+    _sampling = false;
+    _odr_hz = ODR_HZ_MAP[0];
+    _sampling_start_us = 0;
+    _sampling_index = 0;
+    _sample_count = 0;
+    memset(_output, 0, sizeof(_output));
+    _status = 0;
+    _fifo_head = 0;
+    _fifo_level = 0;
+    _fifo_stopped = false;
+    _reset_int1();
+}
+
+uint8_t SimulatedL3GD20::peek_register(uint8_t reg)
+{
+    _update();
+    return _read_register(reg, false);
+}
+
+int SimulatedL3GD20::get_fifo_level()
+{
+    _update();
+    return _fifo_level;
+}
+
+int SimulatedL3GD20::get_int2_level()
+{
+    _update();
+    uint8_t ctrl_reg3 = _regs[CTRL_REG3_ADDR];
+    uint8_t fifo_src = _get_fifo_src();
+    int level = 0;
+    level |= (ctrl_reg3 & CTRL_REG3_I2_DRDY) && (_status & STATUS_ZYXDA);
+    level |= (ctrl_reg3 & CTRL_REG3_I2_WTM) && (fifo_src & FIFO_SRC_WTM);
+    level |= (ctrl_reg3 & CTRL_REG3_I2_ORUN) && (fifo_src & FIFO_SRC_OVRN);
+    level |= (ctrl_reg3 & CTRL_REG3_I2_EMPTY) && (fifo_src & FIFO_SRC_EMPTY);
+    return level;
+}
+
+int SimulatedL3GD20::get_int1_level()
+{
+    _update();
+    uint8_t ctrl_reg3 = _regs[CTRL_REG3_ADDR];
+    int level = (ctrl_reg3 & CTRL_REG3_I1_INT1) && (_int1_src & INT1_SRC_IA);
+    return (ctrl_reg3 & CTRL_REG3_H_LACTIVE) ? !level : level;
+}
+
+uint64_t SimulatedL3GD20::get_sample_count()
+{
+    _update();
+    return _sample_count;
+}
+
+void SimulatedL3GD20::read_registers(uint8_t reg, uint8_t *data, uint8_t length)
+{
+    _update();
+    for (int i = 0; i < length; i++) {
+        data[i] = _read_register(reg, true);
+        reg = _next_address(reg);
+    }
+}
+
+void SimulatedL3GD20::write_registers(uint8_t reg, const uint8_t *data, uint8_t length)
+{
+    _update();
+    for (int i = 0; i < length; i++) {
+        _write_register(reg, data[i]);
+        reg = _next_address(reg);
+    }
+}
+
+int SimulatedL3GD20::read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback)
+{
+    // note: like shim SPI/I2C, data is read immediately, but callback is invoked later
+    read_registers(reg, data + ASYNC_READ_OFFSET, length);
+    mbed_host::post_transfer_completion(this, callback, MBED_SUCCESS);
+    return MBED_SUCCESS;
+}
+
+void SimulatedL3GD20::abort_async()
+{
+    mbed_host::cancel_transfer_completion(this);
+}
+
+void SimulatedL3GD20::spi_select()
+{
+    _update();
+    _spi_byte_index = 0;
+}
+
+uint8_t SimulatedL3GD20::spi_transfer(uint8_t mosi)
+{
+    uint8_t miso = 0xFF;
+    if (_spi_byte_index == 0) {
+        // command: RW bit, MS bit and 6-bit address
+        _spi_read = mosi & 0x80;
+        _spi_increment = mosi & 0x40;
+        _spi_addr = mosi & 0x3F;
+    } else if (_spi_read) {
+        miso = _read_register(_spi_addr, true);
+        if (_spi_increment) {
+            _spi_addr = _next_address(_spi_addr) & 0x3F;
+        }
+    } else {
+        _write_register(_spi_addr, mosi);
+        if (_spi_increment) {
+            _spi_addr = _next_address(_spi_addr) & 0x3F;
+        }
+    }
+    _spi_byte_index++;
+    return miso;
+}
+
+void SimulatedL3GD20::spi_deselect()
+{
+    _spi_byte_index = 0;
+}
+
+bool SimulatedL3GD20::i2c_write(const uint8_t *data, int length)
+{
+    _update();
+    if (length <= 0) {
+        return true;
+    }
+    // sub-address: MSB enables auto-increment
+    _i2c_increment = data[0] & 0x80;
+    _i2c_addr = data[0] & 0x7F;
+    for (int i = 1; i < length; i++) {
+        _write_register(_i2c_addr, data[i]);
+        if (_i2c_increment) {
+            _i2c_addr = _next_address(_i2c_addr) & 0x7F;
+        }
+    }
+    return true;
+}
+
+bool SimulatedL3GD20::i2c_read(uint8_t *data, int length)
+{
+    _update();
+    for (int i = 0; i < length; i++) {
+        data[i] = _read_register(_i2c_addr, true);
+        if (_i2c_increment) {
+            _i2c_addr = _next_address(_i2c_addr) & 0x7F;
+        }
+    }
+    return true;
+}
+
+void SimulatedL3GD20::_update()
+{
+    if (!_sampling) {
+        return;
+    }
+    uint64_t now = mbed_host::get_time_us();
+    while (true) {
+        uint64_t sample_time = _get_sample_time(_sampling_index + 1);
+        if (sample_time > now) {
+            break;
+        }
+        _sampling_index++;
+        _generate_sample(sample_time);
+    }
+}
+
+uint64_t SimulatedL3GD20::_get_sample_time(uint64_t index)
+{
+    return _sampling_start_us + (uint64_t)(index * 1e6 / (_odr_hz * (1.0 + _odr_deviation)));
+}
+
+void SimulatedL3GD20::_configure_sampling()
+{
+    uint8_t ctrl_reg1 = _regs[CTRL_REG1_ADDR];
+    bool powered = ctrl_reg1 & CTRL_REG1_PD;
+    bool sampling = powered && (ctrl_reg1 & (CTRL_REG1_ZEN | CTRL_REG1_XEN | CTRL_REG1_YEN));
+    float odr_hz = ODR_HZ_MAP[ctrl_reg1 >> 6];
+    if (sampling != _sampling || odr_hz != _odr_hz) {
+        _sampling_start_us = mbed_host::get_time_us();
+        if (sampling && !_sampling) {
+            // turn-on from power down or sleep mode
+            _sampling_start_us += _powered ? _sleep_turn_on_us : _power_down_turn_on_us;
+        }
+        _sampling = sampling;
+        _odr_hz = odr_hz;
+        _sampling_index = 0;
+    }
+    _powered = powered;
+}
+
+double SimulatedL3GD20::_next_noise()
+{
+    // approximation of the normal distribution with sum of 4 uniform variables (xorshift32 generator)
+    double sum = 0.0;
+    for (int i = 0; i < 4; i++) {
+        _noise_state ^= _noise_state << 13;
+        _noise_state ^= _noise_state >> 17;
+        _noise_state ^= _noise_state << 5;
+        sum += _noise_state / 4294967296.0;
+    }
+    return (sum - 2.0) * sqrt(3.0);
+}
+
+void SimulatedL3GD20::_generate_sample(uint64_t time_us)
+{
+    double rate[3] = { 0.0, 0.0, 0.0 };
+    if (_trajectory != NULL) {
+        _trajectory->get_angular_rate(time_us * 1e-6, rate);
+    }
+    float sensitivity_dps = SENSITIVITY_MDPS_MAP[(_regs[CTRL_REG4_ADDR] & CTRL_REG4_FS_MASK) >> 4] / 1000.0f;
+    // temperature sensor sensitivity is -1 LSB/°C
+    double temperature = -(int8_t)_regs[OUT_TEMP_ADDR];
+
+    int16_t sample[3];
+    for (int i = 0; i < 3; i++) {
+        if (!(_regs[CTRL_REG1_ADDR] & AXIS_ENABLE_BITS[i])) {
+            sample[i] = 0;
+            continue;
+        }
+        double value = rate[i] + _bias[i] + _bias_tc[i] * temperature;
+        if (_noise_rms > 0.0) {
+            value += _noise_rms * _next_noise();
+        }
+        value = round(value / sensitivity_dps);
+        if (value > INT16_MAX) {
+            value = INT16_MAX;
+        } else if (value < INT16_MIN) {
+            value = INT16_MIN;
+        }
+        sample[i] = (int16_t)value;
+    }
+    _sample_count++;
+    _update_int1(sample);
+
+    // status register
+    uint8_t axes_da = 0;
+    for (int i = 0; i < 3; i++) {
+        if (_regs[CTRL_REG1_ADDR] & AXIS_ENABLE_BITS[i]) {
+            axes_da |= 1 << i;
+        }
+    }
+    _status |= (_status & axes_da) << 4; // overrun flags of the unread axes
+    _status |= axes_da | STATUS_ZYXDA;
+    if (_status & 0x70) {
+        _status |= STATUS_ZYXOR;
+    }
+
+    // output registers
+    EffectiveFifoMode fifo_mode = _get_fifo_mode();
+    if (fifo_mode == EFFECTIVE_BYPASS) {
+        memcpy(_output, sample, sizeof(_output));
+        return;
+    }
+    if (_fifo_stopped) {
+        return;
+    }
+    if (_fifo_level == FIFO_SIZE) {
+        if (fifo_mode == EFFECTIVE_FIFO) {
+            // FIFO mode stops collecting data when FIFO is full until reset with bypass mode
+            _fifo_stopped = true;
+            return;
+        }
+        // stream mode discards the oldest sample
+        _fifo_head = (_fifo_head + 1) % FIFO_SIZE;
+        _fifo_level--;
+    }
+    memcpy(_fifo[(_fifo_head + _fifo_level) % FIFO_SIZE], sample, sizeof(sample));
+    _fifo_level++;
+}
+
+void SimulatedL3GD20::_update_int1(const int16_t sample[3])
+{
+    uint8_t int1_cfg = _regs[INT1_CFG_ADDR];
+    uint8_t events = int1_cfg & INT1_CFG_EVENTS_MASK;
+    if (!events) {
+        return;
+    }
+    // event flags in order: XL, XH, YL, YH, ZL, ZH
+    uint8_t flags = 0;
+    for (int i = 0; i < 3; i++) {
+        if (!(_regs[CTRL_REG1_ADDR] & AXIS_ENABLE_BITS[i])) {
+            continue;
+        }
+        int threshold = ((_regs[INT1_TSH_XH_ADDR + i * 2] << 8) | _regs[INT1_TSH_XH_ADDR + i * 2 + 1]) & 0x7FFF;
+        int value = abs((int)sample[i]);
+        flags |= (value > threshold ? 0x02 : 0x01) << (i * 2);
+    }
+    flags &= events;
+    bool condition = (int1_cfg & INT1_CFG_AND_OR) ? flags == events : flags != 0;
+
+    uint8_t int1_duration = _regs[INT1_DURATION_ADDR];
+    int duration = int1_duration & INT1_DURATION_MASK;
+    duration = duration > 0 ? duration : 1;
+    bool latch = int1_cfg & INT1_CFG_LIR;
+    if (latch && (_int1_src & INT1_SRC_IA)) {
+        // latched request and its flags are kept until INT1_SRC reading
+        return;
+    }
+    if (condition) {
+        _int1_reset_count = 0;
+        if (_int1_set_count < duration) {
+            _int1_set_count++;
+        }
+        if (_int1_set_count >= duration) {
+            _int1_src = flags | INT1_SRC_IA;
+            _fifo_triggered = true;
+        }
+    } else {
+        _int1_set_count = 0;
+        if (!(_int1_src & INT1_SRC_IA)) {
+            _int1_src = 0;
+            return;
+        }
+        // the request is reset immediately or after duration samples without events
+        if (int1_duration & INT1_DURATION_WAIT) {
+            _int1_reset_count++;
+            if (_int1_reset_count < duration) {
+                return;
+            }
+        }
+        _int1_src = 0;
+        _int1_reset_count = 0;
+    }
+}
+
+void SimulatedL3GD20::_reset_int1()
+{
+    _int1_src = 0;
+    _int1_set_count = 0;
+    _int1_reset_count = 0;
+    _fifo_triggered = false;
+}
+
+SimulatedL3GD20::EffectiveFifoMode SimulatedL3GD20::_get_fifo_mode()
+{
+    if (!(_regs[CTRL_REG5_ADDR] & CTRL_REG5_FIFO_EN)) {
+        return EFFECTIVE_BYPASS;
+    }
+    switch (_regs[FIFO_CTRL_REG_ADDR] & FIFO_CTRL_FM_MASK) {
+    case FIFO_CTRL_FM_BYPASS:
+        return EFFECTIVE_BYPASS;
+    case FIFO_CTRL_FM_BYPASS_TO_STREAM:
+        // INT1 event starts streaming
+        return _fifo_triggered ? EFFECTIVE_STREAM : EFFECTIVE_BYPASS;
+    case FIFO_CTRL_FM_FIFO:
+        return EFFECTIVE_FIFO;
+    case FIFO_CTRL_FM_STREAM_TO_FIFO:
+        // INT1 event switches streaming to FIFO mode
+        return _fifo_triggered ? EFFECTIVE_FIFO : EFFECTIVE_STREAM;
+    default:
+        return EFFECTIVE_STREAM;
+    }
+}
+
+void SimulatedL3GD20::_update_fifo_mode()
+{
+    if (_get_fifo_mode() != EFFECTIVE_BYPASS) {
+        return;
+    }
+    // FIFO is reset in the bypass mode, output registers keep the last unread sample
+    if (_fifo_level > 0) {
+        memcpy(_output, _fifo[_fifo_head], sizeof(_output));
+    }
+    _fifo_head = 0;
+    _fifo_level = 0;
+    _fifo_stopped = false;
+}
+
+uint8_t SimulatedL3GD20::_get_fifo_src()
+{
+    if (_get_fifo_mode() == EFFECTIVE_BYPASS) {
+        return FIFO_SRC_EMPTY;
+    }
+    uint8_t fifo_src = _fifo_level & 0x1F;
+    if (_fifo_level >= (_regs[FIFO_CTRL_REG_ADDR] & FIFO_CTRL_WTM_MASK)) {
+        fifo_src |= FIFO_SRC_WTM;
+    }
+    if (_fifo_level == FIFO_SIZE) {
+        fifo_src |= FIFO_SRC_OVRN;
+    }
+    if (_fifo_level == 0) {
+        fifo_src |= FIFO_SRC_EMPTY;
+    }
+    return fifo_src;
+}
+
+uint8_t SimulatedL3GD20::_read_register(uint8_t reg, bool side_effects)
+{
+    if (reg >= OUT_X_L_ADDR && reg <= OUT_Z_H_ADDR) {
+        // output registers
+        bool fifo_output = _get_fifo_mode() != EFFECTIVE_BYPASS && _fifo_level > 0;
+        const int16_t *sample = fifo_output ? _fifo[_fifo_head] : _output;
+        int axis = (reg - OUT_X_L_ADDR) / 2;
+        bool high_byte = (reg - OUT_X_L_ADDR) & 0x01;
+        if (_regs[CTRL_REG4_ADDR] & CTRL_REG4_BLE) {
+            high_byte = !high_byte;
+        }
+        uint16_t value = (uint16_t)sample[axis];
+        uint8_t res = high_byte ? value >> 8 : value & 0xFF;
+
+        if (side_effects) {
+            // clear data available and overrun flags of the axis
+            _status &= ~((0x11) << axis);
+            if (!(_status & 0x07)) {
+                _status &= ~(STATUS_ZYXDA | STATUS_ZYXOR);
+            }
+            if (reg == OUT_Z_H_ADDR && fifo_output) {
+                // the sample is read completely, so remove it from FIFO
+                memcpy(_output, sample, sizeof(_output));
+                _fifo_head = (_fifo_head + 1) % FIFO_SIZE;
+                _fifo_level--;
+            }
+        }
+        return res;
+    }
+
+    switch (reg) {
+    case WHO_AM_I_ADDR:
+        return DEVICE_ID;
+    case STATUS_REG_ADDR:
+        return _status;
+    case FIFO_SRC_REG_ADDR:
+        return _get_fifo_src();
+    case INT1_SRC_ADDR: {
+        uint8_t int1_src = _int1_src;
+        if (side_effects && (_regs[INT1_CFG_ADDR] & INT1_CFG_LIR)) {
+            // reading clears latched request
+            _int1_src = 0;
+            _int1_set_count = 0;
+        }
+        return int1_src;
+    }
+    default:
+        break;
+    }
+
+    if (reg < _REG_COUNT) {
+        // note: reserved registers are always zero
+        return _regs[reg];
+    }
+    return 0x00;
+}
+
+void SimulatedL3GD20::_write_register(uint8_t reg, uint8_t val)
+{
+    switch (reg) {
+    case CTRL_REG1_ADDR:
+        _regs[reg] = val;
+        _configure_sampling();
+        break;
+    case CTRL_REG5_ADDR:
+        // BOOT bit is cleared automatically after memory content reloading
+        _regs[reg] = val & ~CTRL_REG5_BOOT;
+        _update_fifo_mode();
+        break;
+    case FIFO_CTRL_REG_ADDR:
+        _regs[reg] = val;
+        // FIFO mode change rearms INT1 trigger
+        _fifo_triggered = false;
+        _update_fifo_mode();
+        break;
+    case CTRL_REG2_ADDR:
+        _regs[reg] = val & 0x3F;
+        break;
+    case INT1_CFG_ADDR:
+        _regs[reg] = val;
+        _reset_int1();
+        break;
+    case CTRL_REG3_ADDR:
+    case CTRL_REG4_ADDR:
+    case REFERENCE_ADDR:
+        _regs[reg] = val;
+        break;
+    default:
+        if (reg >= INT1_TSH_XH_ADDR && reg <= INT1_DURATION_ADDR) {
+            _regs[reg] = val;
+        }
+        // other registers are read-only or reserved
+        break;
+    }
+}
+
+uint8_t SimulatedL3GD20::_next_address(uint8_t reg)
+{
+    if (reg == OUT_Z_H_ADDR && (_regs[CTRL_REG5_ADDR] & CTRL_REG5_FIFO_EN)) {
+        // output registers rollover to simplify FIFO reading
+        return OUT_X_L_ADDR;
+    }
+    return reg + 1;
+}
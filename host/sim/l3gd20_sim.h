@@ -0,0 +1,339 @@
+#ifndef L3GD20_SIM_H
+#define L3GD20_SIM_H
+#include "l3gd20_bus.h"
+#include "mbed.h"
+
+namespace l3gd20 {
+namespace sim {
+
+/**
+ * Angular rate source of the simulated device.
+ */
+class Trajectory {
+public:
+    virtual ~Trajectory()
+    {
+    }
+
+    /**
+     * Get angular rate at the specified time.
+     *
+     * @param t time in seconds
+     * @param rate angular rate in degrees per second
+     */
+    virtual void get_angular_rate(double t, double rate[3]) = 0;
+};
+
+/**
+ * Rotation with a constant angular rate.
+ */
+class ConstantTrajectory : public Trajectory {
+public:
+    ConstantTrajectory(double x = 0.0, double y = 0.0, double z = 0.0);
+    virtual void get_angular_rate(double t, double rate[3]);
+
+private:
+    double _rate[3];
+};
+
+/**
+ * Oscillation: `rate[i] = offset[i] + amplitude[i] * sin(2 * pi * frequency[i] * t + phase[i])`.
+ */
+class SineTrajectory : public Trajectory {
+public:
+    /**
+     * Constructor.
+     *
+     * @param amplitude oscillation amplitudes in degrees per second
+     * @param frequency oscillation frequencies in Hz
+     * @param phase phases in radians. If it's NULL, zero phases are used.
+     * @param offset constant rate offsets in degrees per second. If it's NULL, zero offsets are used.
+     */
+    SineTrajectory(const double amplitude[3], const double frequency[3], const double phase[3] = NULL, const double offset[3] = NULL);
+    virtual void get_angular_rate(double t, double rate[3]);
+
+private:
+    double _amplitude[3];
+    double _frequency[3];
+    double _phase[3];
+    double _offset[3];
+};
+
+/**
+ * Sequence of constant rate rotations. The rate is zero after the last segment.
+ */
+class SegmentTrajectory : public Trajectory {
+public:
+    static const int MAX_SEGMENTS = 16;
+
+    SegmentTrajectory();
+
+    /**
+     * Add rotation segment.
+     *
+     * @param duration segment duration in seconds
+     * @param x X axis rate in degrees per second
+     * @param y Y axis rate in degrees per second
+     * @param z Z axis rate in degrees per second
+     * @return 0 on success, non-zero value if there are too many segments.
+     */
+    int add_segment(double duration, double x, double y, double z);
+    virtual void get_angular_rate(double t, double rate[3]);
+
+private:
+    int _n_segments;
+    double _end_time[MAX_SEGMENTS];
+    double _rate[MAX_SEGMENTS][3];
+};
+
+/**
+ * Software model of the L3GD20 gyroscope.
+ *
+ * The model covers:
+ *
+ * - complete register map with read-only, reserved and writable registers;
+ * - SPI and I2C protocols with their auto-increment rules (MS bit of the SPI command and
+ *   MSB of the I2C sub-address) and output registers rollover if FIFO is enabled;
+ * - output data rate pacing with optional oscillator deviation, power down, sleep mode and axes selection;
+ * - big/little endian output format and full scale selection;
+ * - STATUS_REG data available and overrun flags;
+ * - FIFO bypass, FIFO and stream modes with watermark, overrun and empty flags;
+ * - INT2/DRDY pin with data ready and FIFO interrupts;
+ * - INT1 pin with angular rate threshold events (AND/OR combination, latch, duration and wait),
+ *   that also trigger stream-to-FIFO and bypass-to-stream FIFO modes.
+ *
+ * INT1 thresholds are compared with absolute output values of the enabled axes: a high event occurs,
+ * when the value is greater than the threshold, a low event - otherwise. The interrupt request is set,
+ * when the combined condition holds for INT1_DURATION consecutive samples (at least one).
+ * Digital filters (including INT1_Sel high-pass filter selection) and BDU aren't modeled.
+ * The temperature dependency is limited to a linear zero-rate level drift.
+ *
+ * Samples are generated from the trajectory, bias and gaussian noise using simulated time
+ * (see mbed_host::get_time_us). The first sample is generated one ODR period after power on
+ * plus optional turn-on delay of power down or sleep mode (see set_turn_on_delay()).
+ *
+ * The model can be connected to the driver via shim SPI/I2C interfaces or directly as RegisterTransport.
+ */
+class SimulatedL3GD20 : public RegisterTransport, public mbed_host::SpiSlave, public mbed_host::I2cSlave, private NonCopyable<SimulatedL3GD20> {
+public:
+    static const int FIFO_SIZE = 32;
+
+    SimulatedL3GD20();
+    virtual ~SimulatedL3GD20();
+
+    /**
+     * Connect device to the SPI bus.
+     *
+     * @param ssel SPI ssel pin
+     */
+    void attach_spi(PinName ssel);
+
+    /**
+     * Connect device to the I2C bus.
+     *
+     * @param address 8-bit I2C address
+     */
+    void attach_i2c(int address = L3GD20_I2C_ADDRESS);
+
+    /**
+     * Connect INT2/DRDY output to the pin.
+     *
+     * @param pin
+     */
+    void connect_int2(PinName pin);
+
+    /**
+     * Connect INT1 output to the pin.
+     *
+     * @param pin
+     */
+    void connect_int1(PinName pin);
+
+    /**
+     * Set angular rate source.
+     *
+     * @param trajectory trajectory or NULL for zero rate. It should exist during device lifetime.
+     */
+    void set_trajectory(Trajectory *trajectory);
+
+    /**
+     * Set zero-rate level.
+     *
+     * @param x X axis bias in degrees per second
+     * @param y Y axis bias in degrees per second
+     * @param z Z axis bias in degrees per second
+     */
+    void set_bias(double x, double y, double z);
+
+    /**
+     * Set linear zero-rate level drift with temperature.
+     *
+     * The bias is `bias + coefficient * t`, where `t = -OUT_TEMP` is a relative temperature
+     * in degrees Celsius (see set_temperature()).
+     *
+     * @param x X axis drift in degrees per second per degree Celsius
+     * @param y Y axis drift in degrees per second per degree Celsius
+     * @param z Z axis drift in degrees per second per degree Celsius
+     */
+    void set_bias_temperature_coefficient(double x, double y, double z);
+
+    /**
+     * Set rate noise.
+     *
+     * @param rms_dps noise standard deviation in degrees per second
+     * @param seed random generator seed
+     */
+    void set_noise(double rms_dps, uint32_t seed = 1);
+
+    /**
+     * Set relative deviation of the internal oscillator.
+     *
+     * Actual output data rate is `(1 + deviation) * nominal_odr`.
+     *
+     * @param deviation relative deviation (e.g. 0.03 for +3%)
+     */
+    void set_odr_deviation(double deviation);
+
+    /**
+     * Set turn-on delay before the first sample period.
+     *
+     * Both delays are zero by default. They are model parameters, that allow to test turn-on handling
+     * (e.g. with measured values of a real device).
+     *
+     * @param power_down_us delay after power down mode (PD = 0)
+     * @param sleep_us delay after sleep mode (PD = 1, all axes are disabled)
+     */
+    void set_turn_on_delay(uint32_t power_down_us, uint32_t sleep_us);
+
+    /**
+     * Set OUT_TEMP register value.
+     *
+     * The temperature sensor sensitivity is -1 LSB per degree Celsius.
+     *
+     * @param out_temp
+     */
+    void set_temperature(int8_t out_temp);
+
+    /**
+     * Reset registers, FIFO and output to the power on state.
+     */
+    void power_on_reset();
+
+    /**
+     * Get register value without reading side effects.
+     *
+     * @param reg register address
+     * @return register value
+     */
+    uint8_t peek_register(uint8_t reg);
+
+    /**
+     * Get number of samples in FIFO.
+     */
+    int get_fifo_level();
+
+    /**
+     * Get INT2/DRDY pin level.
+     */
+    int get_int2_level();
+
+    /**
+     * Get INT1 pin level.
+     */
+    int get_int1_level();
+
+    /**
+     * Get total number of generated samples.
+     */
+    uint64_t get_sample_count();
+
+    /*
+     * RegisterTransport interface
+     */
+    virtual void read_registers(uint8_t reg, uint8_t *data, uint8_t length);
+    virtual void write_registers(uint8_t reg, const uint8_t *data, uint8_t length);
+    virtual int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback);
+    virtual void abort_async();
+
+    /*
+     * SPI slave interface
+     */
+    virtual void spi_select();
+    virtual uint8_t spi_transfer(uint8_t mosi);
+    virtual void spi_deselect();
+
+    /*
+     * I2C slave interface
+     */
+    virtual bool i2c_write(const uint8_t *data, int length);
+    virtual bool i2c_read(uint8_t *data, int length);
+
+private:
+    enum EffectiveFifoMode {
+        EFFECTIVE_BYPASS,
+        EFFECTIVE_FIFO,
+        EFFECTIVE_STREAM
+    };
+
+    static const uint8_t _REG_COUNT = 0x40;
+    uint8_t _regs[_REG_COUNT];
+
+    // sample generation
+    Trajectory *_trajectory;
+    double _bias[3];
+    double _bias_tc[3];
+    double _noise_rms;
+    uint32_t _noise_state;
+    double _odr_deviation;
+    uint32_t _power_down_turn_on_us;
+    uint32_t _sleep_turn_on_us;
+    bool _powered;
+    bool _sampling;
+    float _odr_hz;
+    uint64_t _sampling_start_us;
+    uint64_t _sampling_index;
+    uint64_t _sample_count;
+
+    // output data
+    int16_t _output[3];
+    uint8_t _status;
+    int16_t _fifo[FIFO_SIZE][3];
+    int _fifo_head;
+    int _fifo_level;
+    bool _fifo_stopped;
+
+    // INT1 interrupt generator
+    uint8_t _int1_src;
+    int _int1_set_count;
+    int _int1_reset_count;
+    // INT1 event has switched stream-to-FIFO or bypass-to-stream mode
+    bool _fifo_triggered;
+
+    // bus state
+    PinName _int1_pin;
+    PinName _int2_pin;
+    bool _spi_read;
+    bool _spi_increment;
+    int _spi_byte_index;
+    uint8_t _spi_addr;
+    bool _i2c_increment;
+    uint8_t _i2c_addr;
+
+    void _update();
+    uint64_t _get_sample_time(uint64_t index);
+    void _configure_sampling();
+    void _generate_sample(uint64_t time_us);
+    void _update_int1(const int16_t sample[3]);
+    void _reset_int1();
+    double _next_noise();
+    EffectiveFifoMode _get_fifo_mode();
+    void _update_fifo_mode();
+    uint8_t _get_fifo_src();
+    uint8_t _read_register(uint8_t reg, bool side_effects);
+    void _write_register(uint8_t reg, uint8_t val);
+    uint8_t _next_address(uint8_t reg);
+};
+}
+}
+
+#endif // L3GD20_SIM_H
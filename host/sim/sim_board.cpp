@@ -0,0 +1,25 @@
+/**
+ * Simulated STM32F3Discovery board.
+ *
+ * The L3GD20 model is connected to the test SPI pins and its INT2/DRDY output
+ * to the test DRDY pin, so the target tests can be run on host without changes.
+ */
+#include "l3gd20_sim.h"
+
+using namespace l3gd20::sim;
+
+namespace {
+struct SimulatedBoard {
+    SimulatedBoard()
+    {
+        gyro.attach_spi(MBED_CONF_L3GD20_DRIVER_TEST_SPI_CS);
+        gyro.connect_int2(MBED_CONF_L3GD20_DRIVER_TEST_DRDY);
+        // noise level of a motionless device
+        gyro.set_noise(0.02);
+    }
+
+    SimulatedL3GD20 gyro;
+};
+
+SimulatedBoard board;
+}
@@ -0,0 +1,268 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_adaptive_rate.h"
+#include "l3gd20_gyro_stream.h"
+#include "l3gd20_sim.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+static const PinName INT2_PIN = PE_1;
+static const float SENSITIVITY = 0.00875f * 0.017453292f;
+static const int MAX_RATE_CHANGES = 8;
+
+/**
+ * Fill block with constant samples.
+ */
+static void fill_block(int16_t (*samples)[3], int n, int16_t x, int16_t y, int16_t z)
+{
+    for (int i = 0; i < n; i++) {
+        samples[i][0] = x;
+        samples[i][1] = y;
+        samples[i][2] = z;
+    }
+}
+
+/**
+ * Test controller decisions and hysteresis.
+ */
+void test_controller_hysteresis()
+{
+    AdaptiveRateController::Config config;
+    AdaptiveRateController controller(config);
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    TEST_ASSERT_TRUE(controller.is_high_rate());
+
+    // low activity selects the low rate after hold time only: 500 ms contains 380 samples at 760 Hz
+    fill_block(samples, 24, 100, -50, 20);
+    int n_blocks = 0;
+    while (!controller.update(samples, 24, SENSITIVITY, 760.0f)) {
+        n_blocks++;
+        TEST_ASSERT_TRUE(n_blocks < 100);
+    }
+    TEST_ASSERT_EQUAL(15, n_blocks);
+    TEST_ASSERT_FALSE(controller.is_high_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_95_HZ, controller.get_odr());
+    TEST_ASSERT_EQUAL(4, controller.get_watermark());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, sqrtf(100 * 100 + 50 * 50 + 20 * 20) * SENSITIVITY, controller.get_activity());
+
+    // activity between thresholds doesn't change the rate: 0.15 rad/s is 981 LSB
+    fill_block(samples, 4, 0, 981, 0);
+    for (int i = 0; i < 50; i++) {
+        TEST_ASSERT_FALSE(controller.update(samples, 4, SENSITIVITY, 95.0f));
+    }
+    TEST_ASSERT_FALSE(controller.is_high_rate());
+
+    // high activity selects the high rate immediately
+    fill_block(samples, 4, 0, 0, -2000);
+    TEST_ASSERT_TRUE(controller.update(samples, 4, SENSITIVITY, 95.0f));
+    TEST_ASSERT_TRUE(controller.is_high_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_760_HZ, controller.get_odr());
+    TEST_ASSERT_EQUAL(24, controller.get_watermark());
+
+    // activity between thresholds keeps the high rate, and it restarts hold time
+    fill_block(samples, 24, 0, 0, 0);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_FALSE(controller.update(samples, 24, SENSITIVITY, 760.0f));
+    }
+    fill_block(samples, 24, 0, 981, 0);
+    for (int i = 0; i < 50; i++) {
+        TEST_ASSERT_FALSE(controller.update(samples, 24, SENSITIVITY, 760.0f));
+    }
+    TEST_ASSERT_TRUE(controller.is_high_rate());
+
+    // vibration around zero mean is activity too
+    for (int i = 0; i < 24; i++) {
+        samples[i][0] = i % 2 ? 2000 : -2000;
+    }
+    TEST_ASSERT_FALSE(controller.update(samples, 24, SENSITIVITY, 760.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, sqrtf(2000 * 2000 + 981 * 981) * SENSITIVITY, controller.get_activity());
+
+    // bias isn't activity
+    float bias[3] = { 0.0f, 981 * SENSITIVITY, 0.0f };
+    controller.set_bias(bias);
+    fill_block(samples, 24, 0, 981, 0);
+    n_blocks = 0;
+    while (!controller.update(samples, 24, SENSITIVITY, 760.0f)) {
+        n_blocks++;
+        TEST_ASSERT_TRUE(n_blocks < 100);
+    }
+    TEST_ASSERT_EQUAL(15, n_blocks);
+    TEST_ASSERT_EQUAL(3, controller.get_switch_count());
+
+    // reset selects the rate without switch
+    controller.reset(true);
+    TEST_ASSERT_TRUE(controller.is_high_rate());
+    TEST_ASSERT_EQUAL(3, controller.get_switch_count());
+}
+
+/**
+ * Stream statistics.
+ */
+struct StreamStats {
+    GyroStream *stream;
+    int n_blocks;
+    int n_samples;
+    bool monotonic;
+    uint64_t last_timestamp_us;
+    float last_odr_hz;
+    // number of blocks, whose size isn't the watermark of the current rate
+    int n_partial_blocks;
+    int watermark;
+    bool in_stream_thread;
+
+    int n_rate_changes;
+    GyroStream::RateChange rate_changes[MAX_RATE_CHANGES];
+    // sample count and timestamps at rate changes
+    int change_sample_count[MAX_RATE_CHANGES];
+    uint64_t last_timestamp_before_change_us[MAX_RATE_CHANGES];
+    uint64_t first_timestamp_after_change_us[MAX_RATE_CHANGES];
+    float first_odr_hz_after_change[MAX_RATE_CHANGES];
+};
+
+static StreamStats stream_stats;
+
+static void on_block(const GyroStream::Block &block)
+{
+    int changes = stream_stats.n_rate_changes;
+    if (changes > 0 && stream_stats.first_timestamp_after_change_us[changes - 1] == 0) {
+        stream_stats.first_timestamp_after_change_us[changes - 1] = block.timestamps[0];
+        stream_stats.first_odr_hz_after_change[changes - 1] = block.odr_hz;
+    }
+    for (int i = 0; i < block.n_samples; i++) {
+        if (stream_stats.n_blocks > 0 && block.timestamps[i] <= stream_stats.last_timestamp_us) {
+            stream_stats.monotonic = false;
+        }
+        stream_stats.last_timestamp_us = block.timestamps[i];
+    }
+    if (block.n_samples != stream_stats.watermark) {
+        stream_stats.n_partial_blocks++;
+    }
+    if (ThisThread::get_id() != stream_stats.stream->get_thread()->get_id()) {
+        stream_stats.in_stream_thread = false;
+    }
+    stream_stats.n_blocks++;
+    stream_stats.n_samples += block.n_samples;
+    stream_stats.last_odr_hz = block.odr_hz;
+}
+
+static void on_rate_change(const GyroStream::RateChange &change)
+{
+    int i = stream_stats.n_rate_changes;
+    TEST_ASSERT_TRUE(i < MAX_RATE_CHANGES);
+    stream_stats.rate_changes[i] = change;
+    stream_stats.change_sample_count[i] = stream_stats.n_samples;
+    stream_stats.last_timestamp_before_change_us[i] = stream_stats.last_timestamp_us;
+    stream_stats.first_timestamp_after_change_us[i] = 0;
+    stream_stats.watermark = change.watermark;
+    stream_stats.n_rate_changes++;
+    if (ThisThread::get_id() != stream_stats.stream->get_thread()->get_id()) {
+        stream_stats.in_stream_thread = false;
+    }
+}
+
+/**
+ * Test glitch-free rate switching of the stream with simulated device.
+ */
+void test_stream_rate_switching()
+{
+    const double odr_deviation = 0.02;
+    SegmentTrajectory trajectory;
+    SimulatedL3GD20 sim_gyro;
+    SPI spi(SPI_MOSI, SPI_MISO, SPI_SCLK);
+    L3GD20Gyroscope gyroscope(&spi, SPI_CS);
+    sim_gyro.attach_spi(SPI_CS);
+    sim_gyro.connect_int2(INT2_PIN);
+    sim_gyro.set_trajectory(&trajectory);
+    sim_gyro.set_noise(0.3);
+    sim_gyro.set_odr_deviation(odr_deviation);
+    TEST_ASSERT_EQUAL(0, gyroscope.init());
+    gyroscope.set_output_data_rate(L3GD20Gyroscope::ODR_95_HZ);
+    gyroscope.set_full_scale(L3GD20Gyroscope::FULL_SCALE_250);
+
+    // stationary for 1 second, rotation for 1 second, then stationary
+    uint64_t motion_time_us = mbed_host::get_time_us() + 1000000;
+    trajectory.add_segment(motion_time_us * 1e-6, 0.0, 0.0, 0.0);
+    trajectory.add_segment(1.0, 0.0, 0.0, 60.0);
+    trajectory.add_segment(10.0, 0.0, 0.0, 0.0);
+
+    AdaptiveRateController controller;
+    GyroStream stream(&gyroscope, INT2_PIN);
+    memset(&stream_stats, 0, sizeof(stream_stats));
+    stream_stats.stream = &stream;
+    stream_stats.monotonic = true;
+    stream_stats.in_stream_thread = true;
+    stream_stats.watermark = controller.get_config().low_watermark;
+
+    TEST_ASSERT_EQUAL(0, stream.set_rate_controller(&controller, callback(on_rate_change)));
+    uint64_t start_sample_count = sim_gyro.get_sample_count();
+    uint64_t start_time_us = mbed_host::get_time_us();
+    TEST_ASSERT_EQUAL(0, stream.start(24, callback(on_block)));
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_EBUSY, stream.set_rate_controller(NULL));
+    // the low device rate is kept at start
+    TEST_ASSERT_FALSE(controller.is_high_rate());
+    ThisThread::sleep_for(3s);
+    stream.stop();
+    uint64_t sample_count = sim_gyro.get_sample_count() - start_sample_count;
+
+    // motion onset and stop are followed by rate changes
+    TEST_ASSERT_EQUAL(2, stream_stats.n_rate_changes);
+    TEST_ASSERT_EQUAL(2, stream.get_rate_change_count());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_760_HZ, stream_stats.rate_changes[0].odr);
+    TEST_ASSERT_EQUAL(24, stream_stats.rate_changes[0].watermark);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_95_HZ, stream_stats.rate_changes[1].odr);
+    TEST_ASSERT_EQUAL(4, stream_stats.rate_changes[1].watermark);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_95_HZ, gyroscope.get_output_data_rate());
+    TEST_ASSERT_TRUE(stream_stats.in_stream_thread);
+    // the high rate is selected with the first low rate block after motion onset (4 samples at 95 Hz),
+    // and the low rate is selected after the hold time
+    uint64_t onset_delay_us = start_time_us + stream_stats.rate_changes[0].time_us - motion_time_us;
+    TEST_ASSERT(onset_delay_us <= 5 * 1000000 / 95);
+    uint64_t stop_delay_us = start_time_us + stream_stats.rate_changes[1].time_us - (motion_time_us + 1000000);
+    TEST_ASSERT(stop_delay_us >= controller.get_config().hold_time_us);
+    TEST_ASSERT(stop_delay_us <= controller.get_config().hold_time_us + 100000);
+
+    // all samples are delivered, and the blocks of the previous rate are completed by a single partial block
+    TEST_ASSERT_EQUAL(sample_count - sim_gyro.get_fifo_level(), stream_stats.n_samples);
+    TEST_ASSERT_EQUAL(0, stream.get_lost_sample_count());
+    TEST_ASSERT_TRUE(stream_stats.n_partial_blocks <= stream_stats.n_rate_changes);
+    for (int i = 0; i < stream_stats.n_rate_changes; i++) {
+        TEST_ASSERT_EQUAL(stream_stats.change_sample_count[i], stream_stats.rate_changes[i].sample_count);
+    }
+
+    // timestamps are continuous, and the measured oscillator deviation is kept
+    TEST_ASSERT_TRUE(stream_stats.monotonic);
+    for (int i = 0; i < stream_stats.n_rate_changes; i++) {
+        const GyroStream::RateChange &change = stream_stats.rate_changes[i];
+        float new_period_us = 1e6f / change.odr_hz;
+        float old_period_us = 1e6f / stream_stats.rate_changes[1 - i].odr_hz;
+        uint64_t gap_us = stream_stats.first_timestamp_after_change_us[i] - stream_stats.last_timestamp_before_change_us[i];
+        TEST_ASSERT(gap_us <= old_period_us + new_period_us + 100);
+        float nominal_odr_hz = change.odr == L3GD20Gyroscope::ODR_760_HZ ? 760.0f : 95.0f;
+        TEST_ASSERT_FLOAT_WITHIN(nominal_odr_hz * 0.005f, nominal_odr_hz * (1.0 + odr_deviation), change.odr_hz);
+        TEST_ASSERT_FLOAT_WITHIN(nominal_odr_hz * 0.005f, nominal_odr_hz * (1.0 + odr_deviation), stream_stats.first_odr_hz_after_change[i]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(95 * 0.005f, 95 * (1.0 + odr_deviation), stream_stats.last_odr_hz);
+}
+
+// test cases description
+#define AdaptiveRateCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    AdaptiveRateCase(test_controller_hysteresis),
+    AdaptiveRateCase(test_stream_rate_switching)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
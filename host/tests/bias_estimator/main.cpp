@@ -0,0 +1,156 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_bias_estimator.h"
+#include "l3gd20_driver.h"
+#include "l3gd20_sim.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+
+static const float RAD_PER_DEGREE = (float)M_PI / 180.0f;
+
+/**
+ * Fill block with rate samples: `offset + amplitude * sin(...)` with small noise.
+ */
+static void fill_rates(float (*rates)[3], int n, int start, const float offset[3], float amplitude)
+{
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) {
+            float noise = 0.001f * (((start + i) * 7919 + j * 104729) % 11 - 5) / 5.0f;
+            rates[i][j] = offset[j] + amplitude * sinf(0.05f * (start + i) + j) + noise;
+        }
+    }
+}
+
+/**
+ * Test stationary detection and bias estimation with synthetic data.
+ */
+void test_synthetic_rates()
+{
+    const int window_size = 128;
+    const float bias[3] = { 0.02f, -0.01f, 0.03f };
+    const float slow_rotation[3] = { 0.02f, 0.5f, 0.03f };
+    float rates[32][3];
+    float estimated_bias[3];
+    BiasEstimator estimator(window_size);
+
+    estimator.get_bias(estimated_bias);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, estimated_bias[0]);
+    TEST_ASSERT_FALSE(estimator.is_stationary());
+
+    // vibration
+    int k = 0;
+    for (; k < window_size * 4; k += 32) {
+        fill_rates(rates, 32, k, bias, 0.2f);
+        estimator.update(rates, 32);
+    }
+    TEST_ASSERT_EQUAL(0, estimator.get_stationary_window_count());
+
+    // constant rotation above bias limit
+    for (; k < window_size * 8; k += 32) {
+        fill_rates(rates, 32, k, slow_rotation, 0.0f);
+        estimator.update(rates, 32);
+    }
+    TEST_ASSERT_EQUAL(0, estimator.get_stationary_window_count());
+
+    // motionless device
+    for (; k < window_size * 12; k += 32) {
+        fill_rates(rates, 32, k, bias, 0.0f);
+        estimator.update(rates, 32);
+    }
+    TEST_ASSERT_TRUE(estimator.is_stationary());
+    TEST_ASSERT_EQUAL(4, estimator.get_stationary_window_count());
+    estimator.get_bias(estimated_bias);
+    for (int j = 0; j < 3; j++) {
+        TEST_ASSERT_FLOAT_WITHIN(2e-4f, bias[j], estimated_bias[j]);
+    }
+
+    // vibration again: bias isn't changed
+    for (; k < window_size * 14; k += 32) {
+        fill_rates(rates, 32, k, slow_rotation, 0.2f);
+        estimator.update(rates, 32);
+    }
+    TEST_ASSERT_FALSE(estimator.is_stationary());
+    TEST_ASSERT_EQUAL(4, estimator.get_stationary_window_count());
+    estimator.get_bias(estimated_bias);
+    TEST_ASSERT_FLOAT_WITHIN(2e-4f, bias[1], estimated_bias[1]);
+
+    // initial bias is refined by the next windows
+    estimator.reset();
+    const float initial_bias[3] = { 0.0f, 0.0f, 0.0f };
+    estimator.set_bias(initial_bias);
+    for (k = 0; k < window_size * 8; k += 32) {
+        fill_rates(rates, 32, k, bias, 0.0f);
+        estimator.update(rates, 32);
+    }
+    estimator.get_bias(estimated_bias);
+    // 8 stationary windows and initial value with weight of 8 windows
+    TEST_ASSERT_FLOAT_WITHIN(2e-4f, bias[2] / 2, estimated_bias[2]);
+}
+
+/**
+ * Test bias estimation with simulated device, that vibrates at startup.
+ */
+void test_simulated_device()
+{
+    SimulatedL3GD20 sim_gyro;
+    sim_gyro.attach_spi(SPI_CS);
+    sim_gyro.set_bias(1.0, -0.5, 2.0);
+    sim_gyro.set_noise(0.05);
+    const double amplitude[3] = { 5.0, 3.0, 4.0 };
+    const double frequency[3] = { 20.0, 35.0, 50.0 };
+    SineTrajectory vibration(amplitude, frequency);
+    sim_gyro.set_trajectory(&vibration);
+
+    L3GD20Gyroscope gyro(SPI_MOSI, SPI_MISO, SPI_SCLK, SPI_CS);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro.clear_fifo();
+    BiasEstimator estimator;
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    float sensitivity = gyro.get_sensitivity();
+
+    for (int t = 0; t < 4000; t += 20) {
+        if (t == 1000) {
+            // device is placed on a table
+            sim_gyro.set_trajectory(NULL);
+        }
+        ThisThread::sleep_for(20ms);
+        int n = gyro.read_fifo(samples);
+        estimator.update(samples, n, sensitivity);
+        if (t < 1000) {
+            TEST_ASSERT_EQUAL(0, estimator.get_stationary_window_count());
+        }
+    }
+
+    float bias[3];
+    estimator.get_bias(bias);
+    TEST_ASSERT(estimator.get_stationary_window_count() >= 7);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f * RAD_PER_DEGREE, 1.0f * RAD_PER_DEGREE, bias[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f * RAD_PER_DEGREE, -0.5f * RAD_PER_DEGREE, bias[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f * RAD_PER_DEGREE, 2.0f * RAD_PER_DEGREE, bias[2]);
+}
+
+// test cases description
+#define BiasCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    BiasCase(test_synthetic_rates),
+    BiasCase(test_simulated_device)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
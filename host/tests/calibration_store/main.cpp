@@ -0,0 +1,165 @@
+#include "blockdevice/HeapBlockDevice.h"
+#include "greentea-client/test_env.h"
+#include "l3gd20_calibration_store.h"
+#include "l3gd20_timestamper.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+
+/**
+ * Heap block device that counts read and program operations.
+ */
+class CountingBlockDevice : public HeapBlockDevice {
+public:
+    CountingBlockDevice(bd_size_t size, bd_size_t read, bd_size_t program, bd_size_t erase)
+        : HeapBlockDevice(size, read, program, erase)
+        , reads(0)
+        , programs(0)
+    {
+    }
+
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        reads++;
+        return HeapBlockDevice::read(buffer, addr, size);
+    }
+
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        programs++;
+        return HeapBlockDevice::program(buffer, addr, size);
+    }
+
+    int reads;
+    int programs;
+};
+
+static CalibrationStore::Calibration create_calibration()
+{
+    CalibrationStore::Calibration calibration;
+    calibration.full_scale = L3GD20Gyroscope::FULL_SCALE_500;
+    calibration.odr = L3GD20Gyroscope::ODR_380_HZ;
+    calibration.bias[0] = 0.0123f;
+    calibration.bias[1] = -0.0045f;
+    calibration.bias[2] = 0.0301f;
+    calibration.temperature = -12;
+    calibration.odr_hz = 391.25f;
+    return calibration;
+}
+
+/**
+ * Test calibration saving and loading with different block device geometries.
+ */
+void test_save_load()
+{
+    // byte addressable device, and device with large program unit
+    const bd_size_t geometries[][3] = { { 1, 1, 512 }, { 16, 64, 4096 } };
+    for (size_t k = 0; k < sizeof(geometries) / sizeof(geometries[0]); k++) {
+        CountingBlockDevice block_device(16384, geometries[k][0], geometries[k][1], geometries[k][2]);
+        TEST_ASSERT_EQUAL(0, block_device.init());
+        bd_addr_t address = geometries[k][2];
+        CalibrationStore store(&block_device, address);
+        CalibrationStore::Calibration calibration;
+
+        // blank device
+        int err = store.load(&calibration, L3GD20Gyroscope::FULL_SCALE_500, L3GD20Gyroscope::ODR_380_HZ);
+        TEST_ASSERT_EQUAL(MBED_ERROR_CODE_ITEM_NOT_FOUND, err);
+
+        const CalibrationStore::Calibration saved = create_calibration();
+        TEST_ASSERT_EQUAL(0, store.save(saved));
+        TEST_ASSERT_EQUAL(1, block_device.programs);
+
+        // restore with a single read
+        block_device.reads = 0;
+        err = store.load(&calibration, L3GD20Gyroscope::FULL_SCALE_500, L3GD20Gyroscope::ODR_380_HZ);
+        TEST_ASSERT_EQUAL(0, err);
+        TEST_ASSERT_EQUAL(1, block_device.reads);
+        TEST_ASSERT_EQUAL(saved.full_scale, calibration.full_scale);
+        TEST_ASSERT_EQUAL(saved.odr, calibration.odr);
+        TEST_ASSERT_EQUAL(saved.temperature, calibration.temperature);
+        for (int i = 0; i < 3; i++) {
+            TEST_ASSERT_EQUAL_FLOAT(saved.bias[i], calibration.bias[i]);
+        }
+        TEST_ASSERT_EQUAL_FLOAT(saved.odr_hz, calibration.odr_hz);
+
+        // the record is invalidated
+        TEST_ASSERT_EQUAL(0, store.erase());
+        err = store.load(&calibration, L3GD20Gyroscope::FULL_SCALE_500, L3GD20Gyroscope::ODR_380_HZ);
+        TEST_ASSERT_EQUAL(MBED_ERROR_CODE_ITEM_NOT_FOUND, err);
+        TEST_ASSERT_EQUAL(0, block_device.deinit());
+    }
+}
+
+/**
+ * Test validity checks.
+ */
+void test_validity_checks()
+{
+    CountingBlockDevice block_device(4096, 1, 1, 512);
+    TEST_ASSERT_EQUAL(0, block_device.init());
+    CalibrationStore store(&block_device);
+    CalibrationStore::Calibration calibration;
+    const CalibrationStore::Calibration saved = create_calibration();
+    TEST_ASSERT_EQUAL(0, store.save(saved));
+
+    // other configuration
+    int err = store.load(&calibration, L3GD20Gyroscope::FULL_SCALE_250, L3GD20Gyroscope::ODR_380_HZ);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_FORMAT, err);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FULL_SCALE_500, calibration.full_scale);
+    err = store.load(&calibration, L3GD20Gyroscope::FULL_SCALE_500, L3GD20Gyroscope::ODR_760_HZ);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_FORMAT, err);
+
+    // corrupted bias
+    uint8_t value;
+    TEST_ASSERT_EQUAL(0, block_device.read(&value, 13, 1));
+    value ^= 0x04;
+    TEST_ASSERT_EQUAL(0, block_device.program(&value, 13, 1));
+    err = store.load(&calibration, L3GD20Gyroscope::FULL_SCALE_500, L3GD20Gyroscope::ODR_380_HZ);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_DATA_DETECTED, err);
+
+    // too large program unit
+    CountingBlockDevice large_block_device(4096, 512, 512, 512);
+    TEST_ASSERT_EQUAL(0, large_block_device.init());
+    CalibrationStore large_store(&large_block_device);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_SIZE, large_store.save(saved));
+}
+
+/**
+ * Test timestamper initialization with stored output data rate.
+ */
+void test_restore_odr()
+{
+    SampleTimestamper timestamper(380.0f);
+    const CalibrationStore::Calibration saved = create_calibration();
+    timestamper.set_odr_hz(saved.odr_hz);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, saved.odr_hz, timestamper.get_odr_hz());
+
+    // the first block is timestamped with restored rate
+    uint64_t timestamps[4];
+    timestamper.update(1000000, 4, 4, timestamps);
+    TEST_ASSERT_EQUAL(1000000, timestamps[3]);
+    TEST_ASSERT_INT_WITHIN(1, 1000000 - (int)(3e6f / saved.odr_hz), (int)timestamps[0]);
+
+    // the value is limited by nominal rate
+    timestamper.set_odr_hz(1000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, 380.0f / 0.8f, timestamper.get_odr_hz());
+}
+
+// test cases description
+#define CalibrationCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    CalibrationCase(test_save_load),
+    CalibrationCase(test_validity_checks),
+    CalibrationCase(test_restore_odr)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
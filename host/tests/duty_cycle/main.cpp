@@ -0,0 +1,241 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_duty_cycle.h"
+#include "l3gd20_sim.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+static const PinName INT2_PIN = PE_1;
+static const int16_t EXPECTED_SAMPLE[3] = { 1000, -3000, 2000 };
+// turn-on delays of the model (they aren't measured values of a real device)
+static const uint32_t POWER_DOWN_TURN_ON_US = 100000;
+static const uint32_t SLEEP_TURN_ON_US = 0;
+
+/**
+ * Capture statistics.
+ */
+struct CaptureStats {
+    int n_captures;
+    int n_samples;
+    int max_sample_error;
+    uint64_t last_wake_time_us;
+    uint64_t max_wake_interval_us;
+    uint64_t min_wake_interval_us;
+    // CTRL_REG1 power bits after capture
+    uint8_t idle_power_bits;
+    SimulatedL3GD20 *sim_gyro;
+    // expected sample (zero values of the disabled axes)
+    int16_t expected_sample[3];
+};
+
+static CaptureStats capture_stats;
+
+static void on_capture(const DutyCycleScheduler::Capture &capture)
+{
+    if (capture_stats.n_captures > 0) {
+        uint64_t interval_us = capture.wake_time_us - capture_stats.last_wake_time_us;
+        capture_stats.max_wake_interval_us = interval_us > capture_stats.max_wake_interval_us ? interval_us : capture_stats.max_wake_interval_us;
+        capture_stats.min_wake_interval_us = interval_us < capture_stats.min_wake_interval_us ? interval_us : capture_stats.min_wake_interval_us;
+    }
+    capture_stats.last_wake_time_us = capture.wake_time_us;
+    capture_stats.n_captures++;
+    capture_stats.n_samples += capture.n_samples;
+    for (int i = 0; i < capture.n_samples; i++) {
+        for (int j = 0; j < 3; j++) {
+            int error = abs(capture.samples[i][j] - capture_stats.expected_sample[j]);
+            capture_stats.max_sample_error = error > capture_stats.max_sample_error ? error : capture_stats.max_sample_error;
+        }
+    }
+    capture_stats.idle_power_bits = capture_stats.sim_gyro->peek_register(L3GD20Gyroscope::CTRL_REG1_ADDR) & 0x0F;
+}
+
+/**
+ * Helper object with simulated device and its driver.
+ */
+struct DutyCycleFixture {
+    DutyCycleFixture()
+        : trajectory(EXPECTED_SAMPLE[0] * 0.00875, EXPECTED_SAMPLE[1] * 0.00875, EXPECTED_SAMPLE[2] * 0.00875)
+        , spi(SPI_MOSI, SPI_MISO, SPI_SCLK)
+        , gyroscope(&spi, SPI_CS)
+    {
+        memset(&capture_stats, 0, sizeof(capture_stats));
+        capture_stats.min_wake_interval_us = UINT64_MAX;
+        capture_stats.sim_gyro = &sim_gyro;
+        memcpy(capture_stats.expected_sample, EXPECTED_SAMPLE, sizeof(EXPECTED_SAMPLE));
+        sim_gyro.attach_spi(SPI_CS);
+        sim_gyro.connect_int2(INT2_PIN);
+        sim_gyro.set_trajectory(&trajectory);
+        sim_gyro.set_turn_on_delay(POWER_DOWN_TURN_ON_US, SLEEP_TURN_ON_US);
+        TEST_ASSERT_EQUAL(0, gyroscope.init());
+        gyroscope.set_full_scale(L3GD20Gyroscope::FULL_SCALE_250);
+    }
+
+    ConstantTrajectory trajectory;
+    SimulatedL3GD20 sim_gyro;
+    SPI spi;
+    L3GD20Gyroscope gyroscope;
+};
+
+/**
+ * Run scheduler for the specified time and check captures.
+ */
+static DutyCycleScheduler::LatencyStats run_scheduler(DutyCycleFixture &fixture, const DutyCycleScheduler::Config &config, int run_time_ms)
+{
+    DutyCycleScheduler scheduler(&fixture.gyroscope, INT2_PIN);
+    uint64_t start_sample_count = fixture.sim_gyro.get_sample_count();
+    TEST_ASSERT_EQUAL(0, scheduler.start(config, callback(on_capture)));
+    TEST_ASSERT_TRUE(scheduler.is_running());
+    ThisThread::sleep_for(std::chrono::milliseconds(run_time_ms));
+    scheduler.stop();
+    TEST_ASSERT_FALSE(scheduler.is_running());
+    uint64_t sample_count = fixture.sim_gyro.get_sample_count() - start_sample_count;
+
+    DutyCycleScheduler::LatencyStats stats = scheduler.get_latency_stats();
+    TEST_ASSERT_EQUAL(capture_stats.n_captures, stats.n_captures);
+    TEST_ASSERT_EQUAL(capture_stats.n_captures * config.n_samples, capture_stats.n_samples);
+    TEST_ASSERT(capture_stats.max_sample_error <= 1);
+    // the device doesn't sample between captures
+    int max_cycle_samples = 1 + scheduler.get_settling_samples() + config.n_samples + 2;
+    TEST_ASSERT(sample_count <= (uint64_t)(capture_stats.n_captures + 1) * max_cycle_samples);
+    // the wake period is kept
+    TEST_ASSERT(capture_stats.max_wake_interval_us - config.period_us <= 100);
+    TEST_ASSERT(capture_stats.min_wake_interval_us >= config.period_us);
+    return stats;
+}
+
+/**
+ * Test duty cycle with sleep mode between captures.
+ */
+void test_sleep_mode_cycles()
+{
+    DutyCycleFixture fixture;
+    DutyCycleScheduler::Config config;
+    config.period_us = 200000;
+    config.n_samples = 8;
+    config.idle_mode = L3GD20Gyroscope::G_SLEEP;
+
+    DutyCycleScheduler::LatencyStats stats = run_scheduler(fixture, config, 1000);
+    TEST_ASSERT_EQUAL(5, capture_stats.n_captures);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::G_SLEEP, capture_stats.idle_power_bits);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::G_SLEEP, fixture.gyroscope.get_gyroscope_mode());
+
+    // the first sample arrives one sample period after wake, and 7 samples are skipped for 12.5 Hz LPF at 95 Hz
+    int sample_period_us = 1000000 / 95;
+    TEST_ASSERT_INT_WITHIN(100, sample_period_us, stats.min_turn_on_latency_us);
+    TEST_ASSERT_INT_WITHIN(100, sample_period_us, stats.max_turn_on_latency_us);
+    TEST_ASSERT(stats.min_valid_data_latency_us >= (uint32_t)(7 + 1) * sample_period_us - 100);
+    TEST_ASSERT(stats.max_valid_data_latency_us <= (uint32_t)(7 + 2) * sample_period_us + 100);
+}
+
+/**
+ * Test duty cycle with power down mode between captures.
+ */
+void test_power_down_cycles()
+{
+    DutyCycleFixture fixture;
+    fixture.gyroscope.set_output_data_rate(L3GD20Gyroscope::ODR_380_HZ);
+    DutyCycleScheduler::Config config;
+    config.period_us = 250000;
+    config.n_samples = 16;
+    config.idle_mode = L3GD20Gyroscope::G_DISABLE;
+    config.axes = L3GD20Gyroscope::AXIS_X_ENABLE | L3GD20Gyroscope::AXIS_Z_ENABLE;
+    config.settling_samples = 4;
+    capture_stats.expected_sample[1] = 0;
+
+    DutyCycleScheduler::LatencyStats stats = run_scheduler(fixture, config, 1000);
+    TEST_ASSERT_EQUAL(4, capture_stats.n_captures);
+    // power down mode keeps axes configuration
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::AXIS_X_ENABLE | L3GD20Gyroscope::AXIS_Z_ENABLE, capture_stats.idle_power_bits);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::G_DISABLE, fixture.gyroscope.get_gyroscope_mode());
+
+    // turn-on latency includes the power down delay of the model
+    int sample_period_us = 1000000 / 380;
+    TEST_ASSERT_INT_WITHIN(100, POWER_DOWN_TURN_ON_US + sample_period_us, stats.min_turn_on_latency_us);
+    TEST_ASSERT_INT_WITHIN(100, POWER_DOWN_TURN_ON_US + sample_period_us, stats.max_turn_on_latency_us);
+    TEST_ASSERT(stats.min_valid_data_latency_us >= POWER_DOWN_TURN_ON_US + (4 + 1) * sample_period_us - 100);
+    TEST_ASSERT(stats.max_valid_data_latency_us <= POWER_DOWN_TURN_ON_US + (4 + 2) * sample_period_us + 100);
+}
+
+/**
+ * Test settling time estimation and argument checks.
+ */
+void test_settling_and_arguments()
+{
+    DutyCycleFixture fixture;
+    // LPF2 12.5 Hz at 95 Hz: ceil(0.733 / 12.5 Hz * 95 Hz) + 1
+    TEST_ASSERT_EQUAL(7, fixture.gyroscope.get_settling_sample_count());
+    // LPF2 110 Hz at 760 Hz
+    fixture.gyroscope.set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    fixture.gyroscope.set_low_pass_filter_cutoff_freq_mode(L3GD20Gyroscope::LPF_CF3);
+    TEST_ASSERT_EQUAL(7, fixture.gyroscope.get_settling_sample_count());
+    // high pass filter with 51.4 Hz cutoff at 760 Hz
+    fixture.gyroscope.set_high_pass_filter_mode(L3GD20Gyroscope::HPF_ENABLE);
+    TEST_ASSERT_EQUAL(18, fixture.gyroscope.get_settling_sample_count());
+    fixture.gyroscope.set_high_pass_filter_mode(L3GD20Gyroscope::HPF_DISABLE);
+
+    DutyCycleScheduler scheduler(&fixture.gyroscope, INT2_PIN);
+    DutyCycleScheduler::Config config;
+    DutyCycleScheduler::Config invalid_config;
+    invalid_config.n_samples = L3GD20Gyroscope::FIFO_SIZE;
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, scheduler.start(invalid_config, callback(on_capture)));
+    invalid_config = config;
+    invalid_config.idle_mode = L3GD20Gyroscope::G_ENABLE;
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, scheduler.start(invalid_config, callback(on_capture)));
+    invalid_config = config;
+    invalid_config.axes = 0;
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, scheduler.start(invalid_config, callback(on_capture)));
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, scheduler.start(config, nullptr));
+    TEST_ASSERT_FALSE(scheduler.is_running());
+
+    TEST_ASSERT_EQUAL(0, scheduler.start(config, callback(on_capture)));
+    TEST_ASSERT_EQUAL(7, scheduler.get_settling_samples());
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_EBUSY, scheduler.start(config, callback(on_capture)));
+    // the scheduler is stopped by destructor during capture
+    ThisThread::sleep_for(30ms);
+}
+
+/**
+ * Test that stop cancels pending events.
+ */
+void test_stop_cancels_events()
+{
+    DutyCycleFixture fixture;
+    // the queue isn't dispatched, so the events remain pending
+    EventQueue queue;
+    DutyCycleScheduler::Config config;
+    {
+        DutyCycleScheduler scheduler(&fixture.gyroscope, INT2_PIN, &queue);
+        TEST_ASSERT_EQUAL(0, scheduler.start(config, callback(on_capture)));
+        ThisThread::sleep_for(20ms);
+        TEST_ASSERT_EQUAL(1, queue.get_posted_count());
+        scheduler.stop();
+        TEST_ASSERT_EQUAL(0, queue.get_posted_count());
+    }
+    queue.dispatch_posted();
+    TEST_ASSERT_EQUAL(0, capture_stats.n_captures);
+}
+
+// test cases description
+#define DutyCycleCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    DutyCycleCase(test_sleep_mode_cycles),
+    DutyCycleCase(test_power_down_cycles),
+    DutyCycleCase(test_settling_and_arguments),
+    DutyCycleCase(test_stop_cancels_events)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
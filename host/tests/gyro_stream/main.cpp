@@ -0,0 +1,257 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_gyro_stream.h"
+#include "l3gd20_sim.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+static const PinName INT2_PIN = PE_1;
+static const int BLOCK_SIZE = 24;
+
+/**
+ * Block statistics.
+ */
+struct BlockStats {
+    GyroStream *stream;
+    int n_blocks;
+    int n_samples;
+    int min_block_size;
+    int max_block_size;
+    bool in_stream_thread;
+    bool monotonic;
+    uint64_t last_timestamp_us;
+    int max_sample_error;
+    int8_t temperature;
+    float odr_hz;
+    // stop the stream from the callback after this number of blocks (0 - disabled)
+    int stop_block;
+    // delay the processing of this block (0 - disabled)
+    int stall_block;
+};
+
+static BlockStats block_stats;
+static const int16_t EXPECTED_SAMPLE[3] = { 5000, -2000, 1000 };
+
+static void reset_block_stats(GyroStream *stream)
+{
+    memset(&block_stats, 0, sizeof(block_stats));
+    block_stats.stream = stream;
+    block_stats.min_block_size = L3GD20Gyroscope::FIFO_SIZE;
+    block_stats.in_stream_thread = true;
+    block_stats.monotonic = true;
+}
+
+static void on_block(const GyroStream::Block &block)
+{
+    block_stats.n_blocks++;
+    block_stats.n_samples += block.n_samples;
+    block_stats.min_block_size = block.n_samples < block_stats.min_block_size ? block.n_samples : block_stats.min_block_size;
+    block_stats.max_block_size = block.n_samples > block_stats.max_block_size ? block.n_samples : block_stats.max_block_size;
+    if (ThisThread::get_id() != block_stats.stream->get_thread()->get_id()) {
+        block_stats.in_stream_thread = false;
+    }
+    for (int i = 0; i < block.n_samples; i++) {
+        // the first timestamps are unknown until the first interrupt edge
+        if (block_stats.n_blocks > 1 && block.timestamps[i] <= block_stats.last_timestamp_us) {
+            block_stats.monotonic = false;
+        }
+        block_stats.last_timestamp_us = block.timestamps[i];
+        for (int j = 0; j < 3; j++) {
+            int error = abs(block.samples[i][j] - EXPECTED_SAMPLE[j]);
+            block_stats.max_sample_error = error > block_stats.max_sample_error ? error : block_stats.max_sample_error;
+        }
+    }
+    block_stats.temperature = block.temperature;
+    block_stats.odr_hz = block.odr_hz;
+
+    if (block_stats.n_blocks == block_stats.stall_block) {
+        // events aren't processed in the nested context, so FIFO overruns
+        wait_us(80000);
+    }
+    if (block_stats.n_blocks == block_stats.stop_block) {
+        block_stats.stream->stop();
+    }
+}
+
+/**
+ * Helper object with simulated device and its driver.
+ */
+struct StreamFixture {
+    StreamFixture(double odr_deviation = 0.0)
+        : trajectory(EXPECTED_SAMPLE[0] * 0.00875, EXPECTED_SAMPLE[1] * 0.00875, EXPECTED_SAMPLE[2] * 0.00875)
+        , spi(SPI_MOSI, SPI_MISO, SPI_SCLK)
+        , gyroscope(&spi, SPI_CS)
+    {
+        sim_gyro.attach_spi(SPI_CS);
+        sim_gyro.connect_int2(INT2_PIN);
+        sim_gyro.set_odr_deviation(odr_deviation);
+        sim_gyro.set_trajectory(&trajectory);
+        sim_gyro.set_temperature(-12);
+        TEST_ASSERT_EQUAL(0, gyroscope.init());
+        gyroscope.set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+        gyroscope.set_full_scale(L3GD20Gyroscope::FULL_SCALE_250);
+    }
+
+    ConstantTrajectory trajectory;
+    SimulatedL3GD20 sim_gyro;
+    SPI spi;
+    L3GD20Gyroscope gyroscope;
+};
+
+/**
+ * Test contiguous blocks of the watermark interrupt driven stream.
+ */
+void test_stream_blocks()
+{
+    StreamFixture fixture(0.02);
+    GyroStream stream(&fixture.gyroscope, INT2_PIN, osPriorityHigh7, 2048, "test_stream");
+    TEST_ASSERT_EQUAL(osPriorityHigh7, stream.get_thread()->get_priority());
+    TEST_ASSERT_EQUAL(2048, stream.get_thread()->stack_size());
+
+    reset_block_stats(&stream);
+    TEST_ASSERT_EQUAL(0, stream.start(BLOCK_SIZE, callback(on_block)));
+    TEST_ASSERT_TRUE(stream.is_running());
+    uint64_t start_sample_count = fixture.sim_gyro.get_sample_count();
+    ThisThread::sleep_for(2s);
+    stream.stop();
+    TEST_ASSERT_FALSE(stream.is_running());
+    uint64_t sample_count = fixture.sim_gyro.get_sample_count() - start_sample_count;
+
+    // all samples are delivered in the blocks of the watermark size
+    TEST_ASSERT_EQUAL((uint32_t)block_stats.n_blocks, stream.get_block_count());
+    TEST_ASSERT_EQUAL(sample_count - fixture.sim_gyro.get_fifo_level(), block_stats.n_samples);
+    TEST_ASSERT_EQUAL(BLOCK_SIZE, block_stats.min_block_size);
+    TEST_ASSERT_EQUAL(BLOCK_SIZE, block_stats.max_block_size);
+    TEST_ASSERT_EQUAL(0, stream.get_lost_sample_count());
+    TEST_ASSERT_TRUE(block_stats.in_stream_thread);
+    TEST_ASSERT_TRUE(block_stats.monotonic);
+    TEST_ASSERT(block_stats.max_sample_error <= 1);
+    TEST_ASSERT_EQUAL(-12, block_stats.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(760 * 0.02 * 0.1, 760 * 1.02, block_stats.odr_hz);
+
+    // no blocks after stop
+    int n_blocks = block_stats.n_blocks;
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(n_blocks, block_stats.n_blocks);
+}
+
+/**
+ * Test start and stop sequences.
+ */
+void test_start_stop()
+{
+    StreamFixture fixture;
+    GyroStream stream(&fixture.gyroscope, INT2_PIN);
+    reset_block_stats(&stream);
+
+    // invalid arguments
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, stream.start(0, callback(on_block)));
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, stream.start(L3GD20Gyroscope::FIFO_SIZE, callback(on_block)));
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, stream.start(BLOCK_SIZE, nullptr));
+    TEST_ASSERT_FALSE(stream.is_running());
+    // stop of the stopped stream does nothing
+    stream.stop();
+
+    // restart
+    for (int i = 0; i < 3; i++) {
+        reset_block_stats(&stream);
+        TEST_ASSERT_EQUAL(0, stream.start(BLOCK_SIZE, callback(on_block)));
+        TEST_ASSERT_EQUAL(MBED_ERROR_CODE_EBUSY, stream.start(BLOCK_SIZE, callback(on_block)));
+        ThisThread::sleep_for(200ms);
+        stream.stop();
+        // 200 ms contains 152 samples
+        TEST_ASSERT_INT_WITHIN(1, 6, block_stats.n_blocks);
+        TEST_ASSERT_EQUAL(block_stats.n_blocks, stream.get_block_count());
+    }
+    TEST_ASSERT_EQUAL(0, fixture.sim_gyro.get_int2_level());
+
+    // stop from the block callback
+    reset_block_stats(&stream);
+    block_stats.stop_block = 3;
+    TEST_ASSERT_EQUAL(0, stream.start(BLOCK_SIZE, callback(on_block)));
+    ThisThread::sleep_for(500ms);
+    TEST_ASSERT_FALSE(stream.is_running());
+    TEST_ASSERT_EQUAL(3, block_stats.n_blocks);
+
+    // the stream is stopped by destructor
+    reset_block_stats(&stream);
+    TEST_ASSERT_EQUAL(0, stream.start(BLOCK_SIZE, callback(on_block)));
+    ThisThread::sleep_for(100ms);
+}
+
+/**
+ * Test that FIFO overrun due processing delay is accounted.
+ */
+void test_overrun()
+{
+    StreamFixture fixture;
+    GyroStream stream(&fixture.gyroscope, INT2_PIN);
+    reset_block_stats(&stream);
+    block_stats.stall_block = 10;
+
+    TEST_ASSERT_EQUAL(0, stream.start(BLOCK_SIZE, callback(on_block)));
+    uint64_t start_sample_count = fixture.sim_gyro.get_sample_count();
+    ThisThread::sleep_for(1s);
+    stream.stop();
+    uint64_t sample_count = fixture.sim_gyro.get_sample_count() - start_sample_count;
+    uint32_t lost_sample_count = stream.get_lost_sample_count();
+
+    // 80 ms delay is 61 samples, so 29 samples of the full FIFO are overwritten
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_SIZE, block_stats.max_block_size);
+    TEST_ASSERT_INT_WITHIN(1, 61 - L3GD20Gyroscope::FIFO_SIZE, lost_sample_count);
+    TEST_ASSERT_INT_WITHIN(1, sample_count - fixture.sim_gyro.get_fifo_level(), block_stats.n_samples + lost_sample_count);
+    TEST_ASSERT_TRUE(block_stats.monotonic);
+}
+
+/**
+ * Test start and stop, if events can't be posted to the stream thread.
+ */
+void test_event_allocation_failure()
+{
+    StreamFixture fixture;
+    GyroStream stream(&fixture.gyroscope, INT2_PIN);
+    reset_block_stats(&stream);
+
+    // start doesn't wait for the event, that isn't posted
+    mbed_host::fail_event_allocations(1);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_ENOMEM, stream.start(BLOCK_SIZE, callback(on_block)));
+    TEST_ASSERT_FALSE(stream.is_running());
+
+    TEST_ASSERT_EQUAL(0, stream.start(BLOCK_SIZE, callback(on_block)));
+    ThisThread::sleep_for(200ms);
+    TEST_ASSERT(block_stats.n_blocks > 0);
+
+    // stop is retried
+    mbed_host::fail_event_allocations(3);
+    stream.stop();
+    mbed_host::fail_event_allocations(0);
+    TEST_ASSERT_FALSE(stream.is_running());
+    int n_blocks = block_stats.n_blocks;
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(n_blocks, block_stats.n_blocks);
+}
+
+// test cases description
+#define StreamCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    StreamCase(test_stream_blocks),
+    StreamCase(test_start_stop),
+    StreamCase(test_overrun),
+    StreamCase(test_event_allocation_failure)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
@@ -0,0 +1,288 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_gyroscope_group.h"
+#include "l3gd20_sim.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const int N_GYROSCOPES = 4;
+static const PinName SPI_CS_PINS[N_GYROSCOPES] = { PE_3, PE_4, PE_5, PE_6 };
+static const PinName INT2_PINS[N_GYROSCOPES] = { PE_1, PE_2, PE_7, PE_8 };
+// oscillators of the devices have different deviations
+static const double ODR_DEVIATIONS[N_GYROSCOPES] = { 0.0, 0.015, -0.02, 0.005 };
+
+/**
+ * Block statistics.
+ */
+struct BlockStats {
+    int n_blocks;
+    int n_samples;
+    uint64_t max_time_difference_us;
+    uint64_t max_first_time_difference_us;
+    int max_first_sample_difference;
+    uint64_t last_timestamp_us;
+    bool monotonic;
+};
+
+static BlockStats block_stats;
+
+static void on_block(const GyroscopeGroup::Block &block)
+{
+    block_stats.n_blocks++;
+    block_stats.n_samples += block.n_samples;
+    for (int k = 0; k < block.n_samples; k++) {
+        uint64_t t0 = block.timestamps[0][k];
+        if (t0 <= block_stats.last_timestamp_us) {
+            block_stats.monotonic = false;
+        }
+        block_stats.last_timestamp_us = t0;
+        // skip startup samples before the first estimation of the sample period
+        if (block_stats.n_blocks <= 2) {
+            continue;
+        }
+        for (int i = 1; i < block.n_gyroscopes; i++) {
+            uint64_t t = block.timestamps[i][k];
+            uint64_t dt = t > t0 ? t - t0 : t0 - t;
+            block_stats.max_time_difference_us = dt > block_stats.max_time_difference_us ? dt : block_stats.max_time_difference_us;
+            if (k > 0) {
+                continue;
+            }
+            block_stats.max_first_time_difference_us = dt > block_stats.max_first_time_difference_us ? dt : block_stats.max_first_time_difference_us;
+            for (int j = 0; j < 3; j++) {
+                int ds = abs(block.samples[i][k][j] - block.samples[0][k][j]);
+                block_stats.max_first_sample_difference = ds > block_stats.max_first_sample_difference ? ds : block_stats.max_first_sample_difference;
+            }
+        }
+    }
+}
+
+/**
+ * Test synchronized acquisition of 4 devices on one SPI bus, whose oscillators have different deviations.
+ */
+void test_aligned_blocks()
+{
+    // all devices are mounted on the same rotating body
+    const double amplitude[3] = { 100.0, 60.0, 80.0 };
+    const double frequency[3] = { 2.0, 3.0, 1.0 };
+    SineTrajectory trajectory(amplitude, frequency);
+    SimulatedL3GD20 sim_gyros[N_GYROSCOPES];
+    for (int i = 0; i < N_GYROSCOPES; i++) {
+        sim_gyros[i].attach_spi(SPI_CS_PINS[i]);
+        sim_gyros[i].connect_int2(INT2_PINS[i]);
+        sim_gyros[i].set_odr_deviation(ODR_DEVIATIONS[i]);
+        sim_gyros[i].set_trajectory(&trajectory);
+    }
+
+    SPI spi(SPI_MOSI, SPI_MISO, SPI_SCLK);
+    GyroscopeGroup group(&spi, mbed_event_queue());
+    for (int i = 0; i < N_GYROSCOPES; i++) {
+        TEST_ASSERT_EQUAL(0, group.add_gyroscope(SPI_CS_PINS[i], INT2_PINS[i]));
+    }
+    TEST_ASSERT_NOT_EQUAL(0, group.add_gyroscope(PE_9, PE_10));
+    TEST_ASSERT_EQUAL(N_GYROSCOPES, group.get_gyroscope_count());
+    TEST_ASSERT_EQUAL(0, group.init());
+    for (int i = 0; i < N_GYROSCOPES; i++) {
+        group.get_gyroscope(i)->set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    }
+
+    // output data rates should be the same
+    group.get_gyroscope(1)->set_output_data_rate(L3GD20Gyroscope::ODR_380_HZ);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, group.start(16, callback(on_block)));
+    group.get_gyroscope(1)->set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+
+    memset(&block_stats, 0, sizeof(block_stats));
+    block_stats.monotonic = true;
+    const int block_size = 16;
+    TEST_ASSERT_EQUAL(0, group.start(block_size, callback(on_block)));
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_EBUSY, group.start(block_size, callback(on_block)));
+    ThisThread::sleep_for(5s);
+    group.stop();
+
+    uint64_t min_sample_count = sim_gyros[0].get_sample_count();
+    uint64_t max_sample_count = min_sample_count;
+    for (int i = 1; i < N_GYROSCOPES; i++) {
+        uint64_t count = sim_gyros[i].get_sample_count();
+        min_sample_count = count < min_sample_count ? count : min_sample_count;
+        max_sample_count = count > max_sample_count ? count : max_sample_count;
+    }
+
+    // blocks are limited by the slowest device
+    TEST_ASSERT_EQUAL((uint32_t)block_stats.n_blocks, group.get_block_count());
+    TEST_ASSERT_INT_WITHIN(2, min_sample_count / block_size, block_stats.n_blocks);
+    TEST_ASSERT_TRUE(block_stats.monotonic);
+    // the faster devices drop samples to keep alignment
+    TEST_ASSERT(group.get_dropped_sample_count() >= max_sample_count - min_sample_count);
+    // first samples of the blocks are aligned within 5/8 of the sample period (with 50 us interrupt latency),
+    // other samples diverge due to oscillator mismatch up to 16 samples * 3.5% of the period
+    const double period_us = 1e6 / 760;
+    TEST_ASSERT(block_stats.max_first_time_difference_us < period_us * 5 / 8 + 50);
+    TEST_ASSERT(block_stats.max_time_difference_us < period_us * (5.0 / 8 + block_size * 0.035) + 50);
+    // rate change during 5/8 of the period is up to 2 * pi * 2 Hz * 100 dps * 0.82 ms = 1.03 dps (118 LSB)
+    TEST_ASSERT(block_stats.max_first_sample_difference < 130);
+
+    // no interrupts after stop
+    int n_blocks = block_stats.n_blocks;
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(n_blocks, block_stats.n_blocks);
+}
+
+static void on_slow_block(const GyroscopeGroup::Block &block)
+{
+    on_block(block);
+    if (block_stats.n_blocks % 50 == 0) {
+        // occasional processing longer than the sample period, so FIFO reaches the watermark again
+        wait_us(2000);
+    }
+}
+
+/**
+ * Test that small blocks are delivered continuously, when watermark is reached again before processing completion.
+ */
+void test_small_blocks()
+{
+    ConstantTrajectory trajectory(10.0, 20.0, 30.0);
+    SimulatedL3GD20 sim_gyros[N_GYROSCOPES];
+    for (int i = 0; i < N_GYROSCOPES; i++) {
+        sim_gyros[i].attach_spi(SPI_CS_PINS[i]);
+        sim_gyros[i].connect_int2(INT2_PINS[i]);
+        sim_gyros[i].set_odr_deviation(ODR_DEVIATIONS[i]);
+        sim_gyros[i].set_trajectory(&trajectory);
+    }
+
+    SPI spi(SPI_MOSI, SPI_MISO, SPI_SCLK);
+    GyroscopeGroup group(&spi, mbed_event_queue());
+    for (int i = 0; i < N_GYROSCOPES; i++) {
+        TEST_ASSERT_EQUAL(0, group.add_gyroscope(SPI_CS_PINS[i], INT2_PINS[i]));
+    }
+    TEST_ASSERT_EQUAL(0, group.init());
+    for (int i = 0; i < N_GYROSCOPES; i++) {
+        group.get_gyroscope(i)->set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    }
+
+    for (int block_size = 1; block_size <= 2; block_size++) {
+        memset(&block_stats, 0, sizeof(block_stats));
+        block_stats.monotonic = true;
+        uint64_t start_sample_count[N_GYROSCOPES];
+        for (int i = 0; i < N_GYROSCOPES; i++) {
+            start_sample_count[i] = sim_gyros[i].get_sample_count();
+        }
+        TEST_ASSERT_EQUAL(0, group.start(block_size, callback(on_slow_block)));
+        ThisThread::sleep_for(2s);
+        group.stop();
+
+        uint64_t min_sample_count = sim_gyros[0].get_sample_count() - start_sample_count[0];
+        for (int i = 1; i < N_GYROSCOPES; i++) {
+            uint64_t count = sim_gyros[i].get_sample_count() - start_sample_count[i];
+            min_sample_count = count < min_sample_count ? count : min_sample_count;
+        }
+        // no device stalls till the end of acquisition (the slow processing delays interrupts, so a few samples
+        // are dropped for realignment)
+        TEST_ASSERT_INT_WITHIN(min_sample_count / block_size / 50, min_sample_count / block_size, block_stats.n_blocks);
+        TEST_ASSERT_TRUE(block_stats.monotonic);
+    }
+}
+
+/**
+ * Test that start keeps enabled axes, and stop cancels pending event.
+ */
+void test_axes_and_stop()
+{
+    SimulatedL3GD20 sim_gyros[2];
+    for (int i = 0; i < 2; i++) {
+        sim_gyros[i].attach_spi(SPI_CS_PINS[i]);
+        sim_gyros[i].connect_int2(INT2_PINS[i]);
+    }
+
+    SPI spi(SPI_MOSI, SPI_MISO, SPI_SCLK);
+    // the queue isn't dispatched, so the event remains pending
+    EventQueue queue;
+    memset(&block_stats, 0, sizeof(block_stats));
+    {
+        GyroscopeGroup group(&spi, &queue);
+        for (int i = 0; i < 2; i++) {
+            TEST_ASSERT_EQUAL(0, group.add_gyroscope(SPI_CS_PINS[i], INT2_PINS[i]));
+        }
+        TEST_ASSERT_EQUAL(0, group.init());
+        group.get_gyroscope(1)->set_axes(L3GD20Gyroscope::AXIS_X_ENABLE);
+
+        TEST_ASSERT_EQUAL(0, group.start(8, callback(on_block)));
+        TEST_ASSERT_EQUAL(L3GD20Gyroscope::G_ENABLE, group.get_gyroscope(0)->get_gyroscope_mode());
+        TEST_ASSERT_EQUAL(L3GD20Gyroscope::AXIS_ALL_ENABLE, group.get_gyroscope(0)->get_axes());
+        TEST_ASSERT_EQUAL(L3GD20Gyroscope::G_ENABLE, group.get_gyroscope(1)->get_gyroscope_mode());
+        TEST_ASSERT_EQUAL(L3GD20Gyroscope::AXIS_X_ENABLE, group.get_gyroscope(1)->get_axes());
+
+        ThisThread::sleep_for(200ms);
+        TEST_ASSERT_EQUAL(1, queue.get_posted_count());
+        group.stop();
+        TEST_ASSERT_EQUAL(0, queue.get_posted_count());
+    }
+    queue.dispatch_posted();
+    TEST_ASSERT_EQUAL(0, block_stats.n_blocks);
+}
+
+static GyroscopeGroup *stopped_group;
+
+static void on_block_and_stop(const GyroscopeGroup::Block &block)
+{
+    on_block(block);
+    if (block_stats.n_blocks == 3) {
+        stopped_group->stop();
+    }
+}
+
+/**
+ * Test that the group can be stopped from the block callback.
+ */
+void test_stop_from_callback()
+{
+    SimulatedL3GD20 sim_gyros[2];
+    for (int i = 0; i < 2; i++) {
+        sim_gyros[i].attach_spi(SPI_CS_PINS[i]);
+        sim_gyros[i].connect_int2(INT2_PINS[i]);
+    }
+
+    SPI spi(SPI_MOSI, SPI_MISO, SPI_SCLK);
+    GyroscopeGroup group(&spi, mbed_event_queue());
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL(0, group.add_gyroscope(SPI_CS_PINS[i], INT2_PINS[i]));
+    }
+    TEST_ASSERT_EQUAL(0, group.init());
+
+    // no blocks are delivered after stop
+    memset(&block_stats, 0, sizeof(block_stats));
+    stopped_group = &group;
+    TEST_ASSERT_EQUAL(0, group.start(1, callback(on_block_and_stop)));
+    ThisThread::sleep_for(200ms);
+    TEST_ASSERT_EQUAL(3, block_stats.n_blocks);
+    TEST_ASSERT_EQUAL(3, group.get_block_count());
+
+    // the group can be started again
+    TEST_ASSERT_EQUAL(0, group.start(8, callback(on_block)));
+    ThisThread::sleep_for(200ms);
+    group.stop();
+    TEST_ASSERT(block_stats.n_blocks > 3);
+}
+
+// test cases description
+#define GroupCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    GroupCase(test_aligned_blocks),
+    GroupCase(test_small_blocks),
+    GroupCase(test_axes_and_stop),
+    GroupCase(test_stop_from_callback)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
@@ -0,0 +1,940 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_async_reader.h"
+#include "l3gd20_driver.h"
+#include "l3gd20_sim.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+static const PinName I2C_SDA = PB_7;
+static const PinName I2C_SCL = PB_6;
+static const PinName INT1_PIN = PE_0;
+static const PinName INT2_PIN = PE_1;
+
+static SimulatedL3GD20 *sim_gyro;
+
+utest::v1::status_t case_setup_handler(const Case *const source, const size_t index_of_case)
+{
+    sim_gyro = new SimulatedL3GD20();
+    sim_gyro->attach_spi(SPI_CS);
+    sim_gyro->attach_i2c();
+    sim_gyro->connect_int1(INT1_PIN);
+    sim_gyro->connect_int2(INT2_PIN);
+    return greentea_case_setup_handler(source, index_of_case);
+}
+
+utest::v1::status_t case_teardown_handler(const Case *const source, const size_t passed, const size_t failed, const failure_t failure)
+{
+    delete sim_gyro;
+    sim_gyro = NULL;
+    return greentea_case_teardown_handler(source, passed, failed, failure);
+}
+
+/**
+ * Trajectory, whose X axis rate grows with 100 dps per second.
+ *
+ * It allows to identify sample by its value.
+ */
+class RampTrajectory : public Trajectory {
+public:
+    RampTrajectory()
+        : start_time(mbed_host::get_time_us() * 1e-6)
+    {
+    }
+
+    virtual void get_angular_rate(double t, double rate[3])
+    {
+        rate[0] = get_raw_value(t) * 0.00875;
+        rate[1] = -1.0;
+        rate[2] = 2.0;
+    }
+
+    // expected sample value at the specified time (for 250 dps full scale)
+    double get_raw_value(double t)
+    {
+        return (t - start_time) * 100.0 / 0.00875;
+    }
+
+    // sample value increment per ODR period
+    double get_raw_step(double odr_hz)
+    {
+        return 100.0 / 0.00875 / odr_hz;
+    }
+
+    const double start_time;
+};
+
+static void spi_transaction(SPI &spi, DigitalOut &cs, const uint8_t *tx, uint8_t *rx, int length)
+{
+    cs = 0;
+    for (int i = 0; i < length; i++) {
+        uint8_t res = spi.write(tx[i]);
+        if (rx) {
+            rx[i] = res;
+        }
+    }
+    cs = 1;
+}
+
+/**
+ * Test register map access.
+ */
+void test_register_map()
+{
+    uint8_t data[6];
+
+    TEST_ASSERT_EQUAL(0xD4, sim_gyro->peek_register(0x0F));
+    // power on state
+    TEST_ASSERT_EQUAL(0x07, sim_gyro->peek_register(0x20));
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x24));
+    TEST_ASSERT_EQUAL(0x20, sim_gyro->peek_register(0x2F));
+
+    // writable registers
+    const uint8_t values[5] = { 0x0F, 0x29, 0x08, 0x10, 0x10 };
+    sim_gyro->write_registers(0x20, values, 5);
+    sim_gyro->read_registers(0x20, data, 5);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(values, data, 5);
+    // CTRL_REG2 reserved bits and self-cleared BOOT bit
+    data[0] = 0xFF;
+    data[4] = 0x80;
+    sim_gyro->write_registers(0x21, data, 1);
+    sim_gyro->write_registers(0x24, data + 4, 1);
+    TEST_ASSERT_EQUAL(0x3F, sim_gyro->peek_register(0x21));
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x24));
+
+    // read-only and reserved registers
+    data[0] = 0x55;
+    sim_gyro->write_registers(0x0F, data, 1);
+    sim_gyro->write_registers(0x27, data, 1);
+    sim_gyro->write_registers(0x10, data, 1);
+    TEST_ASSERT_EQUAL(0xD4, sim_gyro->peek_register(0x0F));
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x27));
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x10));
+
+    // temperature
+    sim_gyro->set_temperature(-5);
+    TEST_ASSERT_EQUAL(-5, (int8_t)sim_gyro->peek_register(0x26));
+}
+
+/**
+ * Test SPI protocol and auto-increment rules.
+ */
+void test_spi_auto_increment()
+{
+    SPI spi(SPI_MOSI, SPI_MISO, SPI_SCLK);
+    DigitalOut cs(SPI_CS, 1);
+    uint8_t tx[4];
+    uint8_t rx[4];
+
+    // write without MS bit: all bytes go to the same register
+    tx[0] = 0x32;
+    tx[1] = 0x11;
+    tx[2] = 0x22;
+    spi_transaction(spi, cs, tx, NULL, 3);
+    TEST_ASSERT_EQUAL(0x22, sim_gyro->peek_register(0x32));
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x33));
+
+    // write with MS bit
+    tx[0] = 0x40 | 0x32;
+    tx[1] = 0x11;
+    tx[2] = 0x22;
+    tx[3] = 0x33;
+    spi_transaction(spi, cs, tx, NULL, 4);
+    TEST_ASSERT_EQUAL(0x11, sim_gyro->peek_register(0x32));
+    TEST_ASSERT_EQUAL(0x22, sim_gyro->peek_register(0x33));
+    TEST_ASSERT_EQUAL(0x33, sim_gyro->peek_register(0x34));
+
+    // read without MS bit
+    memset(tx, 0, sizeof(tx));
+    tx[0] = 0x80 | 0x32;
+    spi_transaction(spi, cs, tx, rx, 3);
+    TEST_ASSERT_EQUAL(0x11, rx[1]);
+    TEST_ASSERT_EQUAL(0x11, rx[2]);
+
+    // read with MS bit
+    tx[0] = 0x80 | 0x40 | 0x32;
+    spi_transaction(spi, cs, tx, rx, 4);
+    TEST_ASSERT_EQUAL(0x11, rx[1]);
+    TEST_ASSERT_EQUAL(0x22, rx[2]);
+    TEST_ASSERT_EQUAL(0x33, rx[3]);
+
+    // device ignores bus if it isn't selected
+    TEST_ASSERT_EQUAL(0xFF, spi.write(0x80 | 0x0F));
+}
+
+/**
+ * Test I2C protocol and auto-increment rules.
+ */
+void test_i2c_auto_increment()
+{
+    I2C i2c(I2C_SDA, I2C_SCL);
+    char data[4];
+
+    // write without auto-increment
+    data[0] = 0x32;
+    data[1] = 0x11;
+    data[2] = 0x22;
+    TEST_ASSERT_EQUAL(0, i2c.write(L3GD20_I2C_ADDRESS, data, 3));
+    TEST_ASSERT_EQUAL(0x22, sim_gyro->peek_register(0x32));
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x33));
+
+    // write with auto-increment
+    data[0] = 0x80 | 0x32;
+    data[1] = 0x11;
+    data[2] = 0x22;
+    data[3] = 0x33;
+    TEST_ASSERT_EQUAL(0, i2c.write(L3GD20_I2C_ADDRESS, data, 4));
+    TEST_ASSERT_EQUAL(0x11, sim_gyro->peek_register(0x32));
+    TEST_ASSERT_EQUAL(0x22, sim_gyro->peek_register(0x33));
+    TEST_ASSERT_EQUAL(0x33, sim_gyro->peek_register(0x34));
+
+    // read without auto-increment
+    data[0] = 0x33;
+    TEST_ASSERT_EQUAL(0, i2c.write(L3GD20_I2C_ADDRESS, data, 1, true));
+    TEST_ASSERT_EQUAL(0, i2c.read(L3GD20_I2C_ADDRESS, data, 2));
+    TEST_ASSERT_EQUAL(0x22, data[0]);
+    TEST_ASSERT_EQUAL(0x22, data[1]);
+
+    // read with auto-increment
+    data[0] = 0x80 | 0x32;
+    TEST_ASSERT_EQUAL(0, i2c.write(L3GD20_I2C_ADDRESS, data, 1, true));
+    TEST_ASSERT_EQUAL(0, i2c.read(L3GD20_I2C_ADDRESS, data, 3));
+    TEST_ASSERT_EQUAL(0x11, data[0]);
+    TEST_ASSERT_EQUAL(0x22, data[1]);
+    TEST_ASSERT_EQUAL(0x33, data[2]);
+
+    // wrong address
+    TEST_ASSERT_NOT_EQUAL(0, i2c.read(0x30, data, 1));
+}
+
+/**
+ * Test sample generation pacing.
+ */
+void test_odr_pacing()
+{
+    const uint8_t odr_bits[4] = { 0x00, 0x40, 0x80, 0xC0 };
+    const int odr_hz[4] = { 95, 190, 380, 760 };
+    uint8_t val;
+
+    // power down mode
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(0, sim_gyro->get_sample_count());
+
+    for (int i = 0; i < 4; i++) {
+        uint64_t start_count = sim_gyro->get_sample_count();
+        val = odr_bits[i] | 0x0F;
+        sim_gyro->write_registers(0x20, &val, 1);
+        ThisThread::sleep_for(1000ms);
+        TEST_ASSERT_INT_WITHIN(1, odr_hz[i], sim_gyro->get_sample_count() - start_count);
+    }
+
+    // oscillator deviation
+    uint64_t start_count = sim_gyro->get_sample_count();
+    sim_gyro->set_odr_deviation(0.05);
+    ThisThread::sleep_for(1000ms);
+    TEST_ASSERT_INT_WITHIN(1, 798, sim_gyro->get_sample_count() - start_count);
+    sim_gyro->set_odr_deviation(0.0);
+
+    // sleep mode
+    val = 0x08;
+    sim_gyro->write_registers(0x20, &val, 1);
+    start_count = sim_gyro->get_sample_count();
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(start_count, sim_gyro->get_sample_count());
+}
+
+/**
+ * Test output data of the trajectories.
+ */
+void test_trajectory_output()
+{
+    ConstantTrajectory constant_trajectory(100.0, -200.0, 50.0);
+    sim_gyro->set_trajectory(&constant_trajectory);
+    L3GD20Gyroscope gyro(sim_gyro);
+    float data[3];
+    int16_t data_16[3];
+
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    ThisThread::sleep_for(20ms);
+    gyro.read_data_dps(data);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -200.0f, data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, data[2]);
+
+    // full scale and endianness
+    gyro.set_full_scale(L3GD20Gyroscope::FULL_SCALE_2000);
+    ThisThread::sleep_for(20ms);
+    gyro.read_data_16(data_16);
+    TEST_ASSERT_EQUAL(1429, data_16[0]);
+    gyro.write_register(L3GD20Gyroscope::CTRL_REG4_ADDR, 0x60);
+    ThisThread::sleep_for(20ms);
+    gyro.read_data_16(data_16);
+    TEST_ASSERT_EQUAL((int16_t)0x9505, data_16[0]);
+    gyro.write_register(L3GD20Gyroscope::CTRL_REG4_ADDR, 0x20);
+
+    // axes selection
+    gyro.write_register(L3GD20Gyroscope::CTRL_REG1_ADDR, 0x0A);
+    ThisThread::sleep_for(20ms);
+    gyro.read_data_16(data_16);
+    TEST_ASSERT_EQUAL(1429, data_16[0]);
+    TEST_ASSERT_EQUAL(0, data_16[1]);
+    TEST_ASSERT_EQUAL(0, data_16[2]);
+
+    // oscillation
+    const double amplitude[3] = { 200.0, 0.0, 0.0 };
+    const double frequency[3] = { 1.0, 0.0, 0.0 };
+    SineTrajectory sine_trajectory(amplitude, frequency);
+    sim_gyro->set_trajectory(&sine_trajectory);
+    gyro.init();
+    float max_rate = 0.0f;
+    float min_rate = 0.0f;
+    for (int i = 0; i < 100; i++) {
+        ThisThread::sleep_for(10ms);
+        gyro.read_data_dps(data);
+        max_rate = data[0] > max_rate ? data[0] : max_rate;
+        min_rate = data[0] < min_rate ? data[0] : min_rate;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, 200.0f, max_rate);
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, -200.0f, min_rate);
+
+    // segments
+    SegmentTrajectory segment_trajectory;
+    double t = mbed_host::get_time_us() * 1e-6;
+    segment_trajectory.add_segment(t + 0.1, 10.0, 0.0, 0.0);
+    segment_trajectory.add_segment(0.1, 0.0, 20.0, 0.0);
+    sim_gyro->set_trajectory(&segment_trajectory);
+    ThisThread::sleep_for(50ms);
+    gyro.read_data_dps(data);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, data[0]);
+    ThisThread::sleep_for(100ms);
+    gyro.read_data_dps(data);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, data[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, data[1]);
+    ThisThread::sleep_for(100ms);
+    gyro.read_data_dps(data);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, data[1]);
+
+    sim_gyro->set_trajectory(NULL);
+}
+
+/**
+ * Test status register flags.
+ */
+void test_status_flags()
+{
+    uint8_t data[6];
+    data[0] = 0x0F;
+    sim_gyro->write_registers(0x20, data, 1);
+
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x27));
+    ThisThread::sleep_for(12ms);
+    TEST_ASSERT_EQUAL(0x0F, sim_gyro->peek_register(0x27));
+    ThisThread::sleep_for(12ms);
+    TEST_ASSERT_EQUAL(0xFF, sim_gyro->peek_register(0x27));
+
+    // read X axis
+    sim_gyro->read_registers(0x28, data, 2);
+    TEST_ASSERT_EQUAL(0xEE, sim_gyro->peek_register(0x27));
+    // read all axes
+    sim_gyro->read_registers(0x28, data, 6);
+    TEST_ASSERT_EQUAL(0x00, sim_gyro->peek_register(0x27));
+}
+
+/**
+ * Test FIFO modes.
+ */
+void test_fifo_modes()
+{
+    RampTrajectory trajectory;
+    sim_gyro->set_trajectory(&trajectory);
+    uint8_t data[12];
+    int16_t samples[2][3];
+
+    // enable device and FIFO in bypass mode
+    data[0] = 0x0F;
+    sim_gyro->write_registers(0x20, data, 1);
+    data[0] = 0x40;
+    sim_gyro->write_registers(0x24, data, 1);
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(0, sim_gyro->get_fifo_level());
+    TEST_ASSERT_EQUAL(0x20, sim_gyro->peek_register(0x2F));
+
+    // stream mode
+    data[0] = 0x40 | 10;
+    sim_gyro->write_registers(0x2E, data, 1);
+    ThisThread::sleep_for(50ms);
+    int level = sim_gyro->get_fifo_level();
+    TEST_ASSERT_INT_WITHIN(1, 5, level);
+    TEST_ASSERT_EQUAL(level, sim_gyro->peek_register(0x2F));
+    ThisThread::sleep_for(70ms);
+    level = sim_gyro->get_fifo_level();
+    TEST_ASSERT_INT_WITHIN(1, 11, level);
+    TEST_ASSERT_EQUAL(0x80 | level, sim_gyro->peek_register(0x2F));
+    ThisThread::sleep_for(300ms);
+    TEST_ASSERT_EQUAL(32, sim_gyro->get_fifo_level());
+    TEST_ASSERT_EQUAL(0xC0, sim_gyro->peek_register(0x2F));
+
+    // stream mode keeps the latest samples, and output registers rollover
+    sim_gyro->read_registers(0x28, data, 12);
+    L3GD20Gyroscope::decode_samples(data, samples, 2);
+    TEST_ASSERT_EQUAL(30, sim_gyro->get_fifo_level());
+    double oldest_value = trajectory.get_raw_value(mbed_host::get_time_us() * 1e-6 - 31 / 95.0);
+    TEST_ASSERT_INT_WITHIN(trajectory.get_raw_step(95.0), oldest_value, samples[0][0]);
+    TEST_ASSERT_INT_WITHIN(1, trajectory.get_raw_step(95.0), samples[1][0] - samples[0][0]);
+    TEST_ASSERT_EQUAL(-114, samples[0][1]);
+    TEST_ASSERT_EQUAL(229, samples[0][2]);
+
+    // bypass mode resets FIFO
+    data[0] = 0x00 | 10;
+    sim_gyro->write_registers(0x2E, data, 1);
+    TEST_ASSERT_EQUAL(0, sim_gyro->get_fifo_level());
+
+    // FIFO mode stops data collecting after overrun
+    data[0] = 0x20 | 10;
+    sim_gyro->write_registers(0x2E, data, 1);
+    double first_value = trajectory.get_raw_value(mbed_host::get_time_us() * 1e-6);
+    ThisThread::sleep_for(500ms);
+    TEST_ASSERT_EQUAL(32, sim_gyro->get_fifo_level());
+    TEST_ASSERT_EQUAL(0xC0, sim_gyro->peek_register(0x2F));
+    sim_gyro->read_registers(0x28, data, 6);
+    L3GD20Gyroscope::decode_samples(data, samples, 1);
+    TEST_ASSERT_INT_WITHIN(trajectory.get_raw_step(95.0), first_value + trajectory.get_raw_step(95.0) / 2, samples[0][0]);
+    // note: FIFO mode doesn't continue data collecting until reset
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(31, sim_gyro->get_fifo_level());
+    data[0] = 0x00 | 10;
+    sim_gyro->write_registers(0x2E, data, 1);
+    data[0] = 0x20 | 10;
+    sim_gyro->write_registers(0x2E, data, 1);
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_INT_WITHIN(1, 9, sim_gyro->get_fifo_level());
+
+    // FIFO disabling
+    data[0] = 0x00;
+    sim_gyro->write_registers(0x24, data, 1);
+    TEST_ASSERT_EQUAL(0, sim_gyro->get_fifo_level());
+    TEST_ASSERT_EQUAL(0x20, sim_gyro->peek_register(0x2F));
+
+    sim_gyro->set_trajectory(NULL);
+}
+
+/**
+ * Test INT2/DRDY output.
+ */
+void test_int2_output()
+{
+    uint8_t data[6];
+    DigitalIn int2(INT2_PIN);
+
+    data[0] = 0x0F;
+    sim_gyro->write_registers(0x20, data, 1);
+    ThisThread::sleep_for(20ms);
+    TEST_ASSERT_EQUAL(0, int2.read());
+
+    // data ready
+    data[0] = 0x08;
+    sim_gyro->write_registers(0x22, data, 1);
+    TEST_ASSERT_EQUAL(1, int2.read());
+    sim_gyro->read_registers(0x28, data, 6);
+    TEST_ASSERT_EQUAL(0, int2.read());
+
+    // watermark
+    data[0] = 0x40;
+    sim_gyro->write_registers(0x24, data, 1);
+    data[0] = 0x40 | 8;
+    sim_gyro->write_registers(0x2E, data, 1);
+    data[0] = 0x04;
+    sim_gyro->write_registers(0x22, data, 1);
+    for (int i = 0; i < 200 && !int2.read(); i++) {
+        TEST_ASSERT(sim_gyro->get_fifo_level() < 8);
+        ThisThread::sleep_for(1ms);
+    }
+    TEST_ASSERT_EQUAL(1, int2.read());
+    TEST_ASSERT_EQUAL(8, sim_gyro->get_fifo_level());
+    sim_gyro->read_registers(0x28, data, 6);
+    TEST_ASSERT_EQUAL(0, int2.read());
+
+    // overrun
+    data[0] = 0x02;
+    sim_gyro->write_registers(0x22, data, 1);
+    ThisThread::sleep_for(300ms);
+    TEST_ASSERT_EQUAL(1, int2.read());
+    sim_gyro->read_registers(0x28, data, 6);
+    TEST_ASSERT_EQUAL(0, int2.read());
+
+    // empty
+    data[0] = 0x01;
+    sim_gyro->write_registers(0x22, data, 1);
+    TEST_ASSERT_EQUAL(0, int2.read());
+    data[0] = 0x00;
+    sim_gyro->write_registers(0x2E, data, 1);
+    TEST_ASSERT_EQUAL(1, int2.read());
+}
+
+/**
+ * Test INT1 angular rate threshold interrupt.
+ */
+void test_int1_output()
+{
+    L3GD20Gyroscope gyro(sim_gyro);
+    DigitalIn int1(INT1_PIN);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_95_HZ);
+    gyro.set_full_scale(L3GD20Gyroscope::FULL_SCALE_250);
+
+    // configuration round trip with burst threshold writing
+    L3GD20Gyroscope::MotionInterruptConfig config;
+    config.events = L3GD20Gyroscope::MOTION_X_HIGH | L3GD20Gyroscope::MOTION_Z_HIGH;
+    config.threshold[0] = gyro.get_motion_threshold(10.0f);
+    config.threshold[1] = 0x7FFF;
+    config.threshold[2] = gyro.get_motion_threshold(-10.0f);
+    TEST_ASSERT_EQUAL(1143, config.threshold[0]);
+    TEST_ASSERT_EQUAL(1143, config.threshold[2]);
+    TEST_ASSERT_EQUAL(0x7FFF, gyro.get_motion_threshold(1000.0f));
+    gyro.set_motion_interrupt(config);
+    L3GD20Gyroscope::MotionInterruptConfig read_config = gyro.get_motion_interrupt();
+    TEST_ASSERT_EQUAL(config.events, read_config.events);
+    TEST_ASSERT_EQUAL(1143, read_config.threshold[0]);
+    TEST_ASSERT_EQUAL(0x7FFF, read_config.threshold[1]);
+    TEST_ASSERT_EQUAL(1143, read_config.threshold[2]);
+    TEST_ASSERT_FALSE(read_config.and_combination);
+    TEST_ASSERT_TRUE(read_config.latch);
+    TEST_ASSERT_EQUAL(0, read_config.duration);
+    TEST_ASSERT_EQUAL(0x80, sim_gyro->peek_register(0x22) & 0x80);
+
+    // OR combination with latched request
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(0, int1.read());
+    sim_gyro->set_bias(0.0, 0.0, -20.0);
+    ThisThread::sleep_for(20ms);
+    TEST_ASSERT_EQUAL(1, int1.read());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_Z_HIGH, sim_gyro->peek_register(0x31));
+    sim_gyro->set_bias(0.0, 0.0, 0.0);
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(1, int1.read());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_Z_HIGH, gyro.read_motion_interrupt_source());
+    TEST_ASSERT_EQUAL(0, int1.read());
+
+    // request without latch follows the events
+    config.latch = false;
+    gyro.set_motion_interrupt(config);
+    sim_gyro->set_bias(15.0, 0.0, 0.0);
+    ThisThread::sleep_for(20ms);
+    TEST_ASSERT_EQUAL(1, int1.read());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_X_HIGH, gyro.read_motion_interrupt_source());
+    TEST_ASSERT_EQUAL(1, int1.read());
+    sim_gyro->set_bias(0.0, 0.0, 0.0);
+    ThisThread::sleep_for(20ms);
+    TEST_ASSERT_EQUAL(0, int1.read());
+
+    // AND combination requires events of all axes
+    config.and_combination = true;
+    gyro.set_motion_interrupt(config);
+    sim_gyro->set_bias(0.0, 0.0, 20.0);
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(0, int1.read());
+    sim_gyro->set_bias(-20.0, 0.0, 20.0);
+    ThisThread::sleep_for(20ms);
+    TEST_ASSERT_EQUAL(1, int1.read());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_X_HIGH | L3GD20Gyroscope::MOTION_Z_HIGH,
+                      sim_gyro->peek_register(0x31));
+    sim_gyro->set_bias(0.0, 0.0, 0.0);
+
+    // minimal duration of 5 samples (53 ms) for request setting and resetting
+    config.and_combination = false;
+    config.duration = 5;
+    config.wait = true;
+    gyro.set_motion_interrupt(config);
+    sim_gyro->set_bias(0.0, 0.0, 20.0);
+    ThisThread::sleep_for(30ms);
+    TEST_ASSERT_EQUAL(0, int1.read());
+    ThisThread::sleep_for(40ms);
+    TEST_ASSERT_EQUAL(1, int1.read());
+    sim_gyro->set_bias(0.0, 0.0, 0.0);
+    ThisThread::sleep_for(30ms);
+    TEST_ASSERT_EQUAL(1, int1.read());
+    ThisThread::sleep_for(40ms);
+    TEST_ASSERT_EQUAL(0, int1.read());
+
+    // low events
+    config.events = L3GD20Gyroscope::MOTION_Y_LOW;
+    config.duration = 0;
+    gyro.set_motion_interrupt(config);
+    ThisThread::sleep_for(20ms);
+    TEST_ASSERT_EQUAL(1, int1.read());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_Y_LOW, sim_gyro->peek_register(0x31));
+
+    // disabled interrupt
+    gyro.set_motion_interrupt(L3GD20Gyroscope::MotionInterruptConfig());
+    TEST_ASSERT_EQUAL(0, sim_gyro->peek_register(0x22) & 0x80);
+    ThisThread::sleep_for(20ms);
+    TEST_ASSERT_EQUAL(0, int1.read());
+
+    // bypass-to-stream mode starts streaming after INT1 event
+    config.events = L3GD20Gyroscope::MOTION_ANY_HIGH;
+    config.threshold[1] = config.threshold[0];
+    config.latch = true;
+    gyro.set_motion_interrupt(config);
+    gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro.write_register(L3GD20Gyroscope::FIFO_CTRL_REG_ADDR, 0x80);
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(0, sim_gyro->get_fifo_level());
+    sim_gyro->set_bias(0.0, 20.0, 0.0);
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_INT_WITHIN(1, 5, sim_gyro->get_fifo_level());
+    sim_gyro->set_bias(0.0, 0.0, 0.0);
+}
+
+/**
+ * Test driver with I2C and custom transport.
+ */
+void test_driver_buses()
+{
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    L3GD20Gyroscope transport_gyro(sim_gyro);
+    L3GD20Gyroscope i2c_gyro(I2C_SDA, I2C_SCL);
+    L3GD20GyroscopeI2C i2c_static_gyro(I2C_SDA, I2C_SCL);
+
+    TEST_ASSERT_EQUAL(0, transport_gyro.init());
+    TEST_ASSERT_EQUAL(0, i2c_gyro.init());
+    TEST_ASSERT_EQUAL(0, i2c_static_gyro.init());
+
+    transport_gyro.set_output_data_rate(L3GD20Gyroscope::ODR_380_HZ);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_380_HZ, i2c_gyro.get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_380_HZ, i2c_static_gyro.get_output_data_rate());
+
+    i2c_gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    i2c_gyro.clear_fifo();
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(19, i2c_gyro.read_fifo(samples));
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(19, i2c_static_gyro.read_fifo(samples));
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(19, transport_gyro.read_fifo(samples));
+}
+
+/**
+ * Test FIFO reading into caller buffer without copy.
+ */
+void test_fifo_view()
+{
+    ConstantTrajectory constant_trajectory(100.0, -200.0, 50.0);
+    sim_gyro->set_trajectory(&constant_trajectory);
+    sim_gyro->set_temperature(21);
+    L3GD20Gyroscope gyro(SPI_MOSI, SPI_MISO, SPI_SCLK, SPI_CS);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_380_HZ);
+    gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro.clear_fifo();
+    // int16_t buffer is aligned to 2 bytes
+    int16_t buffer[L3GD20Gyroscope::FIFO_VIEW_BUFFER_SIZE / 2];
+
+    // the view points to the caller buffer
+    ThisThread::sleep_for(50ms);
+    L3GD20Gyroscope::FIFOView view = gyro.read_fifo_view(buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL(19, view.n_samples);
+    TEST_ASSERT_TRUE((void *)view.samples == (void *)buffer);
+    for (int i = 0; i < view.n_samples; i++) {
+        TEST_ASSERT_EQUAL(11429, view.samples[i][0]);
+        TEST_ASSERT_EQUAL(-22857, view.samples[i][1]);
+        TEST_ASSERT_EQUAL(5714, view.samples[i][2]);
+    }
+
+    // temperature precedes the samples
+    ThisThread::sleep_for(50ms);
+    view = gyro.read_fifo_view(buffer, sizeof(buffer), true);
+    TEST_ASSERT_EQUAL(19, view.n_samples);
+    TEST_ASSERT_TRUE((uint8_t *)view.samples == (uint8_t *)buffer + L3GD20Gyroscope::FIFO_VIEW_TEMPERATURE_OFFSET);
+    TEST_ASSERT_EQUAL(21, view.temperature);
+    TEST_ASSERT_EQUAL(11429, view.samples[0][0]);
+    TEST_ASSERT_EQUAL(5714, view.samples[18][2]);
+
+    // the number of samples is limited by the buffer size; the rest remains in FIFO
+    ThisThread::sleep_for(50ms);
+    view = gyro.read_fifo_view(buffer, 2 + 10 * 6 + 5, true);
+    TEST_ASSERT_EQUAL(10, view.n_samples);
+    TEST_ASSERT_EQUAL(9, sim_gyro->get_fifo_level());
+    view = gyro.read_fifo_view(buffer, 4);
+    TEST_ASSERT_EQUAL(0, view.n_samples);
+    TEST_ASSERT_EQUAL(9, sim_gyro->get_fifo_level());
+
+    // empty FIFO
+    gyro.clear_fifo();
+    view = gyro.read_fifo_view(buffer, sizeof(buffer), true);
+    TEST_ASSERT_EQUAL(0, view.n_samples);
+    TEST_ASSERT_TRUE(gyro.get_last_fifo_status().empty);
+}
+
+static int async_block_count;
+static int async_sample_count;
+static int async_invalid_sample_count;
+
+static void on_async_block(const int16_t (*samples)[3], int n)
+{
+    async_block_count++;
+    async_sample_count += n;
+    for (int i = 0; i < n; i++) {
+        if (samples[i][0] != 11429 || samples[i][1] != -22857 || samples[i][2] != 5714) {
+            async_invalid_sample_count++;
+        }
+    }
+}
+
+/**
+ * Test asynchronous FIFO reading.
+ */
+void test_async_fifo_reader()
+{
+    L3GD20Gyroscope gyro(SPI_MOSI, SPI_MISO, SPI_SCLK, SPI_CS);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_190_HZ);
+
+    ConstantTrajectory constant_trajectory(100.0, -200.0, 50.0);
+    sim_gyro->set_trajectory(&constant_trajectory);
+    AsyncFifoReader reader(&gyro, INT2_PIN);
+    async_block_count = 0;
+    async_sample_count = 0;
+    async_invalid_sample_count = 0;
+    TEST_ASSERT_EQUAL(0, reader.start(10, on_async_block));
+    ThisThread::sleep_for(1000ms);
+    reader.stop();
+
+    TEST_ASSERT_EQUAL(19, async_block_count);
+    TEST_ASSERT_EQUAL(190, async_sample_count);
+    TEST_ASSERT_EQUAL(0, async_invalid_sample_count);
+    TEST_ASSERT_EQUAL(0, reader.get_error_count());
+    TEST_ASSERT(sim_gyro->get_fifo_level() < 10);
+}
+
+/**
+ * Register transport, whose asynchronous transfers can be never completed.
+ */
+class LostCompletionTransport : public RegisterTransport {
+public:
+    LostCompletionTransport(RegisterTransport *transport)
+        : lose_completions(true)
+        , async_read_count(0)
+        , abort_count(0)
+        , _transport(transport)
+    {
+    }
+
+    virtual void read_registers(uint8_t reg, uint8_t *data, uint8_t length)
+    {
+        _transport->read_registers(reg, data, length);
+    }
+
+    virtual void write_registers(uint8_t reg, const uint8_t *data, uint8_t length)
+    {
+        _transport->write_registers(reg, data, length);
+    }
+
+    virtual int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback)
+    {
+        async_read_count++;
+        if (!lose_completions) {
+            return _transport->read_registers_async(reg, data, length, callback);
+        }
+        return MBED_SUCCESS;
+    }
+
+    virtual void abort_async()
+    {
+        abort_count++;
+    }
+
+    bool lose_completions;
+    int async_read_count;
+    int abort_count;
+
+private:
+    RegisterTransport *_transport;
+};
+
+/**
+ * Test that asynchronous FIFO reader stop doesn't hang, if transfer completion is lost,
+ * and the reader can be started again.
+ */
+void test_async_fifo_reader_lost_completion()
+{
+    LostCompletionTransport transport(sim_gyro);
+    L3GD20Gyroscope gyro(&transport);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_190_HZ);
+
+    AsyncFifoReader reader(&gyro, INT2_PIN);
+    async_block_count = 0;
+    TEST_ASSERT_EQUAL(0, reader.start(10, on_async_block));
+    ThisThread::sleep_for(200ms);
+    uint64_t stop_time_us = mbed_host::get_time_us();
+    reader.stop();
+
+    // the single started transfer is aborted after timeout
+    TEST_ASSERT_EQUAL(1, transport.async_read_count);
+    TEST_ASSERT_EQUAL(1, transport.abort_count);
+    TEST_ASSERT_EQUAL(0, async_block_count);
+    TEST_ASSERT_EQUAL(1, reader.get_error_count());
+    TEST_ASSERT(mbed_host::get_time_us() - stop_time_us <= 51000);
+
+    // restart with working transport
+    ConstantTrajectory constant_trajectory(100.0, -200.0, 50.0);
+    sim_gyro->set_trajectory(&constant_trajectory);
+    transport.lose_completions = false;
+    async_sample_count = 0;
+    async_invalid_sample_count = 0;
+    TEST_ASSERT_EQUAL(0, reader.start(10, on_async_block));
+    ThisThread::sleep_for(1000ms);
+    reader.stop();
+    TEST_ASSERT_EQUAL(19, async_block_count);
+    TEST_ASSERT_EQUAL(190, async_sample_count);
+    TEST_ASSERT_EQUAL(0, async_invalid_sample_count);
+    TEST_ASSERT_EQUAL(0, reader.get_error_count());
+    TEST_ASSERT_EQUAL(1, transport.abort_count);
+}
+
+static LostCompletionTransport *overlap_transport;
+static int overlap_block_count;
+static int overlap_in_flight_count;
+
+static void on_slow_async_block(const int16_t (*samples)[3], int n)
+{
+    overlap_block_count++;
+    // the next block transfer is started before the current block processing
+    if (overlap_transport->async_read_count > overlap_block_count) {
+        overlap_in_flight_count++;
+    }
+    if (overlap_block_count == 1) {
+        // slow processing of the first block, so FIFO accumulates a few blocks
+        wait_us(120000);
+    }
+}
+
+/**
+ * Test that asynchronous FIFO reader reads the next block, while the current one is processed.
+ */
+void test_async_fifo_reader_overlap()
+{
+    LostCompletionTransport transport(sim_gyro);
+    transport.lose_completions = false;
+    L3GD20Gyroscope gyro(&transport);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_190_HZ);
+
+    AsyncFifoReader reader(&gyro, INT2_PIN);
+    overlap_transport = &transport;
+    overlap_block_count = 0;
+    overlap_in_flight_count = 0;
+    TEST_ASSERT_EQUAL(0, reader.start(10, on_slow_async_block));
+    ThisThread::sleep_for(1000ms);
+    reader.stop();
+
+    TEST_ASSERT_EQUAL(19, overlap_block_count);
+    TEST_ASSERT(overlap_in_flight_count > 0);
+    TEST_ASSERT_EQUAL(0, reader.get_error_count());
+}
+
+static volatile int async_transfer_count;
+static volatile int async_transfer_result;
+
+static void on_async_transfer(int err)
+{
+    async_transfer_count++;
+    async_transfer_result = err;
+}
+
+/**
+ * Test asynchronous FIFO reading with I2C bus.
+ */
+void test_async_fifo_reader_i2c()
+{
+    ConstantTrajectory constant_trajectory(100.0, -200.0, 50.0);
+    sim_gyro->set_trajectory(&constant_trajectory);
+
+    // reader with runtime bus selection
+    L3GD20Gyroscope gyro(I2C_SDA, I2C_SCL);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_190_HZ);
+    AsyncFifoReader reader(&gyro, INT2_PIN);
+    async_block_count = 0;
+    async_sample_count = 0;
+    async_invalid_sample_count = 0;
+    TEST_ASSERT_EQUAL(0, reader.start(10, on_async_block));
+    ThisThread::sleep_for(1000ms);
+    reader.stop();
+    TEST_ASSERT_EQUAL(19, async_block_count);
+    TEST_ASSERT_EQUAL(190, async_sample_count);
+    TEST_ASSERT_EQUAL(0, async_invalid_sample_count);
+    TEST_ASSERT_EQUAL(0, reader.get_error_count());
+
+    // driver with compile-time bus selection
+    L3GD20GyroscopeI2C static_gyro(I2C_SDA, I2C_SCL);
+    TEST_ASSERT_EQUAL(0, static_gyro.init());
+    static_gyro.set_output_data_rate(L3GD20Gyroscope::ODR_190_HZ);
+    static_gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    static_gyro.clear_fifo();
+    ThisThread::sleep_for(60ms);
+    int16_t buffer[(10 * 6 + L3GD20Gyroscope::FIFO_ASYNC_OFFSET) / 2 + 1];
+    uint8_t *raw_buffer = (uint8_t *)(buffer + 1) - L3GD20Gyroscope::FIFO_ASYNC_OFFSET;
+    async_transfer_count = 0;
+    async_transfer_result = -1;
+    TEST_ASSERT_EQUAL(0, static_gyro.read_fifo_async(raw_buffer, 10, on_async_transfer));
+    TEST_ASSERT_EQUAL(0, async_transfer_count);
+    mbed_host::process_events();
+    TEST_ASSERT_EQUAL(1, async_transfer_count);
+    TEST_ASSERT_EQUAL(MBED_SUCCESS, async_transfer_result);
+    int16_t(*samples)[3] = (int16_t(*)[3])(buffer + 1);
+    L3GD20Gyroscope::decode_samples(raw_buffer + L3GD20Gyroscope::FIFO_ASYNC_OFFSET, samples, 10);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(11429, samples[i][0]);
+        TEST_ASSERT_EQUAL(-22857, samples[i][1]);
+        TEST_ASSERT_EQUAL(5714, samples[i][2]);
+    }
+
+    // both I2C buses report the same error code as SPI, if device doesn't respond
+    mbed_host::detach_slave(static_cast<mbed_host::I2cSlave *>(sim_gyro));
+    async_transfer_count = 0;
+    TEST_ASSERT_EQUAL(0, gyro.read_fifo_async(raw_buffer, 10, on_async_transfer));
+    mbed_host::process_events();
+    TEST_ASSERT_EQUAL(1, async_transfer_count);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_READ_FAILED, async_transfer_result);
+    TEST_ASSERT_EQUAL(0, static_gyro.read_fifo_async(raw_buffer, 10, on_async_transfer));
+    mbed_host::process_events();
+    TEST_ASSERT_EQUAL(2, async_transfer_count);
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_READ_FAILED, async_transfer_result);
+}
+
+// test cases description
+#define SimCase(test_fun) Case(#test_fun, case_setup_handler, test_fun, case_teardown_handler, greentea_case_failure_continue_handler)
+Case cases[] = {
+    SimCase(test_register_map),
+    SimCase(test_spi_auto_increment),
+    SimCase(test_i2c_auto_increment),
+    SimCase(test_odr_pacing),
+    SimCase(test_trajectory_output),
+    SimCase(test_status_flags),
+    SimCase(test_fifo_modes),
+    SimCase(test_int2_output),
+    SimCase(test_int1_output),
+    SimCase(test_driver_buses),
+    SimCase(test_fifo_view),
+    SimCase(test_async_fifo_reader),
+    SimCase(test_async_fifo_reader_lost_completion),
+    SimCase(test_async_fifo_reader_overlap),
+    SimCase(test_async_fifo_reader_i2c)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
@@ -0,0 +1,214 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_gyro_stream.h"
+#include "l3gd20_motion_wakeup.h"
+#include "l3gd20_sim.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+static const PinName INT1_PIN = PE_0;
+static const PinName INT2_PIN = PE_1;
+static const int BLOCK_SIZE = 24;
+
+/**
+ * Wakeup statistics.
+ */
+struct WakeupStats {
+    int n_wakeups;
+    uint8_t source;
+    uint64_t time_us;
+};
+
+static WakeupStats wakeup_stats;
+static int n_blocks;
+
+static void on_wakeup(uint8_t source)
+{
+    wakeup_stats.n_wakeups++;
+    wakeup_stats.source = source;
+    wakeup_stats.time_us = mbed_host::get_time_us();
+}
+
+static void on_block(const GyroStream::Block &block)
+{
+    n_blocks++;
+}
+
+static uint32_t get_bus_transaction_count(L3GD20Gyroscope &gyroscope)
+{
+    RegisterDeviceStats stats = gyroscope.get_stats().bus;
+    return stats.register_reads + stats.register_writes + stats.burst_reads + stats.burst_writes + stats.async_reads;
+}
+
+/**
+ * Helper object with simulated device and its driver in the streaming configuration.
+ */
+struct WakeupFixture {
+    WakeupFixture()
+        : spi(SPI_MOSI, SPI_MISO, SPI_SCLK)
+        , gyroscope(&spi, SPI_CS)
+    {
+        memset(&wakeup_stats, 0, sizeof(wakeup_stats));
+        n_blocks = 0;
+        sim_gyro.attach_spi(SPI_CS);
+        sim_gyro.connect_int1(INT1_PIN);
+        sim_gyro.connect_int2(INT2_PIN);
+        sim_gyro.set_trajectory(&trajectory);
+        sim_gyro.set_noise(0.3);
+        TEST_ASSERT_EQUAL(0, gyroscope.init());
+        gyroscope.set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+        gyroscope.set_full_scale(L3GD20Gyroscope::FULL_SCALE_250);
+        gyroscope.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+
+        config.events = L3GD20Gyroscope::MOTION_ANY_HIGH;
+        config.threshold[0] = config.threshold[1] = config.threshold[2] = gyroscope.get_motion_threshold(5.0f);
+        config.duration = 2;
+    }
+
+    SegmentTrajectory trajectory;
+    SimulatedL3GD20 sim_gyro;
+    SPI spi;
+    L3GD20Gyroscope gyroscope;
+    L3GD20Gyroscope::MotionInterruptConfig config;
+};
+
+/**
+ * Test that a stationary device doesn't cause bus traffic, and motion onset restores streaming.
+ */
+void test_wake_on_motion()
+{
+    WakeupFixture fixture;
+    // stationary for 2 seconds, then rotation around Y axis
+    uint64_t motion_time_us = mbed_host::get_time_us() + 2000000;
+    fixture.trajectory.add_segment(motion_time_us * 1e-6, 0.0, 0.0, 0.0);
+    fixture.trajectory.add_segment(10.0, 0.0, -30.0, 0.0);
+    MotionWakeup wakeup(&fixture.gyroscope, INT1_PIN);
+
+    TEST_ASSERT_EQUAL(0, wakeup.sleep(fixture.config, callback(on_wakeup)));
+    TEST_ASSERT_TRUE(wakeup.is_sleeping());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_95_HZ, fixture.gyroscope.get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_DISABLE, fixture.gyroscope.get_fifo_mode());
+
+    // nothing is read while device is stationary
+    fixture.gyroscope.reset_stats();
+    ThisThread::sleep_for(1900ms);
+    TEST_ASSERT_EQUAL(0, get_bus_transaction_count(fixture.gyroscope));
+    TEST_ASSERT_EQUAL(0, wakeup_stats.n_wakeups);
+    TEST_ASSERT_TRUE(wakeup.is_sleeping());
+
+    // wakeup after 2 samples of 95 Hz
+    ThisThread::sleep_for(200ms);
+    TEST_ASSERT_EQUAL(1, wakeup_stats.n_wakeups);
+    TEST_ASSERT_EQUAL(1, wakeup.get_wakeup_count());
+    TEST_ASSERT_FALSE(wakeup.is_sleeping());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_Y_HIGH, wakeup_stats.source);
+    TEST_ASSERT_EQUAL(wakeup_stats.source, wakeup.get_wakeup_source());
+    TEST_ASSERT(wakeup_stats.time_us > motion_time_us);
+    TEST_ASSERT(wakeup_stats.time_us < motion_time_us + 3 * 1000000 / 95);
+
+    // streaming configuration is restored and INT1 is disabled
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_760_HZ, fixture.gyroscope.get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_ENABLE, fixture.gyroscope.get_fifo_mode());
+    TEST_ASSERT_EQUAL(0, fixture.gyroscope.get_motion_interrupt().events);
+    TEST_ASSERT_EQUAL(0, fixture.sim_gyro.get_int1_level());
+
+    // full rate acquisition (the shim can't block in event handlers, so the stream is started by the main thread)
+    GyroStream stream(&fixture.gyroscope, INT2_PIN);
+    TEST_ASSERT_EQUAL(0, stream.start(BLOCK_SIZE, callback(on_block)));
+    ThisThread::sleep_for(500ms);
+    stream.stop();
+    // 500 ms contains 380 samples
+    TEST_ASSERT_INT_WITHIN(1, 15, n_blocks);
+    TEST_ASSERT_EQUAL(1, wakeup_stats.n_wakeups);
+}
+
+/**
+ * Test argument checks, cancellation and motion before sleep.
+ */
+void test_sleep_cancel()
+{
+    WakeupFixture fixture;
+    MotionWakeup wakeup(&fixture.gyroscope, INT1_PIN);
+
+    // invalid arguments
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, wakeup.sleep(L3GD20Gyroscope::MotionInterruptConfig(), callback(on_wakeup)));
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_INVALID_ARGUMENT, wakeup.sleep(fixture.config, nullptr));
+    TEST_ASSERT_FALSE(wakeup.is_sleeping());
+
+    // cancellation restores streaming configuration without callback
+    TEST_ASSERT_EQUAL(0, wakeup.sleep(fixture.config, callback(on_wakeup), L3GD20Gyroscope::ODR_190_HZ));
+    TEST_ASSERT_EQUAL(MBED_ERROR_CODE_EBUSY, wakeup.sleep(fixture.config, callback(on_wakeup)));
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_190_HZ, fixture.gyroscope.get_output_data_rate());
+    ThisThread::sleep_for(100ms);
+    wakeup.cancel();
+    TEST_ASSERT_FALSE(wakeup.is_sleeping());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::ODR_760_HZ, fixture.gyroscope.get_output_data_rate());
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::FIFO_ENABLE, fixture.gyroscope.get_fifo_mode());
+    fixture.sim_gyro.set_bias(0.0, 0.0, 50.0);
+    ThisThread::sleep_for(100ms);
+    TEST_ASSERT_EQUAL(0, wakeup_stats.n_wakeups);
+
+    // the device is already moving, so it wakes up immediately
+    TEST_ASSERT_EQUAL(0, wakeup.sleep(fixture.config, callback(on_wakeup)));
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(1, wakeup_stats.n_wakeups);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_Z_HIGH, wakeup_stats.source);
+
+    // repeated sleep
+    fixture.sim_gyro.set_bias(0.0, 0.0, 0.0);
+    TEST_ASSERT_EQUAL(0, wakeup.sleep(fixture.config, callback(on_wakeup)));
+    ThisThread::sleep_for(200ms);
+    TEST_ASSERT_EQUAL(1, wakeup_stats.n_wakeups);
+    fixture.sim_gyro.set_bias(-50.0, 0.0, 0.0);
+    ThisThread::sleep_for(50ms);
+    TEST_ASSERT_EQUAL(2, wakeup_stats.n_wakeups);
+    TEST_ASSERT_EQUAL(L3GD20Gyroscope::MOTION_ACTIVE | L3GD20Gyroscope::MOTION_X_HIGH, wakeup_stats.source);
+
+    // waiting is cancelled by destructor
+    TEST_ASSERT_EQUAL(0, wakeup.sleep(fixture.config, callback(on_wakeup)));
+}
+
+/**
+ * Test that cancellation cancels pending wakeup event.
+ */
+void test_cancel_pending_wakeup()
+{
+    WakeupFixture fixture;
+    // the queue isn't dispatched, so the event remains pending
+    EventQueue queue;
+    {
+        MotionWakeup wakeup(&fixture.gyroscope, INT1_PIN, &queue);
+        TEST_ASSERT_EQUAL(0, wakeup.sleep(fixture.config, callback(on_wakeup)));
+        fixture.sim_gyro.set_bias(0.0, 0.0, 50.0);
+        ThisThread::sleep_for(50ms);
+        TEST_ASSERT_EQUAL(1, queue.get_posted_count());
+        wakeup.cancel();
+        TEST_ASSERT_EQUAL(0, queue.get_posted_count());
+    }
+    queue.dispatch_posted();
+    TEST_ASSERT_EQUAL(0, wakeup_stats.n_wakeups);
+}
+
+// test cases description
+#define WakeupCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    WakeupCase(test_wake_on_motion),
+    WakeupCase(test_sleep_cancel),
+    WakeupCase(test_cancel_pending_wakeup)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
@@ -0,0 +1,225 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_sample_ring.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+#include <thread>
+
+using namespace utest::v1;
+using namespace l3gd20;
+
+static TimestampedSample make_sample(uint32_t seq)
+{
+    TimestampedSample sample;
+    sample.timestamp_us = seq;
+    sample.data[0] = (int16_t)seq;
+    sample.data[1] = (int16_t)(seq >> 16);
+    sample.data[2] = (int16_t)~seq;
+    return sample;
+}
+
+static bool check_sample(const TimestampedSample &sample)
+{
+    uint32_t seq = (uint32_t)sample.timestamp_us;
+    return sample.data[0] == (int16_t)seq && sample.data[1] == (int16_t)(seq >> 16) && sample.data[2] == (int16_t)~seq;
+}
+
+/**
+ * Test push and read with single reader.
+ */
+void test_push_read()
+{
+    SampleRing<8> ring;
+    SampleRing<8>::Reader reader(&ring);
+    TimestampedSample samples[8];
+    uint32_t lost;
+
+    TEST_ASSERT_EQUAL(0, reader.available());
+    TEST_ASSERT_EQUAL(0, reader.read(samples, 8, &lost));
+    TEST_ASSERT_EQUAL(0, lost);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        ring.push(make_sample(i));
+    }
+    TEST_ASSERT_EQUAL(5, reader.available());
+
+    // partial read
+    TEST_ASSERT_EQUAL(3, reader.read(samples, 3, &lost));
+    TEST_ASSERT_EQUAL(0, lost);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(i, samples[i].timestamp_us);
+        TEST_ASSERT(check_sample(samples[i]));
+    }
+
+    // read with wraparound
+    for (uint32_t i = 5; i < 10; i++) {
+        ring.push(make_sample(i));
+    }
+    TEST_ASSERT_EQUAL(7, reader.read(samples, 8, &lost));
+    TEST_ASSERT_EQUAL(0, lost);
+    for (int i = 0; i < 7; i++) {
+        TEST_ASSERT_EQUAL(i + 3, samples[i].timestamp_us);
+    }
+    TEST_ASSERT_EQUAL(0, reader.available());
+
+    // a new reader gets new items only
+    SampleRing<8>::Reader late_reader(&ring);
+    TEST_ASSERT_EQUAL(0, late_reader.available());
+    ring.push(make_sample(10));
+    TEST_ASSERT_EQUAL(1, late_reader.read(samples, 8));
+    TEST_ASSERT_EQUAL(10, samples[0].timestamp_us);
+}
+
+/**
+ * Test that readers are independent.
+ */
+void test_multiple_readers()
+{
+    SampleRing<16> ring;
+    SampleRing<16>::Reader logger(&ring);
+    SampleRing<16>::Reader fusion(&ring);
+    SampleRing<16>::Reader telemetry(&ring);
+    TimestampedSample samples[16];
+
+    TimestampedSample block[4];
+    for (uint32_t i = 0; i < 4; i++) {
+        block[i] = make_sample(i);
+    }
+    ring.push(block, 4);
+
+    TEST_ASSERT_EQUAL(4, logger.read(samples, 16));
+    TEST_ASSERT_EQUAL(2, fusion.read(samples, 2));
+    TEST_ASSERT_EQUAL(0, logger.available());
+    TEST_ASSERT_EQUAL(2, fusion.available());
+    TEST_ASSERT_EQUAL(4, telemetry.available());
+
+    ring.push(make_sample(4));
+    TEST_ASSERT_EQUAL(3, fusion.read(samples, 16));
+    TEST_ASSERT_EQUAL(2, samples[0].timestamp_us);
+    TEST_ASSERT_EQUAL(4, samples[2].timestamp_us);
+    TEST_ASSERT_EQUAL(1, logger.read(samples, 16));
+    TEST_ASSERT_EQUAL(4, samples[0].timestamp_us);
+
+    telemetry.skip();
+    TEST_ASSERT_EQUAL(0, telemetry.available());
+    TEST_ASSERT_EQUAL(0, telemetry.get_lost_count());
+}
+
+/**
+ * Test overrun detection.
+ */
+void test_overrun()
+{
+    SampleRing<8> ring;
+    SampleRing<8>::Reader slow_reader(&ring);
+    SampleRing<8>::Reader fast_reader(&ring);
+    TimestampedSample samples[8];
+    uint32_t lost;
+
+    // a reader can lag behind by N - 1 items
+    for (uint32_t i = 0; i < 7; i++) {
+        ring.push(make_sample(i));
+    }
+    TEST_ASSERT_EQUAL(7, fast_reader.read(samples, 8, &lost));
+    TEST_ASSERT_EQUAL(0, lost);
+
+    for (uint32_t i = 7; i < 20; i++) {
+        ring.push(make_sample(i));
+    }
+    TEST_ASSERT_EQUAL(20, slow_reader.available());
+    TEST_ASSERT_EQUAL(4, slow_reader.read(samples, 4, &lost));
+    TEST_ASSERT_EQUAL(13, lost);
+    TEST_ASSERT_EQUAL(13, samples[0].timestamp_us);
+    TEST_ASSERT_EQUAL(3, slow_reader.read(samples, 8, &lost));
+    TEST_ASSERT_EQUAL(0, lost);
+    TEST_ASSERT_EQUAL(19, samples[2].timestamp_us);
+    TEST_ASSERT_EQUAL(13, slow_reader.get_lost_count());
+
+    // the other reader isn't affected
+    TEST_ASSERT_EQUAL(7, fast_reader.read(samples, 8, &lost));
+    TEST_ASSERT_EQUAL(6, lost);
+    TEST_ASSERT_EQUAL(6, fast_reader.get_lost_count());
+}
+
+/**
+ * Test concurrent producer and consumers.
+ */
+void test_concurrent_access()
+{
+    static SampleRing<64> ring;
+    const uint32_t total_count = 2000000;
+    const int n_readers = 3;
+    struct ReaderResult {
+        uint32_t received;
+        uint32_t lost;
+        uint32_t errors;
+    } results[n_readers];
+    std::atomic<int> ready_count(0);
+
+    std::thread consumers[n_readers];
+    for (int k = 0; k < n_readers; k++) {
+        consumers[k] = std::thread([&, k]() {
+            SampleRing<64>::Reader reader(&ring);
+            TimestampedSample samples[16];
+            ReaderResult &res = results[k];
+            uint32_t expected_seq = 0;
+            res = { 0, 0, 0 };
+            ready_count++;
+            // readers use different block sizes
+            int block_size = 1 + k * 7;
+            while (expected_seq < total_count) {
+                uint32_t lost;
+                int n = reader.read(samples, block_size, &lost);
+                expected_seq += lost;
+                res.lost += lost;
+                for (int i = 0; i < n; i++) {
+                    if (samples[i].timestamp_us != expected_seq || !check_sample(samples[i])) {
+                        res.errors++;
+                    }
+                    expected_seq = (uint32_t)samples[i].timestamp_us + 1;
+                }
+                res.received += n;
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    while (ready_count < n_readers) {
+        std::this_thread::yield();
+    }
+
+    for (uint32_t i = 0; i < total_count; i++) {
+        ring.push(make_sample(i));
+        // give time to consumers, so they receive a part of samples
+        if (i % 128 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (int k = 0; k < n_readers; k++) {
+        consumers[k].join();
+    }
+
+    for (int k = 0; k < n_readers; k++) {
+        TEST_ASSERT_EQUAL(0, results[k].errors);
+        TEST_ASSERT(results[k].received > 0);
+        TEST_ASSERT_EQUAL(total_count, results[k].received + results[k].lost);
+    }
+}
+
+// test cases description
+#define RingCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    RingCase(test_push_read),
+    RingCase(test_multiple_readers),
+    RingCase(test_overrun),
+    RingCase(test_concurrent_access)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
@@ -0,0 +1,166 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_bias_estimator.h"
+#include "l3gd20_driver.h"
+#include "l3gd20_sim.h"
+#include "l3gd20_temperature_bias.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+
+static const float RAD_PER_DEGREE = (float)M_PI / 180.0f;
+
+/**
+ * Nonlinear bias curve of the synthetic test.
+ */
+static void get_curve_bias(int temperature, float bias[3])
+{
+    float t = (float)temperature;
+    bias[0] = 0.01f + 1e-4f * t + 2e-6f * t * t;
+    bias[1] = -0.02f - 3e-4f * t;
+    bias[2] = 0.005f - 1e-6f * t * t;
+}
+
+/**
+ * Test table learning, interpolation and extrapolation with synthetic observations.
+ */
+void test_synthetic_curve()
+{
+    TemperatureBiasModel model;
+    float bias[3] = { 1.0f, 1.0f, 1.0f };
+    float expected[3];
+    int8_t min_temperature;
+    int8_t max_temperature;
+
+    // empty model
+    TEST_ASSERT_FALSE(model.get_bias(0, bias));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, bias[0]);
+    TEST_ASSERT_FALSE(model.get_temperature_range(&min_temperature, &max_temperature));
+
+    // single observation is used for all temperatures
+    get_curve_bias(0, expected);
+    model.learn(0, expected);
+    TEST_ASSERT_TRUE(model.get_bias(40, bias));
+    TEST_ASSERT_EQUAL_FLOAT(expected[1], bias[1]);
+
+    // observations at every 10 degrees with noise, that is averaged
+    for (int repeat = 0; repeat < 4; repeat++) {
+        for (int t = -60; t <= 60; t += 10) {
+            get_curve_bias(t, expected);
+            float noise = repeat & 1 ? 1e-4f : -1e-4f;
+            for (int i = 0; i < 3; i++) {
+                expected[i] += noise;
+            }
+            model.learn(t, expected);
+        }
+    }
+    TEST_ASSERT_EQUAL(13, model.get_learned_bin_count());
+    TEST_ASSERT_TRUE(model.get_temperature_range(&min_temperature, &max_temperature));
+    TEST_ASSERT_EQUAL(-60, min_temperature);
+    TEST_ASSERT_EQUAL(60, max_temperature);
+
+    // piecewise linear interpolation error of the quadratic term is up to 2e-6 * (10 / 2)^2
+    float max_error = 0.0f;
+    for (int t = -60; t <= 60; t++) {
+        get_curve_bias(t, expected);
+        TEST_ASSERT_TRUE(model.get_bias(t, bias));
+        for (int i = 0; i < 3; i++) {
+            float error = fabsf(bias[i] - expected[i]);
+            max_error = error > max_error ? error : max_error;
+        }
+    }
+    TEST_ASSERT(max_error < 5.5e-5f);
+
+    // the nearest bin is used outside of the learned range
+    get_curve_bias(60, expected);
+    model.get_bias(100, bias);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected[0], bias[0]);
+    get_curve_bias(-60, expected);
+    model.get_bias(-128, bias);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, expected[2], bias[2]);
+
+    model.reset();
+    TEST_ASSERT_EQUAL(0, model.get_learned_bin_count());
+    TEST_ASSERT_FALSE(model.get_bias(0, bias));
+}
+
+/**
+ * Test model learning with simulated device, that warms up with vibration periods.
+ */
+void test_simulated_device()
+{
+    SimulatedL3GD20 sim_gyro;
+    sim_gyro.attach_spi(SPI_CS);
+    sim_gyro.set_bias(1.0, -0.5, 2.0);
+    sim_gyro.set_bias_temperature_coefficient(0.03, -0.02, 0.04);
+    sim_gyro.set_noise(0.05);
+    const double amplitude[3] = { 5.0, 3.0, 4.0 };
+    const double frequency[3] = { 20.0, 35.0, 50.0 };
+    SineTrajectory vibration(amplitude, frequency);
+
+    L3GD20Gyroscope gyro(SPI_MOSI, SPI_MISO, SPI_SCLK, SPI_CS);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro.clear_fifo();
+    BiasEstimator estimator;
+    TemperatureBiasModel model;
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    float sensitivity = gyro.get_sensitivity();
+    float window_mean[3];
+
+    // OUT_TEMP decreases from 10 to -30 (the device warms up by 40 degrees), the device vibrates
+    // during the first half of each temperature step
+    int8_t temperature = 0;
+    for (int8_t out_temp = 10; out_temp >= -30; out_temp -= 10) {
+        sim_gyro.set_temperature(out_temp);
+        for (int t = 0; t < 2000; t += 20) {
+            sim_gyro.set_trajectory(t < 1000 ? &vibration : NULL);
+            ThisThread::sleep_for(20ms);
+            int n = gyro.read_fifo(samples, &temperature);
+            if (n > 0) {
+                TEST_ASSERT_EQUAL(out_temp, temperature);
+            }
+            if (estimator.update(samples, n, sensitivity)) {
+                estimator.get_window_mean(window_mean);
+                model.learn(temperature, window_mean);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL(5, model.get_learned_bin_count());
+
+    // learned and interpolated temperatures
+    const int8_t check_temperatures[] = { 10, -30, -5, -17 };
+    for (size_t k = 0; k < sizeof(check_temperatures) / sizeof(check_temperatures[0]); k++) {
+        int8_t out_temp = check_temperatures[k];
+        float bias[3];
+        TEST_ASSERT_TRUE(model.get_bias(out_temp, bias));
+        double expected[3] = { 1.0 - 0.03 * out_temp, -0.5 + 0.02 * out_temp, 2.0 - 0.04 * out_temp };
+        for (int i = 0; i < 3; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(0.02f * RAD_PER_DEGREE, expected[i] * RAD_PER_DEGREE, bias[i]);
+        }
+    }
+}
+
+// test cases description
+#define TemperatureBiasCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    TemperatureBiasCase(test_synthetic_curve),
+    TemperatureBiasCase(test_simulated_device)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
@@ -0,0 +1,308 @@
+#include "greentea-client/test_env.h"
+#include "l3gd20_driver.h"
+#include "l3gd20_sim.h"
+#include "l3gd20_timestamper.h"
+#include "mbed.h"
+#include "unity.h"
+#include "utest.h"
+
+using namespace utest::v1;
+using namespace l3gd20;
+using namespace l3gd20::sim;
+
+static const PinName SPI_MOSI = PA_7;
+static const PinName SPI_MISO = PA_6;
+static const PinName SPI_SCLK = PA_5;
+static const PinName SPI_CS = PE_3;
+static const PinName INT2_PIN = PE_1;
+
+/**
+ * Pseudo-random interrupt latency generator.
+ */
+class LatencyGenerator {
+public:
+    LatencyGenerator(uint32_t max_latency_us)
+        : _state(1)
+        , _max_latency_us(max_latency_us)
+    {
+    }
+
+    uint32_t next()
+    {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state % (_max_latency_us + 1);
+    }
+
+private:
+    uint32_t _state;
+    uint32_t _max_latency_us;
+};
+
+/**
+ * Test ODR estimation and timestamps with synthetic edge times.
+ */
+void test_synthetic_edges()
+{
+    const float nominal_odr_hz = 760.0f;
+    const double true_period_us = 1e6 / (nominal_odr_hz * 1.03);
+    const int watermark = 24;
+    const uint32_t max_latency_us = 60;
+    SampleTimestamper timestamper(nominal_odr_hz);
+    LatencyGenerator latency(max_latency_us);
+    uint64_t timestamps[L3GD20Gyroscope::FIFO_SIZE];
+
+    uint32_t sample_index = 0;
+    double max_error_us = 0.0;
+    for (int block = 0; block < 400; block++) {
+        // the edge occurs on the watermark sample, but the reading gets some extra samples sometimes
+        uint64_t edge_time_us = (uint64_t)((sample_index + watermark) * true_period_us) + latency.next();
+        int n = watermark + (block % 5 == 0 ? 2 : 0);
+        timestamper.update(edge_time_us, watermark, n, timestamps);
+        if (block >= 100) {
+            for (int i = 0; i < n; i++) {
+                double error_us = fabs(timestamps[i] - (sample_index + i + 1) * true_period_us);
+                max_error_us = error_us > max_error_us ? error_us : max_error_us;
+            }
+        }
+        sample_index += n;
+    }
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-4 * true_period_us, true_period_us, timestamper.get_sample_period_us());
+    // timestamps include mean latency
+    TEST_ASSERT(max_error_us < max_latency_us);
+    TEST_ASSERT_EQUAL(sample_index, timestamper.get_sample_count());
+    TEST_ASSERT_EQUAL(0, timestamper.get_resync_count());
+}
+
+/**
+ * Test tracking restart after lost samples and blocks without edges.
+ */
+void test_lost_samples()
+{
+    const float nominal_odr_hz = 190.0f;
+    const double true_period_us = 1e6 / (nominal_odr_hz * 0.97);
+    const int watermark = 10;
+    SampleTimestamper timestamper(nominal_odr_hz);
+    uint64_t timestamps[L3GD20Gyroscope::FIFO_SIZE];
+
+    // no time reference before the first edge
+    timestamper.update(3, timestamps);
+    TEST_ASSERT_EQUAL(0, timestamps[2]);
+
+    uint32_t sample_index = 3;
+    for (int block = 0; block < 100; block++) {
+        if (block == 50) {
+            // FIFO overrun: samples are lost, but the timestamper doesn't know about it
+            sample_index += 5;
+        }
+        uint64_t edge_time_us = (uint64_t)((sample_index + watermark) * true_period_us);
+        timestamper.update(edge_time_us, watermark, watermark, timestamps);
+        sample_index += watermark;
+    }
+    TEST_ASSERT_EQUAL(1, timestamper.get_resync_count());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4 * true_period_us, true_period_us, timestamper.get_sample_period_us());
+    double expected_us = sample_index * true_period_us;
+    TEST_ASSERT_FLOAT_WITHIN(2.0, expected_us, (double)timestamps[watermark - 1]);
+
+    // block without edge is extrapolated
+    timestamper.update(2, timestamps);
+    expected_us = (sample_index + 2) * true_period_us;
+    TEST_ASSERT_FLOAT_WITHIN(2.0, expected_us, (double)timestamps[1]);
+}
+
+/**
+ * Test lost samples accounting after reported FIFO overrun.
+ */
+void test_overrun_lost_samples()
+{
+    const float nominal_odr_hz = 760.0f;
+    const double true_period_us = 1e6 / (nominal_odr_hz * 1.02);
+    const int watermark = 16;
+    const int n_lost = 7;
+    SampleTimestamper timestamper(nominal_odr_hz);
+    LatencyGenerator latency(40);
+    uint64_t timestamps[L3GD20Gyroscope::FIFO_SIZE];
+
+    uint32_t sample_index = 0;
+    uint32_t n_read = 0;
+    double max_error_us = 0.0;
+    for (int block = 0; block < 200; block++) {
+        uint64_t edge_time_us = (uint64_t)((sample_index + watermark) * true_period_us) + latency.next();
+        int n = watermark;
+        bool overrun = false;
+        if (block == 100) {
+            // processing is delayed, so the oldest samples of the full FIFO are overwritten after the edge
+            sample_index += n_lost;
+            n = L3GD20Gyroscope::FIFO_SIZE;
+            overrun = true;
+        }
+        timestamper.update(edge_time_us, watermark, n, timestamps, overrun);
+        if (block == 100) {
+            // the loss isn't known until the next edge
+            TEST_ASSERT_EQUAL(0, timestamper.get_lost_sample_count());
+        } else if (block > 100) {
+            for (int i = 0; i < n; i++) {
+                double error_us = fabs(timestamps[i] - (sample_index + i + 1) * true_period_us);
+                max_error_us = error_us > max_error_us ? error_us : max_error_us;
+            }
+        }
+        sample_index += n;
+        n_read += n;
+    }
+
+    // the tracking continues without restart
+    TEST_ASSERT_EQUAL(0, timestamper.get_resync_count());
+    TEST_ASSERT_EQUAL(n_lost, timestamper.get_lost_sample_count());
+    TEST_ASSERT_EQUAL(n_read, timestamper.get_sample_count());
+    TEST_ASSERT(max_error_us < 40);
+
+    // the same late edge without overrun report restarts the tracking
+    timestamper.reset(nominal_odr_hz);
+    sample_index = 0;
+    for (int block = 0; block < 10; block++) {
+        if (block == 5) {
+            sample_index += n_lost;
+        }
+        uint64_t edge_time_us = (uint64_t)((sample_index + watermark) * true_period_us);
+        timestamper.update(edge_time_us, watermark, watermark, timestamps);
+        sample_index += watermark;
+    }
+    TEST_ASSERT_EQUAL(1, timestamper.get_resync_count());
+    TEST_ASSERT_EQUAL(0, timestamper.get_lost_sample_count());
+}
+
+/**
+ * Test timestamps continuity across output data rate switches.
+ */
+void test_odr_switch()
+{
+    const float odr_hz[2] = { 95.0f, 760.0f };
+    const int watermark[2] = { 4, 24 };
+    const double deviation = 1.03;
+    const uint32_t max_latency_us = 60;
+    SampleTimestamper timestamper(odr_hz[0]);
+    LatencyGenerator latency(max_latency_us);
+    uint64_t timestamps[L3GD20Gyroscope::FIFO_SIZE];
+
+    // time of the sample before the first sample of the current rate
+    double rate_start_us = 0.0;
+    uint32_t rate_sample_index = 0;
+    uint32_t sample_index = 0;
+    uint64_t last_timestamp_us = 0;
+    bool monotonic = true;
+    double max_error_us = 0.0;
+    for (int rate_block = 0; rate_block < 6; rate_block++) {
+        int r = rate_block % 2;
+        double true_period_us = 1e6 / (odr_hz[r] * deviation);
+        for (int block = 0; block < 40; block++) {
+            uint32_t edge_index = sample_index - rate_sample_index + watermark[r];
+            uint64_t edge_time_us = (uint64_t)(rate_start_us + edge_index * true_period_us) + latency.next();
+            timestamper.update(edge_time_us, watermark[r], watermark[r], timestamps);
+            for (int i = 0; i < watermark[r]; i++) {
+                double expected_us = rate_start_us + (sample_index - rate_sample_index + i + 1) * true_period_us;
+                double error_us = fabs(timestamps[i] - expected_us);
+                if (rate_block > 0) {
+                    // the first rate is used for the initial estimation
+                    max_error_us = error_us > max_error_us ? error_us : max_error_us;
+                }
+                monotonic &= timestamps[i] > last_timestamp_us;
+                last_timestamp_us = timestamps[i];
+            }
+            sample_index += watermark[r];
+        }
+        // the rate is switched a half of the sample period after the last sample
+        rate_start_us += (sample_index - rate_sample_index) * true_period_us + 0.5 * true_period_us;
+        rate_sample_index = sample_index;
+        timestamper.switch_odr(odr_hz[1 - r]);
+        // the measured oscillator deviation is kept
+        TEST_ASSERT_FLOAT_WITHIN(1e-3 * odr_hz[1 - r], odr_hz[1 - r] * deviation, timestamper.get_odr_hz());
+    }
+
+    TEST_ASSERT_TRUE(monotonic);
+    TEST_ASSERT(max_error_us < max_latency_us);
+    TEST_ASSERT_EQUAL(sample_index, timestamper.get_sample_count());
+    TEST_ASSERT_EQUAL(0, timestamper.get_resync_count());
+}
+
+static SampleTimestamper *sim_timestamper;
+static Timer *sim_timer;
+static volatile bool sim_edge_pending;
+static uint64_t sim_edge_time_us;
+
+static void on_watermark()
+{
+    sim_edge_time_us = sim_timer->elapsed_time().count();
+    sim_edge_pending = true;
+}
+
+/**
+ * Test ODR estimation with simulated device, whose oscillator is slower than nominal one.
+ */
+void test_simulated_device()
+{
+    SimulatedL3GD20 sim_gyro;
+    sim_gyro.attach_spi(SPI_CS);
+    sim_gyro.connect_int2(INT2_PIN);
+    sim_gyro.set_odr_deviation(-0.04);
+
+    L3GD20Gyroscope gyro(SPI_MOSI, SPI_MISO, SPI_SCLK, SPI_CS);
+    TEST_ASSERT_EQUAL(0, gyro.init());
+    gyro.set_output_data_rate(L3GD20Gyroscope::ODR_760_HZ);
+    const int watermark = 16;
+    gyro.set_fifo_watermark(watermark);
+    gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    gyro.clear_fifo();
+
+    Timer timer;
+    timer.start();
+    SampleTimestamper timestamper(gyro.get_output_data_rate_hz());
+    sim_timer = &timer;
+    sim_timestamper = &timestamper;
+    sim_edge_pending = false;
+    InterruptIn int2(INT2_PIN);
+    int2.rise(on_watermark);
+    gyro.set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
+
+    int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    uint64_t timestamps[L3GD20Gyroscope::FIFO_SIZE];
+    int n_total = 0;
+    while (timer.elapsed_time() < 5s) {
+        // process blocks with some delay to get extra samples
+        ThisThread::sleep_for(1ms);
+        if (sim_edge_pending) {
+            sim_edge_pending = false;
+            int n = gyro.read_fifo(samples);
+            timestamper.update(sim_edge_time_us, watermark, n, timestamps);
+            n_total += n;
+        }
+    }
+    int2.rise(nullptr);
+
+    float true_odr_hz = 760.0f * 0.96f;
+    TEST_ASSERT_FLOAT_WITHIN(true_odr_hz * 5e-4f, true_odr_hz, timestamper.get_odr_hz());
+    // all samples are read except the last incomplete block
+    TEST_ASSERT_INT_WITHIN(2 * watermark, (int)(true_odr_hz * 5), n_total);
+    TEST_ASSERT_EQUAL(0, timestamper.get_resync_count());
+    // the last sample is produced before the reading
+    TEST_ASSERT(timestamps[0] < (uint64_t)timer.elapsed_time().count());
+}
+
+// test cases description
+#define TimestamperCase(test_fun) Case(#test_fun, test_fun, greentea_case_failure_continue_handler)
+Case cases[] = {
+    TimestamperCase(test_synthetic_edges),
+    TimestamperCase(test_lost_samples),
+    TimestamperCase(test_overrun_lost_samples),
+    TimestamperCase(test_odr_switch),
+    TimestamperCase(test_simulated_device)
+};
+Specification specification(greentea_test_setup_handler, cases, greentea_test_teardown_handler);
+
+// Entry point into the tests
+int main()
+{
+    GREENTEA_SETUP(40, "default_auto");
+    return !Harness::run(specification);
+}
@@ -0,0 +1,146 @@
+#ifndef L3GD20_ADAPTIVE_RATE_H
+#define L3GD20_ADAPTIVE_RATE_H
+
+#include "l3gd20_driver.h"
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Output data rate controller, that is driven by signal activity.
+ *
+ * The controller selects one of two rates: a low output data rate with small FIFO watermark for idle periods
+ * and a high output data rate with large FIFO watermark for motion. Activity of each block is RMS
+ * of the angular rate vector magnitude (bias is subtracted), so it includes both rotation and vibration:
+ *
+ * - the high rate is selected immediately, when block activity exceeds `high_activity`;
+ * - the low rate is selected, when activity stays below `low_activity` during `hold_time_us`.
+ *
+ * The gap between thresholds and the hold time prevent switching on a boundary activity level.
+ * The controller makes decisions only; the switching is executed by GyroStream (see GyroStream::set_rate_controller()).
+ *
+ * Example:
+ *
+ * @code
+ * AdaptiveRateController::Config config;
+ * config.high_activity = 0.2f;
+ * config.low_activity = 0.1f;
+ * AdaptiveRateController controller(config);
+ *
+ * stream.set_rate_controller(&controller, callback(on_rate_change));
+ * stream.start(24, callback(on_block));
+ * @endcode
+ */
+class AdaptiveRateController : private NonCopyable<AdaptiveRateController> {
+public:
+    /**
+     * Controller configuration.
+     */
+    struct Config {
+        // output data rate and FIFO watermark of the idle periods
+        L3GD20Gyroscope::OutputDataRate low_odr;
+        int low_watermark;
+        // output data rate and FIFO watermark of the motion periods
+        L3GD20Gyroscope::OutputDataRate high_odr;
+        int high_watermark;
+        // activity in rad/s, that selects the high rate
+        float high_activity;
+        // activity in rad/s, that allows to select the low rate. It should be less than high_activity.
+        float low_activity;
+        // duration of low activity before low rate selection in microseconds
+        uint32_t hold_time_us;
+
+        Config();
+    };
+
+    /**
+     * Constructor.
+     *
+     * The initial rate is the high one.
+     *
+     * @param config controller configuration
+     */
+    AdaptiveRateController(const Config &config = Config());
+
+    /**
+     * Set current rate and drop low activity duration.
+     *
+     * @param high_rate select the high rate
+     */
+    void reset(bool high_rate);
+
+    /**
+     * Process block of raw samples, that are sampled with the current rate.
+     *
+     * @param samples raw samples in order: x, y, z
+     * @param n number of samples
+     * @param sensitivity sensitivity in rad/s per LSB (see L3GD20Gyroscope::get_sensitivity())
+     * @param odr_hz output data rate of the samples in Hz
+     * @return true if the rate should be changed (see get_odr() and get_watermark())
+     */
+    bool update(const int16_t (*samples)[3], int n, float sensitivity, float odr_hz);
+
+    /**
+     * Set bias, that is subtracted from the samples (e.g. BiasEstimator result).
+     *
+     * @param bias bias in rad/s in order: x, y, z
+     */
+    void set_bias(const float bias[3]);
+
+    /**
+     * Get configuration.
+     *
+     * @return
+     */
+    const Config &get_config();
+
+    /**
+     * Check if the high rate is selected.
+     *
+     * @return
+     */
+    bool is_high_rate();
+
+    /**
+     * Get output data rate of the selected rate.
+     *
+     * @return
+     */
+    L3GD20Gyroscope::OutputDataRate get_odr();
+
+    /**
+     * Get FIFO watermark of the selected rate.
+     *
+     * @return
+     */
+    int get_watermark();
+
+    /**
+     * Get activity of the last block.
+     *
+     * @return activity in rad/s
+     */
+    float get_activity();
+
+    /**
+     * Get number of rate changes since construction.
+     *
+     * @return
+     */
+    uint32_t get_switch_count();
+
+private:
+    Config _config;
+    float _bias[3];
+    bool _high_rate;
+    float _activity;
+    float _low_activity_time_us;
+    uint32_t _switch_count;
+
+    void _select(bool high_rate);
+};
+}
+
+using l3gd20::AdaptiveRateController;
+
+#endif // L3GD20_ADAPTIVE_RATE_H
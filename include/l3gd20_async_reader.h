@@ -0,0 +1,95 @@
+#ifndef L3GD20_ASYNC_READER_H
+#define L3GD20_ASYNC_READER_H
+
+#include "l3gd20_driver.h"
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Helper class to read gyroscope FIFO asynchronously.
+ *
+ * The reader configures FIFO stream mode with watermark interrupt on pin INT2.
+ * On each watermark interrupt it starts asynchronous burst reading of FIFO block
+ * directly from an ISR context, and on transfer completion it invokes user callback
+ * with block samples.
+ *
+ * The reader uses two buffers, so the next block is read while the current one
+ * can be processed. The samples that are passed to callback remain valid until
+ * the next block is delivered.
+ *
+ * Both SPI and I2C buses are supported, if target provides asynchronous API for them.
+ *
+ * @note
+ * The driver methods shouldn't be used while reader is running. To reduce CPU usage
+ * during transfers, the DMA usage can be enabled with SPI::set_dma_usage/I2C::set_dma_usage methods.
+ */
+class AsyncFifoReader : private NonCopyable<AsyncFifoReader> {
+public:
+    /**
+     * Constructor.
+     *
+     * @param gyro initialized gyroscope driver
+     * @param int2_pin pin that is connected to INT2 of the L3GD20
+     */
+    AsyncFifoReader(L3GD20Gyroscope *gyro, PinName int2_pin);
+
+    virtual ~AsyncFifoReader();
+
+    /**
+     * Block callback.
+     *
+     * It's invoked from an ISR context with block samples and their number.
+     */
+    typedef Callback<void(const int16_t (*samples)[3], int n)> block_callback_t;
+
+    /**
+     * Start FIFO reading.
+     *
+     * @param block_size number of samples in a block (FIFO watermark). It should be between 1 and 31.
+     * @param block_callback block callback
+     * @return 0 on success, otherwise non-zero error code.
+     */
+    int start(int block_size, const block_callback_t &block_callback);
+
+    /**
+     * Stop FIFO reading.
+     *
+     * The method waits completion of the current transfer. If the transfer isn't completed within 50 ms
+     * (e.g. the completion is lost due bus error), it's aborted on the bus and counted as an error,
+     * so the reader can be started again.
+     */
+    void stop();
+
+    /**
+     * Get number of interrupts that are skipped due bus errors and abandoned transfers.
+     *
+     * @return
+     */
+    int get_error_count();
+
+private:
+    L3GD20Gyroscope *_gyro;
+    InterruptIn _int2;
+
+    block_callback_t _callback;
+    int _block_size;
+    volatile bool _running;
+    volatile bool _transfer;
+    volatile bool _abandoned_transfer;
+    int _error_count;
+
+    // two buffers with extra head element, so the raw data, that is placed after
+    // an extra byte of the asynchronous transfer, is aligned and can be decoded in place
+    int16_t _buffers[2][L3GD20Gyroscope::FIFO_SIZE * 3 + 1];
+    int _current_buffer;
+
+    void _start_transfer();
+    void _on_interrupt();
+    void _on_transfer_complete(int err);
+};
+}
+
+using l3gd20::AsyncFifoReader;
+
+#endif // L3GD20_ASYNC_READER_H
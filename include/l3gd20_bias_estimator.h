@@ -0,0 +1,137 @@
+#ifndef L3GD20_BIAS_ESTIMATOR_H
+#define L3GD20_BIAS_ESTIMATOR_H
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Streaming estimator of the gyroscope zero-rate level (bias).
+ *
+ * The estimator processes sample stream in consecutive windows. For each window it calculates
+ * mean and variance of each axis with Welford's algorithm (O(1) per sample, no sample storage).
+ * A window is considered stationary if standard deviation of each axis is below `max_std_dev`
+ * and absolute mean of each axis is below `max_bias`. The bias is refined with the means of the
+ * stationary windows (running average of the last `AVERAGING_WINDOWS` windows), so the device
+ * doesn't need to be still at startup and acquisition isn't interrupted.
+ *
+ * @note
+ * Rotation with a constant rate below `max_bias` and without vibration can't be distinguished from bias,
+ * so `max_bias` should be close to the zero-rate level specification of the used full scale.
+ *
+ * Example:
+ *
+ * @code
+ * BiasEstimator bias_estimator;
+ * float bias[3];
+ *
+ * int n = gyroscope.read_fifo(samples);
+ * bias_estimator.update(samples, n, gyroscope.get_sensitivity());
+ * bias_estimator.get_bias(bias);
+ * integrator.update(samples, n, gyroscope.get_sensitivity(), bias);
+ * @endcode
+ */
+class BiasEstimator {
+public:
+    /**
+     * Number of stationary windows, whose means are averaged in the steady state.
+     */
+    static const int AVERAGING_WINDOWS = 16;
+
+    /**
+     * Constructor.
+     *
+     * @param window_size number of samples in a window (e.g. 256 samples are 0.34 s at 760 Hz)
+     * @param max_std_dev maximal standard deviation of a stationary window in rad/s
+     * @param max_bias maximal absolute mean of a stationary window in rad/s
+     */
+    BiasEstimator(int window_size = 256, float max_std_dev = 0.01f, float max_bias = 0.35f);
+
+    /**
+     * Drop bias estimation and current window.
+     */
+    void reset();
+
+    /**
+     * Process block of angular rates.
+     *
+     * @param rates angular rates in rad/s in order: x, y, z
+     * @param n number of samples
+     * @return true if a stationary window has been completed during this block
+     */
+    bool update(const float (*rates)[3], int n);
+
+    /**
+     * Process block of raw samples (e.g. L3GD20Gyroscope::read_fifo output).
+     *
+     * @param samples raw samples in order: x, y, z
+     * @param n number of samples
+     * @param sensitivity sensitivity in rad/s per LSB (see L3GD20Gyroscope::get_sensitivity())
+     * @return true if a stationary window has been completed during this block
+     */
+    bool update(const int16_t (*samples)[3], int n, float sensitivity);
+
+    /**
+     * Get estimated bias.
+     *
+     * @param bias bias in rad/s in order: x, y, z. It's zero until the first stationary window.
+     */
+    void get_bias(float bias[3]);
+
+    /**
+     * Get mean of the last stationary window.
+     *
+     * Unlike get_bias(), the value isn't averaged with previous windows, so it can be used
+     * as a bias observation at the current conditions (e.g. by TemperatureBiasModel).
+     *
+     * @param mean mean in rad/s in order: x, y, z
+     */
+    void get_window_mean(float mean[3]);
+
+    /**
+     * Set initial bias (e.g. stored calibration).
+     *
+     * It's refined by the next stationary windows.
+     *
+     * @param bias bias in rad/s in order: x, y, z
+     */
+    void set_bias(const float bias[3]);
+
+    /**
+     * Check if the last complete window is stationary.
+     *
+     * @return
+     */
+    bool is_stationary();
+
+    /**
+     * Get number of stationary windows that have been used for bias estimation.
+     *
+     * @return
+     */
+    int get_stationary_window_count();
+
+private:
+    int _window_size;
+    float _max_variance;
+    float _max_bias;
+
+    // current window statistics
+    int _count;
+    float _mean[3];
+    float _m2[3];
+
+    float _bias[3];
+    float _window_mean[3];
+    bool _stationary;
+    int _stationary_count;
+    // number of windows in the bias average
+    int _weight;
+
+    bool _add_sample(float x, float y, float z);
+    bool _finish_window();
+};
+}
+
+using l3gd20::BiasEstimator;
+
+#endif // L3GD20_BIAS_ESTIMATOR_H
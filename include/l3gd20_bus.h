@@ -0,0 +1,379 @@
+#ifndef L3GD20_BUS_H
+#define L3GD20_BUS_H
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Offset of the register values in the buffer of the asynchronous reading.
+ *
+ * For SPI the first received byte corresponds to the register address transmission,
+ * so the same offset is used for all buses.
+ */
+static const int ASYNC_READ_OFFSET = 1;
+
+/**
+ * I2C address of the L3GD20 (assume SDO pin is set to 0).
+ */
+static const uint8_t L3GD20_I2C_ADDRESS = 0xDA;
+
+/**
+ * Register transport interface.
+ *
+ * It can be used to connect L3GD20 driver to a custom register storage,
+ * like a bus bridge, a software device model or a recorded data player.
+ *
+ * Multi-byte operations should use register address auto-increment.
+ */
+class RegisterTransport {
+public:
+    virtual ~RegisterTransport()
+    {
+    }
+
+    /**
+     * Read several registers, starting with address \p reg.
+     *
+     * @param reg first register address
+     * @param data buffer for register values
+     * @param length number of registers to read
+     */
+    virtual void read_registers(uint8_t reg, uint8_t *data, uint8_t length) = 0;
+
+    /**
+     * Write several registers, starting with address \p reg.
+     *
+     * @param reg first register address
+     * @param data register values
+     * @param length number of registers to write
+     */
+    virtual void write_registers(uint8_t reg, const uint8_t *data, uint8_t length) = 0;
+
+    /**
+     * Start asynchronous reading of several registers.
+     *
+     * The register values should be placed into \p data buffer starting with position ASYNC_READ_OFFSET.
+     * On transfer completion the \p callback should be invoked with 0 argument if transfer is successful,
+     * or non-zero error code otherwise.
+     *
+     * Default implementation doesn't support asynchronous reading.
+     *
+     * @param reg first register address
+     * @param data buffer for register values
+     * @param length number of registers to read
+     * @param callback transfer completion callback
+     * @return 0 if transfer is started, otherwise non-zero error code.
+     */
+    virtual int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback)
+    {
+        return MBED_ERROR_CODE_UNSUPPORTED;
+    }
+
+    /**
+     * Abort asynchronous reading.
+     *
+     * After return the callback of the aborted transfer shouldn't be invoked.
+     *
+     * Default implementation does nothing.
+     */
+    virtual void abort_async()
+    {
+    }
+};
+
+/**
+ * SPI bus policy.
+ *
+ * All register access methods are inlined, so they can be used to create
+ * L3GD20 driver without runtime bus selection overhead.
+ *
+ * Bus policy interface:
+ *
+ * - `uint8_t read_register(uint8_t reg)`
+ * - `void write_register(uint8_t reg, uint8_t val)`
+ * - `void read_registers(uint8_t reg, uint8_t *data, uint8_t length)`
+ * - `void write_registers(uint8_t reg, const uint8_t *data, uint8_t length)`
+ * - `int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback)`
+ * - `void abort_async()`
+ *
+ * @note
+ * Unlike L3GD20Gyroscope, the ssel pin is required.
+ */
+class SpiBus : private NonCopyable<SpiBus> {
+public:
+    /**
+     * Constructor.
+     *
+     * @param spi_ptr SPI interface
+     * @param ssel SPI ssel pin
+     */
+    SpiBus(SPI *spi_ptr, PinName ssel);
+
+    /**
+     * Constructor.
+     *
+     * @param mosi SPI mosi pin
+     * @param miso SPI miso pin
+     * @param sclk SPI sclk pin
+     * @param ssel SPI ssel pin
+     */
+    SpiBus(PinName mosi, PinName miso, PinName sclk, PinName ssel);
+
+    ~SpiBus();
+
+    uint8_t read_register(uint8_t reg);
+    void write_register(uint8_t reg, uint8_t val);
+    void read_registers(uint8_t reg, uint8_t *data, uint8_t length);
+    void write_registers(uint8_t reg, const uint8_t *data, uint8_t length);
+    int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback);
+    void abort_async();
+
+private:
+    SPI *_spi_ptr;
+    DigitalOut _ssel;
+    bool _cleanup_spi_ptr;
+
+    // asynchronous transfer data
+    volatile bool _async_transfer;
+    uint8_t _async_reg;
+    Callback<void(int)> _async_callback;
+
+    void _async_handler(int event);
+};
+
+/**
+ * I2C bus policy.
+ *
+ * All register access methods are inlined, so they can be used to create
+ * L3GD20 driver without runtime bus selection overhead.
+ *
+ * See SpiBus for bus policy interface description.
+ */
+class I2cBus : private NonCopyable<I2cBus> {
+public:
+    /**
+     * Constructor.
+     *
+     * @param i2c_ptr I2C interface
+     */
+    I2cBus(I2C *i2c_ptr);
+
+    /**
+     * Constructor.
+     *
+     * @param sda I2C data line pin
+     * @param scl I2C clock line pin
+     */
+    I2cBus(PinName sda, PinName scl);
+
+    ~I2cBus();
+
+    uint8_t read_register(uint8_t reg);
+    void write_register(uint8_t reg, uint8_t val);
+    void read_registers(uint8_t reg, uint8_t *data, uint8_t length);
+    void write_registers(uint8_t reg, const uint8_t *data, uint8_t length);
+    int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback);
+    void abort_async();
+
+    /**
+     * Maximal number of registers that can be written with write_registers method.
+     */
+    static const uint8_t MAX_WRITE_LENGTH = 16;
+
+private:
+    I2C *_i2c_ptr;
+    bool _cleanup_i2c_ptr;
+
+    // asynchronous transfer data
+    volatile bool _async_transfer;
+    uint8_t _async_reg;
+    Callback<void(int)> _async_callback;
+
+    void _async_handler(int event);
+};
+
+/**
+ * Bus policy with runtime bus selection.
+ *
+ * It's used by L3GD20Gyroscope, and supports both SPI and I2C interfaces.
+ *
+ * See SpiBus for bus policy interface description.
+ */
+class DynamicBus : private NonCopyable<DynamicBus> {
+public:
+    /**
+     * Constructor
+     *
+     * @param i2c_ptr I2C interface
+     */
+    DynamicBus(I2C *i2c_ptr);
+
+    /**
+     * Constructor.
+     *
+     * @param sda I2C data line pin
+     * @param scl I2C clock line pin
+     */
+    DynamicBus(PinName sda, PinName scl);
+
+    /**
+     * Constructor.
+     *
+     * @param spi_ptr SPI interface
+     * @param ssel SPI ssel pin. It can be NC, if ssel is controlled outside driver.
+     */
+    DynamicBus(SPI *spi_ptr, PinName ssel);
+
+    /**
+     * Constructor.
+     *
+     * @param mosi SPI mosi pin
+     * @param miso SPI miso pin
+     * @param sclk SPI sclk pin
+     * @param ssel SPI ssel pin. It can be NC, if ssel is controlled outside driver.
+     */
+    DynamicBus(PinName mosi, PinName miso, PinName sclk, PinName ssel);
+
+    /**
+     * Constructor.
+     *
+     * @param transport_ptr custom register transport
+     */
+    DynamicBus(RegisterTransport *transport_ptr);
+
+    ~DynamicBus();
+
+    uint8_t read_register(uint8_t reg);
+    void write_register(uint8_t reg, uint8_t val);
+    void read_registers(uint8_t reg, uint8_t *data, uint8_t length);
+    void write_registers(uint8_t reg, const uint8_t *data, uint8_t length);
+    int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback);
+    void abort_async();
+
+private:
+    // helper variable with state flags
+    uint8_t _state;
+    enum StateFlags : uint8_t {
+        SPI_DEVICE = 0x01,
+        I2C_DEVICE = 0x02,
+        CLEANUP_I2C_PTR = 0x04,
+        CLEANUP_SPI_PTR = 0x08,
+        CLEANUP_SPI_SSEL = 0x10,
+        TRANSPORT_DEVICE = 0x20,
+        ASYNC_TRANSFER = 0x40
+    };
+
+    // spi/i2c data
+    union Interface {
+        SPI *spi_ptr;
+        I2C *i2c_ptr;
+        RegisterTransport *transport_ptr;
+    };
+    Interface _interface;
+
+    DigitalOut *_spi_ssel_ptr;
+
+    // asynchronous transfer data
+    uint8_t _async_reg;
+    Callback<void(int)> _async_callback;
+
+    void _spi_async_handler(int event);
+    void _i2c_async_handler(int event);
+    void _transport_async_handler(int err);
+};
+
+/*
+ * SpiBus inline methods
+ */
+
+inline uint8_t SpiBus::read_register(uint8_t reg)
+{
+    _ssel.write(0);
+    _spi_ptr->write(reg | 0x80); // send register address in read mode
+    uint8_t val = _spi_ptr->write(0x00); // read register value
+    _ssel.write(1);
+    return val;
+}
+
+inline void SpiBus::write_register(uint8_t reg, uint8_t val)
+{
+    _ssel.write(0);
+    _spi_ptr->write(reg & 0x7F); // send register address in write mode
+    _spi_ptr->write(val); // send value
+    _ssel.write(1);
+}
+
+inline void SpiBus::read_registers(uint8_t reg, uint8_t *data, uint8_t length)
+{
+    _ssel.write(0);
+    _spi_ptr->write(reg | 0x40 | 0x80); // send register address in read multiple bytes mode
+    _spi_ptr->write(NULL, 0, (char *)data, length); // read data
+    _ssel.write(1);
+}
+
+inline void SpiBus::write_registers(uint8_t reg, const uint8_t *data, uint8_t length)
+{
+    _ssel.write(0);
+    _spi_ptr->write((reg & 0x3F) | 0x40); // send register address in write multiple bytes mode
+    _spi_ptr->write((const char *)data, length, NULL, 0); // write data
+    _ssel.write(1);
+}
+
+/*
+ * I2cBus inline methods
+ */
+
+inline uint8_t I2cBus::read_register(uint8_t reg)
+{
+    uint8_t val;
+    int res;
+    res = _i2c_ptr->write(L3GD20_I2C_ADDRESS, (char *)&reg, 1, true); // send register address
+    res |= _i2c_ptr->read(L3GD20_I2C_ADDRESS, (char *)&val, 1); // read register value
+    if (res) {
+        MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_READ_FAILED), "register reading failed");
+    }
+    return val;
+}
+
+inline void I2cBus::write_register(uint8_t reg, uint8_t val)
+{
+    uint8_t data[2] = { reg, val };
+    // write register address and value
+    int res = _i2c_ptr->write(L3GD20_I2C_ADDRESS, (char *)data, 2);
+    if (res) {
+        MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "register writing failed");
+    }
+}
+
+inline void I2cBus::read_registers(uint8_t reg, uint8_t *data, uint8_t length)
+{
+    int res;
+    reg |= 0x80; // read multiple bytes
+    res = _i2c_ptr->write(L3GD20_I2C_ADDRESS, (char *)&reg, 1, true); // send register address
+    res |= _i2c_ptr->read(L3GD20_I2C_ADDRESS, (char *)data, length); // read data
+    if (res) {
+        MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_READ_FAILED), "registers reading failed");
+    }
+}
+
+inline void I2cBus::write_registers(uint8_t reg, const uint8_t *data, uint8_t length)
+{
+    if (length > MAX_WRITE_LENGTH) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Too many registers to write");
+    }
+    uint8_t buf[MAX_WRITE_LENGTH + 1];
+    buf[0] = reg | 0x80; // write multiple bytes
+    memcpy(buf + 1, data, length);
+    // write register address and values
+    int res = _i2c_ptr->write(L3GD20_I2C_ADDRESS, (char *)buf, length + 1);
+    if (res) {
+        MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "registers writing failed");
+    }
+}
+}
+
+using l3gd20::RegisterTransport;
+using l3gd20::SpiBus;
+using l3gd20::I2cBus;
+
+#endif // L3GD20_BUS_H
@@ -0,0 +1,113 @@
+#ifndef L3GD20_CALIBRATION_STORE_H
+#define L3GD20_CALIBRATION_STORE_H
+#include "blockdevice/BlockDevice.h"
+#include "l3gd20_driver.h"
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Persistent storage of the gyroscope calibration on a block device.
+ *
+ * The calibration is kept in a single 32 byte record (padded to the device read/program size),
+ * that has magic number, format version and CRC-32, so it's restored with a single block device read
+ * and processing can start without calibration delay after power cycle.
+ *
+ * The record is bound to the full scale and output data rate, as zero-rate level and the actual output
+ * data rate depend on them. The record uses native byte order.
+ *
+ * @note
+ * The block device should be initialized. The record address should be aligned to the erase size,
+ * as the record is erased before programming.
+ *
+ * Example:
+ *
+ * @code
+ * CalibrationStore store(&block_device);
+ * CalibrationStore::Calibration calibration;
+ * if (store.load(&calibration, gyroscope.get_full_scale(), gyroscope.get_output_data_rate()) == 0) {
+ *     bias_estimator.set_bias(calibration.bias);
+ *     timestamper.set_odr_hz(calibration.odr_hz);
+ * }
+ * @endcode
+ */
+class CalibrationStore : private NonCopyable<CalibrationStore> {
+public:
+    /**
+     * Record magic number ("L3GC").
+     */
+    static const uint32_t MAGIC = 0x4347334C;
+
+    /**
+     * Record format version.
+     */
+    static const uint16_t VERSION = 1;
+
+    /**
+     * Maximal size of the padded record.
+     */
+    static const int MAX_RECORD_SIZE = 256;
+
+    /**
+     * Calibration data.
+     */
+    struct Calibration {
+        // configuration, that is used for calibration
+        L3GD20GyroscopeBase::FullScale full_scale;
+        L3GD20GyroscopeBase::OutputDataRate odr;
+        // bias in rad/s in order: x, y, z
+        float bias[3];
+        // raw temperature sensor value at bias estimation (see L3GD20Gyroscope::read_temperature_8())
+        int8_t temperature;
+        // measured output data rate in Hz or 0, if it's unknown (see SampleTimestamper::get_odr_hz())
+        float odr_hz;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param block_device block device
+     * @param address record address
+     */
+    CalibrationStore(BlockDevice *block_device, bd_addr_t address = 0);
+
+    /**
+     * Save calibration.
+     *
+     * @param calibration
+     * @return 0 on success, non-zero value otherwise (negative values are block device errors)
+     */
+    int save(const Calibration &calibration);
+
+    /**
+     * Load calibration with a single block device read and check it against current configuration.
+     *
+     * @param calibration buffer for calibration. It's filled even if configuration doesn't match.
+     * @param full_scale current full scale
+     * @param odr current output data rate
+     * @return 0 on success, or error code:
+     *         - MBED_ERROR_CODE_ITEM_NOT_FOUND - there is no record of the current format version;
+     *         - MBED_ERROR_CODE_INVALID_DATA_DETECTED - the record is corrupted;
+     *         - MBED_ERROR_CODE_INVALID_FORMAT - the record is made for other full scale or output data rate;
+     *         - negative value - block device error.
+     */
+    int load(Calibration *calibration, L3GD20GyroscopeBase::FullScale full_scale, L3GD20GyroscopeBase::OutputDataRate odr);
+
+    /**
+     * Invalidate stored calibration.
+     *
+     * @return 0 on success, non-zero value otherwise
+     */
+    int erase();
+
+private:
+    BlockDevice *_block_device;
+    bd_addr_t _address;
+
+    int _get_record_size(bd_size_t *record_size);
+};
+}
+
+using l3gd20::CalibrationStore;
+
+#endif // L3GD20_CALIBRATION_STORE_H
@@ -7,54 +7,12 @@
 namespace l3gd20 {
 
 /**
- * The L3GD20 gyroscope driver.
+ * Base class of the L3GD20 gyroscope drivers.
+ *
+ * It contains register map, configuration enumerations and bus independent helpers.
  */
-class L3GD20Gyroscope {
+class L3GD20GyroscopeBase {
 public:
-    /**
-     * Constructor.
-     *
-     * @param i2c_ptr I2C interface
-     */
-    L3GD20Gyroscope(I2C *i2c_ptr);
-
-    /**
-     * Constructor.
-     *
-     * @param sda I2C data line pin
-     * @param scl I2C clock line pin
-     */
-    L3GD20Gyroscope(PinName sda, PinName scl);
-
-    /**
-     * Constructor.
-     *
-     * @param spi_ptr SPI interface
-     */
-    L3GD20Gyroscope(SPI *spi_ptr, PinName ssel);
-
-    /**
-     * Constructor.
-     *
-     * @param mosi SPI mosi pin
-     * @param miso SPI miso pin
-     * @param sclk SPI sclk pin
-     * @param ssel SPI ssel pin
-     */
-    L3GD20Gyroscope(PinName mosi, PinName miso, PinName sclk, PinName ssel);
-
-    virtual ~L3GD20Gyroscope();
-
-    /**
-     * Initialize device with default settings and test connection.
-     *
-     * Note: this method is idempotent.
-     *
-     * @param start if it's `true`, then initially sensor will be enabled, otherwise disabled.
-     * @return 0, if device is initialize correctly, otherwise non-zero error code.
-     */
-    int init(bool start = true);
-
     enum Registers {
         WHO_AM_I_ADDR = 0x0F, // device identification register
         CTRL_REG1_ADDR = 0x20, // Control register 1
@@ -84,6 +42,361 @@ public:
         INT1_DURATION_ADDR = 0x38, // Interrupt 1 DURATION register
     };
 
+    enum RegisterCacheMode {
+        REG_CACHE_ENABLE = 1,
+        REG_CACHE_DISABLE = 0
+    };
+
+    /**
+     * Device power mode (CTRL_REG1 PD bit and axes enable bits).
+     *
+     * Sleep mode keeps the device powered with all axes disabled, so it wakes up faster than from power down.
+     */
+    enum GyroscopeMode {
+        G_DISABLE = 0x00,
+        G_SLEEP = 0x08,
+        G_ENABLE = 0x0F
+    };
+
+    /**
+     * Axis enable bits of CTRL_REG1 (note: L3GD20 uses "Zen Xen Yen" order).
+     */
+    enum AxisEnable {
+        AXIS_Y_ENABLE = 0x01,
+        AXIS_X_ENABLE = 0x02,
+        AXIS_Z_ENABLE = 0x04,
+        AXIS_ALL_ENABLE = 0x07
+    };
+
+    enum OutputDataRate {
+        ODR_95_HZ = 0x00,
+        ODR_190_HZ = 0x40,
+        ODR_380_HZ = 0x80,
+        ODR_760_HZ = 0xC0
+    };
+
+    enum LowPassFilterCutoffFreqMode {
+        LPF_CF0 = 0x00,
+        LPF_CF1 = 0x10,
+        LPF_CF2 = 0x20,
+        LPF_CF3 = 0x30
+    };
+
+    enum HighPassFilterMode {
+        HPF_ENABLE = 0x10,
+        HPF_DISABLE = 0x00
+    };
+
+    enum HighPassFilterCutoffFreqMode {
+        HPF_CF0 = 0x00,
+        HPF_CF1 = 0x01,
+        HPF_CF2 = 0x02,
+        HPF_CF3 = 0x03,
+        HPF_CF4 = 0x04,
+        HPF_CF5 = 0x05,
+        HPF_CF6 = 0x06,
+        HPF_CF7 = 0x07,
+        HPF_CF8 = 0x08,
+        HPF_CF9 = 0x09
+    };
+
+    enum FullScale {
+        FULL_SCALE_250 = 0x00,
+        FULL_SCALE_500 = 0x10,
+        FULL_SCALE_1000 = 0x20,
+        FULL_SCALE_2000 = 0x30
+    };
+
+    enum FIFOMode {
+        FIFO_ENABLE = 1,
+        FIFO_DISABLE = 0
+    };
+
+    /**
+     * FIFO capacity in samples.
+     */
+    static const int FIFO_SIZE = 32;
+
+    /**
+     * Offset of the FIFO data in the buffer of the read_fifo_async method.
+     */
+    static const int FIFO_ASYNC_OFFSET = ASYNC_READ_OFFSET;
+
+    /**
+     * Offset of the samples in the buffer of the read_fifo_view method, if temperature is read.
+     *
+     * OUT_TEMP and STATUS_REG precede output registers, so the samples remain aligned to 2 bytes.
+     */
+    static const int FIFO_VIEW_TEMPERATURE_OFFSET = 2;
+
+    /**
+     * Size of the read_fifo_view buffer, that can hold all FIFO samples and temperature.
+     */
+    static const int FIFO_VIEW_BUFFER_SIZE = FIFO_VIEW_TEMPERATURE_OFFSET + FIFO_SIZE * 6;
+
+    /**
+     * Convert raw output registers data into samples.
+     *
+     * Conversion can be done in place, i.e. \p raw_data can point to \p samples.
+     * Raw data already has sample layout on little-endian targets, so in place conversion does nothing,
+     * and bytes are swapped on big-endian targets only.
+     *
+     * @param raw_data raw data (6 bytes per sample)
+     * @param samples buffer for samples
+     * @param n number of samples
+     */
+    static void decode_samples(const uint8_t *raw_data, int16_t (*samples)[3], int n);
+
+    /**
+     * Convert block of raw samples into floating point values: `data[i][j] = samples[i][j] * scale`.
+     *
+     * CMSIS-DSP (if `l3gd20-driver.use_cmsis_dsp` option is set), SSE2 or NEON instructions
+     * are used if they are available.
+     *
+     * @param samples raw samples
+     * @param data buffer for converted samples
+     * @param n number of samples
+     * @param scale scale factor (see get_sensitivity() and get_sensitivity_dps())
+     */
+    static void convert_samples(const int16_t (*samples)[3], float (*data)[3], int n, float scale);
+
+    /**
+     * Convert block of raw samples into separate per-axis arrays of floating point values:
+     * `x[i] = samples[i][0] * scale`, `y[i] = samples[i][1] * scale` and `z[i] = samples[i][2] * scale`.
+     *
+     * @param samples raw samples
+     * @param x buffer for x axis values
+     * @param y buffer for y axis values
+     * @param z buffer for z axis values
+     * @param n number of samples
+     * @param scale scale factor (see get_sensitivity() and get_sensitivity_dps())
+     */
+    static void convert_samples(const int16_t (*samples)[3], float *x, float *y, float *z, int n, float scale);
+
+    /**
+     * Number of fractional bits of the fixed-point angular rate values (Q16.16 format).
+     */
+    static const int FIXED_POINT_FRAC_BITS = 16;
+
+    /**
+     * Fixed-point sensitivity: `value = (raw * multiplier + rounding) >> shift`.
+     *
+     * The multiplier is less than 2^16, so the product fits into 32 bits and only integer
+     * multiplication and shift are needed. The values for Q16.16 output are:
+     *
+     * | FullScale       | mdps/LSB | dps (Q16.16)       | rad/s (Q16.16)     |
+     * |-----------------|----------|--------------------|--------------------|
+     * | FULL_SCALE_250  | 8.75     | raw * 36700 >> 6   | raw * 40994 >> 12  |
+     * | FULL_SCALE_500  | 17.5     | raw * 36700 >> 5   | raw * 40994 >> 11  |
+     * | FULL_SCALE_1000 | 35       | raw * 36700 >> 4   | raw * 40994 >> 10  |
+     * | FULL_SCALE_2000 | 70       | raw * 36700 >> 3   | raw * 40994 >> 9   |
+     *
+     * Relative errors of the multipliers are 4.4e-6 (dps) and 1.2e-5 (rad/s).
+     */
+    struct FixedScale {
+        int32_t multiplier;
+        int shift;
+    };
+
+    /**
+     * Convert block of raw samples into fixed-point values: `data[i][j] = (samples[i][j] * multiplier) >> shift`.
+     *
+     * The values are rounded to nearest.
+     *
+     * @param samples raw samples
+     * @param data buffer for converted samples
+     * @param n number of samples
+     * @param scale fixed-point scale (see get_sensitivity_q16() and get_sensitivity_dps_q16())
+     */
+    static void convert_samples(const int16_t (*samples)[3], int32_t (*data)[3], int n, FixedScale scale);
+
+    enum DataReadyInterruptMode {
+        DRDY_ENABLE = 1,
+        DRDY_DISABLE = 0
+    };
+
+    /**
+     * FIFO overrun and empty interrupts on pin INT2.
+     *
+     * They are routed independently of the data ready/watermark interrupt, and the pin level is OR of all
+     * enabled sources. So the overrun interrupt produces a rising edge only if the pin isn't held
+     * by the watermark interrupt already (e.g. FIFO is polled, or watermark interrupt is disabled).
+     */
+    enum FIFOInterruptMode {
+        FIFO_INT_DISABLE = 0x00,
+        FIFO_INT_EMPTY = 0x01,
+        FIFO_INT_OVERRUN = 0x02,
+        FIFO_INT_OVERRUN_EMPTY = 0x03
+    };
+
+    /**
+     * FIFO state (FIFO_SRC_REG content).
+     */
+    struct FIFOStatus {
+        // number of samples in FIFO
+        int level;
+        // FIFO level is greater than or equal to watermark
+        bool watermark;
+        // FIFO is completely filled. In stream mode each new sample overwrites the oldest one, so samples can be lost.
+        bool overrun;
+        // FIFO is empty
+        bool empty;
+    };
+
+    /**
+     * Typed view of the samples, that are read into caller buffer (see read_fifo_view()).
+     */
+    struct FIFOView {
+        // samples in order: x, y, z. They point into the caller buffer.
+        int16_t (*samples)[3];
+        // number of read samples
+        int n_samples;
+        // raw temperature sensor value (see read_temperature_8()), if it's requested and FIFO isn't empty
+        int8_t temperature;
+    };
+
+    /**
+     * Decode FIFO_SRC_REG value.
+     *
+     * @param fifo_src FIFO_SRC_REG value
+     * @return FIFO state
+     */
+    static FIFOStatus decode_fifo_status(uint8_t fifo_src);
+
+    /**
+     * Angular rate threshold events of the INT1 interrupt generator (INT1_CFG/INT1_SRC bits).
+     *
+     * High event occurs, when absolute angular rate of the axis is higher than the axis threshold,
+     * low event occurs, when it's lower.
+     */
+    enum MotionEvent {
+        MOTION_X_LOW = 0x01,
+        MOTION_X_HIGH = 0x02,
+        MOTION_Y_LOW = 0x04,
+        MOTION_Y_HIGH = 0x08,
+        MOTION_Z_LOW = 0x10,
+        MOTION_Z_HIGH = 0x20,
+        // high events of all axes
+        MOTION_ANY_HIGH = 0x2A
+    };
+
+    /**
+     * INT1_SRC flag of the active interrupt request.
+     */
+    static const uint8_t MOTION_ACTIVE = 0x40;
+
+    /**
+     * INT1 angular rate threshold interrupt configuration.
+     */
+    struct MotionInterruptConfig {
+        // enabled events (bit mask of MotionEvent values). Zero value disables INT1 pin.
+        uint8_t events;
+        // absolute raw angular rate thresholds (0-32767) in order: x, y, z (see get_motion_threshold())
+        uint16_t threshold[3];
+        // the interrupt is requested when all enabled events occur, otherwise when any of them occurs
+        bool and_combination;
+        // the interrupt request is latched until read_motion_interrupt_source() call
+        bool latch;
+        // minimal duration of the events in samples (0-127)
+        uint8_t duration;
+        // the interrupt request is cleared after duration samples without events, otherwise immediately
+        bool wait;
+        // compare high-pass filtered data (CTRL_REG5 INT1_Sel), so the zero-rate level doesn't trigger events.
+        // The cutoff frequency is set by set_high_pass_filter_cutoff_freq_mode().
+        bool high_pass_filter;
+
+        MotionInterruptConfig();
+    };
+
+    /**
+     * Driver statistics (see `l3gd20-driver.stats_enabled` option).
+     *
+     * The numbers help to choose watermark, output data rate and bus clock: bus load per sample,
+     * FIFO level distribution at reading (levels near FIFO_SIZE mean that the FIFO is read too late)
+     * and interrupt masking time.
+     */
+    struct Stats {
+        // bus transactions
+        RegisterDeviceStats bus;
+        // samples, that are read by read_fifo, read_data* and started read_fifo_async transfers
+        uint32_t samples_read;
+        // fifo_level_histogram[i] is number of read_fifo calls, that have found i samples in FIFO
+        uint32_t fifo_level_histogram[FIFO_SIZE + 1];
+        // data ready interrupt masking intervals, that are reported by add_irq_masked_time()
+        uint32_t irq_masked_count;
+        uint64_t irq_masked_time_us;
+        uint32_t max_irq_masked_time_us;
+    };
+
+    /**
+     * Complete gyroscope configuration.
+     *
+     * Default constructor creates configuration that is used by init() method.
+     */
+    struct GyroConfig {
+        GyroscopeMode gyroscope_mode;
+        // enabled axes of G_ENABLE and G_DISABLE modes (bit mask of AxisEnable values)
+        uint8_t axes;
+        OutputDataRate output_data_rate;
+        LowPassFilterCutoffFreqMode low_pass_filter_cutoff_freq_mode;
+        HighPassFilterMode high_pass_filter_mode;
+        HighPassFilterCutoffFreqMode high_pass_filter_cutoff_freq_mode;
+        FullScale full_scale;
+        FIFOMode fifo_mode;
+        int fifo_watermark;
+        DataReadyInterruptMode data_ready_interrupt_mode;
+        FIFOInterruptMode fifo_interrupt_mode;
+
+        GyroConfig();
+    };
+
+protected:
+    static const uint8_t _DEVICE_ID = 0xD4;
+};
+
+/**
+ * The L3GD20 gyroscope driver with compile-time bus selection.
+ *
+ * The \p Bus is a bus policy class (SpiBus, I2cBus or DynamicBus), so register access
+ * is inlined without runtime bus checks. Constructor arguments are passed to the bus policy.
+ *
+ * Example:
+ *
+ * @code
+ * L3GD20GyroscopeT<SpiBus> gyroscope(&spi, PE_3);
+ * @endcode
+ */
+template <typename Bus>
+class L3GD20GyroscopeT : public L3GD20GyroscopeBase, private NonCopyable<L3GD20GyroscopeT<Bus> > {
+public:
+    /**
+     * Constructor.
+     *
+     * All arguments are passed to the bus policy constructor.
+     */
+    template <typename... Args>
+    explicit L3GD20GyroscopeT(Args... args)
+        : _register_device(args...)
+        , _last_fifo_status()
+        , _fifo_overrun_count(0)
+    {
+        reset_stats();
+    }
+
+    virtual ~L3GD20GyroscopeT()
+    {
+    }
+
+    /**
+     * Initialize device with default settings and test connection.
+     *
+     * Note: this method is idempotent.
+     *
+     * @param start if it's `true`, then initially sensor will be enabled, otherwise disabled.
+     * @return 0, if device is initialize correctly, otherwise non-zero error code.
+     */
+    int init(bool start = true);
+
     /**
      * Read register.
      *
@@ -100,30 +413,86 @@ public:
      */
     void write_register(uint8_t reg, uint8_t val);
 
-    enum GyroscopeMode {
-        G_DISABLE = 0x00,
-        G_ENABLE = 0x0F
-    };
     /**
-     * Enable/disable gyroscope.
+     * Enable/disable cache of the writable registers.
+     *
+     * If cache is enabled, then setters require only one write operation, and getters
+     * don't use bus at all. But if the device state is changed bypassing this driver
+     * (device reset, usage of other driver instance, etc.), the resync() method should be
+     * invoked to reload cache.
+     *
+     * Note: write_register method updates cache, so it can be used safely.
+     *
+     * @param mode
+     */
+    void set_register_cache_mode(RegisterCacheMode mode);
+
+    /**
+     * Check if register cache is enabled/disabled.
+     *
+     * @return 0 if cache is disabled, otherwise non-zero value
+     */
+    RegisterCacheMode get_register_cache_mode();
+
+    /**
+     * Reload register cache and driver state from device.
+     */
+    void resync();
+
+    /**
+     * Enable/disable gyroscope or switch it into sleep mode.
+     *
+     * G_ENABLE and G_DISABLE modes change power down bit only, so the enabled axes are kept.
+     * If all axes are disabled (e.g. in sleep mode), G_ENABLE mode enables all of them.
+     * G_SLEEP mode disables all axes.
      *
      * @param mode
      */
     void set_gyroscope_mode(GyroscopeMode mode);
 
+    /**
+     * Set gyroscope mode and enabled axes with a single register write.
+     *
+     * \p axes are ignored in G_SLEEP mode, and at least one axis should be enabled in G_ENABLE mode.
+     *
+     * @param mode
+     * @param axes bit mask of AxisEnable values
+     */
+    void set_gyroscope_mode(GyroscopeMode mode, uint8_t axes);
+
     /**
      * Check if gyroscope is enabled/disabled.
      *
-     * @return 0 if gyroscope is disabled, otherwise non-zero value
+     * @return 0 if gyroscope is disabled, G_SLEEP if it's powered with all axes disabled, otherwise G_ENABLE
      */
     GyroscopeMode get_gyroscope_mode();
 
-    enum OutputDataRate {
-        ODR_95_HZ = 0x00,
-        ODR_190_HZ = 0x40,
-        ODR_380_HZ = 0x80,
-        ODR_760_HZ = 0xC0
-    };
+    /**
+     * Enable/disable axes.
+     *
+     * Data of the disabled axes isn't updated. If gyroscope is powered and all axes are disabled, it's in sleep mode.
+     *
+     * @param axes bit mask of AxisEnable values
+     */
+    void set_axes(uint8_t axes);
+
+    /**
+     * Get enabled axes.
+     *
+     * @return bit mask of AxisEnable values
+     */
+    uint8_t get_axes();
+
+    /**
+     * Get number of samples after turn-on, that are affected by digital filters transient.
+     *
+     * The value is estimated from the current output data rate, low pass filter bandwidth and high pass filter
+     * cutoff frequency (if it's enabled) as 1% settling time of the first order filters plus the first sample.
+     * It doesn't include the turn-on time before the first sample.
+     *
+     * @return
+     */
+    int get_settling_sample_count();
 
     /**
      * Set output data rate.
@@ -146,13 +515,6 @@ public:
      */
     float get_output_data_rate_hz();
 
-    enum LowPassFilterCutoffFreqMode {
-        LPF_CF0 = 0x00,
-        LPF_CF1 = 0x10,
-        LPF_CF2 = 0x20,
-        LPF_CF3 = 0x30
-    };
-
     /**
      * Set low pass filter cutoff frequency mode.
      *
@@ -177,11 +539,6 @@ public:
      */
     float get_low_pass_filter_cut_off_frequency();
 
-    enum HighPassFilterMode {
-        HPF_ENABLE = 0x10,
-        HPF_DISABLE = 0x00
-    };
-
     /**
      * Disable/enable high pass filter.
      *
@@ -196,19 +553,6 @@ public:
      */
     HighPassFilterMode get_high_pass_filter_mode();
 
-    enum HighPassFilterCutoffFreqMode {
-        HPF_CF0 = 0x00,
-        HPF_CF1 = 0x01,
-        HPF_CF2 = 0x02,
-        HPF_CF3 = 0x03,
-        HPF_CF4 = 0x04,
-        HPF_CF5 = 0x05,
-        HPF_CF6 = 0x06,
-        HPF_CF7 = 0x07,
-        HPF_CF8 = 0x08,
-        HPF_CF9 = 0x09
-    };
-
     /**
      * Set high pass filter cutoff frequency mode.
      *
@@ -233,13 +577,6 @@ public:
      */
     float get_high_pass_filter_cut_off_frequency();
 
-    enum FullScale {
-        FULL_SCALE_250 = 0x00,
-        FULL_SCALE_500 = 0x10,
-        FULL_SCALE_1000 = 0x20,
-        FULL_SCALE_2000 = 0x30
-    };
-
     /**
      * Get full scale, i.e. maximum degrees per second (dps) value that gyroscope can detect.
      *
@@ -271,10 +608,23 @@ public:
      */
     float get_sensitivity_dps();
 
-    enum FIFOMode {
-        FIFO_ENABLE = 1,
-        FIFO_DISABLE = 0
-    };
+    /**
+     * Get fixed-point sensor sensitivity to convert raw values into radians per second in Q16.16 format.
+     *
+     * Unlike get_sensitivity(), it doesn't access device registers.
+     *
+     * @return
+     */
+    FixedScale get_sensitivity_q16();
+
+    /**
+     * Get fixed-point sensor sensitivity to convert raw values into degrees per second in Q16.16 format.
+     *
+     * Unlike get_sensitivity_dps(), it doesn't access device registers.
+     *
+     * @return
+     */
+    FixedScale get_sensitivity_dps_q16();
 
     /**
      * Enable/disabled FIFO.
@@ -309,13 +659,119 @@ public:
      */
     void clear_fifo();
 
-    enum DataReadyInterruptMode {
-        DRDY_ENABLE = 1,
-        DRDY_DISABLE = 0
-    };
+    /**
+     * Read FIFO state.
+     *
+     * It's a single register read, that doesn't change FIFO content and driver counters.
+     *
+     * @return
+     */
+    FIFOStatus read_fifo_status();
+
+    /**
+     * Get FIFO state, that is read by the last read_fifo() call before samples reading.
+     *
+     * It doesn't access device registers.
+     *
+     * @return
+     */
+    FIFOStatus get_last_fifo_status();
+
+    /**
+     * Get number of read_fifo() calls, that have found FIFO overrun, since driver creation.
+     *
+     * Each overrun means that the FIFO hasn't been read in time, and some samples can be lost
+     * (see SampleTimestamper::get_lost_sample_count() for their number).
+     *
+     * @return
+     */
+    uint32_t get_fifo_overrun_count();
+
+    /**
+     * Read all pending samples from FIFO.
+     *
+     * The method reads FIFO level from FIFO_SRC_REG and then gets all pending samples
+     * with a single burst transaction. The samples will be placed into \p samples
+     * array in order of their arrival, each sample has order: x, y, z.
+     * The FIFO state is available with get_last_fifo_status() method.
+     *
+     * @note
+     * FIFO should be enabled, otherwise no samples will be returned.
+     *
+     * @param samples buffer for samples
+     * @param max_samples \p samples buffer size
+     * @return number of read samples
+     */
+    int read_fifo(int16_t (*samples)[3], int max_samples = FIFO_SIZE);
+
+    /**
+     * Read all pending samples from FIFO together with temperature sensor data.
+     *
+     * The method works like read_fifo(int16_t (*)[3], int), but the burst transaction starts
+     * from OUT_TEMP register, so the temperature costs 2 extra bytes instead of a separate transaction.
+     *
+     * @note
+     * If FIFO is empty, \p temperature isn't updated.
+     *
+     * @param samples buffer for samples
+     * @param temperature raw temperature sensor value (see read_temperature_8())
+     * @param max_samples \p samples buffer size
+     * @return number of read samples
+     */
+    int read_fifo(int16_t (*samples)[3], int8_t *temperature, int max_samples = FIFO_SIZE);
+
+    /**
+     * Read all pending samples from FIFO directly into caller buffer without copy.
+     *
+     * The samples are read with a single burst transaction into \p buffer (into \p buffer + FIFO_VIEW_TEMPERATURE_OFFSET,
+     * if \p read_temperature is set), and the returned view points to them. Raw data already has sample layout
+     * on little-endian targets, so the samples aren't copied or reassembled; they are byte swapped in place
+     * on big-endian targets only. So the buffer can be passed to storage or DMA as is.
+     *
+     * The FIFO state is available with get_last_fifo_status() method.
+     *
+     * @param buffer caller buffer. It should be aligned to 2 bytes. FIFO_VIEW_BUFFER_SIZE bytes are enough for all samples.
+     * @param size \p buffer size in bytes
+     * @param read_temperature read temperature sensor data in the same transaction (2 extra bytes)
+     * @return view of the read samples
+     */
+    FIFOView read_fifo_view(void *buffer, size_t size, bool read_temperature = false);
+
+    /**
+     * Start asynchronous reading of \p n_samples samples from FIFO.
+     *
+     * Unlike read_fifo() method, this method doesn't check FIFO level, so it
+     * should be used when number of pending samples is known (for example
+     * after FIFO watermark interrupt).
+     *
+     * The \p buffer should have at least `n_samples * 6 + FIFO_ASYNC_OFFSET` bytes.
+     * On transfer completion, raw samples data will be placed into it starting with
+     * FIFO_ASYNC_OFFSET position, and \p callback will be invoked from an ISR context
+     * with 0 argument on success or non-zero error code otherwise.
+     * The raw data can be converted into samples with decode_samples() method. If `buffer + FIFO_ASYNC_OFFSET`
+     * is aligned to 2 bytes, it can be converted in place, that does nothing on little-endian targets.
+     *
+     * @note
+     * This method can be invoked from an ISR context. But any other driver methods
+     * shouldn't be used until transfer completion.
+     *
+     * @param buffer
+     * @param n_samples number of samples to read (up to FIFO_SIZE)
+     * @param callback
+     * @return 0 if transfer is started, otherwise non-zero error code.
+     */
+    int read_fifo_async(uint8_t *buffer, int n_samples, const Callback<void(int)> &callback);
+
+    /**
+     * Abort asynchronous FIFO reading, that is started with read_fifo_async() method.
+     *
+     * The transfer callback isn't invoked after return (e.g. if its completion is lost due bus error),
+     * and other driver methods can be used again. The samples of the aborted transfer are lost.
+     */
+    void abort_fifo_async();
 
     /**
-     * Enable/disable data ready interrupt on pin INT1.
+     * Enable/disable data ready interrupt on pin INT2.
      *
      * If FIFO is enabled, interrupt will be configured for FIFO watermark.
      *
@@ -330,6 +786,75 @@ public:
      */
     DataReadyInterruptMode get_data_ready_interrupt_mode();
 
+    /**
+     * Enable/disable FIFO overrun and empty interrupts on pin INT2.
+     *
+     * They don't depend on the data ready interrupt mode.
+     *
+     * @param mode
+     */
+    void set_fifo_interrupt_mode(FIFOInterruptMode mode);
+
+    /**
+     * Get enabled FIFO overrun and empty interrupts.
+     *
+     * @return
+     */
+    FIFOInterruptMode get_fifo_interrupt_mode();
+
+    /**
+     * Configure INT1 angular rate threshold interrupt.
+     *
+     * INT1_TSH_* and INT1_DURATION registers are written with a single burst transaction.
+     * INT1 pin is enabled (CTRL_REG3 I1_Int1), if any event is enabled. The interrupt generator
+     * doesn't depend on FIFO, so FIFO can be disabled while the device waits for motion.
+     *
+     * @param config
+     */
+    void set_motion_interrupt(const MotionInterruptConfig &config);
+
+    /**
+     * Get INT1 angular rate threshold interrupt configuration.
+     *
+     * @return
+     */
+    MotionInterruptConfig get_motion_interrupt();
+
+    /**
+     * Read INT1 interrupt source (INT1_SRC).
+     *
+     * The reading clears latched interrupt request.
+     *
+     * @return bit mask of the MotionEvent values and MOTION_ACTIVE flag
+     */
+    uint8_t read_motion_interrupt_source();
+
+    /**
+     * Convert angular rate into threshold value of the current full scale.
+     *
+     * @param rate_dps absolute angular rate in degrees per second
+     * @return threshold value (limited to 0-32767)
+     */
+    uint16_t get_motion_threshold(float rate_dps);
+
+    /**
+     * Apply complete gyroscope configuration.
+     *
+     * The method reads CTRL_REG1-CTRL_REG5 with a single burst transaction and FIFO_CTRL_REG,
+     * and writes only registers that don't match configuration. CTRL_REG1-CTRL_REG5
+     * are written with a single burst transaction.
+     *
+     * @param config
+     */
+    void apply(const GyroConfig &config);
+
+    /**
+     * Get current gyroscope configuration.
+     *
+     * @return
+     */
+    GyroConfig get_config();
+
     /**
      * Read current gyroscope data.
      *
@@ -363,6 +888,96 @@ public:
      */
     void read_data_16(int16_t data[3]);
 
+    /**
+     * Convert block of raw samples (e.g. samples of the read_fifo() method) into radians per second (rad/s).
+     *
+     * Current full scale is used, so it shouldn't be changed between samples reading and conversion.
+     *
+     * @param samples raw samples
+     * @param data buffer for converted samples in order: x, y, z
+     * @param n number of samples
+     */
+    void convert_data(const int16_t (*samples)[3], float (*data)[3], int n);
+
+    /**
+     * Convert block of raw samples into separate per-axis arrays in radians per second (rad/s).
+     *
+     * Current full scale is used, so it shouldn't be changed between samples reading and conversion.
+     *
+     * @param samples raw samples
+     * @param x buffer for x axis values
+     * @param y buffer for y axis values
+     * @param z buffer for z axis values
+     * @param n number of samples
+     */
+    void convert_data(const int16_t (*samples)[3], float *x, float *y, float *z, int n);
+
+    /**
+     * Convert block of raw samples (e.g. samples of the read_fifo() method) into degrees per second (dps).
+     *
+     * Current full scale is used, so it shouldn't be changed between samples reading and conversion.
+     *
+     * @param samples raw samples
+     * @param data buffer for converted samples in order: x, y, z
+     * @param n number of samples
+     */
+    void convert_data_dps(const int16_t (*samples)[3], float (*data)[3], int n);
+
+    /**
+     * Convert block of raw samples into separate per-axis arrays in degrees per second (dps).
+     *
+     * Current full scale is used, so it shouldn't be changed between samples reading and conversion.
+     *
+     * @param samples raw samples
+     * @param x buffer for x axis values
+     * @param y buffer for y axis values
+     * @param z buffer for z axis values
+     * @param n number of samples
+     */
+    void convert_data_dps(const int16_t (*samples)[3], float *x, float *y, float *z, int n);
+
+    /**
+     * Read current gyroscope data in radians per second (rad/s) as Q16.16 fixed-point values.
+     *
+     * The data will be placed into \p data array in order: x, y, z.
+     * The conversion doesn't use floating point operations.
+     *
+     * @param data
+     */
+    void read_data_q16(int32_t data[3]);
+
+    /**
+     * Read current gyroscope data in degrees per second (dps) as Q16.16 fixed-point values.
+     *
+     * The data will be placed into \p data array in order: x, y, z.
+     * The conversion doesn't use floating point operations.
+     *
+     * @param data
+     */
+    void read_data_dps_q16(int32_t data[3]);
+
+    /**
+     * Convert block of raw samples into radians per second (rad/s) as Q16.16 fixed-point values.
+     *
+     * Current full scale is used, so it shouldn't be changed between samples reading and conversion.
+     *
+     * @param samples raw samples
+     * @param data buffer for converted samples in order: x, y, z
+     * @param n number of samples
+     */
+    void convert_data_q16(const int16_t (*samples)[3], int32_t (*data)[3], int n);
+
+    /**
+     * Convert block of raw samples into degrees per second (dps) as Q16.16 fixed-point values.
+     *
+     * Current full scale is used, so it shouldn't be changed between samples reading and conversion.
+     *
+     * @param samples raw samples
+     * @param data buffer for converted samples in order: x, y, z
+     * @param n number of samples
+     */
+    void convert_data_dps_q16(const int16_t (*samples)[3], int32_t (*data)[3], int n);
+
     /**
      * Get raw data from temperature sensor.
      *
@@ -378,14 +993,38 @@ public:
     /**
      * Get temperature sensor sensitivity.
      *
-     * @return
+     * The sensor output decreases with temperature rise, so the sensitivity is negative.
+     *
+     * @return sensitivity in degrees Celsius per LSB
      */
     float get_temperature_sensor_sensitivity();
 
-private:
-    RegisterDevice _register_device;
+    /**
+     * Get snapshot of the driver statistics.
+     *
+     * @note
+     * The counters aren't updated atomically, so they shouldn't be read during asynchronous transfer.
+     *
+     * @return statistics or zeros, if statistics is disabled
+     */
+    Stats get_stats();
 
-    static const uint8_t _DEVICE_ID = 0xD4;
+    /**
+     * Reset driver statistics.
+     */
+    void reset_stats();
+
+    /**
+     * Report interval, when data ready interrupt has been masked (e.g. during FIFO reading).
+     *
+     * The driver doesn't control the interrupt pin, so the interval should be measured by application.
+     *
+     * @param time_us interval duration in microseconds
+     */
+    void add_irq_masked_time(uint32_t time_us);
+
+private:
+    RegisterDeviceT<Bus> _register_device;
 
     /**
      * Update interrupt register.
@@ -400,12 +1039,101 @@ private:
      */
     DataReadyInterruptMode _update_interrupt_register(int mode);
 
+    /**
+     * Read FIFO state, update counters and get number of samples to read.
+     *
+     * @param max_samples samples buffer size
+     * @return number of samples to read
+     */
+    int _read_fifo_level(int max_samples);
+
+    /**
+     * Update cached sensitivity values.
+     *
+     * @param fs current full scale
+     */
+    void _update_sensitivity(FullScale fs);
+
     // current gyroscope sensitivity
     float _gyro_sensitivity_dps;
     float _gyro_sensitivity_rps;
+    FixedScale _gyro_scale_dps_q16;
+    FixedScale _gyro_scale_rps_q16;
+
+    // FIFO state of the last read_fifo call
+    FIFOStatus _last_fifo_status;
+    uint32_t _fifo_overrun_count;
+
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    Stats _stats;
+#endif
+};
+
+/**
+ * The L3GD20 gyroscope driver.
+ *
+ * It supports both SPI and I2C interfaces with runtime selection.
+ */
+class L3GD20Gyroscope : public L3GD20GyroscopeT<DynamicBus> {
+public:
+    /**
+     * Constructor.
+     *
+     * @param i2c_ptr I2C interface
+     */
+    L3GD20Gyroscope(I2C *i2c_ptr);
+
+    /**
+     * Constructor.
+     *
+     * @param sda I2C data line pin
+     * @param scl I2C clock line pin
+     */
+    L3GD20Gyroscope(PinName sda, PinName scl);
+
+    /**
+     * Constructor.
+     *
+     * @param spi_ptr SPI interface
+     */
+    L3GD20Gyroscope(SPI *spi_ptr, PinName ssel);
+
+    /**
+     * Constructor.
+     *
+     * @param mosi SPI mosi pin
+     * @param miso SPI miso pin
+     * @param sclk SPI sclk pin
+     * @param ssel SPI ssel pin
+     */
+    L3GD20Gyroscope(PinName mosi, PinName miso, PinName sclk, PinName ssel);
+
+    /**
+     * Constructor.
+     *
+     * The transport object should exist during driver lifetime.
+     *
+     * @param transport_ptr custom register transport
+     */
+    L3GD20Gyroscope(RegisterTransport *transport_ptr);
+
+    virtual ~L3GD20Gyroscope();
 };
+
+/**
+ * The L3GD20 gyroscope driver with SPI interface.
+ */
+typedef L3GD20GyroscopeT<SpiBus> L3GD20GyroscopeSPI;
+
+/**
+ * The L3GD20 gyroscope driver with I2C interface.
+ */
+typedef L3GD20GyroscopeT<I2cBus> L3GD20GyroscopeI2C;
 }
 
 using l3gd20::L3GD20Gyroscope;
+using l3gd20::L3GD20GyroscopeT;
+using l3gd20::L3GD20GyroscopeSPI;
+using l3gd20::L3GD20GyroscopeI2C;
 
 #endif // L3GD20_DRIVER_H
@@ -0,0 +1,195 @@
+#ifndef L3GD20_DUTY_CYCLE_H
+#define L3GD20_DUTY_CYCLE_H
+
+#include "l3gd20_driver.h"
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Duty-cycled sampling scheduler.
+ *
+ * The scheduler keeps the device in sleep or power down mode and periodically captures a short block of samples:
+ *
+ * 1. wake: the configured axes are enabled with a single CTRL_REG1 write and data ready interrupt is enabled on INT2;
+ * 2. turn-on: the first data ready edge gives measured turn-on latency;
+ * 3. settle: the samples, that are affected by digital filters transient, are skipped without bus access
+ *    (see L3GD20Gyroscope::get_settling_sample_count());
+ * 4. capture: FIFO is enabled with watermark of the block size, and the block is read with a single burst;
+ * 5. sleep: the device is switched back into the idle mode, and the next wake is scheduled.
+ *
+ * Timing uses LowPowerTimer and LowPowerTimeout, so the MCU can enter deep sleep between the phases.
+ * Wake-to-data latencies of each cycle are measured and reported with the block, as the turn-on time depends
+ * on the idle mode and the device.
+ *
+ * @note
+ * The device driver shouldn't be used by other code while scheduler is running.
+ * The device output data rate and filters should be configured before start.
+ *
+ * Example:
+ *
+ * @code
+ * DutyCycleScheduler scheduler(&gyroscope, PE_1);
+ * DutyCycleScheduler::Config config;
+ * config.period_us = 1000000;
+ * config.n_samples = 8;
+ * config.idle_mode = L3GD20Gyroscope::G_SLEEP;
+ * scheduler.start(config, callback(on_capture));
+ *
+ * void on_capture(const DutyCycleScheduler::Capture &capture)
+ * {
+ *     process(capture.samples, capture.n_samples);
+ * }
+ * @endcode
+ */
+class DutyCycleScheduler : private NonCopyable<DutyCycleScheduler> {
+public:
+    /**
+     * Scheduler configuration.
+     */
+    struct Config {
+        // capture period (wake to wake) in microseconds
+        uint32_t period_us;
+        // number of samples in a capture (1-31)
+        int n_samples;
+        // mode between captures: G_SLEEP or G_DISABLE (power down)
+        L3GD20Gyroscope::GyroscopeMode idle_mode;
+        // enabled axes during capture (bit mask of L3GD20Gyroscope::AxisEnable values)
+        uint8_t axes;
+        // number of samples, that are skipped after turn-on, including the first one,
+        // or -1 to use L3GD20Gyroscope::get_settling_sample_count()
+        int settling_samples;
+
+        Config();
+    };
+
+    /**
+     * Captured block.
+     */
+    struct Capture {
+        int n_samples;
+        // raw samples in order: x, y, z
+        const int16_t (*samples)[3];
+        // wake time in microseconds since start
+        uint64_t wake_time_us;
+        // measured time from wake to the first data ready edge
+        uint32_t turn_on_latency_us;
+        // measured time from wake to the first captured sample (estimated from the watermark edge time)
+        uint32_t valid_data_latency_us;
+        // number of skipped samples
+        int settling_samples;
+    };
+
+    /**
+     * Latency statistics since start.
+     */
+    struct LatencyStats {
+        uint32_t n_captures;
+        uint32_t min_turn_on_latency_us;
+        uint32_t max_turn_on_latency_us;
+        uint32_t min_valid_data_latency_us;
+        uint32_t max_valid_data_latency_us;
+        uint64_t total_valid_data_latency_us;
+    };
+
+    /**
+     * Capture callback.
+     *
+     * It's invoked from the event queue context. Capture data is valid during callback invocation only.
+     */
+    typedef Callback<void(const Capture &capture)> capture_callback_t;
+
+    /**
+     * Constructor.
+     *
+     * @param gyro device driver
+     * @param int2_pin pin that is connected to INT2 of the device
+     * @param queue event queue, that is used for device access and captures delivering
+     */
+    DutyCycleScheduler(L3GD20Gyroscope *gyro, PinName int2_pin, EventQueue *queue = mbed_event_queue());
+
+    /**
+     * Destructor. It stops the scheduler.
+     */
+    ~DutyCycleScheduler();
+
+    /**
+     * Switch device into the idle mode and start captures. The first capture starts immediately.
+     *
+     * @param config scheduler configuration
+     * @param capture_callback capture callback
+     * @return 0 on success, otherwise non-zero error code:
+     *         - MBED_ERROR_CODE_INVALID_ARGUMENT - invalid configuration or callback;
+     *         - MBED_ERROR_CODE_EBUSY - the scheduler is running.
+     */
+    int start(const Config &config, const capture_callback_t &capture_callback);
+
+    /**
+     * Stop captures and leave the device in the idle mode.
+     */
+    void stop();
+
+    /**
+     * Check if the scheduler is running.
+     *
+     * @return
+     */
+    bool is_running();
+
+    /**
+     * Get number of skipped samples after turn-on of the current run.
+     *
+     * @return
+     */
+    int get_settling_samples();
+
+    /**
+     * Get latency statistics since start.
+     *
+     * @return
+     */
+    LatencyStats get_latency_stats();
+
+private:
+    enum Phase {
+        PHASE_IDLE,
+        PHASE_TURN_ON,
+        PHASE_SETTLE,
+        PHASE_CAPTURE
+    };
+
+    L3GD20Gyroscope *_gyro;
+    InterruptIn _int2;
+    Event<void()> _edge_event;
+    Event<void()> _timeout_event;
+    LowPowerTimeout _timeout;
+    LowPowerTimer _timer;
+
+    Config _config;
+    capture_callback_t _callback;
+    volatile bool _running;
+    volatile Phase _phase;
+    volatile uint64_t _edge_time_us;
+    uint64_t _wake_time_us;
+    uint32_t _turn_on_latency_us;
+    int _settling_samples;
+    LatencyStats _stats;
+
+    int16_t _samples[L3GD20Gyroscope::FIFO_SIZE][3];
+
+    void _on_edge();
+    void _on_timeout();
+    void _process_edge();
+    void _process_timeout();
+    void _wake();
+    void _settle();
+    void _start_capture();
+    void _capture();
+    void _enter_idle_mode();
+    void _enable_edge_interrupt();
+};
+}
+
+using l3gd20::DutyCycleScheduler;
+
+#endif // L3GD20_DUTY_CYCLE_H
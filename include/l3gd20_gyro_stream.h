@@ -0,0 +1,238 @@
+#ifndef L3GD20_GYRO_STREAM_H
+#define L3GD20_GYRO_STREAM_H
+
+#include "l3gd20_adaptive_rate.h"
+#include "l3gd20_driver.h"
+#include "l3gd20_timestamper.h"
+#include "mbed.h"
+#include "rtos.h"
+
+namespace l3gd20 {
+
+/**
+ * Acquisition engine, that is driven by the FIFO watermark interrupt.
+ *
+ * The stream owns a thread with an event queue. It:
+ *
+ * - configures FIFO stream mode with watermark interrupt on INT2;
+ * - records watermark interrupt times and posts a single processing event to its queue;
+ * - drains the FIFO with a burst read (samples and temperature in one transaction) in the thread context
+ *   with masked interrupt, and reads it again, if watermark has been reached while interrupt was masked;
+ * - timestamps samples with SampleTimestamper including lost samples of FIFO overruns;
+ * - invokes the block callback with all samples of each read, so the block is contiguous and
+ *   the callback is invoked once per watermark interrupt;
+ * - optionally, switches output data rate and watermark with AdaptiveRateController decisions
+ *   (see set_rate_controller()).
+ *
+ * Start and stop are race-free: the device configuration is executed by the stream thread, so it can't
+ * interleave with FIFO reading, and the caller waits for it. As the queue is FIFO, stop returns after
+ * the processing in progress and the posted events, so the callback isn't invoked after stop returns.
+ * Both methods can be invoked from any thread (but not from interrupt context), and stop can be invoked
+ * from the block callback.
+ *
+ * @note
+ * The device driver shouldn't be used by other threads while stream is running.
+ * The device output data rate, full scale and filters should be configured before start.
+ *
+ * Example:
+ *
+ * @code
+ * GyroStream stream(&gyroscope, PE_1, osPriorityHigh);
+ * stream.start(24, callback(on_block));
+ *
+ * void on_block(const GyroStream::Block &block)
+ * {
+ *     integrator.set_sample_rate(block.odr_hz);
+ *     integrator.update(block.samples, block.n_samples, sensitivity, bias);
+ * }
+ * @endcode
+ */
+class GyroStream : private NonCopyable<GyroStream> {
+public:
+    /**
+     * Contiguous block of samples.
+     */
+    struct Block {
+        int n_samples;
+        // raw samples in order: x, y, z
+        const int16_t (*samples)[3];
+        // sample timestamps in microseconds since start
+        const uint64_t *timestamps;
+        // raw temperature sensor value (see L3GD20Gyroscope::read_temperature_8())
+        int8_t temperature;
+        // estimated output data rate in Hz
+        float odr_hz;
+    };
+
+    /**
+     * Block callback.
+     *
+     * It's invoked from the stream thread. Block data is valid during callback invocation only.
+     */
+    typedef Callback<void(const Block &block)> block_callback_t;
+
+    /**
+     * Output data rate change.
+     */
+    struct RateChange {
+        L3GD20Gyroscope::OutputDataRate odr;
+        // FIFO watermark (block size) of the new rate
+        int watermark;
+        // estimated output data rate of the new rate in Hz (the nominal one with measured oscillator deviation)
+        float odr_hz;
+        // switch time in microseconds since start
+        uint64_t time_us;
+        // number of samples before the switch (index of the first sample of the new rate)
+        uint32_t sample_count;
+    };
+
+    /**
+     * Output data rate change callback.
+     *
+     * It's invoked from the stream thread after the last block of the previous rate and before the first block
+     * of the new one.
+     */
+    typedef Callback<void(const RateChange &change)> rate_change_callback_t;
+
+    /**
+     * Constructor.
+     *
+     * The thread is created by the first start() call.
+     *
+     * @param gyro device driver
+     * @param int2_pin pin that is connected to INT2 of the device
+     * @param priority stream thread priority
+     * @param stack_size stream thread stack size. The block callback is invoked with this stack.
+     * @param name stream thread name
+     */
+    GyroStream(L3GD20Gyroscope *gyro, PinName int2_pin, osPriority priority = osPriorityHigh,
+               uint32_t stack_size = OS_STACK_SIZE, const char *name = "l3gd20_stream");
+
+    /**
+     * Destructor. It stops the stream and its thread.
+     */
+    ~GyroStream();
+
+    /**
+     * Start acquisition.
+     *
+     * @param block_size FIFO watermark. It should be between 1 and 31. If rate controller is set,
+     *                   the watermark is selected by the controller.
+     * @param block_callback block callback
+     * @param odr_hz initial output data rate estimation (e.g. stored calibration) or 0 to use the nominal one
+     * @return 0 on success, otherwise non-zero error code:
+     *         - MBED_ERROR_CODE_INVALID_ARGUMENT - invalid block size or callback;
+     *         - MBED_ERROR_CODE_EBUSY - the stream is running;
+     *         - MBED_ERROR_CODE_INITIALIZATION_FAILED - the thread can't be started;
+     *         - MBED_ERROR_CODE_ENOMEM - the start event can't be posted to the stream thread.
+     */
+    int start(int block_size, const block_callback_t &block_callback, float odr_hz = 0.0f);
+
+    /**
+     * Set output data rate controller.
+     *
+     * When the stream is started, the controller rate is reset to the current device rate, if it's the controller
+     * low rate, otherwise the high rate is selected. Each block is processed by the controller, and when the rate
+     * should be changed, the stream:
+     *
+     * 1. masks the watermark interrupt and changes output data rate;
+     * 2. drains FIFO and delivers the remaining samples of the previous rate as a block
+     *    (the first sample of the new rate is produced a sample period later, so the rates aren't mixed);
+     * 3. sets FIFO watermark of the new rate and continues timestamps with the new rate
+     *    (see SampleTimestamper::switch_odr());
+     * 4. invokes the rate change callback.
+     *
+     * The controller shouldn't be used by other threads while stream is running.
+     *
+     * @param controller controller or NULL to disable rate changes
+     * @param rate_change_callback optional rate change callback
+     * @return 0 on success, otherwise non-zero error code:
+     *         - MBED_ERROR_CODE_EBUSY - the stream is running.
+     */
+    int set_rate_controller(AdaptiveRateController *controller, const rate_change_callback_t &rate_change_callback = nullptr);
+
+    /**
+     * Stop acquisition.
+     *
+     * When it's invoked from other thread, it waits for the processing in progress, so the callback
+     * isn't invoked after return. The FIFO watermark interrupt is disabled.
+     */
+    void stop();
+
+    /**
+     * Check if the stream is running.
+     *
+     * @return
+     */
+    bool is_running();
+
+    /**
+     * Get number of delivered blocks since start.
+     *
+     * @return
+     */
+    uint32_t get_block_count();
+
+    /**
+     * Get number of samples, that are lost due FIFO overruns since start (see SampleTimestamper::get_lost_sample_count()).
+     *
+     * @return
+     */
+    uint32_t get_lost_sample_count();
+
+    /**
+     * Get number of output data rate changes since start.
+     *
+     * @return
+     */
+    uint32_t get_rate_change_count();
+
+    /**
+     * Get stream thread.
+     *
+     * @return
+     */
+    Thread *get_thread();
+
+private:
+    L3GD20Gyroscope *_gyro;
+    InterruptIn _int2;
+    EventQueue _queue;
+    Thread _thread;
+    bool _thread_started;
+    Event<void()> _process_event;
+    // serializes start and stop
+    Mutex _mutex;
+
+    Timer _timer;
+    SampleTimestamper _timestamper;
+    block_callback_t _callback;
+    int _block_size;
+    float _initial_odr_hz;
+    volatile bool _running;
+    volatile bool _edge_pending;
+    volatile bool _event_posted;
+    volatile uint64_t _edge_time_us;
+    uint32_t _block_count;
+
+    AdaptiveRateController *_controller;
+    rate_change_callback_t _rate_change_callback;
+    float _sensitivity;
+    uint32_t _rate_change_count;
+
+    int16_t _samples[L3GD20Gyroscope::FIFO_SIZE][3];
+    uint64_t _timestamps[L3GD20Gyroscope::FIFO_SIZE];
+
+    void _on_interrupt();
+    void _process();
+    void _deliver_block(int n, int8_t temperature);
+    void _change_rate();
+    void _start_acquisition();
+    void _stop_acquisition();
+    int _invoke_in_thread(void (GyroStream::*method)());
+};
+}
+
+using l3gd20::GyroStream;
+
+#endif // L3GD20_GYRO_STREAM_H
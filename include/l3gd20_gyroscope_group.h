@@ -0,0 +1,204 @@
+#ifndef L3GD20_GYROSCOPE_GROUP_H
+#define L3GD20_GYROSCOPE_GROUP_H
+
+#include "l3gd20_driver.h"
+#include "l3gd20_timestamper.h"
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Group of gyroscopes on a shared SPI bus with synchronized start and time-aligned blocks.
+ *
+ * The group owns drivers of several L3GD20 devices, that share one SPI interface and have separate
+ * ssel and INT2 pins. It:
+ *
+ * - configures FIFO stream mode with watermark interrupt for all devices and powers them on back to back
+ *   with locked SPI, so their sample phases are aligned within a few register writes;
+ * - records watermark interrupt times and posts a single processing event to the event queue,
+ *   that reads all pending devices in a batch with locked SPI (SPI::lock), so other SPI users
+ *   can't interleave with the transfers;
+ * - timestamps samples of each device with SampleTimestamper;
+ * - delivers blocks with the same number of samples of all devices. As internal oscillators of the devices
+ *   are independent, a sample of a faster device is dropped, when its sample times are ahead of the first
+ *   device by more than a half of the sample period (plus 1/8 period hysteresis against timestamp jitter),
+ *   so the first sample times of a block differ from the first device by less than 5/8 of the sample period.
+ *   The next samples of the block diverge with oscillator mismatch (e.g. 0.32 period for 16 samples
+ *   and 2% mismatch), so the per device timestamps should be used, if exact sample times are required.
+ *
+ * Devices with watermark interrupts, that are pending when the processing event is dispatched,
+ * are read in the same batch. As the oscillators drift, their interrupts become distributed over the block
+ * period, so a batch usually contains a single device, but other SPI users never interleave with the reading.
+ *
+ * @note
+ * The device drivers shouldn't be used while group is running.
+ *
+ * Example:
+ *
+ * @code
+ * SPI spi(PA_7, PA_6, PA_5);
+ * GyroscopeGroup group(&spi, &queue);
+ * group.add_gyroscope(PE_3, PE_1);
+ * group.add_gyroscope(PE_4, PE_2);
+ * group.init();
+ * group.start(16, callback(on_block));
+ *
+ * void on_block(const GyroscopeGroup::Block &block)
+ * {
+ *     for (int i = 0; i < block.n_gyroscopes; i++) {
+ *         process(i, block.samples[i], block.timestamps[i], block.n_samples);
+ *     }
+ * }
+ * @endcode
+ */
+class GyroscopeGroup : private NonCopyable<GyroscopeGroup> {
+public:
+    /**
+     * Maximal number of devices in a group.
+     */
+    static const int MAX_GYROSCOPES = 4;
+
+    /**
+     * Capacity of the per device buffer, that collects samples for aligned blocks.
+     */
+    static const int STAGING_SIZE = 2 * L3GD20Gyroscope::FIFO_SIZE;
+
+    /**
+     * Time-aligned block.
+     */
+    struct Block {
+        int n_gyroscopes;
+        int n_samples;
+        // raw samples of each device in order: x, y, z
+        const int16_t (*samples[MAX_GYROSCOPES])[3];
+        // sample timestamps of each device in microseconds since start
+        const uint64_t *timestamps[MAX_GYROSCOPES];
+    };
+
+    /**
+     * Block callback.
+     *
+     * It's invoked from the event queue context. Block data is valid during callback invocation only.
+     */
+    typedef Callback<void(const Block &block)> block_callback_t;
+
+    /**
+     * Constructor.
+     *
+     * @param spi_ptr shared SPI interface
+     * @param queue event queue, that is used for FIFO reading and blocks delivering
+     */
+    GyroscopeGroup(SPI *spi_ptr, EventQueue *queue);
+
+    /**
+     * Destructor.
+     *
+     * If the group is running, it should be invoked from the event queue thread like stop().
+     */
+    ~GyroscopeGroup();
+
+    /**
+     * Add device.
+     *
+     * @param ssel SPI ssel pin of the device
+     * @param int2_pin pin that is connected to INT2 of the device
+     * @return 0 on success, otherwise non-zero error code.
+     */
+    int add_gyroscope(PinName ssel, PinName int2_pin);
+
+    /**
+     * Get number of devices.
+     *
+     * @return
+     */
+    int get_gyroscope_count();
+
+    /**
+     * Get device driver to adjust its configuration before start.
+     *
+     * @param index device index in order of addition
+     * @return driver or NULL, if index is invalid
+     */
+    L3GD20Gyroscope *get_gyroscope(int index);
+
+    /**
+     * Initialize all devices.
+     *
+     * @return 0 on success, otherwise non-zero error code of the first failed device.
+     */
+    int init();
+
+    /**
+     * Start synchronized acquisition.
+     *
+     * All devices should have the same output data rate.
+     *
+     * @param block_size number of samples in a block (FIFO watermark). It should be between 1 and 31.
+     * @param block_callback block callback
+     * @return 0 on success, otherwise non-zero error code.
+     */
+    int start(int block_size, const block_callback_t &block_callback);
+
+    /**
+     * Stop acquisition.
+     *
+     * The method should be invoked from the event queue thread (e.g. from the block callback or with EventQueue::call),
+     * so the processing event isn't running concurrently. The pending processing event is canceled, so the block
+     * callback isn't invoked and the group can be destroyed after return.
+     */
+    void stop();
+
+    /**
+     * Get number of delivered blocks since start.
+     *
+     * @return
+     */
+    uint32_t get_block_count();
+
+    /**
+     * Get number of samples, that are dropped for alignment or due staging buffer overflow, since start.
+     *
+     * @return
+     */
+    uint32_t get_dropped_sample_count();
+
+    /**
+     * Get number of processing batches (locked SPI intervals) since start.
+     *
+     * @return
+     */
+    uint32_t get_batch_count();
+
+private:
+    class Channel;
+
+    SPI *_spi_ptr;
+    Event<void()> _process_event;
+    Channel *_channels[MAX_GYROSCOPES];
+    int _n_channels;
+
+    Timer _timer;
+    block_callback_t _callback;
+    int _block_size;
+    volatile bool _running;
+    // bit mask of the devices with pending watermark interrupts
+    volatile uint32_t _pending_mask;
+    // bit mask of the devices, whose FIFO has reached the watermark again during processing without a new edge
+    volatile uint32_t _missed_edge_mask;
+    volatile bool _event_posted;
+    // thread, that dispatches processing events
+    osThreadId_t _queue_thread_id;
+
+    uint32_t _block_count;
+    uint32_t _dropped_sample_count;
+    uint32_t _batch_count;
+
+    void _on_interrupt(Channel *channel);
+    void _process();
+    void _deliver_blocks();
+};
+}
+
+using l3gd20::GyroscopeGroup;
+
+#endif // L3GD20_GYROSCOPE_GROUP_H
@@ -0,0 +1,224 @@
+#ifndef L3GD20_INTEGRATOR_H
+#define L3GD20_INTEGRATOR_H
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Angular rate integrator.
+ *
+ * It integrates blocks of angular rates in rad/s (see L3GD20Gyroscope::convert_data) into
+ * orientation quaternion `[w, x, y, z]`.
+ *
+ * Each sample rotates quaternion by rotation quaternion `[cos(|v|), sin(|v|) * v / |v|]`, where `v = w * dt / 2`
+ * and `w` is angular rate in the body frame. As rotation angles of the samples are small, sine and cosine
+ * are calculated with 4th order polynomials of `|v|^2`, so neither square root nor trigonometric function
+ * is needed per sample. Quaternion is normalized once per block.
+ *
+ * Optionally, samples are integrated in groups of 2, 3 or 4 samples with coning compensation
+ * (see OrientationIntegrator::ConingMode). In this case the rotation vector of a group is calculated
+ * from sample rotations `w * dt` and their cross products, and the quaternion is rotated once per group.
+ * It reduces number of quaternion products and the error of non-commutative rotations under vibration.
+ *
+ * Example:
+ *
+ * @code
+ * OrientationIntegrator integrator(gyroscope.get_output_data_rate_hz());
+ * int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+ * float rates[L3GD20Gyroscope::FIFO_SIZE][3];
+ * float q[4];
+ *
+ * int n = gyroscope.read_fifo(samples);
+ * gyroscope.convert_data(samples, rates, n);
+ * integrator.update(rates, n);
+ * integrator.get_quaternion(q);
+ * @endcode
+ */
+class OrientationIntegrator {
+public:
+    /**
+     * Coning compensation mode.
+     *
+     * The values are number of samples in a group. The coning correction terms are the ones of
+     * the multi-sample algorithms for angular increments (Ignagni), where increments are `w * dt`.
+     */
+    enum ConingMode {
+        CONING_DISABLE = 1,
+        CONING_2_SAMPLE = 2,
+        CONING_3_SAMPLE = 3,
+        CONING_4_SAMPLE = 4
+    };
+
+    /**
+     * Constructor.
+     *
+     * The orientation is set to identity quaternion.
+     *
+     * @param sample_rate_hz sample rate (see L3GD20Gyroscope::get_output_data_rate_hz())
+     */
+    OrientationIntegrator(float sample_rate_hz);
+
+    /**
+     * Set sample rate.
+     *
+     * @param sample_rate_hz sample rate (see L3GD20Gyroscope::get_output_data_rate_hz() and SampleTimestamper::get_odr_hz())
+     */
+    void set_sample_rate(float sample_rate_hz);
+
+    /**
+     * Set coning compensation mode.
+     *
+     * If block size isn't multiple of the group size, the remaining samples of the block
+     * are integrated as a smaller group. So the block size should be multiple of the group size
+     * (for example, FIFO watermark 24 is multiple of 2, 3 and 4).
+     *
+     * @param mode
+     */
+    void set_coning_mode(ConingMode mode);
+
+    /**
+     * Get coning compensation mode.
+     *
+     * @return
+     */
+    ConingMode get_coning_mode();
+
+    /**
+     * Reset orientation to identity quaternion.
+     */
+    void reset();
+
+    /**
+     * Integrate block of angular rates and normalize the orientation quaternion.
+     *
+     * @param rates angular rates in rad/s in order: x, y, z
+     * @param n number of samples
+     */
+    void update(const float (*rates)[3], int n);
+
+    /**
+     * Integrate block of raw samples (e.g. L3GD20Gyroscope::read_fifo output) and normalize the orientation quaternion.
+     *
+     * @param samples raw samples in order: x, y, z
+     * @param n number of samples
+     * @param sensitivity sensitivity in rad/s per LSB (see L3GD20Gyroscope::get_sensitivity())
+     * @param bias optional rate bias in rad/s, that is subtracted from samples
+     */
+    void update(const int16_t (*samples)[3], int n, float sensitivity, const float bias[3] = NULL);
+
+    /**
+     * Get orientation quaternion.
+     *
+     * @param q quaternion in order: w, x, y, z
+     */
+    void get_quaternion(float q[4]);
+
+    /**
+     * Set orientation quaternion.
+     *
+     * @param q normalized quaternion in order: w, x, y, z
+     */
+    void set_quaternion(const float q[4]);
+
+private:
+    // sample period in seconds
+    float _dt;
+    ConingMode _coning_mode;
+    float _q[4];
+
+    void _normalize();
+};
+
+/**
+ * Fixed-point angular rate integrator for targets without FPU.
+ *
+ * It integrates angular rates in rad/s in Q16.16 format (see L3GD20Gyroscope::convert_data_q16)
+ * into orientation quaternion `[w, x, y, z]` in Q2.30 format (1.0 is 2^30). Only integer
+ * operations are used: 32x32 bit multiplications with 64 bit results and shifts.
+ *
+ * Each sample rotates quaternion by small angle quaternion `[1 - |v|^2 / 2, v]`, where `v = w * dt / 2`
+ * and `w` is angular rate in the body frame. Quaternion is normalized once per block with a first order
+ * correction `q * (3 - |q|^2) / 2`, so neither square root nor division is needed.
+ *
+ * Example:
+ *
+ * @code
+ * FixedOrientationIntegrator integrator(gyroscope.get_output_data_rate_hz());
+ * int16_t samples[L3GD20Gyroscope::FIFO_SIZE][3];
+ * int32_t rates[L3GD20Gyroscope::FIFO_SIZE][3];
+ * int32_t q[4];
+ *
+ * int n = gyroscope.read_fifo(samples);
+ * gyroscope.convert_data_q16(samples, rates, n);
+ * integrator.update(rates, n);
+ * integrator.get_quaternion(q);
+ * @endcode
+ */
+class FixedOrientationIntegrator {
+public:
+    /**
+     * Number of fractional bits of the quaternion components.
+     */
+    static const int QUATERNION_FRAC_BITS = 30;
+
+    /**
+     * Fixed-point representation of 1.0 for quaternion components.
+     */
+    static const int32_t QUATERNION_ONE = (int32_t)1 << QUATERNION_FRAC_BITS;
+
+    /**
+     * Constructor.
+     *
+     * The orientation is set to identity quaternion.
+     *
+     * @param sample_rate_hz sample rate (see L3GD20Gyroscope::get_output_data_rate_hz())
+     */
+    FixedOrientationIntegrator(float sample_rate_hz);
+
+    /**
+     * Set sample rate.
+     *
+     * @param sample_rate_hz sample rate (see L3GD20Gyroscope::get_output_data_rate_hz())
+     */
+    void set_sample_rate(float sample_rate_hz);
+
+    /**
+     * Reset orientation to identity quaternion.
+     */
+    void reset();
+
+    /**
+     * Integrate block of angular rates and normalize the orientation quaternion.
+     *
+     * @param rates angular rates in rad/s in Q16.16 format in order: x, y, z
+     * @param n number of samples
+     */
+    void update(const int32_t (*rates)[3], int n);
+
+    /**
+     * Get orientation quaternion.
+     *
+     * @param q quaternion in order: w, x, y, z in Q2.30 format
+     */
+    void get_quaternion(int32_t q[4]);
+
+    /**
+     * Set orientation quaternion.
+     *
+     * @param q normalized quaternion in order: w, x, y, z in Q2.30 format
+     */
+    void set_quaternion(const int32_t q[4]);
+
+private:
+    // half of the sample period in seconds in Q1.31 format
+    int32_t _half_dt;
+    int32_t _q[4];
+
+    void _normalize();
+};
+}
+
+using l3gd20::FixedOrientationIntegrator;
+using l3gd20::OrientationIntegrator;
+
+#endif // L3GD20_INTEGRATOR_H
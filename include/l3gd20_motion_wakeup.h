@@ -0,0 +1,135 @@
+#ifndef L3GD20_MOTION_WAKEUP_H
+#define L3GD20_MOTION_WAKEUP_H
+
+#include "l3gd20_driver.h"
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Wake-on-motion helper, that lets the MCU sleep while the device is stationary.
+ *
+ * sleep() stores the streaming configuration and switches the device into the waiting state:
+ *
+ * - FIFO and data ready interrupt are disabled, so there are no FIFO reads and no SPI/I2C traffic;
+ * - output data rate is reduced to the sleep one (the duration of the motion interrupt is counted in its samples);
+ * - INT1 angular rate threshold interrupt is configured with latched request, so the pin keeps its level until
+ *   the source is read.
+ *
+ * The helper doesn't use timers or events while waiting, so the MCU can enter deep sleep, if the INT1 pin
+ * can wake it up (e.g. EXTI lines of STM32). The INT1 rising edge posts an event to the event queue,
+ * that reads and clears the interrupt source, disables INT1, restores the streaming configuration and invokes
+ * the wakeup callback. The callback usually starts full rate acquisition (e.g. GyroStream::start()).
+ *
+ * @note
+ * The device driver shouldn't be used by other code while helper is sleeping.
+ * The device pin INT1 is push-pull active high after init(), that is expected by the helper.
+ *
+ * Example:
+ *
+ * @code
+ * MotionWakeup wakeup(&gyroscope, PE_0);
+ * GyroStream stream(&gyroscope, PE_1);
+ *
+ * void go_to_sleep()
+ * {
+ *     stream.stop();
+ *     L3GD20Gyroscope::MotionInterruptConfig config;
+ *     config.events = L3GD20Gyroscope::MOTION_ANY_HIGH;
+ *     config.threshold[0] = config.threshold[1] = config.threshold[2] = gyroscope.get_motion_threshold(5.0f);
+ *     config.duration = 2;
+ *     wakeup.sleep(config, callback(on_wakeup));
+ * }
+ *
+ * void on_wakeup(uint8_t source)
+ * {
+ *     stream.start(24, callback(on_block));
+ * }
+ * @endcode
+ */
+class MotionWakeup : private NonCopyable<MotionWakeup> {
+public:
+    /**
+     * Wakeup callback.
+     *
+     * It's invoked from the event queue context with INT1_SRC value (see L3GD20Gyroscope::MotionEvent).
+     */
+    typedef Callback<void(uint8_t source)> wakeup_callback_t;
+
+    /**
+     * Constructor.
+     *
+     * @param gyro device driver
+     * @param int1_pin pin that is connected to INT1 of the device
+     * @param queue event queue, that is used for wakeup processing
+     */
+    MotionWakeup(L3GD20Gyroscope *gyro, PinName int1_pin, EventQueue *queue = mbed_event_queue());
+
+    /**
+     * Destructor. It cancels waiting.
+     */
+    ~MotionWakeup();
+
+    /**
+     * Wait for motion.
+     *
+     * @param config motion interrupt configuration. Request latching is always enabled.
+     * @param wakeup_callback callback, that is invoked after the streaming configuration restoring
+     * @param sleep_odr output data rate while waiting
+     * @return 0 on success, otherwise non-zero error code:
+     *         - MBED_ERROR_CODE_INVALID_ARGUMENT - no events are enabled or callback isn't set;
+     *         - MBED_ERROR_CODE_EBUSY - the helper is already sleeping.
+     */
+    int sleep(const L3GD20Gyroscope::MotionInterruptConfig &config, const wakeup_callback_t &wakeup_callback,
+              L3GD20Gyroscope::OutputDataRate sleep_odr = L3GD20Gyroscope::ODR_95_HZ);
+
+    /**
+     * Cancel waiting and restore the streaming configuration without callback invocation.
+     */
+    void cancel();
+
+    /**
+     * Check if the helper waits for motion.
+     *
+     * @return
+     */
+    bool is_sleeping();
+
+    /**
+     * Get number of wakeups.
+     *
+     * @return
+     */
+    uint32_t get_wakeup_count();
+
+    /**
+     * Get INT1_SRC value of the last wakeup.
+     *
+     * @return
+     */
+    uint8_t get_wakeup_source();
+
+private:
+    L3GD20Gyroscope *_gyro;
+    InterruptIn _int1;
+    Event<void()> _wakeup_event;
+
+    wakeup_callback_t _callback;
+    volatile bool _sleeping;
+    uint32_t _wakeup_count;
+    uint8_t _wakeup_source;
+
+    // streaming configuration
+    L3GD20Gyroscope::OutputDataRate _odr;
+    L3GD20Gyroscope::FIFOMode _fifo_mode;
+    L3GD20Gyroscope::DataReadyInterruptMode _drdy_mode;
+
+    void _on_interrupt();
+    void _wakeup();
+    bool _leave_sleep();
+};
+}
+
+using l3gd20::MotionWakeup;
+
+#endif // L3GD20_MOTION_WAKEUP_H
@@ -0,0 +1,234 @@
+#ifndef L3GD20_SAMPLE_RING_H
+#define L3GD20_SAMPLE_RING_H
+#include "mbed.h"
+#include <atomic>
+
+namespace l3gd20 {
+
+/**
+ * Gyroscope sample with timestamp.
+ */
+struct TimestampedSample {
+    // sample time in microseconds
+    uint64_t timestamp_us;
+    // raw sample in order: x, y, z
+    int16_t data[3];
+};
+
+/**
+ * Lock-free single producer ring buffer with multiple independent consumers.
+ *
+ * The producer (e.g. FIFO reading code in an ISR or high priority thread) never waits and never fails:
+ * new items overwrite the oldest ones. Each consumer reads the ring with its own SampleRing::Reader cursor,
+ * so several consumers (e.g. logger, sensor fusion and telemetry) see the same stream. If a consumer
+ * falls behind by N - 1 or more items, the overwritten items are skipped and reported as lost.
+ *
+ * The producer path contains no locks, no critical sections and doesn't depend on number of consumers.
+ * Readers validate copied items against the producer position after copying, so they never
+ * return partially overwritten items.
+ *
+ * The memory is allocated statically. \p T should be trivially copyable type (e.g. TimestampedSample
+ * or a structure with block of samples), and \p N should be a power of two.
+ *
+ * Example:
+ *
+ * @code
+ * SampleRing<64> ring;
+ *
+ * // producer
+ * TimestampedSample sample;
+ * ring.push(sample);
+ *
+ * // consumer
+ * SampleRing<64>::Reader reader(&ring);
+ * TimestampedSample samples[16];
+ * uint32_t lost;
+ * int n = reader.read(samples, 16, &lost);
+ * @endcode
+ */
+template <size_t N, typename T = TimestampedSample>
+class SampleRing : private NonCopyable<SampleRing<N, T> > {
+public:
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SampleRing size should be a power of two");
+
+    /**
+     * Ring buffer consumer cursor.
+     *
+     * A reader should be used by one consumer thread only. A new reader starts from
+     * the current producer position, so it gets items that are pushed after its creation.
+     */
+    class Reader : private NonCopyable<Reader> {
+    public:
+        /**
+         * Constructor.
+         *
+         * @param ring ring buffer. It should exist during reader lifetime.
+         */
+        Reader(SampleRing *ring)
+            : _ring(ring)
+            , _read_index(ring->get_write_index())
+            , _lost_count(0)
+        {
+        }
+
+        /**
+         * Get number of items that can be read.
+         *
+         * @return number of items, including items that will be reported as lost if the reader is overrun
+         */
+        uint32_t available()
+        {
+            return _ring->get_write_index() - _read_index;
+        }
+
+        /**
+         * Read pending items.
+         *
+         * @param items buffer for items
+         * @param max_items buffer size
+         * @param lost optional pointer to store number of items that have been overwritten and skipped
+         * @return number of read items
+         */
+        int read(T *items, int max_items, uint32_t *lost = NULL)
+        {
+            uint32_t lost_items = 0;
+            int n = 0;
+
+            while (n == 0 && max_items > 0) {
+                uint32_t write_index = _ring->get_write_index();
+                uint32_t pending = write_index - _read_index;
+                if (pending >= N) {
+                    // overrun: skip items that can be overwritten
+                    lost_items += pending - (N - 1);
+                    _read_index = write_index - (N - 1);
+                    pending = N - 1;
+                }
+                if (pending == 0) {
+                    break;
+                }
+                n = pending < (uint32_t)max_items ? (int)pending : max_items;
+                for (int i = 0; i < n; i++) {
+                    items[i] = _ring->_items[(_read_index + i) & (N - 1)];
+                }
+
+                // check that producer hasn't overwritten copied items
+                // note: the fence prevents reordering of the items copying after index loading
+                std::atomic_thread_fence(std::memory_order_acquire);
+                write_index = _ring->get_write_index();
+                uint32_t oldest_valid_index = write_index - (N - 1);
+                int32_t invalid = (int32_t)(oldest_valid_index - _read_index);
+                if (invalid > 0) {
+                    if (invalid >= n) {
+                        // all items are overwritten, so try again
+                        lost_items += n;
+                        _read_index += n;
+                        n = 0;
+                        continue;
+                    }
+                    memmove(items, items + invalid, (n - invalid) * sizeof(T));
+                    lost_items += invalid;
+                    _read_index += invalid;
+                    n -= invalid;
+                }
+                _read_index += n;
+            }
+
+            _lost_count += lost_items;
+            if (lost) {
+                *lost = lost_items;
+            }
+            return n;
+        }
+
+        /**
+         * Skip all pending items.
+         */
+        void skip()
+        {
+            _read_index = _ring->get_write_index();
+        }
+
+        /**
+         * Get total number of lost items of this reader.
+         */
+        uint32_t get_lost_count()
+        {
+            return _lost_count;
+        }
+
+    private:
+        SampleRing *_ring;
+        uint32_t _read_index;
+        uint32_t _lost_count;
+    };
+
+    SampleRing()
+        : _items()
+        , _write_index(0)
+    {
+    }
+
+    /**
+     * Get ring size.
+     *
+     * Readers can lag behind the producer by up to `N - 1` items.
+     */
+    static size_t size()
+    {
+        return N;
+    }
+
+    /**
+     * Add item.
+     *
+     * It should be called from a single producer context. It's safe to call it from ISR.
+     *
+     * @param item
+     */
+    void push(const T &item)
+    {
+        uint32_t write_index = _write_index.load(std::memory_order_relaxed);
+        // note: the fence prevents reordering of the slot writing before the previous publication,
+        // so readers detect overwritten items by write index
+        std::atomic_thread_fence(std::memory_order_release);
+        _items[write_index & (N - 1)] = item;
+        // publish item
+        _write_index.store(write_index + 1, std::memory_order_release);
+    }
+
+    /**
+     * Add several items.
+     *
+     * It should be called from a single producer context. It's safe to call it from ISR.
+     *
+     * @note items are published one by one, so readers can detect overwritten items
+     *       by write index only.
+     *
+     * @param items
+     * @param n number of items
+     */
+    void push(const T *items, int n)
+    {
+        for (int i = 0; i < n; i++) {
+            push(items[i]);
+        }
+    }
+
+    /**
+     * Get total number of pushed items (modulo 2^32).
+     */
+    uint32_t get_write_index()
+    {
+        return _write_index.load(std::memory_order_acquire);
+    }
+
+private:
+    T _items[N];
+    std::atomic<uint32_t> _write_index;
+};
+}
+
+using l3gd20::SampleRing;
+using l3gd20::TimestampedSample;
+
+#endif // L3GD20_SAMPLE_RING_H
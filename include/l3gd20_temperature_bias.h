@@ -0,0 +1,114 @@
+#ifndef L3GD20_TEMPERATURE_BIAS_H
+#define L3GD20_TEMPERATURE_BIAS_H
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Temperature dependency model of the gyroscope zero-rate level (bias).
+ *
+ * The zero-rate level of the L3GD20 drifts with temperature (up to 0.03-0.04 dps/°C), so a bias,
+ * that is estimated at one temperature, becomes invalid when the device warms up. The model keeps
+ * a table of bias observations indexed by raw temperature sensor value (see L3GD20Gyroscope::read_temperature_8()).
+ * Each table bin covers `BIN_WIDTH` sensor LSBs and stores running average of the observed biases
+ * and of their temperatures, so the model is learned incrementally from stationary windows
+ * (see BiasEstimator::get_window_mean()) without calibration in a climate chamber.
+ *
+ * The bias at arbitrary temperature is linearly interpolated between the nearest learned bins.
+ * Outside of the learned range the bias of the nearest learned bin is used. The last lookup result is cached,
+ * as the temperature changes slowly, so per block lookup usually costs a single comparison.
+ *
+ * Example:
+ *
+ * @code
+ * int8_t temperature;
+ * int n = gyroscope.read_fifo(samples, &temperature);
+ * if (bias_estimator.update(samples, n, gyroscope.get_sensitivity())) {
+ *     bias_estimator.get_window_mean(window_mean);
+ *     bias_model.learn(temperature, window_mean);
+ * }
+ * if (!bias_model.get_bias(temperature, bias)) {
+ *     bias_estimator.get_bias(bias);
+ * }
+ * integrator.update(samples, n, gyroscope.get_sensitivity(), bias);
+ * @endcode
+ */
+class TemperatureBiasModel {
+public:
+    /**
+     * Width of the table bin in temperature sensor LSBs (degrees Celsius).
+     */
+    static const int BIN_WIDTH = 4;
+
+    /**
+     * Number of table bins, that cover the whole temperature sensor range.
+     */
+    static const int BIN_COUNT = 256 / BIN_WIDTH;
+
+    /**
+     * Number of observations, that are averaged by a bin in the steady state.
+     */
+    static const int AVERAGING_WINDOWS = 16;
+
+    TemperatureBiasModel();
+
+    /**
+     * Drop all learned data.
+     */
+    void reset();
+
+    /**
+     * Add bias observation.
+     *
+     * @param temperature raw temperature sensor value
+     * @param bias bias in rad/s in order: x, y, z
+     */
+    void learn(int8_t temperature, const float bias[3]);
+
+    /**
+     * Get bias at the specified temperature.
+     *
+     * @param temperature raw temperature sensor value
+     * @param bias bias in rad/s in order: x, y, z. It isn't modified if the model is empty.
+     * @return true on success, false if the model has no data yet
+     */
+    bool get_bias(int8_t temperature, float bias[3]);
+
+    /**
+     * Get number of table bins with data.
+     *
+     * @return
+     */
+    int get_learned_bin_count();
+
+    /**
+     * Get learned temperature range.
+     *
+     * @param min_temperature minimal raw temperature sensor value of the observations
+     * @param max_temperature maximal raw temperature sensor value of the observations
+     * @return true on success, false if the model has no data yet
+     */
+    bool get_temperature_range(int8_t *min_temperature, int8_t *max_temperature);
+
+private:
+    // mean bias and mean temperature of the bin observations
+    float _bias[BIN_COUNT][3];
+    float _temperature[BIN_COUNT];
+    // number of observations in the bin average (0 for an empty bin)
+    uint8_t _weight[BIN_COUNT];
+    int _learned_bin_count;
+    int8_t _min_temperature;
+    int8_t _max_temperature;
+
+    // last lookup result
+    bool _cache_valid;
+    int8_t _cache_temperature;
+    float _cache_bias[3];
+
+    void _interpolate(int8_t temperature, float bias[3]);
+};
+}
+
+using l3gd20::TemperatureBiasModel;
+
+#endif // L3GD20_TEMPERATURE_BIAS_H
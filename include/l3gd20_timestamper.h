@@ -0,0 +1,166 @@
+#ifndef L3GD20_TIMESTAMPER_H
+#define L3GD20_TIMESTAMPER_H
+#include "mbed.h"
+
+namespace l3gd20 {
+
+/**
+ * Helper class to reconstruct sample timestamps and to measure actual output data rate.
+ *
+ * The L3GD20 samples have no timestamps, and the actual output data rate of the internal oscillator
+ * can deviate from the nominal one by several percents. The timestamper counts samples of the consecutive
+ * FIFO blocks and uses the interrupt edge times as observations of the sample times:
+ *
+ * - for FIFO watermark interrupt, the edge occurs when the FIFO level reaches watermark,
+ *   so the sample number `watermark` of the next block is produced at edge time;
+ * - for data ready interrupt (FIFO bypass mode), the first sample of the next block is produced at edge time.
+ *
+ * Sample time is modeled by a line `t(k) = t0 + k * T`, where `k` is sample index and `T` is sample period.
+ * The line is tracked with an alpha-beta filter, whose gains start from least squares fit values and decrease
+ * to the values of the `filter_length` observations window, so interrupt latency jitter is averaged,
+ * but oscillator drift is still tracked. Each update requires a few floating point operations only.
+ *
+ * If an edge time deviates from the prediction by more than a half of the sample period (for example,
+ * due missed interrupt), the tracking is restarted from this edge. But if FIFO overrun is reported for
+ * the previous block, the deviation is counted as a whole number of lost samples (see get_lost_sample_count()),
+ * so the tracking continues and CPU side losses can be distinguished from the sensor timing jitter.
+ *
+ * Example:
+ *
+ * @code
+ * // ISR
+ * edge_time_us = timer.elapsed_time().count();
+ *
+ * // block processing
+ * uint64_t timestamps[L3GD20Gyroscope::FIFO_SIZE];
+ * int n = gyroscope.read_fifo(samples);
+ * timestamper.update(edge_time_us, watermark, n, timestamps, gyroscope.get_last_fifo_status().overrun);
+ * @endcode
+ */
+class SampleTimestamper {
+public:
+    /**
+     * Constructor.
+     *
+     * @param nominal_odr_hz nominal output data rate (see L3GD20Gyroscope::get_output_data_rate_hz())
+     * @param filter_length number of edge observations, that are averaged in the steady state
+     */
+    SampleTimestamper(float nominal_odr_hz, int filter_length = 64);
+
+    /**
+     * Reset sample counter and set nominal output data rate.
+     *
+     * It should be invoked if FIFO is cleared or output data rate is changed.
+     *
+     * @param nominal_odr_hz nominal output data rate
+     */
+    void reset(float nominal_odr_hz);
+
+    /**
+     * Change nominal output data rate without timestamps discontinuity.
+     *
+     * It should be invoked after FIFO draining, when the device output data rate is changed.
+     * The sample counter and the lost samples are kept, and the measured oscillator deviation
+     * is applied to the new sample period, as the rates are derived from the same oscillator.
+     * The line is restarted with the next edge, so the sample time offset of the new rate
+     * doesn't affect the estimated period, but the filter gains are kept.
+     *
+     * @param nominal_odr_hz new nominal output data rate
+     */
+    void switch_odr(float nominal_odr_hz);
+
+    /**
+     * Timestamp block of samples, whose reading is triggered by interrupt edge.
+     *
+     * @param edge_time_us interrupt edge time in microseconds
+     * @param edge_level number of samples of this block, that have been in FIFO at the edge time
+     *                   (FIFO watermark for watermark interrupt or 1 for data ready interrupt)
+     * @param n number of samples in the block (e.g. result of the L3GD20Gyroscope::read_fifo)
+     * @param timestamps buffer for \p n sample timestamps in microseconds. It can be NULL.
+     * @param overrun FIFO overrun is found at block reading (see L3GD20Gyroscope::get_last_fifo_status()).
+     *                The oldest samples of the block can be overwritten, so their number is estimated with the next edge.
+     *                The timestamps of this block don't include the lost samples.
+     */
+    void update(uint64_t edge_time_us, int edge_level, int n, uint64_t *timestamps, bool overrun = false);
+
+    /**
+     * Timestamp block of samples without interrupt edge.
+     *
+     * Timestamps are extrapolated with the current estimation.
+     *
+     * @param n number of samples in the block
+     * @param timestamps buffer for \p n sample timestamps in microseconds. It can be NULL.
+     */
+    void update(int n, uint64_t *timestamps);
+
+    /**
+     * Set initial output data rate estimation (e.g. stored calibration).
+     *
+     * It's used until the first interrupt edges are observed, and then it's refined by the edges.
+     * The value is limited to 20% deviation from the nominal output data rate.
+     *
+     * @param odr_hz output data rate in Hz
+     */
+    void set_odr_hz(float odr_hz);
+
+    /**
+     * Get estimated output data rate.
+     *
+     * @return output data rate in Hz
+     */
+    float get_odr_hz();
+
+    /**
+     * Get estimated sample period.
+     *
+     * @return sample period in microseconds
+     */
+    float get_sample_period_us();
+
+    /**
+     * Get number of timestamped samples since reset.
+     */
+    uint32_t get_sample_count();
+
+    /**
+     * Get number of tracking restarts due inconsistent edge times.
+     */
+    int get_resync_count();
+
+    /**
+     * Get number of samples, that are lost due FIFO overruns since reset.
+     *
+     * Samples lost after the last edge are counted with the next edge.
+     */
+    uint32_t get_lost_sample_count();
+
+private:
+    float _nominal_period_us;
+    int _filter_length;
+    float _period_us;
+
+    // estimated time of the sample _anchor_index is _anchor_time_us + _anchor_frac_us
+    uint64_t _anchor_time_us;
+    float _anchor_frac_us;
+    uint32_t _anchor_index;
+    // index of the last observed edge sample
+    uint32_t _edge_index;
+    // index of the next sample (lost samples are included)
+    uint32_t _sample_index;
+    int _edge_count;
+    // number of edge observations before output data rate switch
+    int _resume_edge_count;
+    int _resync_count;
+    uint32_t _lost_sample_count;
+    // FIFO overrun is reported after the last edge
+    bool _overrun_pending;
+
+    void _set_period(float period_us);
+    void _set_anchor(uint64_t time_us, float offset_us, uint32_t index);
+    void _restart(uint64_t edge_time_us, uint32_t edge_index);
+};
+}
+
+using l3gd20::SampleTimestamper;
+
+#endif // L3GD20_TIMESTAMPER_H
@@ -1,49 +1,92 @@
 #ifndef L3GD20_UTILS_H
 #define L3GD20_UTILS_H
+#include "l3gd20_bus.h"
 #include "mbed.h"
 
+/**
+ * Driver statistics (`l3gd20-driver.stats_enabled` option).
+ *
+ * If it's disabled, the counters are removed, and statistics getters return zeros.
+ */
+#ifndef MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+#define MBED_CONF_L3GD20_DRIVER_STATS_ENABLED 0
+#endif
+
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+#define L3GD20_STATS_ADD(stats, field, value) ((stats).field += (value))
+#else
+#define L3GD20_STATS_ADD(stats, field, value) ((void)0)
+#endif
+
+/**
+ * Target byte order.
+ *
+ * The driver configures little-endian output registers (CTRL_REG4 BLE bit is 0), so raw samples are valid
+ * int16_t values on little-endian targets, and they are byte swapped on big-endian ones only.
+ * The portable byte swapping path is also correct on little-endian targets, so it can be forced for testing.
+ */
+#ifndef L3GD20_BIG_ENDIAN
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define L3GD20_BIG_ENDIAN 1
+#else
+#define L3GD20_BIG_ENDIAN 0
+#endif
+#endif
+
 namespace l3gd20 {
 
+/**
+ * Flag of the driver statistics availability.
+ */
+static const bool STATS_ENABLED = MBED_CONF_L3GD20_DRIVER_STATS_ENABLED != 0;
+
+/**
+ * Bus transaction counters of the register device.
+ *
+ * Byte counters include register values only. Each transaction also transfers register address
+ * (and I2C device address for I2C bus).
+ */
+struct RegisterDeviceStats {
+    // single register transactions
+    uint32_t register_reads;
+    uint32_t register_writes;
+    // multiple registers transactions
+    uint32_t burst_reads;
+    uint32_t burst_writes;
+    // asynchronous reading transactions
+    uint32_t async_reads;
+    // transferred register values
+    uint32_t bytes_read;
+    uint32_t bytes_written;
+    // register reads, that are served by register cache without bus access
+    uint32_t cache_hits;
+    // failed asynchronous transfers (synchronous bus errors are fatal)
+    uint32_t bus_errors;
+};
+
 /**
  * Inner helper class for L3GD20 driver interface.
  *
+ * It adds register cache and helper methods to the bus policy (see SpiBus, I2cBus and DynamicBus).
+ *
  * It shouldn't be used directly.
  */
-class RegisterDevice : public NonCopyable<RegisterDevice> {
+template <typename Bus>
+class RegisterDeviceT : private NonCopyable<RegisterDeviceT<Bus> > {
 public:
-    /**
-     * Constructor
-     *
-     * @param i2c_ptr I2C interface
-     */
-    RegisterDevice(I2C *i2c_ptr);
-
-    /**
-     * Constructor.
-     *
-     * @param sda I2C data line pin
-     * @param scl I2C clock line pin
-     */
-    RegisterDevice(PinName sda, PinName scl);
-
-    /**
-     * Constructor.
-     *
-     * @param spi_ptr SPI interface
-     */
-    RegisterDevice(SPI *spi_ptr, PinName ssel);
-
     /**
      * Constructor.
      *
-     * @param mosi SPI mosi pin
-     * @param miso SPI miso pin
-     * @param sclk SPI sclk pin
-     * @param ssel SPI ssel pin
+     * All arguments are passed to the bus policy constructor.
      */
-    RegisterDevice(PinName mosi, PinName miso, PinName sclk, PinName ssel);
-
-    virtual ~RegisterDevice();
+    template <typename... Args>
+    explicit RegisterDeviceT(Args... args)
+        : _bus(args...)
+        , _cache_enabled(false)
+        , _cache_valid_mask(0)
+    {
+        reset_stats();
+    }
 
     /**
      * Read device register.
@@ -95,28 +138,190 @@ public:
      */
     void read_registers(uint8_t reg, uint8_t *data, uint8_t length);
 
+    /**
+     * Write several registers, starting with address \p reg.
+     *
+     * @param reg
+     * @param data
+     * @param length number of registers to write. It shouldn't exceed 16.
+     */
+    void write_registers(uint8_t reg, const uint8_t *data, uint8_t length);
+
+    /**
+     * Offset of the register values in the buffer of the read_registers_async method.
+     */
+    static const int ASYNC_READ_OFFSET = l3gd20::ASYNC_READ_OFFSET;
+
+    /**
+     * Start asynchronous reading of several registers, starting with address \p reg.
+     *
+     * SPI and I2C buses are supported, if the target provides asynchronous API for them
+     * (DEVICE_SPI_ASYNCH and DEVICE_I2C_ASYNCH correspondingly).
+     *
+     * The \p data buffer should have at least `length + ASYNC_READ_OFFSET` bytes.
+     * The register values will be placed into it starting with position ASYNC_READ_OFFSET.
+     * The buffer shouldn't be used until transfer completion.
+     *
+     * On transfer completion the \p callback will be invoked from an ISR context
+     * with 0 argument if transfer is successful, or non-zero error code otherwise.
+     *
+     * @note
+     * This method can be invoked from an ISR context. But any other bus operations
+     * shouldn't be used until transfer completion.
+     *
+     * @param reg
+     * @param data
+     * @param length
+     * @param callback
+     * @return 0 if transfer is started, otherwise non-zero error code.
+     */
+    int read_registers_async(uint8_t reg, uint8_t *data, uint8_t length, const Callback<void(int)> &callback);
+
+    /**
+     * Abort asynchronous reading, that is started with read_registers_async method.
+     *
+     * The callback of the aborted transfer isn't invoked after return, and the bus can be used again.
+     */
+    void abort_async();
+
+    /**
+     * Enable/disable write-through cache of the writable registers.
+     *
+     * If cache is enabled, then reading of the cached registers doesn't use bus,
+     * and update_register method requires only one write operation.
+     *
+     * The following registers are cached: CTRL_REG1-CTRL_REG5, REFERENCE,
+     * FIFO_CTRL_REG, INT1_CFG, INT1_TSH_* and INT1_DURATION.
+     *
+     * @note
+     * The cache content is dropped on each mode change.
+     *
+     * @param enable
+     */
+    void set_cache_mode(bool enable);
+
+    /**
+     * Check if register cache is enabled.
+     *
+     * @return
+     */
+    bool get_cache_mode();
+
+    /**
+     * Reload cache content from device.
+     *
+     * It should be invoked if device registers are changed bypassing this object
+     * (for example after device reset). If cache is disabled, this method does nothing.
+     */
+    void resync();
+
+    /**
+     * Read register, that is never cached (output registers, status registers, etc.), without cache checks.
+     *
+     * @param reg register address
+     * @return register value
+     */
+    uint8_t read_volatile_register(uint8_t reg);
+
+    /**
+     * Read several registers, that are never cached, without cache checks.
+     *
+     * @param reg first register address
+     * @param data buffer for register values
+     * @param length number of registers to read
+     */
+    void read_volatile_registers(uint8_t reg, uint8_t *data, uint8_t length);
+
+    /**
+     * Get bus object.
+     *
+     * @note
+     * Transactions of the bus object aren't counted by statistics.
+     *
+     * @return
+     */
+    Bus &get_bus()
+    {
+        return _bus;
+    }
+
+    /**
+     * Get snapshot of the bus transaction counters.
+     *
+     * @note
+     * The counters aren't updated atomically, so they shouldn't be read during asynchronous transfer.
+     *
+     * @return counters or zeros, if statistics is disabled
+     */
+    RegisterDeviceStats get_stats();
+
+    /**
+     * Reset bus transaction counters.
+     */
+    void reset_stats();
+
 private:
-    // helper variable with state flags
-    uint8_t _state;
-    enum StateFlags : uint8_t {
-        SPI_DEVICE = 0x01,
-        I2C_DEVICE = 0x02,
-        CLEANUP_I2C_PTR = 0x04,
-        CLEANUP_SPI_PTR = 0x08,
-        CLEANUP_SPI_SSEL = 0x10
-    };
-
-    // spi/i2c data
-    union Interface {
-        SPI *spi_ptr;
-        I2C *i2c_ptr;
-    };
-    Interface _interface;
-
-    // I2C address (assume SDO pin is set to 0)
-    static const uint8_t _I2C_ADDRESS = 0xDA;
-
-    DigitalOut *_spi_ssel_ptr;
+    Bus _bus;
+
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    RegisterDeviceStats _stats;
+    Callback<void(int)> _async_callback;
+
+    void _on_async_complete(int err);
+#endif
+
+    // register cache (it covers registers from 0x20 to 0x38)
+    static const uint8_t _CACHE_START_ADDR = 0x20;
+    static const uint8_t _CACHE_SIZE = 0x19;
+    static const uint32_t _CACHEABLE_MASK = 0x01FD403F;
+    static const uint8_t _CTRL_REG5_ADDR = 0x24;
+    static const uint8_t _CTRL_REG5_BOOT = 0x80;
+    static const uint8_t _OUT_Z_H_ADDR = 0x2D;
+    bool _cache_enabled;
+    uint8_t _cache[_CACHE_SIZE];
+    uint32_t _cache_valid_mask;
+
+    /**
+     * Get cache entry mask of the register.
+     *
+     * @param reg register address
+     * @return cache entry mask or 0, if register cannot be cached or cache is disabled.
+     */
+    uint32_t _get_cache_entry(uint8_t reg);
+
+    /**
+     * Get cache entries mask of the registers range.
+     *
+     * @param reg first register address
+     * @param length number of registers
+     * @return cache entries mask or 0, if any register of the range cannot be cached or cache is disabled.
+     */
+    uint32_t _get_cache_entries(uint8_t reg, uint8_t length);
 };
+
+/**
+ * Register device with runtime bus selection.
+ */
+typedef RegisterDeviceT<DynamicBus> RegisterDevice;
+
+/*
+ * RegisterDeviceT inline methods
+ */
+
+template <typename Bus>
+inline uint8_t RegisterDeviceT<Bus>::read_volatile_register(uint8_t reg)
+{
+    L3GD20_STATS_ADD(_stats, register_reads, 1);
+    L3GD20_STATS_ADD(_stats, bytes_read, 1);
+    return _bus.read_register(reg);
+}
+
+template <typename Bus>
+inline void RegisterDeviceT<Bus>::read_volatile_registers(uint8_t reg, uint8_t *data, uint8_t length)
+{
+    L3GD20_STATS_ADD(_stats, burst_reads, 1);
+    L3GD20_STATS_ADD(_stats, bytes_read, length);
+    _bus.read_registers(reg, data, length);
+}
 }
 #endif // L3GD20_UTILS_H
@@ -0,0 +1,118 @@
+#include "l3gd20_adaptive_rate.h"
+
+using namespace l3gd20;
+
+AdaptiveRateController::Config::Config()
+    : low_odr(L3GD20Gyroscope::ODR_95_HZ)
+    , low_watermark(4)
+    , high_odr(L3GD20Gyroscope::ODR_760_HZ)
+    , high_watermark(24)
+    , high_activity(0.2f)
+    , low_activity(0.1f)
+    , hold_time_us(500000)
+{
+}
+
+AdaptiveRateController::AdaptiveRateController(const Config &config)
+    : _config(config)
+    , _high_rate(true)
+    , _activity(0.0f)
+    , _low_activity_time_us(0.0f)
+    , _switch_count(0)
+{
+    if (config.low_odr >= config.high_odr) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Low output data rate should be less than high one");
+    }
+    if (config.low_watermark <= 0 || config.low_watermark >= L3GD20Gyroscope::FIFO_SIZE
+        || config.high_watermark <= 0 || config.high_watermark >= L3GD20Gyroscope::FIFO_SIZE) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "FIFO watermark should be between 1 and 31");
+    }
+    if (config.low_activity < 0.0f || config.low_activity >= config.high_activity) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Low activity threshold should be less than high one");
+    }
+    memset(_bias, 0, sizeof(_bias));
+}
+
+void AdaptiveRateController::reset(bool high_rate)
+{
+    _high_rate = high_rate;
+    _activity = 0.0f;
+    _low_activity_time_us = 0.0f;
+}
+
+bool AdaptiveRateController::update(const int16_t (*samples)[3], int n, float sensitivity, float odr_hz)
+{
+    if (n <= 0 || odr_hz <= 0.0f) {
+        return false;
+    }
+    // squared magnitude of the rate vector is the sum of the squared axis rates,
+    // so the activity is RMS of the magnitude over the block
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) {
+            float rate = samples[i][j] * sensitivity - _bias[j];
+            sum += rate * rate;
+        }
+    }
+    _activity = sqrtf(sum / n);
+
+    if (!_high_rate) {
+        if (_activity > _config.high_activity) {
+            _select(true);
+            return true;
+        }
+        return false;
+    }
+    if (_activity >= _config.low_activity) {
+        _low_activity_time_us = 0.0f;
+        return false;
+    }
+    _low_activity_time_us += n * 1e6f / odr_hz;
+    if (_low_activity_time_us < _config.hold_time_us) {
+        return false;
+    }
+    _select(false);
+    return true;
+}
+
+void AdaptiveRateController::set_bias(const float bias[3])
+{
+    memcpy(_bias, bias, sizeof(_bias));
+}
+
+const AdaptiveRateController::Config &AdaptiveRateController::get_config()
+{
+    return _config;
+}
+
+bool AdaptiveRateController::is_high_rate()
+{
+    return _high_rate;
+}
+
+L3GD20Gyroscope::OutputDataRate AdaptiveRateController::get_odr()
+{
+    return _high_rate ? _config.high_odr : _config.low_odr;
+}
+
+int AdaptiveRateController::get_watermark()
+{
+    return _high_rate ? _config.high_watermark : _config.low_watermark;
+}
+
+float AdaptiveRateController::get_activity()
+{
+    return _activity;
+}
+
+uint32_t AdaptiveRateController::get_switch_count()
+{
+    return _switch_count;
+}
+
+void AdaptiveRateController::_select(bool high_rate)
+{
+    _high_rate = high_rate;
+    _low_activity_time_us = 0.0f;
+    _switch_count++;
+}
@@ -0,0 +1,138 @@
+#include "l3gd20_async_reader.h"
+
+using namespace l3gd20;
+
+// the raw data should start with second buffer element
+MBED_STATIC_ASSERT(L3GD20Gyroscope::FIFO_ASYNC_OFFSET == sizeof(int16_t) - 1, "Unexpected asynchronous transfer offset");
+// full FIFO reading takes about 17 ms with 100 kHz I2C
+static const int STOP_TIMEOUT_US = 50000;
+static const int STOP_POLL_INTERVAL_US = 10;
+
+AsyncFifoReader::AsyncFifoReader(L3GD20Gyroscope *gyro, PinName int2_pin)
+    : _gyro(gyro)
+    , _int2(int2_pin)
+    , _block_size(0)
+    , _running(false)
+    , _transfer(false)
+    , _abandoned_transfer(false)
+    , _error_count(0)
+    , _current_buffer(0)
+{
+    _int2.disable_irq();
+}
+
+AsyncFifoReader::~AsyncFifoReader()
+{
+    stop();
+}
+
+int AsyncFifoReader::start(int block_size, const block_callback_t &block_callback)
+{
+    if (block_size <= 0 || block_size >= L3GD20Gyroscope::FIFO_SIZE) {
+        return MBED_ERROR_CODE_INVALID_ARGUMENT;
+    }
+    if (_running) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+
+    _block_size = block_size;
+    _callback = block_callback;
+    _error_count = 0;
+    _current_buffer = 0;
+    _transfer = false;
+    _abandoned_transfer = false;
+
+    // configure FIFO
+    _gyro->set_fifo_watermark(block_size);
+    _gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    _gyro->clear_fifo();
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
+
+    // run interrupts processing
+    _running = true;
+    _int2.rise(callback(this, &AsyncFifoReader::_on_interrupt));
+    _int2.enable_irq();
+    if (_int2.read()) {
+        // watermark level has been reached before interrupt enabling
+        _start_transfer();
+    }
+
+    return MBED_SUCCESS;
+}
+
+void AsyncFifoReader::stop()
+{
+    if (!_running) {
+        return;
+    }
+    _int2.disable_irq();
+    _running = false;
+    // wait transfer completion
+    for (int t = 0; _transfer && t < STOP_TIMEOUT_US; t += STOP_POLL_INTERVAL_US) {
+        wait_us(STOP_POLL_INTERVAL_US);
+    }
+    if (_transfer) {
+        // the completion is lost (e.g. bus error without event), so the transfer is aborted
+        // and its possible late completion is ignored
+        _gyro->abort_fifo_async();
+        _abandoned_transfer = true;
+        _transfer = false;
+        _error_count++;
+    }
+    _int2.rise(nullptr);
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
+}
+
+int AsyncFifoReader::get_error_count()
+{
+    return _error_count;
+}
+
+void AsyncFifoReader::_start_transfer()
+{
+    // note: method can be invoked from pin and bus interrupts, that can have different priorities
+    core_util_critical_section_enter();
+    if (!_transfer && _running) {
+        _transfer = true;
+        // raw data is placed after the first buffer element, so the samples are aligned and decoded in place
+        uint8_t *buffer = (uint8_t *)(_buffers[_current_buffer] + 1) - L3GD20Gyroscope::FIFO_ASYNC_OFFSET;
+        int err = _gyro->read_fifo_async(buffer, _block_size, callback(this, &AsyncFifoReader::_on_transfer_complete));
+        if (err) {
+            _transfer = false;
+            _error_count++;
+        }
+    }
+    core_util_critical_section_exit();
+}
+
+void AsyncFifoReader::_on_interrupt()
+{
+    _start_transfer();
+}
+
+void AsyncFifoReader::_on_transfer_complete(int err)
+{
+    if (_abandoned_transfer) {
+        // late completion of the abandoned transfer
+        _abandoned_transfer = false;
+        return;
+    }
+    int16_t *buffer = _buffers[_current_buffer];
+    _current_buffer ^= 1;
+    _transfer = false;
+
+    // if FIFO still contains block, there is no new rising edge, so start next transfer explicitly
+    // to the other buffer, before the current block processing
+    if (_int2.read()) {
+        _start_transfer();
+    }
+
+    if (err) {
+        _error_count++;
+    } else {
+        // decode samples in place
+        int16_t(*samples)[3] = (int16_t(*)[3])(buffer + 1);
+        L3GD20Gyroscope::decode_samples((const uint8_t *)samples, samples, _block_size);
+        _callback.call(samples, _block_size);
+    }
+}
@@ -0,0 +1,126 @@
+#include "l3gd20_bias_estimator.h"
+
+using namespace l3gd20;
+
+BiasEstimator::BiasEstimator(int window_size, float max_std_dev, float max_bias)
+    : _window_size(window_size)
+    , _max_variance(max_std_dev * max_std_dev)
+    , _max_bias(max_bias)
+{
+    if (window_size < 2) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid window size");
+    }
+    reset();
+}
+
+void BiasEstimator::reset()
+{
+    _count = 0;
+    for (int i = 0; i < 3; i++) {
+        _mean[i] = 0.0f;
+        _m2[i] = 0.0f;
+        _bias[i] = 0.0f;
+        _window_mean[i] = 0.0f;
+    }
+    _stationary = false;
+    _stationary_count = 0;
+    _weight = 0;
+}
+
+bool BiasEstimator::update(const float (*rates)[3], int n)
+{
+    bool window_found = false;
+    for (int i = 0; i < n; i++) {
+        window_found |= _add_sample(rates[i][0], rates[i][1], rates[i][2]);
+    }
+    return window_found;
+}
+
+bool BiasEstimator::update(const int16_t (*samples)[3], int n, float sensitivity)
+{
+    bool window_found = false;
+    for (int i = 0; i < n; i++) {
+        window_found |= _add_sample(samples[i][0] * sensitivity, samples[i][1] * sensitivity, samples[i][2] * sensitivity);
+    }
+    return window_found;
+}
+
+void BiasEstimator::get_bias(float bias[3])
+{
+    for (int i = 0; i < 3; i++) {
+        bias[i] = _bias[i];
+    }
+}
+
+void BiasEstimator::get_window_mean(float mean[3])
+{
+    for (int i = 0; i < 3; i++) {
+        mean[i] = _window_mean[i];
+    }
+}
+
+void BiasEstimator::set_bias(const float bias[3])
+{
+    for (int i = 0; i < 3; i++) {
+        _bias[i] = bias[i];
+    }
+    // the initial value has weight of several windows
+    _weight = AVERAGING_WINDOWS / 2;
+}
+
+bool BiasEstimator::is_stationary()
+{
+    return _stationary;
+}
+
+int BiasEstimator::get_stationary_window_count()
+{
+    return _stationary_count;
+}
+
+bool BiasEstimator::_add_sample(float x, float y, float z)
+{
+    const float v[3] = { x, y, z };
+    _count++;
+    float k = 1.0f / _count;
+    for (int i = 0; i < 3; i++) {
+        float delta = v[i] - _mean[i];
+        _mean[i] += delta * k;
+        _m2[i] += delta * (v[i] - _mean[i]);
+    }
+    if (_count >= _window_size) {
+        return _finish_window();
+    }
+    return false;
+}
+
+bool BiasEstimator::_finish_window()
+{
+    _stationary = true;
+    float max_m2 = _max_variance * (_count - 1);
+    for (int i = 0; i < 3; i++) {
+        if (_m2[i] > max_m2 || fabsf(_mean[i]) > _max_bias) {
+            _stationary = false;
+        }
+    }
+
+    if (_stationary) {
+        // running average of the window means, that becomes exponential after AVERAGING_WINDOWS windows
+        _stationary_count++;
+        if (_weight < AVERAGING_WINDOWS) {
+            _weight++;
+        }
+        float gain = 1.0f / _weight;
+        for (int i = 0; i < 3; i++) {
+            _bias[i] += gain * (_mean[i] - _bias[i]);
+            _window_mean[i] = _mean[i];
+        }
+    }
+
+    _count = 0;
+    for (int i = 0; i < 3; i++) {
+        _mean[i] = 0.0f;
+        _m2[i] = 0.0f;
+    }
+    return _stationary;
+}
@@ -0,0 +1,445 @@
+#include "l3gd20_bus.h"
+using namespace l3gd20;
+
+/*
+ * SpiBus
+ */
+
+SpiBus::SpiBus(SPI* spi_ptr, PinName ssel)
+    : _spi_ptr(spi_ptr)
+    , _ssel(ssel, 1)
+    , _cleanup_spi_ptr(false)
+    , _async_transfer(false)
+{
+    _spi_ptr->format(8, 3);
+}
+
+SpiBus::SpiBus(PinName mosi, PinName miso, PinName sclk, PinName ssel)
+    : _spi_ptr(new SPI(mosi, miso, sclk))
+    , _ssel(ssel, 1)
+    , _cleanup_spi_ptr(true)
+    , _async_transfer(false)
+{
+    _spi_ptr->frequency(10000000);
+    _spi_ptr->format(8, 3);
+}
+
+SpiBus::~SpiBus()
+{
+    if (_cleanup_spi_ptr) {
+        delete _spi_ptr;
+    }
+}
+
+int SpiBus::read_registers_async(uint8_t reg, uint8_t* data, uint8_t length, const Callback<void(int)>& callback)
+{
+#if DEVICE_SPI_ASYNCH
+    if (_async_transfer) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    _async_reg = reg | 0x40 | 0x80; // read multiple bytes
+    _async_callback = callback;
+    _async_transfer = true;
+    _ssel.write(0);
+    // send register address and read data
+    // note: the first received byte corresponds to the register address transmission
+    int res = _spi_ptr->transfer(&_async_reg, 1, data, length + ASYNC_READ_OFFSET,
+                                 mbed::callback(this, &SpiBus::_async_handler),
+                                 SPI_EVENT_COMPLETE | SPI_EVENT_ERROR);
+    if (res) {
+        _ssel.write(1);
+        _async_transfer = false;
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    return MBED_SUCCESS;
+#else
+    return MBED_ERROR_CODE_UNSUPPORTED;
+#endif
+}
+
+void SpiBus::_async_handler(int event)
+{
+    _ssel.write(1);
+    _async_transfer = false;
+    // note: callback can start a new transfer, so state should be reset before it
+    _async_callback.call((event & SPI_EVENT_COMPLETE) ? MBED_SUCCESS : MBED_ERROR_CODE_READ_FAILED);
+}
+
+void SpiBus::abort_async()
+{
+#if DEVICE_SPI_ASYNCH
+    if (_async_transfer) {
+        _spi_ptr->abort_transfer();
+        _ssel.write(1);
+        _async_transfer = false;
+    }
+#endif
+}
+
+/*
+ * I2cBus
+ */
+
+I2cBus::I2cBus(I2C* i2c_ptr)
+    : _i2c_ptr(i2c_ptr)
+    , _cleanup_i2c_ptr(false)
+    , _async_transfer(false)
+{
+}
+
+I2cBus::I2cBus(PinName sda, PinName scl)
+    : _i2c_ptr(new I2C(sda, scl))
+    , _cleanup_i2c_ptr(true)
+    , _async_transfer(false)
+{
+}
+
+I2cBus::~I2cBus()
+{
+    if (_cleanup_i2c_ptr) {
+        delete _i2c_ptr;
+    }
+}
+
+int I2cBus::read_registers_async(uint8_t reg, uint8_t* data, uint8_t length, const Callback<void(int)>& callback)
+{
+#if DEVICE_I2C_ASYNCH
+    if (_async_transfer) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    _async_reg = reg | 0x80; // read multiple bytes
+    _async_callback = callback;
+    _async_transfer = true;
+    // send register address and read data after repeated start
+    int res = _i2c_ptr->transfer(L3GD20_I2C_ADDRESS, (const char*)&_async_reg, 1,
+                                 (char*)data + ASYNC_READ_OFFSET, length,
+                                 mbed::callback(this, &I2cBus::_async_handler),
+                                 I2C_EVENT_ALL, false);
+    if (res) {
+        _async_transfer = false;
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    return MBED_SUCCESS;
+#else
+    return MBED_ERROR_CODE_UNSUPPORTED;
+#endif
+}
+
+void I2cBus::_async_handler(int event)
+{
+    _async_transfer = false;
+    // note: callback can start a new transfer, so state should be reset before it
+    if (event == I2C_EVENT_TRANSFER_COMPLETE) {
+        _async_callback.call(MBED_SUCCESS);
+    } else {
+        _async_callback.call(MBED_ERROR_CODE_READ_FAILED);
+    }
+}
+
+void I2cBus::abort_async()
+{
+#if DEVICE_I2C_ASYNCH
+    if (_async_transfer) {
+        _i2c_ptr->abort_transaction();
+        _async_transfer = false;
+    }
+#endif
+}
+
+/*
+ * DynamicBus
+ */
+
+DynamicBus::DynamicBus(mbed::I2C* i2c_ptr)
+{
+    _interface.i2c_ptr = i2c_ptr;
+    _state = I2C_DEVICE;
+}
+
+DynamicBus::DynamicBus(PinName sda, PinName scl)
+{
+    _interface.i2c_ptr = new I2C(sda, scl);
+    _state = I2C_DEVICE | CLEANUP_I2C_PTR;
+}
+
+DynamicBus::DynamicBus(mbed::SPI* spi_ptr, PinName ssel)
+{
+    _interface.spi_ptr = spi_ptr;
+    spi_ptr->format(8, 3); // set data format
+    _state = SPI_DEVICE;
+    if (ssel == NC) {
+        _spi_ssel_ptr = NULL;
+    } else {
+        _spi_ssel_ptr = new DigitalOut(ssel, 1);
+        _state |= CLEANUP_SPI_SSEL;
+    }
+}
+
+DynamicBus::DynamicBus(PinName mosi, PinName miso, PinName sclk, PinName ssel)
+{
+    _interface.spi_ptr = new SPI(mosi, miso, sclk);
+    _interface.spi_ptr->frequency(10000000);
+    _interface.spi_ptr->format(8, 3);
+    _state = SPI_DEVICE | CLEANUP_SPI_PTR;
+    if (ssel == NC) {
+        _spi_ssel_ptr = NULL;
+    } else {
+        _spi_ssel_ptr = new DigitalOut(ssel, 1);
+        _state |= CLEANUP_SPI_SSEL;
+    }
+}
+
+DynamicBus::DynamicBus(RegisterTransport* transport_ptr)
+{
+    _interface.transport_ptr = transport_ptr;
+    _state = TRANSPORT_DEVICE;
+    _spi_ssel_ptr = NULL;
+}
+
+DynamicBus::~DynamicBus()
+{
+    if (_state & CLEANUP_I2C_PTR) {
+        delete _interface.i2c_ptr;
+    }
+    if (_state & CLEANUP_SPI_PTR) {
+        delete _interface.spi_ptr;
+    }
+    if (_state & CLEANUP_SPI_SSEL) {
+        delete _spi_ssel_ptr;
+    }
+}
+
+uint8_t DynamicBus::read_register(uint8_t reg)
+{
+    uint8_t val;
+
+    if (_state & TRANSPORT_DEVICE) {
+        _interface.transport_ptr->read_registers(reg, &val, 1);
+    } else if (_state & SPI_DEVICE) {
+        // SPI is used
+        reg = reg | 0x80; // read mode
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(0);
+        }
+        _interface.spi_ptr->write(reg); // send register address
+        val = _interface.spi_ptr->write(0x00); // read register value
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(1);
+        }
+    } else {
+        // the I2C is used
+        int res;
+        res = _interface.i2c_ptr->write(L3GD20_I2C_ADDRESS, (char*)&reg, 1, true); // send register address
+        if (res) {
+            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "register reading failed");
+        }
+        res = _interface.i2c_ptr->read(L3GD20_I2C_ADDRESS, (char*)&val, 1); // read register value
+        if (res) {
+            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_READ_FAILED), "register reading failed");
+        }
+    }
+
+    return val;
+}
+
+void DynamicBus::write_register(uint8_t reg, uint8_t val)
+{
+    if (_state & TRANSPORT_DEVICE) {
+        _interface.transport_ptr->write_registers(reg, &val, 1);
+    } else if (_state & SPI_DEVICE) {
+        // the SPI is used
+        reg = reg & 0x7F; // write mode
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(0);
+        }
+        _interface.spi_ptr->write(reg); // send register address
+        _interface.spi_ptr->write(val); // send value
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(1);
+        }
+
+    } else {
+        // the I2C is used
+        uint8_t data[2] = { reg, val };
+        // write register address and value
+        int res = _interface.i2c_ptr->write(L3GD20_I2C_ADDRESS, (char*)data, 2);
+        if (res) {
+            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "register writing failed");
+        }
+    }
+}
+
+void DynamicBus::read_registers(uint8_t reg, uint8_t* data, uint8_t length)
+{
+    if (_state & TRANSPORT_DEVICE) {
+        _interface.transport_ptr->read_registers(reg, data, length);
+    } else if (_state & SPI_DEVICE) {
+        // the SPI is used
+        reg |= 0x40; // read multiple bytes
+        reg |= 0x80; // read mode
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(0);
+        }
+        _interface.spi_ptr->write(reg); // send register address
+        _interface.spi_ptr->write(NULL, 0, (char*)data, length); // read data
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(1);
+        }
+    } else {
+        // the I2C is used
+        reg |= 0x80; // read multiple bytes
+        int res;
+        res = _interface.i2c_ptr->write(L3GD20_I2C_ADDRESS, (char*)&reg, 1, true); // send register address
+        if (res) {
+            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "registers reading failed");
+        }
+        res = _interface.i2c_ptr->read(L3GD20_I2C_ADDRESS, (char*)data, length); // read data
+        if (res) {
+            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_READ_FAILED), "registers reading failed");
+        }
+    }
+}
+
+void DynamicBus::write_registers(uint8_t reg, const uint8_t* data, uint8_t length)
+{
+    if (_state & TRANSPORT_DEVICE) {
+        _interface.transport_ptr->write_registers(reg, data, length);
+    } else if (_state & SPI_DEVICE) {
+        // the SPI is used
+        reg &= 0x3F; // write mode
+        reg |= 0x40; // write multiple bytes
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(0);
+        }
+        _interface.spi_ptr->write(reg); // send register address
+        _interface.spi_ptr->write((const char*)data, length, NULL, 0); // write data
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(1);
+        }
+    } else {
+        // the I2C is used
+        if (length > I2cBus::MAX_WRITE_LENGTH) {
+            MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Too many registers to write");
+        }
+        uint8_t buf[I2cBus::MAX_WRITE_LENGTH + 1];
+        buf[0] = reg | 0x80; // write multiple bytes
+        memcpy(buf + 1, data, length);
+        // write register address and values
+        int res = _interface.i2c_ptr->write(L3GD20_I2C_ADDRESS, (char*)buf, length + 1);
+        if (res) {
+            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "registers writing failed");
+        }
+    }
+}
+
+int DynamicBus::read_registers_async(uint8_t reg, uint8_t* data, uint8_t length, const Callback<void(int)>& callback)
+{
+    if (_state & ASYNC_TRANSFER) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+
+    if (_state & TRANSPORT_DEVICE) {
+        _async_callback = callback;
+        _state |= ASYNC_TRANSFER;
+        int res = _interface.transport_ptr->read_registers_async(reg, data, length,
+                                                                 mbed::callback(this, &DynamicBus::_transport_async_handler));
+        if (res) {
+            _state &= ~ASYNC_TRANSFER;
+        }
+        return res;
+    } else if (_state & SPI_DEVICE) {
+#if DEVICE_SPI_ASYNCH
+        // the SPI is used
+        _async_reg = reg | 0x40 | 0x80; // read multiple bytes
+        _async_callback = callback;
+        _state |= ASYNC_TRANSFER;
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(0);
+        }
+        // send register address and read data
+        // note: the first received byte corresponds to the register address transmission
+        int res = _interface.spi_ptr->transfer(&_async_reg, 1, data, length + ASYNC_READ_OFFSET,
+                                               mbed::callback(this, &DynamicBus::_spi_async_handler),
+                                               SPI_EVENT_COMPLETE | SPI_EVENT_ERROR);
+        if (res) {
+            if (_spi_ssel_ptr != NULL) {
+                _spi_ssel_ptr->write(1);
+            }
+            _state &= ~ASYNC_TRANSFER;
+            return MBED_ERROR_CODE_EBUSY;
+        }
+        return MBED_SUCCESS;
+#else
+        return MBED_ERROR_CODE_UNSUPPORTED;
+#endif
+    } else {
+#if DEVICE_I2C_ASYNCH
+        // the I2C is used
+        _async_reg = reg | 0x80; // read multiple bytes
+        _async_callback = callback;
+        _state |= ASYNC_TRANSFER;
+        // send register address and read data after repeated start
+        int res = _interface.i2c_ptr->transfer(L3GD20_I2C_ADDRESS, (const char*)&_async_reg, 1,
+                                               (char*)data + ASYNC_READ_OFFSET, length,
+                                               mbed::callback(this, &DynamicBus::_i2c_async_handler),
+                                               I2C_EVENT_ALL, false);
+        if (res) {
+            _state &= ~ASYNC_TRANSFER;
+            return MBED_ERROR_CODE_EBUSY;
+        }
+        return MBED_SUCCESS;
+#else
+        return MBED_ERROR_CODE_UNSUPPORTED;
+#endif
+    }
+}
+
+void DynamicBus::_spi_async_handler(int event)
+{
+    if (_spi_ssel_ptr != NULL) {
+        _spi_ssel_ptr->write(1);
+    }
+    _state &= ~ASYNC_TRANSFER;
+    // note: callback can start a new transfer, so state should be reset before it
+    _async_callback.call((event & SPI_EVENT_COMPLETE) ? MBED_SUCCESS : MBED_ERROR_CODE_READ_FAILED);
+}
+
+void DynamicBus::_i2c_async_handler(int event)
+{
+    _state &= ~ASYNC_TRANSFER;
+    // note: callback can start a new transfer, so state should be reset before it
+    if (event == I2C_EVENT_TRANSFER_COMPLETE) {
+        _async_callback.call(MBED_SUCCESS);
+    } else {
+        _async_callback.call(MBED_ERROR_CODE_READ_FAILED);
+    }
+}
+
+void DynamicBus::_transport_async_handler(int err)
+{
+    _state &= ~ASYNC_TRANSFER;
+    // note: callback can start a new transfer, so state should be reset before it
+    _async_callback.call(err);
+}
+
+void DynamicBus::abort_async()
+{
+    if (!(_state & ASYNC_TRANSFER)) {
+        return;
+    }
+    if (_state & TRANSPORT_DEVICE) {
+        _interface.transport_ptr->abort_async();
+    } else if (_state & SPI_DEVICE) {
+#if DEVICE_SPI_ASYNCH
+        _interface.spi_ptr->abort_transfer();
+        if (_spi_ssel_ptr != NULL) {
+            _spi_ssel_ptr->write(1);
+        }
+#endif
+    } else {
+#if DEVICE_I2C_ASYNCH
+        _interface.i2c_ptr->abort_transaction();
+#endif
+    }
+    _state &= ~ASYNC_TRANSFER;
+}
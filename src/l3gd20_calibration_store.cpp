@@ -0,0 +1,137 @@
+#include "l3gd20_calibration_store.h"
+
+using namespace l3gd20;
+
+/**
+ * Record layout.
+ */
+struct CalibrationRecord {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint8_t full_scale;
+    uint8_t odr;
+    int8_t temperature;
+    uint8_t reserved;
+    float bias[3];
+    float odr_hz;
+    // CRC-32 of the previous fields
+    uint32_t crc;
+};
+MBED_STATIC_ASSERT(sizeof(CalibrationRecord) == 32, "Unexpected calibration record padding");
+
+static uint32_t compute_record_crc(const CalibrationRecord *record)
+{
+    MbedCRC<POLY_32BIT_ANSI, 32> ct;
+    uint32_t crc = 0;
+    ct.compute(record, offsetof(CalibrationRecord, crc), &crc);
+    return crc;
+}
+
+CalibrationStore::CalibrationStore(BlockDevice *block_device, bd_addr_t address)
+    : _block_device(block_device)
+    , _address(address)
+{
+    if (block_device == NULL) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Block device isn't set");
+    }
+}
+
+int CalibrationStore::save(const Calibration &calibration)
+{
+    bd_size_t record_size;
+    int err = _get_record_size(&record_size);
+    if (err) {
+        return err;
+    }
+
+    uint8_t buffer[MAX_RECORD_SIZE];
+    memset(buffer, 0, record_size);
+    CalibrationRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = MAGIC;
+    record.version = VERSION;
+    record.size = sizeof(CalibrationRecord);
+    record.full_scale = calibration.full_scale;
+    record.odr = calibration.odr;
+    record.temperature = calibration.temperature;
+    for (int i = 0; i < 3; i++) {
+        record.bias[i] = calibration.bias[i];
+    }
+    record.odr_hz = calibration.odr_hz;
+    record.crc = compute_record_crc(&record);
+    memcpy(buffer, &record, sizeof(record));
+
+    err = _block_device->erase(_address, _block_device->get_erase_size(_address));
+    if (err) {
+        return err;
+    }
+    return _block_device->program(buffer, _address, record_size);
+}
+
+int CalibrationStore::load(Calibration *calibration, L3GD20GyroscopeBase::FullScale full_scale, L3GD20GyroscopeBase::OutputDataRate odr)
+{
+    bd_size_t record_size;
+    int err = _get_record_size(&record_size);
+    if (err) {
+        return err;
+    }
+
+    uint8_t buffer[MAX_RECORD_SIZE];
+    err = _block_device->read(buffer, _address, record_size);
+    if (err) {
+        return err;
+    }
+    CalibrationRecord record;
+    memcpy(&record, buffer, sizeof(record));
+    if (record.magic != MAGIC || record.version != VERSION) {
+        return MBED_ERROR_CODE_ITEM_NOT_FOUND;
+    }
+    if (record.size != sizeof(CalibrationRecord) || record.crc != compute_record_crc(&record)) {
+        return MBED_ERROR_CODE_INVALID_DATA_DETECTED;
+    }
+
+    calibration->full_scale = (L3GD20GyroscopeBase::FullScale)record.full_scale;
+    calibration->odr = (L3GD20GyroscopeBase::OutputDataRate)record.odr;
+    calibration->temperature = record.temperature;
+    for (int i = 0; i < 3; i++) {
+        calibration->bias[i] = record.bias[i];
+    }
+    calibration->odr_hz = record.odr_hz;
+
+    if (calibration->full_scale != full_scale || calibration->odr != odr) {
+        return MBED_ERROR_CODE_INVALID_FORMAT;
+    }
+    return MBED_SUCCESS;
+}
+
+int CalibrationStore::erase()
+{
+    bd_size_t record_size;
+    int err = _get_record_size(&record_size);
+    if (err) {
+        return err;
+    }
+    err = _block_device->erase(_address, _block_device->get_erase_size(_address));
+    if (err) {
+        return err;
+    }
+    // note: erase value can be undefined, so the record is overwritten explicitly
+    uint8_t buffer[MAX_RECORD_SIZE];
+    memset(buffer, 0, record_size);
+    return _block_device->program(buffer, _address, record_size);
+}
+
+int CalibrationStore::_get_record_size(bd_size_t *record_size)
+{
+    // round record size up to the read and program sizes
+    bd_size_t read_size = _block_device->get_read_size();
+    bd_size_t program_size = _block_device->get_program_size();
+    bd_size_t unit = read_size > program_size ? read_size : program_size;
+    bd_size_t size = (sizeof(CalibrationRecord) + unit - 1) / unit * unit;
+    if (size > MAX_RECORD_SIZE || size % read_size || size % program_size) {
+        return MBED_ERROR_CODE_INVALID_SIZE;
+    }
+    *record_size = size;
+    return MBED_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/**
+ * Block conversion of raw samples into floating point and fixed-point values.
+ *
+ * Implementation of the floating point conversion is selected at compile time:
+ *
+ * - CMSIS-DSP, if `l3gd20-driver.use_cmsis_dsp` option is set (Cortex-M4F/M7 targets);
+ * - NEON, if it's available (ARMv7-A/ARMv8-A hosts);
+ * - SSE2, if it's available (x86 hosts);
+ * - scalar code otherwise.
+ */
+#include "l3gd20_driver.h"
+
+#if MBED_CONF_L3GD20_DRIVER_USE_CMSIS_DSP
+#include "arm_math.h"
+#define L3GD20_CONVERT_CMSIS_DSP 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define L3GD20_CONVERT_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define L3GD20_CONVERT_SSE2 1
+#endif
+
+using namespace l3gd20;
+
+static inline void convert_values_scalar(const int16_t *src, float *dst, int n_values, float scale)
+{
+    for (int i = 0; i < n_values; i++) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+static inline void convert_planar_scalar(const int16_t (*samples)[3], float *x, float *y, float *z, int start, int n, float scale)
+{
+    for (int i = start; i < n; i++) {
+        x[i] = samples[i][0] * scale;
+        y[i] = samples[i][1] * scale;
+        z[i] = samples[i][2] * scale;
+    }
+}
+
+#if L3GD20_CONVERT_SSE2
+/**
+ * Load 4 int16 values and convert them into floats.
+ */
+static inline __m128 load_4_values(const int16_t *src)
+{
+    __m128i v = _mm_loadl_epi64((const __m128i *)src);
+    // sign extension: put value into the upper half and shift it back
+    v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    return _mm_cvtepi32_ps(v);
+}
+#endif
+
+void L3GD20GyroscopeBase::convert_samples(const int16_t (*samples)[3], float (*data)[3], int n, float scale)
+{
+    const int16_t *src = &samples[0][0];
+    float *dst = &data[0][0];
+    int n_values = n * 3;
+    if (n_values <= 0) {
+        return;
+    }
+
+#if L3GD20_CONVERT_CMSIS_DSP
+    // arm_q15_to_float divides values by 32768, so compensate it with scale
+    arm_q15_to_float((q15_t *)src, dst, n_values);
+    arm_scale_f32(dst, scale * 32768.0f, dst, n_values);
+#elif L3GD20_CONVERT_NEON
+    int i = 0;
+    for (; i + 8 <= n_values; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(dst + i, vmulq_n_f32(lo, scale));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(hi, scale));
+    }
+    convert_values_scalar(src + i, dst + i, n_values - i, scale);
+#elif L3GD20_CONVERT_SSE2
+    __m128 scale_v = _mm_set1_ps(scale);
+    int i = 0;
+    for (; i + 8 <= n_values; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(lo, scale_v));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(hi, scale_v));
+    }
+    convert_values_scalar(src + i, dst + i, n_values - i, scale);
+#else
+    convert_values_scalar(src, dst, n_values, scale);
+#endif
+}
+
+void L3GD20GyroscopeBase::convert_samples(const int16_t (*samples)[3], float *x, float *y, float *z, int n, float scale)
+{
+    int i = 0;
+
+#if L3GD20_CONVERT_NEON
+    for (; i + 4 <= n; i += 4) {
+        // load 4 samples with deinterleaving
+        int16x4x3_t v = vld3_s16(&samples[i][0]);
+        vst1q_f32(x + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v.val[0])), scale));
+        vst1q_f32(y + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v.val[1])), scale));
+        vst1q_f32(z + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v.val[2])), scale));
+    }
+#elif L3GD20_CONVERT_SSE2
+    __m128 scale_v = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        const int16_t *src = &samples[i][0];
+        // a = (x0, y0, z0, x1), b = (y1, z1, x2, y2), c = (z2, x3, y3, z3)
+        __m128 a = _mm_mul_ps(load_4_values(src), scale_v);
+        __m128 b = _mm_mul_ps(load_4_values(src + 4), scale_v);
+        __m128 c = _mm_mul_ps(load_4_values(src + 8), scale_v);
+        // p = (x2, y2, x3, y3), q = (y0, z0, y1, z1)
+        __m128 p = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+        __m128 q = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+        _mm_storeu_ps(x + i, _mm_shuffle_ps(a, p, _MM_SHUFFLE(2, 0, 3, 0)));
+        _mm_storeu_ps(y + i, _mm_shuffle_ps(q, p, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm_storeu_ps(z + i, _mm_shuffle_ps(q, c, _MM_SHUFFLE(3, 0, 3, 1)));
+    }
+#endif
+    // remaining samples
+    // note: CMSIS-DSP has no deinterleaving conversion, so scalar code is used with it
+    convert_planar_scalar(samples, x, y, z, i, n, scale);
+}
+
+void L3GD20GyroscopeBase::convert_samples(const int16_t (*samples)[3], int32_t (*data)[3], int n, FixedScale scale)
+{
+    const int16_t *src = &samples[0][0];
+    int32_t *dst = &data[0][0];
+    int n_values = n * 3;
+    const int32_t multiplier = scale.multiplier;
+    const int shift = scale.shift;
+    const int32_t rounding = shift > 0 ? (int32_t)1 << (shift - 1) : 0;
+
+    // note: the product fits into 32 bits as multiplier is less than 2^16,
+    // and right shift of negative values is arithmetic with supported compilers
+    for (int i = 0; i < n_values; i++) {
+        dst[i] = (src[i] * multiplier + rounding) >> shift;
+    }
+}
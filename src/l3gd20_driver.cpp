@@ -3,22 +3,27 @@
 using namespace l3gd20;
 
 L3GD20Gyroscope::L3GD20Gyroscope(I2C *i2c_ptr)
-    : _register_device(i2c_ptr)
+    : L3GD20GyroscopeT<DynamicBus>(i2c_ptr)
 {
 }
 
 L3GD20Gyroscope::L3GD20Gyroscope(PinName sda, PinName scl)
-    : _register_device(sda, scl)
+    : L3GD20GyroscopeT<DynamicBus>(sda, scl)
 {
 }
 
 L3GD20Gyroscope::L3GD20Gyroscope(SPI *spi_ptr, PinName ssel)
-    : _register_device(spi_ptr, ssel)
+    : L3GD20GyroscopeT<DynamicBus>(spi_ptr, ssel)
 {
 }
 
 L3GD20Gyroscope::L3GD20Gyroscope(PinName mosi, PinName miso, PinName sclk, PinName ssel)
-    : _register_device(mosi, miso, sclk, ssel)
+    : L3GD20GyroscopeT<DynamicBus>(mosi, miso, sclk, ssel)
+{
+}
+
+L3GD20Gyroscope::L3GD20Gyroscope(RegisterTransport *transport_ptr)
+    : L3GD20GyroscopeT<DynamicBus>(transport_ptr)
 {
 }
 
@@ -26,7 +31,8 @@ L3GD20Gyroscope::~L3GD20Gyroscope()
 {
 }
 
-int L3GD20Gyroscope::init(bool start)
+template <typename Bus>
+int L3GD20GyroscopeT<Bus>::init(bool start)
 {
     // check device id
     uint8_t device_id;
@@ -41,63 +47,146 @@ int L3GD20Gyroscope::init(bool start)
     if (device_id != _DEVICE_ID) {
         return MBED_ERROR_CODE_INITIALIZATION_FAILED;
     }
-
-    // continuous data update and little endian data order
-    _register_device.update_register(CTRL_REG4_ADDR, 0x00, 0xC0);
-    // connect output to LPF2
-    _register_device.update_register(CTRL_REG5_ADDR, 0x03, 0x03);
+    // drop cached values as device can be reset
+    _register_device.resync();
 
     // default settings
-    set_data_ready_interrupt_mode(DRDY_DISABLE);
-    set_fifo_mode(FIFO_DISABLE);
-    set_fifo_watermark(0);
-    set_full_scale(FULL_SCALE_250);
-    set_high_pass_filter_mode(HPF_DISABLE);
-    set_high_pass_filter_cutoff_freq_mode(HPF_CF0);
-    set_low_pass_filter_cutoff_freq_mode(LPF_CF0);
-    set_output_data_rate(ODR_95_HZ);
-    set_gyroscope_mode(start ? G_ENABLE : G_DISABLE);
+    GyroConfig config;
+    config.gyroscope_mode = start ? G_ENABLE : G_DISABLE;
+    apply(config);
 
     return MBED_SUCCESS;
 }
 
-uint8_t L3GD20Gyroscope::read_register(uint8_t reg)
+template <typename Bus>
+uint8_t L3GD20GyroscopeT<Bus>::read_register(uint8_t reg)
 {
     return _register_device.read_register(reg);
 }
 
-void L3GD20Gyroscope::write_register(uint8_t reg, uint8_t val)
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::write_register(uint8_t reg, uint8_t val)
 {
     _register_device.write_register(reg, val);
 }
 
-void L3GD20Gyroscope::set_gyroscope_mode(GyroscopeMode mode)
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_register_cache_mode(RegisterCacheMode mode)
 {
-    _register_device.update_register(CTRL_REG1_ADDR, mode, 0x0F);
+    _register_device.set_cache_mode(mode == REG_CACHE_ENABLE);
 }
 
-L3GD20Gyroscope::GyroscopeMode L3GD20Gyroscope::get_gyroscope_mode()
+template <typename Bus>
+L3GD20GyroscopeBase::RegisterCacheMode L3GD20GyroscopeT<Bus>::get_register_cache_mode()
 {
-    if (_register_device.read_register(CTRL_REG1_ADDR, 0x08)) {
-        return G_ENABLE;
+    return _register_device.get_cache_mode() ? REG_CACHE_ENABLE : REG_CACHE_DISABLE;
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::resync()
+{
+    _register_device.resync();
+    _update_sensitivity(get_full_scale());
+}
+
+// CTRL_REG1 power down mode bit
+static const uint8_t CTRL_REG1_PD = 0x08;
+
+/**
+ * Get CTRL_REG1 power down and axes enable bits of the gyroscope mode.
+ */
+static uint8_t get_power_bits(L3GD20GyroscopeBase::GyroscopeMode mode, uint8_t axes)
+{
+    switch (mode) {
+        case L3GD20GyroscopeBase::G_ENABLE:
+            // the device can't be enabled without axes
+            return CTRL_REG1_PD | (axes ? axes : (uint8_t)L3GD20GyroscopeBase::AXIS_ALL_ENABLE);
+        case L3GD20GyroscopeBase::G_SLEEP:
+            return CTRL_REG1_PD;
+        default:
+            return axes;
+    }
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_gyroscope_mode(GyroscopeMode mode)
+{
+    if (mode == G_SLEEP) {
+        _register_device.update_register(CTRL_REG1_ADDR, CTRL_REG1_PD, CTRL_REG1_PD | AXIS_ALL_ENABLE);
+    } else if (mode == G_DISABLE) {
+        _register_device.update_register(CTRL_REG1_ADDR, 0x00, CTRL_REG1_PD);
     } else {
+        uint8_t val = _register_device.read_register(CTRL_REG1_ADDR);
+        _register_device.write_register(CTRL_REG1_ADDR, (val & ~0x0F) | get_power_bits(G_ENABLE, val & AXIS_ALL_ENABLE));
+    }
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_gyroscope_mode(GyroscopeMode mode, uint8_t axes)
+{
+    if ((axes & ~AXIS_ALL_ENABLE) || (mode == G_ENABLE && !axes)) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid axes");
+    }
+    _register_device.update_register(CTRL_REG1_ADDR, get_power_bits(mode, axes), CTRL_REG1_PD | AXIS_ALL_ENABLE);
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::GyroscopeMode L3GD20GyroscopeT<Bus>::get_gyroscope_mode()
+{
+    uint8_t val = _register_device.read_register(CTRL_REG1_ADDR, 0x0F);
+    if (!(val & CTRL_REG1_PD)) {
         return G_DISABLE;
+    } else if (!(val & AXIS_ALL_ENABLE)) {
+        return G_SLEEP;
+    } else {
+        return G_ENABLE;
     }
 }
 
-void L3GD20Gyroscope::set_output_data_rate(OutputDataRate odr)
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_axes(uint8_t axes)
+{
+    if (axes & ~AXIS_ALL_ENABLE) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid axes");
+    }
+    _register_device.update_register(CTRL_REG1_ADDR, axes, AXIS_ALL_ENABLE);
+}
+
+template <typename Bus>
+uint8_t L3GD20GyroscopeT<Bus>::get_axes()
+{
+    return _register_device.read_register(CTRL_REG1_ADDR, AXIS_ALL_ENABLE);
+}
+
+// 1% settling time of the first order filter in periods of the cutoff frequency: ln(100) / (2 * pi)
+static const float FILTER_SETTLING_PERIODS = 0.733f;
+
+template <typename Bus>
+int L3GD20GyroscopeT<Bus>::get_settling_sample_count()
+{
+    float odr_hz = get_output_data_rate_hz();
+    float settling_time = FILTER_SETTLING_PERIODS / get_low_pass_filter_cut_off_frequency();
+    if (get_high_pass_filter_mode() == HPF_ENABLE) {
+        settling_time += FILTER_SETTLING_PERIODS / get_high_pass_filter_cut_off_frequency();
+    }
+    return 1 + (int)ceilf(settling_time * odr_hz);
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_output_data_rate(OutputDataRate odr)
 {
     _register_device.update_register(CTRL_REG1_ADDR, odr, 0xC0);
 }
 
-static const L3GD20Gyroscope::OutputDataRate ODR_MODE_MAP[] = {
-    L3GD20Gyroscope::ODR_95_HZ,
-    L3GD20Gyroscope::ODR_190_HZ,
-    L3GD20Gyroscope::ODR_380_HZ,
-    L3GD20Gyroscope::ODR_760_HZ,
+static const L3GD20GyroscopeBase::OutputDataRate ODR_MODE_MAP[] = {
+    L3GD20GyroscopeBase::ODR_95_HZ,
+    L3GD20GyroscopeBase::ODR_190_HZ,
+    L3GD20GyroscopeBase::ODR_380_HZ,
+    L3GD20GyroscopeBase::ODR_760_HZ,
 };
 
-L3GD20Gyroscope::OutputDataRate L3GD20Gyroscope::get_output_data_rate()
+template <typename Bus>
+L3GD20GyroscopeBase::OutputDataRate L3GD20GyroscopeT<Bus>::get_output_data_rate()
 {
     uint8_t i = _register_device.read_register(CTRL_REG1_ADDR, 0xC0) >> 6;
     return ODR_MODE_MAP[i];
@@ -110,25 +199,28 @@ static const float ODR_FREQ_MAP[] = {
     760.0f,
 };
 
-float L3GD20Gyroscope::get_output_data_rate_hz()
+template <typename Bus>
+float L3GD20GyroscopeT<Bus>::get_output_data_rate_hz()
 {
     uint8_t val = _register_device.read_register(CTRL_REG1_ADDR, 0xC0) >> 6;
     return ODR_FREQ_MAP[val];
 }
 
-void L3GD20Gyroscope::set_low_pass_filter_cutoff_freq_mode(LowPassFilterCutoffFreqMode mode)
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_low_pass_filter_cutoff_freq_mode(LowPassFilterCutoffFreqMode mode)
 {
     _register_device.update_register(CTRL_REG1_ADDR, mode, 0x30);
 }
 
-static const L3GD20Gyroscope::LowPassFilterCutoffFreqMode LPF_CF_MODE_MAP[] = {
-    L3GD20Gyroscope::LPF_CF0,
-    L3GD20Gyroscope::LPF_CF0,
-    L3GD20Gyroscope::LPF_CF0,
-    L3GD20Gyroscope::LPF_CF0,
+static const L3GD20GyroscopeBase::LowPassFilterCutoffFreqMode LPF_CF_MODE_MAP[] = {
+    L3GD20GyroscopeBase::LPF_CF0,
+    L3GD20GyroscopeBase::LPF_CF1,
+    L3GD20GyroscopeBase::LPF_CF2,
+    L3GD20GyroscopeBase::LPF_CF3,
 };
 
-L3GD20Gyroscope::LowPassFilterCutoffFreqMode L3GD20Gyroscope::get_low_pass_filter_cutoff_freq_mode()
+template <typename Bus>
+L3GD20GyroscopeBase::LowPassFilterCutoffFreqMode L3GD20GyroscopeT<Bus>::get_low_pass_filter_cutoff_freq_mode()
 {
     uint8_t i = _register_device.read_register(CTRL_REG1_ADDR, 0x30) >> 4;
     return LPF_CF_MODE_MAP[i];
@@ -136,7 +228,7 @@ L3GD20Gyroscope::LowPassFilterCutoffFreqMode L3GD20Gyroscope::get_low_pass_filte
 
 static const float LPF_CF_FREQ_MAP[] = {
     // odr 95 Hz
-    15.5f,
+    12.5f,
     25.0f,
     25.0f,
     25.0f,
@@ -157,18 +249,21 @@ static const float LPF_CF_FREQ_MAP[] = {
     100.0f
 };
 
-float L3GD20Gyroscope::get_low_pass_filter_cut_off_frequency()
+template <typename Bus>
+float L3GD20GyroscopeT<Bus>::get_low_pass_filter_cut_off_frequency()
 {
     uint8_t i = _register_device.read_register(CTRL_REG1_ADDR, 0xF0) >> 4;
     return LPF_CF_FREQ_MAP[i];
 }
 
-void L3GD20Gyroscope::set_high_pass_filter_mode(HighPassFilterMode mode)
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_high_pass_filter_mode(HighPassFilterMode mode)
 {
     _register_device.update_register(CTRL_REG5_ADDR, mode, 0x10);
 }
 
-L3GD20Gyroscope::HighPassFilterMode L3GD20Gyroscope::get_high_pass_filter_mode()
+template <typename Bus>
+L3GD20GyroscopeBase::HighPassFilterMode L3GD20GyroscopeT<Bus>::get_high_pass_filter_mode()
 {
     if (_register_device.read_register(CTRL_REG5_ADDR, 0x10)) {
         return HPF_ENABLE;
@@ -177,25 +272,27 @@ L3GD20Gyroscope::HighPassFilterMode L3GD20Gyroscope::get_high_pass_filter_mode()
     }
 }
 
-void L3GD20Gyroscope::set_high_pass_filter_cutoff_freq_mode(HighPassFilterCutoffFreqMode mode)
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_high_pass_filter_cutoff_freq_mode(HighPassFilterCutoffFreqMode mode)
 {
     _register_device.update_register(CTRL_REG2_ADDR, mode, 0x0F);
 }
 
-static const L3GD20Gyroscope::HighPassFilterCutoffFreqMode HPF_CF_MODE_MAP[] = {
-    L3GD20Gyroscope::HPF_CF0,
-    L3GD20Gyroscope::HPF_CF1,
-    L3GD20Gyroscope::HPF_CF2,
-    L3GD20Gyroscope::HPF_CF3,
-    L3GD20Gyroscope::HPF_CF4,
-    L3GD20Gyroscope::HPF_CF5,
-    L3GD20Gyroscope::HPF_CF6,
-    L3GD20Gyroscope::HPF_CF7,
-    L3GD20Gyroscope::HPF_CF8,
-    L3GD20Gyroscope::HPF_CF9,
+static const L3GD20GyroscopeBase::HighPassFilterCutoffFreqMode HPF_CF_MODE_MAP[] = {
+    L3GD20GyroscopeBase::HPF_CF0,
+    L3GD20GyroscopeBase::HPF_CF1,
+    L3GD20GyroscopeBase::HPF_CF2,
+    L3GD20GyroscopeBase::HPF_CF3,
+    L3GD20GyroscopeBase::HPF_CF4,
+    L3GD20GyroscopeBase::HPF_CF5,
+    L3GD20GyroscopeBase::HPF_CF6,
+    L3GD20GyroscopeBase::HPF_CF7,
+    L3GD20GyroscopeBase::HPF_CF8,
+    L3GD20GyroscopeBase::HPF_CF9,
 };
 
-L3GD20Gyroscope::HighPassFilterCutoffFreqMode L3GD20Gyroscope::get_high_pass_filter_cutoff_freq_mode()
+template <typename Bus>
+L3GD20GyroscopeBase::HighPassFilterCutoffFreqMode L3GD20GyroscopeT<Bus>::get_high_pass_filter_cutoff_freq_mode()
 {
     uint8_t i = _register_device.read_register(CTRL_REG2_ADDR, 0x0F);
     if (i >= 10) {
@@ -257,7 +354,8 @@ static const float HPF_CF_FREQ_MAP[] = {
     0.09f,
 };
 
-float L3GD20Gyroscope::get_high_pass_filter_cut_off_frequency()
+template <typename Bus>
+float L3GD20GyroscopeT<Bus>::get_high_pass_filter_cut_off_frequency()
 {
     uint8_t hfp_cf_mode = _register_device.read_register(CTRL_REG2_ADDR, 0x0F);
     if (hfp_cf_mode >= 10) {
@@ -268,11 +366,11 @@ float L3GD20Gyroscope::get_high_pass_filter_cut_off_frequency()
     return HPF_CF_FREQ_MAP[i];
 }
 
-static const L3GD20Gyroscope::FullScale FS_MODE_MAP[] = {
-    L3GD20Gyroscope::FULL_SCALE_250,
-    L3GD20Gyroscope::FULL_SCALE_500,
-    L3GD20Gyroscope::FULL_SCALE_1000,
-    L3GD20Gyroscope::FULL_SCALE_2000,
+static const L3GD20GyroscopeBase::FullScale FS_MODE_MAP[] = {
+    L3GD20GyroscopeBase::FULL_SCALE_250,
+    L3GD20GyroscopeBase::FULL_SCALE_500,
+    L3GD20GyroscopeBase::FULL_SCALE_1000,
+    L3GD20GyroscopeBase::FULL_SCALE_2000,
 };
 
 static const float SENSITIVITY_MAP[] = {
@@ -284,33 +382,55 @@ static const float SENSITIVITY_MAP[] = {
 
 static const float RADIAN_PER_DEGREE = 0.017453292519943295f;
 
-void L3GD20Gyroscope::set_full_scale(FullScale fs)
+// fixed-point sensitivities are 8.75 mdps/LSB * 2^fs_index, so they share multipliers
+// and differ by shift (see L3GD20GyroscopeBase::FixedScale)
+static const int32_t FIXED_DPS_MULTIPLIER = 36700; // 8.75e-3 * 2^22
+static const int FIXED_DPS_SHIFT = 6;
+static const int32_t FIXED_RPS_MULTIPLIER = 40994; // 8.75e-3 * pi / 180 * 2^28
+static const int FIXED_RPS_SHIFT = 12;
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_full_scale(FullScale fs)
 {
     _register_device.update_register(CTRL_REG4_ADDR, fs, 0x30);
-    uint8_t i = (fs & 0x30) >> 4;
-    _gyro_sensitivity_dps = SENSITIVITY_MAP[i];
-    _gyro_sensitivity_rps = _gyro_sensitivity_dps * RADIAN_PER_DEGREE;
+    _update_sensitivity(fs);
 }
 
-L3GD20Gyroscope::FullScale L3GD20Gyroscope::get_full_scale()
+template <typename Bus>
+L3GD20GyroscopeBase::FullScale L3GD20GyroscopeT<Bus>::get_full_scale()
 {
     uint8_t i = _register_device.read_register(CTRL_REG4_ADDR, 0x30) >> 4;
     return FS_MODE_MAP[i];
 }
 
-float L3GD20Gyroscope::get_sensitivity()
+template <typename Bus>
+float L3GD20GyroscopeT<Bus>::get_sensitivity()
 {
     uint8_t i = _register_device.read_register(CTRL_REG4_ADDR, 0x30) >> 4;
     return SENSITIVITY_MAP[i] * RADIAN_PER_DEGREE;
 }
 
-float L3GD20Gyroscope::get_sensitivity_dps()
+template <typename Bus>
+float L3GD20GyroscopeT<Bus>::get_sensitivity_dps()
 {
     uint8_t i = _register_device.read_register(CTRL_REG4_ADDR, 0x30) >> 4;
     return SENSITIVITY_MAP[i];
 }
 
-void L3GD20Gyroscope::set_fifo_mode(FIFOMode mode)
+template <typename Bus>
+L3GD20GyroscopeBase::FixedScale L3GD20GyroscopeT<Bus>::get_sensitivity_q16()
+{
+    return _gyro_scale_rps_q16;
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::FixedScale L3GD20GyroscopeT<Bus>::get_sensitivity_dps_q16()
+{
+    return _gyro_scale_dps_q16;
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_fifo_mode(FIFOMode mode)
 {
     if (mode) {
         _register_device.update_register(FIFO_CTRL_REG_ADDR, 0x40, 0xE0); // configure FIFO stream mode
@@ -322,7 +442,8 @@ void L3GD20Gyroscope::set_fifo_mode(FIFOMode mode)
     _update_interrupt_register(2);
 }
 
-L3GD20Gyroscope::FIFOMode L3GD20Gyroscope::get_fifo_mode()
+template <typename Bus>
+L3GD20GyroscopeBase::FIFOMode L3GD20GyroscopeT<Bus>::get_fifo_mode()
 {
     if (_register_device.read_register(CTRL_REG5_ADDR, 0x40)) {
         return FIFO_ENABLE;
@@ -331,7 +452,8 @@ L3GD20Gyroscope::FIFOMode L3GD20Gyroscope::get_fifo_mode()
     }
 }
 
-void L3GD20Gyroscope::set_fifo_watermark(int watermark)
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_fifo_watermark(int watermark)
 {
     if (watermark < 0 || watermark >= 32) {
         MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid watermark value");
@@ -339,12 +461,14 @@ void L3GD20Gyroscope::set_fifo_watermark(int watermark)
     _register_device.update_register(FIFO_CTRL_REG_ADDR, (uint8_t)watermark, 0x1F);
 }
 
-int L3GD20Gyroscope::get_fifo_watermark()
+template <typename Bus>
+int L3GD20GyroscopeT<Bus>::get_fifo_watermark()
 {
     return _register_device.read_register(FIFO_CTRL_REG_ADDR, 0x1F);
 }
 
-void L3GD20Gyroscope::clear_fifo()
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::clear_fifo()
 {
     uint8_t fifo_mode = _register_device.read_register(FIFO_CTRL_REG_ADDR, 0xC0);
     if (fifo_mode != 0) {
@@ -355,7 +479,142 @@ void L3GD20Gyroscope::clear_fifo()
     }
 }
 
-void L3GD20Gyroscope::set_data_ready_interrupt_mode(DataReadyInterruptMode drdy_mode)
+L3GD20GyroscopeBase::FIFOStatus L3GD20GyroscopeBase::decode_fifo_status(uint8_t fifo_src)
+{
+    FIFOStatus status;
+    status.watermark = (fifo_src & 0x80) != 0;
+    status.overrun = (fifo_src & 0x40) != 0;
+    status.empty = (fifo_src & 0x20) != 0;
+    // FIFO level field has only 5 bits, so full FIFO is indicated by overrun flag
+    status.level = status.overrun ? FIFO_SIZE : fifo_src & 0x1F;
+    return status;
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::FIFOStatus L3GD20GyroscopeT<Bus>::read_fifo_status()
+{
+    return decode_fifo_status(_register_device.read_volatile_register(FIFO_SRC_REG_ADDR));
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::FIFOStatus L3GD20GyroscopeT<Bus>::get_last_fifo_status()
+{
+    return _last_fifo_status;
+}
+
+template <typename Bus>
+uint32_t L3GD20GyroscopeT<Bus>::get_fifo_overrun_count()
+{
+    return _fifo_overrun_count;
+}
+
+template <typename Bus>
+int L3GD20GyroscopeT<Bus>::read_fifo(int16_t (*samples)[3], int max_samples)
+{
+    int n = _read_fifo_level(max_samples);
+    if (n <= 0) {
+        return 0;
+    }
+
+    // read all samples at once
+    // note: output registers address rolls back from OUT_Z_H to OUT_X_L, if FIFO is enabled
+    uint8_t *raw_data = (uint8_t *)samples;
+    _register_device.read_volatile_registers(OUT_X_L_ADDR, raw_data, (uint8_t)(n * 6));
+    // convert data in place
+    decode_samples(raw_data, samples, n);
+    L3GD20_STATS_ADD(_stats, samples_read, n);
+    return n;
+}
+
+template <typename Bus>
+int L3GD20GyroscopeT<Bus>::read_fifo(int16_t (*samples)[3], int8_t *temperature, int max_samples)
+{
+    int n = _read_fifo_level(max_samples);
+    if (n <= 0) {
+        return 0;
+    }
+
+    // read OUT_TEMP, STATUS_REG and all samples at once
+    // note: the samples buffer has no space for 2 extra bytes, so the data is read into a local buffer
+    uint8_t raw_data[2 + FIFO_SIZE * 6];
+    _register_device.read_volatile_registers(OUT_TEMP_ADDR, raw_data, (uint8_t)(2 + n * 6));
+    *temperature = (int8_t)raw_data[0];
+    decode_samples(raw_data + 2, samples, n);
+    L3GD20_STATS_ADD(_stats, samples_read, n);
+    return n;
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::FIFOView L3GD20GyroscopeT<Bus>::read_fifo_view(void *buffer, size_t size, bool read_temperature)
+{
+    if ((uintptr_t)buffer & 0x01) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "FIFO view buffer should be aligned to 2 bytes");
+    }
+    uint8_t *raw_data = (uint8_t *)buffer;
+    size_t offset = read_temperature ? FIFO_VIEW_TEMPERATURE_OFFSET : 0;
+    FIFOView view;
+    view.samples = (int16_t(*)[3])(raw_data + offset);
+    view.n_samples = 0;
+    view.temperature = 0;
+    if (size < offset + 6) {
+        return view;
+    }
+    int n = _read_fifo_level((int)((size - offset) / 6));
+    if (n <= 0) {
+        return view;
+    }
+
+    // read (OUT_TEMP, STATUS_REG and) all samples at once directly into the caller buffer
+    _register_device.read_volatile_registers(read_temperature ? OUT_TEMP_ADDR : OUT_X_L_ADDR, raw_data, (uint8_t)(offset + n * 6));
+    if (read_temperature) {
+        view.temperature = (int8_t)raw_data[0];
+    }
+#if L3GD20_BIG_ENDIAN
+    decode_samples(raw_data + offset, view.samples, n);
+#endif
+    view.n_samples = n;
+    L3GD20_STATS_ADD(_stats, samples_read, n);
+    return view;
+}
+
+template <typename Bus>
+int L3GD20GyroscopeT<Bus>::read_fifo_async(uint8_t *buffer, int n_samples, const Callback<void(int)> &callback)
+{
+    if (n_samples <= 0 || n_samples > FIFO_SIZE) {
+        return MBED_ERROR_CODE_INVALID_ARGUMENT;
+    }
+    int err = _register_device.read_registers_async(OUT_X_L_ADDR, buffer, (uint8_t)(n_samples * 6), callback);
+    if (!err) {
+        L3GD20_STATS_ADD(_stats, samples_read, n_samples);
+    }
+    return err;
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::abort_fifo_async()
+{
+    _register_device.abort_async();
+}
+
+void L3GD20GyroscopeBase::decode_samples(const uint8_t *raw_data, int16_t (*samples)[3], int n)
+{
+#if L3GD20_BIG_ENDIAN
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < 3; j++) {
+            const uint8_t *raw_value = raw_data + i * 6 + j * 2;
+            samples[i][j] = (int16_t)((raw_value[1] << 8) | raw_value[0]);
+        }
+    }
+#else
+    // little-endian raw data has sample layout
+    if ((const void *)raw_data != (const void *)samples) {
+        memmove(samples, raw_data, n * sizeof(samples[0]));
+    }
+#endif
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_data_ready_interrupt_mode(DataReadyInterruptMode drdy_mode)
 {
     if (drdy_mode) {
         _update_interrupt_register(1);
@@ -364,12 +623,211 @@ void L3GD20Gyroscope::set_data_ready_interrupt_mode(DataReadyInterruptMode drdy_
     }
 }
 
-L3GD20Gyroscope::DataReadyInterruptMode L3GD20Gyroscope::get_data_ready_interrupt_mode()
+template <typename Bus>
+L3GD20GyroscopeBase::DataReadyInterruptMode L3GD20GyroscopeT<Bus>::get_data_ready_interrupt_mode()
 {
     return _update_interrupt_register(3);
 }
 
-void L3GD20Gyroscope::read_data(float data[3])
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_fifo_interrupt_mode(FIFOInterruptMode mode)
+{
+    _register_device.update_register(CTRL_REG3_ADDR, mode, 0x03);
+}
+
+static const L3GD20GyroscopeBase::FIFOInterruptMode FIFO_INT_MODE_MAP[] = {
+    L3GD20GyroscopeBase::FIFO_INT_DISABLE,
+    L3GD20GyroscopeBase::FIFO_INT_EMPTY,
+    L3GD20GyroscopeBase::FIFO_INT_OVERRUN,
+    L3GD20GyroscopeBase::FIFO_INT_OVERRUN_EMPTY,
+};
+
+template <typename Bus>
+L3GD20GyroscopeBase::FIFOInterruptMode L3GD20GyroscopeT<Bus>::get_fifo_interrupt_mode()
+{
+    return FIFO_INT_MODE_MAP[_register_device.read_register(CTRL_REG3_ADDR, 0x03)];
+}
+
+// INT1_CFG bits
+static const uint8_t INT1_CFG_AND_OR = 0x80;
+static const uint8_t INT1_CFG_LIR = 0x40;
+static const uint8_t INT1_CFG_EVENTS_MASK = 0x3F;
+// INT1_DURATION bits
+static const uint8_t INT1_DURATION_WAIT = 0x80;
+static const uint8_t INT1_DURATION_MASK = 0x7F;
+// CTRL_REG3 INT1 pin enable bit
+static const uint8_t CTRL_REG3_I1_INT1 = 0x80;
+// CTRL_REG5 INT1_Sel field and its high-pass filter value
+static const uint8_t CTRL_REG5_INT1_SEL_MASK = 0x0C;
+static const uint8_t CTRL_REG5_INT1_SEL_HPF = 0x04;
+static const uint16_t MAX_MOTION_THRESHOLD = 0x7FFF;
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::set_motion_interrupt(const MotionInterruptConfig &config)
+{
+    if ((config.events & ~INT1_CFG_EVENTS_MASK) || config.duration > INT1_DURATION_MASK) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid motion interrupt configuration");
+    }
+    // INT1_TSH_XH-INT1_TSH_ZL and INT1_DURATION are consecutive registers
+    uint8_t data[7];
+    for (int i = 0; i < 3; i++) {
+        if (config.threshold[i] > MAX_MOTION_THRESHOLD) {
+            MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid motion interrupt threshold");
+        }
+        data[i * 2] = config.threshold[i] >> 8;
+        data[i * 2 + 1] = config.threshold[i] & 0xFF;
+    }
+    data[6] = config.duration | (config.wait ? INT1_DURATION_WAIT : 0x00);
+    _register_device.write_registers(INT1_TSH_XH_ADDR, data, 7);
+
+    uint8_t int1_cfg = config.events;
+    int1_cfg |= config.and_combination ? INT1_CFG_AND_OR : 0x00;
+    int1_cfg |= config.latch ? INT1_CFG_LIR : 0x00;
+    _register_device.write_register(INT1_CFG_ADDR, int1_cfg);
+    _register_device.update_register(CTRL_REG5_ADDR, config.high_pass_filter ? CTRL_REG5_INT1_SEL_HPF : 0x00, CTRL_REG5_INT1_SEL_MASK);
+    _register_device.update_register(CTRL_REG3_ADDR, config.events ? CTRL_REG3_I1_INT1 : 0x00, CTRL_REG3_I1_INT1);
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::MotionInterruptConfig L3GD20GyroscopeT<Bus>::get_motion_interrupt()
+{
+    MotionInterruptConfig config;
+    uint8_t data[7];
+    _register_device.read_registers(INT1_TSH_XH_ADDR, data, 7);
+    for (int i = 0; i < 3; i++) {
+        config.threshold[i] = ((data[i * 2] << 8) | data[i * 2 + 1]) & MAX_MOTION_THRESHOLD;
+    }
+    config.duration = data[6] & INT1_DURATION_MASK;
+    config.wait = (data[6] & INT1_DURATION_WAIT) != 0;
+
+    uint8_t int1_cfg = _register_device.read_register(INT1_CFG_ADDR);
+    config.events = int1_cfg & INT1_CFG_EVENTS_MASK;
+    config.and_combination = (int1_cfg & INT1_CFG_AND_OR) != 0;
+    config.latch = (int1_cfg & INT1_CFG_LIR) != 0;
+    config.high_pass_filter = _register_device.read_register(CTRL_REG5_ADDR, CTRL_REG5_INT1_SEL_MASK) == CTRL_REG5_INT1_SEL_HPF;
+    return config;
+}
+
+template <typename Bus>
+uint8_t L3GD20GyroscopeT<Bus>::read_motion_interrupt_source()
+{
+    return _register_device.read_volatile_register(INT1_SRC_ADDR);
+}
+
+template <typename Bus>
+uint16_t L3GD20GyroscopeT<Bus>::get_motion_threshold(float rate_dps)
+{
+    float threshold = fabsf(rate_dps) / _gyro_sensitivity_dps + 0.5f;
+    if (!(threshold < MAX_MOTION_THRESHOLD)) {
+        return MAX_MOTION_THRESHOLD;
+    }
+    return (uint16_t)threshold;
+}
+
+L3GD20GyroscopeBase::MotionInterruptConfig::MotionInterruptConfig()
+    : events(0)
+    , and_combination(false)
+    , latch(true)
+    , duration(0)
+    , wait(false)
+    , high_pass_filter(false)
+{
+    threshold[0] = threshold[1] = threshold[2] = 0;
+}
+
+L3GD20GyroscopeBase::GyroConfig::GyroConfig()
+    : gyroscope_mode(G_ENABLE)
+    , axes(AXIS_ALL_ENABLE)
+    , output_data_rate(ODR_95_HZ)
+    , low_pass_filter_cutoff_freq_mode(LPF_CF0)
+    , high_pass_filter_mode(HPF_DISABLE)
+    , high_pass_filter_cutoff_freq_mode(HPF_CF0)
+    , full_scale(FULL_SCALE_250)
+    , fifo_mode(FIFO_DISABLE)
+    , fifo_watermark(0)
+    , data_ready_interrupt_mode(DRDY_DISABLE)
+    , fifo_interrupt_mode(FIFO_INT_DISABLE)
+{
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::apply(const GyroConfig &config)
+{
+    if (config.fifo_watermark < 0 || config.fifo_watermark >= 32) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid watermark value");
+    }
+    if (config.axes & ~AXIS_ALL_ENABLE) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid axes");
+    }
+
+    uint8_t ctrl_regs[5];
+    uint8_t new_ctrl_regs[5];
+    uint8_t fifo_ctrl_reg;
+    uint8_t new_fifo_ctrl_reg;
+    _register_device.read_registers(CTRL_REG1_ADDR, ctrl_regs, 5);
+    fifo_ctrl_reg = _register_device.read_register(FIFO_CTRL_REG_ADDR);
+
+    // CTRL_REG1: output data rate, bandwidth and power mode
+    new_ctrl_regs[0] = config.output_data_rate | config.low_pass_filter_cutoff_freq_mode;
+    new_ctrl_regs[0] |= get_power_bits(config.gyroscope_mode, config.axes);
+    // CTRL_REG2: high pass filter cutoff frequency (keep high pass filter mode)
+    new_ctrl_regs[1] = (ctrl_regs[1] & 0xF0) | config.high_pass_filter_cutoff_freq_mode;
+    // CTRL_REG3: INT2 interrupts (keep INT1 and pin configuration)
+    new_ctrl_regs[2] = (ctrl_regs[2] & 0xF0) | config.fifo_interrupt_mode;
+    if (config.data_ready_interrupt_mode) {
+        // watermark or DRDY interrupt
+        new_ctrl_regs[2] |= config.fifo_mode ? 0x04 : 0x08;
+    }
+    // CTRL_REG4: continuous data update, little endian data order and full scale (keep SPI mode)
+    new_ctrl_regs[3] = (ctrl_regs[3] & 0x0F) | config.full_scale;
+    // CTRL_REG5: FIFO, high pass filter and connect output to LPF2 (keep INT1 source)
+    new_ctrl_regs[4] = (ctrl_regs[4] & 0x0C) | (config.fifo_mode ? 0x40 : 0x00) | config.high_pass_filter_mode | 0x03;
+    // FIFO_CTRL_REG: stream or bypass mode and watermark
+    new_fifo_ctrl_reg = (config.fifo_mode ? 0x40 : 0x00) | (uint8_t)config.fifo_watermark;
+
+    bool update_ctrl_regs = memcmp(ctrl_regs, new_ctrl_regs, 5) != 0;
+    bool update_fifo_ctrl_reg = fifo_ctrl_reg != new_fifo_ctrl_reg;
+    // configure FIFO mode before FIFO enabling and after FIFO disabling
+    if (update_fifo_ctrl_reg && config.fifo_mode) {
+        _register_device.write_register(FIFO_CTRL_REG_ADDR, new_fifo_ctrl_reg);
+    }
+    if (update_ctrl_regs) {
+        _register_device.write_registers(CTRL_REG1_ADDR, new_ctrl_regs, 5);
+    }
+    if (update_fifo_ctrl_reg && !config.fifo_mode) {
+        _register_device.write_register(FIFO_CTRL_REG_ADDR, new_fifo_ctrl_reg);
+    }
+
+    _update_sensitivity(config.full_scale);
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::GyroConfig L3GD20GyroscopeT<Bus>::get_config()
+{
+    GyroConfig config;
+    uint8_t ctrl_regs[5];
+    uint8_t fifo_ctrl_reg;
+    _register_device.read_registers(CTRL_REG1_ADDR, ctrl_regs, 5);
+    fifo_ctrl_reg = _register_device.read_register(FIFO_CTRL_REG_ADDR);
+
+    config.gyroscope_mode = !(ctrl_regs[0] & CTRL_REG1_PD) ? G_DISABLE : (ctrl_regs[0] & AXIS_ALL_ENABLE) ? G_ENABLE : G_SLEEP;
+    config.axes = (ctrl_regs[0] & AXIS_ALL_ENABLE) ? (ctrl_regs[0] & AXIS_ALL_ENABLE) : AXIS_ALL_ENABLE;
+    config.output_data_rate = ODR_MODE_MAP[(ctrl_regs[0] & 0xC0) >> 6];
+    config.low_pass_filter_cutoff_freq_mode = LPF_CF_MODE_MAP[(ctrl_regs[0] & 0x30) >> 4];
+    uint8_t hpf_cf_mode = ctrl_regs[1] & 0x0F;
+    config.high_pass_filter_cutoff_freq_mode = HPF_CF_MODE_MAP[hpf_cf_mode >= 10 ? 9 : hpf_cf_mode];
+    config.data_ready_interrupt_mode = (ctrl_regs[2] & 0x0C) ? DRDY_ENABLE : DRDY_DISABLE;
+    config.fifo_interrupt_mode = FIFO_INT_MODE_MAP[ctrl_regs[2] & 0x03];
+    config.full_scale = FS_MODE_MAP[(ctrl_regs[3] & 0x30) >> 4];
+    config.fifo_mode = (ctrl_regs[4] & 0x40) ? FIFO_ENABLE : FIFO_DISABLE;
+    config.high_pass_filter_mode = (ctrl_regs[4] & 0x10) ? HPF_ENABLE : HPF_DISABLE;
+    config.fifo_watermark = fifo_ctrl_reg & 0x1F;
+
+    return config;
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::read_data(float data[3])
 {
     int16_t data_16[3];
     read_data_16(data_16);
@@ -378,7 +836,8 @@ void L3GD20Gyroscope::read_data(float data[3])
     data[2] = data_16[2] * _gyro_sensitivity_rps;
 }
 
-void L3GD20Gyroscope::read_data_dps(float data[3])
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::read_data_dps(float data[3])
 {
     int16_t data_16[3];
     read_data_16(data_16);
@@ -387,26 +846,115 @@ void L3GD20Gyroscope::read_data_dps(float data[3])
     data[2] = data_16[2] * _gyro_sensitivity_dps;
 }
 
-void L3GD20Gyroscope::read_data_16(int16_t data[3])
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::read_data_16(int16_t data[3])
 {
-    uint8_t raw_data[6];
-    _register_device.read_registers(OUT_X_L_ADDR, raw_data, 6);
-    data[0] = (int16_t)(raw_data[1] << 8) + raw_data[0];
-    data[1] = (int16_t)(raw_data[3] << 8) + raw_data[2];
-    data[2] = (int16_t)(raw_data[5] << 8) + raw_data[4];
+    // read output registers directly into the data and convert it in place
+    _register_device.read_volatile_registers(OUT_X_L_ADDR, (uint8_t *)data, 6);
+    decode_samples((const uint8_t *)data, (int16_t(*)[3])data, 1);
+    L3GD20_STATS_ADD(_stats, samples_read, 1);
 }
 
-int8_t L3GD20Gyroscope::read_temperature_8()
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::convert_data(const int16_t (*samples)[3], float (*data)[3], int n)
 {
-    return (int8_t)_register_device.read_register(OUT_TEMP_ADDR);
+    convert_samples(samples, data, n, _gyro_sensitivity_rps);
 }
 
-float L3GD20Gyroscope::get_temperature_sensor_sensitivity()
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::convert_data(const int16_t (*samples)[3], float *x, float *y, float *z, int n)
+{
+    convert_samples(samples, x, y, z, n, _gyro_sensitivity_rps);
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::convert_data_dps(const int16_t (*samples)[3], float (*data)[3], int n)
+{
+    convert_samples(samples, data, n, _gyro_sensitivity_dps);
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::convert_data_dps(const int16_t (*samples)[3], float *x, float *y, float *z, int n)
+{
+    convert_samples(samples, x, y, z, n, _gyro_sensitivity_dps);
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::read_data_q16(int32_t data[3])
+{
+    int16_t data_16[3];
+    read_data_16(data_16);
+    convert_samples(&data_16, (int32_t(*)[3])data, 1, _gyro_scale_rps_q16);
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::read_data_dps_q16(int32_t data[3])
+{
+    int16_t data_16[3];
+    read_data_16(data_16);
+    convert_samples(&data_16, (int32_t(*)[3])data, 1, _gyro_scale_dps_q16);
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::convert_data_q16(const int16_t (*samples)[3], int32_t (*data)[3], int n)
+{
+    convert_samples(samples, data, n, _gyro_scale_rps_q16);
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::convert_data_dps_q16(const int16_t (*samples)[3], int32_t (*data)[3], int n)
+{
+    convert_samples(samples, data, n, _gyro_scale_dps_q16);
+}
+
+template <typename Bus>
+int8_t L3GD20GyroscopeT<Bus>::read_temperature_8()
+{
+    return (int8_t)_register_device.read_volatile_register(OUT_TEMP_ADDR);
+}
+
+template <typename Bus>
+float L3GD20GyroscopeT<Bus>::get_temperature_sensor_sensitivity()
 {
     return -1.0f;
 }
 
-L3GD20Gyroscope::DataReadyInterruptMode L3GD20Gyroscope::_update_interrupt_register(int mode)
+template <typename Bus>
+L3GD20GyroscopeBase::Stats L3GD20GyroscopeT<Bus>::get_stats()
+{
+    Stats stats;
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    stats = _stats;
+#else
+    memset(&stats, 0, sizeof(stats));
+#endif
+    stats.bus = _register_device.get_stats();
+    return stats;
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::reset_stats()
+{
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    memset(&_stats, 0, sizeof(_stats));
+#endif
+    _register_device.reset_stats();
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::add_irq_masked_time(uint32_t time_us)
+{
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    _stats.irq_masked_count++;
+    _stats.irq_masked_time_us += time_us;
+    if (time_us > _stats.max_irq_masked_time_us) {
+        _stats.max_irq_masked_time_us = time_us;
+    }
+#endif
+}
+
+template <typename Bus>
+L3GD20GyroscopeBase::DataReadyInterruptMode L3GD20GyroscopeT<Bus>::_update_interrupt_register(int mode)
 {
     DataReadyInterruptMode res;
     FIFOMode fifo_mode;
@@ -414,8 +962,8 @@ L3GD20Gyroscope::DataReadyInterruptMode L3GD20Gyroscope::_update_interrupt_regis
 
     switch (mode) {
     case 0:
-        // disable interrupts
-        _register_device.update_register(CTRL_REG3_ADDR, 0x00, 0x0F);
+        // disable interrupts (keep FIFO overrun and empty interrupts)
+        _register_device.update_register(CTRL_REG3_ADDR, 0x00, 0x0C);
         res = DRDY_DISABLE;
         break;
     case 1:
@@ -423,10 +971,10 @@ L3GD20Gyroscope::DataReadyInterruptMode L3GD20Gyroscope::_update_interrupt_regis
         fifo_mode = get_fifo_mode();
         if (fifo_mode) {
             // watermark interrupt
-            _register_device.update_register(CTRL_REG3_ADDR, 0x04, 0x0F);
+            _register_device.update_register(CTRL_REG3_ADDR, 0x04, 0x0C);
         } else {
             // DRDY interrupt
-            _register_device.update_register(CTRL_REG3_ADDR, 0x08, 0x0F);
+            _register_device.update_register(CTRL_REG3_ADDR, 0x08, 0x0C);
         }
         res = DRDY_ENABLE;
         break;
@@ -441,7 +989,7 @@ L3GD20Gyroscope::DataReadyInterruptMode L3GD20Gyroscope::_update_interrupt_regis
         break;
     case 3:
         // check if register enabled/disabled
-        val = _register_device.read_register(CTRL_REG3_ADDR, 0x0F);
+        val = _register_device.read_register(CTRL_REG3_ADDR, 0x0C);
         res = val ? DRDY_ENABLE : DRDY_DISABLE;
         break;
     default:
@@ -449,3 +997,35 @@ L3GD20Gyroscope::DataReadyInterruptMode L3GD20Gyroscope::_update_interrupt_regis
     }
     return res;
 }
+
+template <typename Bus>
+int L3GD20GyroscopeT<Bus>::_read_fifo_level(int max_samples)
+{
+    _last_fifo_status = read_fifo_status();
+    if (_last_fifo_status.overrun) {
+        _fifo_overrun_count++;
+    }
+    int n = _last_fifo_status.level;
+    L3GD20_STATS_ADD(_stats, fifo_level_histogram[n], 1);
+    if (n > max_samples) {
+        n = max_samples;
+    }
+    return n;
+}
+
+template <typename Bus>
+void L3GD20GyroscopeT<Bus>::_update_sensitivity(FullScale fs)
+{
+    uint8_t i = (fs & 0x30) >> 4;
+    _gyro_sensitivity_dps = SENSITIVITY_MAP[i];
+    _gyro_sensitivity_rps = _gyro_sensitivity_dps * RADIAN_PER_DEGREE;
+    _gyro_scale_dps_q16.multiplier = FIXED_DPS_MULTIPLIER;
+    _gyro_scale_dps_q16.shift = FIXED_DPS_SHIFT - i;
+    _gyro_scale_rps_q16.multiplier = FIXED_RPS_MULTIPLIER;
+    _gyro_scale_rps_q16.shift = FIXED_RPS_SHIFT - i;
+}
+
+// supported bus policies
+template class l3gd20::L3GD20GyroscopeT<DynamicBus>;
+template class l3gd20::L3GD20GyroscopeT<SpiBus>;
+template class l3gd20::L3GD20GyroscopeT<I2cBus>;
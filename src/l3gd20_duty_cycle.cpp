@@ -0,0 +1,225 @@
+#include "l3gd20_duty_cycle.h"
+
+using namespace l3gd20;
+
+// settling interval margin against internal oscillator deviation
+static const float SETTLING_MARGIN = 1.1f;
+
+DutyCycleScheduler::Config::Config()
+    : period_us(1000000)
+    , n_samples(8)
+    , idle_mode(L3GD20Gyroscope::G_SLEEP)
+    , axes(L3GD20Gyroscope::AXIS_ALL_ENABLE)
+    , settling_samples(-1)
+{
+}
+
+DutyCycleScheduler::DutyCycleScheduler(L3GD20Gyroscope *gyro, PinName int2_pin, EventQueue *queue)
+    : _gyro(gyro)
+    , _int2(int2_pin)
+    , _edge_event(queue, callback(this, &DutyCycleScheduler::_process_edge))
+    , _timeout_event(queue, callback(this, &DutyCycleScheduler::_process_timeout))
+    , _running(false)
+    , _phase(PHASE_IDLE)
+    , _edge_time_us(0)
+    , _wake_time_us(0)
+    , _turn_on_latency_us(0)
+    , _settling_samples(0)
+{
+    if (gyro == NULL || queue == NULL) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Gyroscope driver and event queue are required");
+    }
+    _int2.disable_irq();
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+DutyCycleScheduler::~DutyCycleScheduler()
+{
+    stop();
+}
+
+int DutyCycleScheduler::start(const Config &config, const capture_callback_t &capture_callback)
+{
+    bool valid_idle_mode = config.idle_mode == L3GD20Gyroscope::G_SLEEP || config.idle_mode == L3GD20Gyroscope::G_DISABLE;
+    if (config.period_us == 0 || config.n_samples <= 0 || config.n_samples >= L3GD20Gyroscope::FIFO_SIZE || !valid_idle_mode
+        || !config.axes || (config.axes & ~L3GD20Gyroscope::AXIS_ALL_ENABLE) || !capture_callback) {
+        return MBED_ERROR_CODE_INVALID_ARGUMENT;
+    }
+    if (_running) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    _config = config;
+    _callback = capture_callback;
+    _settling_samples = config.settling_samples >= 0 ? config.settling_samples : _gyro->get_settling_sample_count();
+    memset(&_stats, 0, sizeof(_stats));
+
+    _enter_idle_mode();
+    _timer.reset();
+    _timer.start();
+    _running = true;
+    _int2.rise(callback(this, &DutyCycleScheduler::_on_edge));
+    _wake();
+    return MBED_SUCCESS;
+}
+
+void DutyCycleScheduler::stop()
+{
+    if (!_running) {
+        return;
+    }
+    _running = false;
+    _timeout.detach();
+    _int2.disable_irq();
+    _int2.rise(nullptr);
+    // pending events shouldn't be processed after scheduler destruction or restart
+    _edge_event.cancel();
+    _timeout_event.cancel();
+    _enter_idle_mode();
+    _phase = PHASE_IDLE;
+    _timer.stop();
+}
+
+bool DutyCycleScheduler::is_running()
+{
+    return _running;
+}
+
+int DutyCycleScheduler::get_settling_samples()
+{
+    return _settling_samples;
+}
+
+DutyCycleScheduler::LatencyStats DutyCycleScheduler::get_latency_stats()
+{
+    return _stats;
+}
+
+void DutyCycleScheduler::_on_edge()
+{
+    // the edge is processed once per phase
+    _edge_time_us = _timer.elapsed_time().count();
+    _int2.disable_irq();
+    _edge_event.call();
+}
+
+void DutyCycleScheduler::_on_timeout()
+{
+    _timeout_event.call();
+}
+
+void DutyCycleScheduler::_process_edge()
+{
+    if (!_running) {
+        return;
+    }
+    if (_phase == PHASE_TURN_ON) {
+        _settle();
+    } else if (_phase == PHASE_CAPTURE) {
+        _capture();
+    }
+}
+
+void DutyCycleScheduler::_process_timeout()
+{
+    if (!_running) {
+        return;
+    }
+    if (_phase == PHASE_IDLE) {
+        _wake();
+    } else if (_phase == PHASE_SETTLE) {
+        _start_capture();
+    }
+}
+
+void DutyCycleScheduler::_wake()
+{
+    _phase = PHASE_TURN_ON;
+    _wake_time_us = _timer.elapsed_time().count();
+    // clear data ready flag of the previous capture, so the edge is caused by the new data
+    int16_t data[3];
+    _gyro->read_data_16(data);
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
+    _gyro->set_gyroscope_mode(L3GD20Gyroscope::G_ENABLE, _config.axes);
+    _enable_edge_interrupt();
+}
+
+void DutyCycleScheduler::_settle()
+{
+    _turn_on_latency_us = (uint32_t)(_edge_time_us - _wake_time_us);
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
+    if (_settling_samples <= 1) {
+        _start_capture();
+        return;
+    }
+    // the first sample is already available, so wait for the rest ones without bus access
+    _phase = PHASE_SETTLE;
+    float settling_time_us = (_settling_samples - 1) * 1e6f / _gyro->get_output_data_rate_hz() * SETTLING_MARGIN;
+    _timeout.attach(callback(this, &DutyCycleScheduler::_on_timeout), std::chrono::microseconds((int64_t)settling_time_us));
+}
+
+void DutyCycleScheduler::_start_capture()
+{
+    // FIFO is empty after bypass mode, so it collects the settled samples only
+    _phase = PHASE_CAPTURE;
+    _gyro->set_fifo_watermark(_config.n_samples);
+    _gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
+    _enable_edge_interrupt();
+}
+
+void DutyCycleScheduler::_capture()
+{
+    int n = _gyro->read_fifo(_samples, _config.n_samples);
+    _enter_idle_mode();
+
+    Capture capture;
+    capture.n_samples = n;
+    capture.samples = _samples;
+    capture.wake_time_us = _wake_time_us;
+    capture.turn_on_latency_us = _turn_on_latency_us;
+    // the watermark edge is caused by the last sample of the block
+    uint64_t first_sample_time_us = _edge_time_us - (uint64_t)((_config.n_samples - 1) * 1e6f / _gyro->get_output_data_rate_hz());
+    capture.valid_data_latency_us = (uint32_t)(first_sample_time_us - _wake_time_us);
+    capture.settling_samples = _settling_samples;
+
+    if (_stats.n_captures == 0 || capture.turn_on_latency_us < _stats.min_turn_on_latency_us) {
+        _stats.min_turn_on_latency_us = capture.turn_on_latency_us;
+    }
+    if (capture.turn_on_latency_us > _stats.max_turn_on_latency_us) {
+        _stats.max_turn_on_latency_us = capture.turn_on_latency_us;
+    }
+    if (_stats.n_captures == 0 || capture.valid_data_latency_us < _stats.min_valid_data_latency_us) {
+        _stats.min_valid_data_latency_us = capture.valid_data_latency_us;
+    }
+    if (capture.valid_data_latency_us > _stats.max_valid_data_latency_us) {
+        _stats.max_valid_data_latency_us = capture.valid_data_latency_us;
+    }
+    _stats.n_captures++;
+    _stats.total_valid_data_latency_us += capture.valid_data_latency_us;
+
+    // schedule the next wake before callback, so the callback can stop the scheduler
+    _phase = PHASE_IDLE;
+    uint64_t next_wake_us = _wake_time_us + _config.period_us;
+    uint64_t now_us = _timer.elapsed_time().count();
+    uint64_t delay_us = next_wake_us > now_us ? next_wake_us - now_us : 0;
+    _timeout.attach(callback(this, &DutyCycleScheduler::_on_timeout), std::chrono::microseconds(delay_us));
+
+    _callback.call(capture);
+}
+
+void DutyCycleScheduler::_enter_idle_mode()
+{
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
+    _gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+    // sleep mode disables all axes, power down mode keeps them
+    _gyro->set_gyroscope_mode(_config.idle_mode, _config.axes);
+}
+
+void DutyCycleScheduler::_enable_edge_interrupt()
+{
+    _int2.enable_irq();
+    if (_int2.read()) {
+        // the interrupt source has been activated before interrupt enabling
+        _on_edge();
+    }
+}
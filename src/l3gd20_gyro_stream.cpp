@@ -0,0 +1,299 @@
+#include "l3gd20_gyro_stream.h"
+
+using namespace l3gd20;
+
+GyroStream::GyroStream(L3GD20Gyroscope *gyro, PinName int2_pin, osPriority priority, uint32_t stack_size, const char *name)
+    : _gyro(gyro)
+    , _int2(int2_pin)
+    , _queue()
+    , _thread(priority, stack_size, NULL, name)
+    , _thread_started(false)
+    , _process_event(&_queue, callback(this, &GyroStream::_process))
+    , _timestamper(gyro != NULL ? gyro->get_output_data_rate_hz() : 1.0f)
+    , _block_size(0)
+    , _initial_odr_hz(0.0f)
+    , _running(false)
+    , _edge_pending(false)
+    , _event_posted(false)
+    , _edge_time_us(0)
+    , _block_count(0)
+    , _controller(NULL)
+    , _sensitivity(0.0f)
+    , _rate_change_count(0)
+{
+    if (gyro == NULL) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Gyroscope driver isn't set");
+    }
+    _int2.disable_irq();
+}
+
+GyroStream::~GyroStream()
+{
+    stop();
+    if (_thread_started) {
+        _queue.break_dispatch();
+        _thread.join();
+    }
+}
+
+int GyroStream::start(int block_size, const block_callback_t &block_callback, float odr_hz)
+{
+    if (block_size <= 0 || block_size >= L3GD20Gyroscope::FIFO_SIZE || !block_callback || odr_hz < 0.0f) {
+        return MBED_ERROR_CODE_INVALID_ARGUMENT;
+    }
+    bool in_thread = ThisThread::get_id() == _thread.get_id();
+    if (!in_thread) {
+        _mutex.lock();
+    }
+    int err = MBED_SUCCESS;
+    if (_running) {
+        err = MBED_ERROR_CODE_EBUSY;
+    } else if (!_thread_started) {
+        if (_thread.start(callback(&_queue, &EventQueue::dispatch_forever)) == osOK) {
+            _thread_started = true;
+        } else {
+            err = MBED_ERROR_CODE_INITIALIZATION_FAILED;
+        }
+    }
+    if (!err) {
+        _block_size = block_size;
+        _callback = block_callback;
+        _initial_odr_hz = odr_hz;
+        // the device is accessed by the stream thread only, so processing can't interleave with configuration
+        err = _invoke_in_thread(&GyroStream::_start_acquisition);
+    }
+    if (!in_thread) {
+        _mutex.unlock();
+    }
+    return err;
+}
+
+void GyroStream::stop()
+{
+    bool in_thread = ThisThread::get_id() == _thread.get_id();
+    if (!in_thread) {
+        _mutex.lock();
+    }
+    if (_running) {
+        // the queue is FIFO, so the processing in progress and the posted events are completed before return
+        if (_invoke_in_thread(&GyroStream::_stop_acquisition)) {
+            // no events are posted after interrupt masking, so the queue is drained and the stop can be retried
+            _int2.disable_irq();
+            while (_invoke_in_thread(&GyroStream::_stop_acquisition)) {
+                ThisThread::sleep_for(1ms);
+            }
+        }
+    }
+    if (!in_thread) {
+        _mutex.unlock();
+    }
+}
+
+int GyroStream::set_rate_controller(AdaptiveRateController *controller, const rate_change_callback_t &rate_change_callback)
+{
+    bool in_thread = ThisThread::get_id() == _thread.get_id();
+    if (!in_thread) {
+        _mutex.lock();
+    }
+    int err = MBED_SUCCESS;
+    if (_running) {
+        err = MBED_ERROR_CODE_EBUSY;
+    } else {
+        _controller = controller;
+        _rate_change_callback = rate_change_callback;
+    }
+    if (!in_thread) {
+        _mutex.unlock();
+    }
+    return err;
+}
+
+bool GyroStream::is_running()
+{
+    return _running;
+}
+
+uint32_t GyroStream::get_block_count()
+{
+    return _block_count;
+}
+
+uint32_t GyroStream::get_lost_sample_count()
+{
+    return _timestamper.get_lost_sample_count();
+}
+
+uint32_t GyroStream::get_rate_change_count()
+{
+    return _rate_change_count;
+}
+
+Thread *GyroStream::get_thread()
+{
+    return &_thread;
+}
+
+void GyroStream::_on_interrupt()
+{
+    _edge_time_us = _timer.elapsed_time().count();
+
+    // post a single event for the pending interrupt
+    core_util_critical_section_enter();
+    _edge_pending = true;
+    bool post = !_event_posted;
+    _event_posted = true;
+    core_util_critical_section_exit();
+    if (post) {
+        _process_event.call();
+    }
+}
+
+void GyroStream::_process()
+{
+    core_util_critical_section_enter();
+    bool edge = _edge_pending;
+    uint64_t edge_time_us = _edge_time_us;
+    _edge_pending = false;
+    _event_posted = false;
+    core_util_critical_section_exit();
+
+    while (_running) {
+        // mask watermark interrupt, so the draining doesn't post redundant events
+        uint64_t mask_time_us = _timer.elapsed_time().count();
+        _int2.disable_irq();
+        int8_t temperature = 0;
+        int n = _gyro->read_fifo(_samples, &temperature);
+        bool overrun = _gyro->get_last_fifo_status().overrun;
+        _int2.enable_irq();
+        _gyro->add_irq_masked_time(_timer.elapsed_time().count() - mask_time_us);
+        if (n <= 0) {
+            return;
+        }
+
+        // the edge is triggered, when FIFO level reaches block size; the blocks without edge are extrapolated
+        _timestamper.update(edge_time_us, edge ? _block_size : 0, n, _timestamps, overrun);
+        edge = false;
+        _deliver_block(n, temperature);
+
+        if (_running && _controller && _controller->update(_samples, n, _sensitivity, _timestamper.get_odr_hz())) {
+            _change_rate();
+        }
+
+        // if watermark has been reached, while interrupt was masked, there is no edge, so drain FIFO again
+        core_util_critical_section_enter();
+        bool missed_edge = !_edge_pending && _int2.read();
+        core_util_critical_section_exit();
+        if (!missed_edge) {
+            return;
+        }
+    }
+}
+
+void GyroStream::_deliver_block(int n, int8_t temperature)
+{
+    Block block;
+    block.n_samples = n;
+    block.samples = _samples;
+    block.timestamps = _timestamps;
+    block.temperature = temperature;
+    block.odr_hz = _timestamper.get_odr_hz();
+    _callback.call(block);
+    _block_count++;
+}
+
+void GyroStream::_change_rate()
+{
+    L3GD20Gyroscope::OutputDataRate odr = _controller->get_odr();
+    int watermark = _controller->get_watermark();
+
+    uint64_t mask_time_us = _timer.elapsed_time().count();
+    _int2.disable_irq();
+    // the first sample of the new rate is produced a sample period after the change,
+    // so FIFO contains the samples of the previous rate only, while it's drained immediately
+    _gyro->set_output_data_rate(odr);
+    uint64_t switch_time_us = _timer.elapsed_time().count();
+    int8_t temperature = 0;
+    int n = _gyro->read_fifo(_samples, &temperature);
+    _gyro->set_fifo_watermark(watermark);
+    _int2.enable_irq();
+    _gyro->add_irq_masked_time(_timer.elapsed_time().count() - mask_time_us);
+
+    if (n > 0) {
+        _timestamper.update(n, _timestamps);
+        _deliver_block(n, temperature);
+    }
+    _block_size = watermark;
+    _timestamper.switch_odr(_gyro->get_output_data_rate_hz());
+    _rate_change_count++;
+
+    if (_running && _rate_change_callback) {
+        RateChange change;
+        change.odr = odr;
+        change.watermark = watermark;
+        change.odr_hz = _timestamper.get_odr_hz();
+        change.time_us = switch_time_us;
+        change.sample_count = _timestamper.get_sample_count() + _timestamper.get_lost_sample_count();
+        _rate_change_callback.call(change);
+    }
+}
+
+void GyroStream::_start_acquisition()
+{
+    if (_controller) {
+        // keep the current device rate, if it's the low one; otherwise, start with the high rate
+        _controller->reset(_gyro->get_output_data_rate() != _controller->get_config().low_odr);
+        _gyro->set_output_data_rate(_controller->get_odr());
+        _block_size = _controller->get_watermark();
+        _sensitivity = _gyro->get_sensitivity();
+    }
+    _gyro->set_fifo_watermark(_block_size);
+    _gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+    _gyro->clear_fifo();
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
+    _timestamper.reset(_gyro->get_output_data_rate_hz());
+    if (_initial_odr_hz > 0.0f) {
+        _timestamper.set_odr_hz(_initial_odr_hz);
+    }
+    _block_count = 0;
+    _rate_change_count = 0;
+    _edge_pending = false;
+    _event_posted = false;
+    _timer.reset();
+    _timer.start();
+
+    _running = true;
+    _int2.rise(callback(this, &GyroStream::_on_interrupt));
+    _int2.enable_irq();
+    if (_int2.read()) {
+        // watermark has been reached before interrupt enabling
+        _on_interrupt();
+    }
+}
+
+void GyroStream::_stop_acquisition()
+{
+    _int2.disable_irq();
+    _int2.rise(nullptr);
+    _running = false;
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
+    _timer.stop();
+}
+
+int GyroStream::_invoke_in_thread(void (GyroStream::*method)())
+{
+    if (ThisThread::get_id() == _thread.get_id()) {
+        (this->*method)();
+        return MBED_SUCCESS;
+    }
+    Semaphore done;
+    int id = _queue.call([this, method, &done]() {
+        (this->*method)();
+        done.release();
+    });
+    if (!id) {
+        // the event isn't posted, so nothing will release the semaphore
+        return MBED_ERROR_CODE_ENOMEM;
+    }
+    done.acquire();
+    return MBED_SUCCESS;
+}
@@ -0,0 +1,355 @@
+#include "l3gd20_gyroscope_group.h"
+
+using namespace l3gd20;
+
+// alignment hysteresis relative to the sample period
+static const float ALIGNMENT_HYSTERESIS = 0.125f;
+
+/**
+ * Device driver, its interrupt and collected samples.
+ */
+class GyroscopeGroup::Channel : private NonCopyable<Channel> {
+public:
+    Channel(GyroscopeGroup *group, SPI *spi_ptr, PinName ssel, PinName int2_pin)
+        : group(group)
+        , gyro(spi_ptr, ssel)
+        , int2(int2_pin)
+        , timestamper(gyro.get_output_data_rate_hz())
+        , edge_time_us(0)
+        , n_staged(0)
+    {
+        int2.disable_irq();
+    }
+
+    void on_interrupt()
+    {
+        group->_on_interrupt(this);
+    }
+
+    /**
+     * Remove the first samples.
+     */
+    void drop(int n)
+    {
+        n_staged -= n;
+        memmove(samples, samples + n, n_staged * sizeof(samples[0]));
+        memmove(timestamps, timestamps + n, n_staged * sizeof(timestamps[0]));
+    }
+
+    GyroscopeGroup *group;
+    L3GD20Gyroscope gyro;
+    InterruptIn int2;
+    SampleTimestamper timestamper;
+    volatile uint64_t edge_time_us;
+
+    // samples, that aren't delivered yet
+    int16_t samples[STAGING_SIZE][3];
+    uint64_t timestamps[STAGING_SIZE];
+    int n_staged;
+};
+
+GyroscopeGroup::GyroscopeGroup(SPI *spi_ptr, EventQueue *queue)
+    : _spi_ptr(spi_ptr)
+    , _process_event(queue, callback(this, &GyroscopeGroup::_process))
+    , _n_channels(0)
+    , _block_size(0)
+    , _running(false)
+    , _pending_mask(0)
+    , _missed_edge_mask(0)
+    , _event_posted(false)
+    , _queue_thread_id(NULL)
+    , _block_count(0)
+    , _dropped_sample_count(0)
+    , _batch_count(0)
+{
+    if (spi_ptr == NULL || queue == NULL) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "SPI interface and event queue are required");
+    }
+}
+
+GyroscopeGroup::~GyroscopeGroup()
+{
+    stop();
+    for (int i = 0; i < _n_channels; i++) {
+        delete _channels[i];
+    }
+}
+
+int GyroscopeGroup::add_gyroscope(PinName ssel, PinName int2_pin)
+{
+    if (_running) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    if (_n_channels >= MAX_GYROSCOPES) {
+        return MBED_ERROR_CODE_ENOMEM;
+    }
+    if (ssel == NC || int2_pin == NC) {
+        return MBED_ERROR_CODE_INVALID_ARGUMENT;
+    }
+    _channels[_n_channels++] = new Channel(this, _spi_ptr, ssel, int2_pin);
+    return MBED_SUCCESS;
+}
+
+int GyroscopeGroup::get_gyroscope_count()
+{
+    return _n_channels;
+}
+
+L3GD20Gyroscope *GyroscopeGroup::get_gyroscope(int index)
+{
+    if (index < 0 || index >= _n_channels) {
+        return NULL;
+    }
+    return &_channels[index]->gyro;
+}
+
+int GyroscopeGroup::init()
+{
+    for (int i = 0; i < _n_channels; i++) {
+        int err = _channels[i]->gyro.init();
+        if (err) {
+            return err;
+        }
+    }
+    return MBED_SUCCESS;
+}
+
+int GyroscopeGroup::start(int block_size, const block_callback_t &block_callback)
+{
+    if (block_size <= 0 || block_size >= L3GD20Gyroscope::FIFO_SIZE || _n_channels == 0) {
+        return MBED_ERROR_CODE_INVALID_ARGUMENT;
+    }
+    if (_running) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    L3GD20Gyroscope::OutputDataRate odr = _channels[0]->gyro.get_output_data_rate();
+    for (int i = 1; i < _n_channels; i++) {
+        if (_channels[i]->gyro.get_output_data_rate() != odr) {
+            return MBED_ERROR_CODE_INVALID_ARGUMENT;
+        }
+    }
+
+    _block_size = block_size;
+    _callback = block_callback;
+    _pending_mask = 0;
+    _missed_edge_mask = 0;
+    _event_posted = false;
+    _queue_thread_id = NULL;
+    _block_count = 0;
+    _dropped_sample_count = 0;
+    _batch_count = 0;
+
+    _spi_ptr->lock();
+    // configure FIFO of the powered down devices
+    for (int i = 0; i < _n_channels; i++) {
+        Channel *channel = _channels[i];
+        L3GD20Gyroscope &gyro = channel->gyro;
+        gyro.set_gyroscope_mode(L3GD20Gyroscope::G_DISABLE);
+        gyro.set_fifo_watermark(block_size);
+        gyro.set_fifo_mode(L3GD20Gyroscope::FIFO_ENABLE);
+        gyro.clear_fifo();
+        gyro.set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_ENABLE);
+        channel->timestamper.reset(gyro.get_output_data_rate_hz());
+        channel->n_staged = 0;
+    }
+    // power on devices back to back, so their sample phases are aligned
+    for (int i = 0; i < _n_channels; i++) {
+        _channels[i]->gyro.set_gyroscope_mode(L3GD20Gyroscope::G_ENABLE);
+    }
+    _timer.reset();
+    _timer.start();
+    _spi_ptr->unlock();
+
+    _running = true;
+    for (int i = 0; i < _n_channels; i++) {
+        Channel *channel = _channels[i];
+        channel->int2.rise(callback(channel, &Channel::on_interrupt));
+        channel->int2.enable_irq();
+    }
+    return MBED_SUCCESS;
+}
+
+void GyroscopeGroup::stop()
+{
+    if (!_running) {
+        return;
+    }
+    // the processing event can't be running concurrently in the queue thread
+    MBED_ASSERT(_queue_thread_id == NULL || _queue_thread_id == ThisThread::get_id());
+    for (int i = 0; i < _n_channels; i++) {
+        _channels[i]->int2.disable_irq();
+        _channels[i]->int2.rise(nullptr);
+    }
+    _running = false;
+    // pending event shouldn't be processed after group destruction
+    _process_event.cancel();
+    _pending_mask = 0;
+    _missed_edge_mask = 0;
+    _event_posted = false;
+    _spi_ptr->lock();
+    for (int i = 0; i < _n_channels; i++) {
+        _channels[i]->gyro.set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
+    }
+    _spi_ptr->unlock();
+    _timer.stop();
+}
+
+uint32_t GyroscopeGroup::get_block_count()
+{
+    return _block_count;
+}
+
+uint32_t GyroscopeGroup::get_dropped_sample_count()
+{
+    return _dropped_sample_count;
+}
+
+uint32_t GyroscopeGroup::get_batch_count()
+{
+    return _batch_count;
+}
+
+void GyroscopeGroup::_on_interrupt(Channel *channel)
+{
+    channel->edge_time_us = _timer.elapsed_time().count();
+    int index = 0;
+    while (_channels[index] != channel) {
+        index++;
+    }
+
+    // post a single event for all pending devices
+    core_util_critical_section_enter();
+    _pending_mask |= 1 << index;
+    bool post = !_event_posted;
+    _event_posted = true;
+    core_util_critical_section_exit();
+    if (post) {
+        _process_event.call();
+    }
+}
+
+void GyroscopeGroup::_process()
+{
+    core_util_critical_section_enter();
+    uint32_t edge_mask = _pending_mask;
+    uint32_t pending_mask = edge_mask | _missed_edge_mask;
+    uint64_t edge_times_us[MAX_GYROSCOPES];
+    for (int i = 0; i < _n_channels; i++) {
+        edge_times_us[i] = _channels[i]->edge_time_us;
+    }
+    _pending_mask = 0;
+    _missed_edge_mask = 0;
+    _event_posted = false;
+    core_util_critical_section_exit();
+    if (!_running || !pending_mask) {
+        return;
+    }
+    _queue_thread_id = ThisThread::get_id();
+
+    // read all pending devices directly into staging buffers
+    int n_read[MAX_GYROSCOPES];
+    bool overrun[MAX_GYROSCOPES];
+    _spi_ptr->lock();
+    for (int i = 0; i < _n_channels; i++) {
+        n_read[i] = 0;
+        overrun[i] = false;
+        if (!(pending_mask & (1 << i))) {
+            continue;
+        }
+        Channel *channel = _channels[i];
+        int overflow = channel->n_staged + L3GD20Gyroscope::FIFO_SIZE - STAGING_SIZE;
+        if (overflow > 0) {
+            // other devices don't deliver samples, so discard the oldest ones
+            channel->drop(overflow);
+            _dropped_sample_count += overflow;
+        }
+        n_read[i] = channel->gyro.read_fifo(channel->samples + channel->n_staged);
+        overrun[i] = channel->gyro.get_last_fifo_status().overrun;
+    }
+    _spi_ptr->unlock();
+    _batch_count++;
+
+    for (int i = 0; i < _n_channels; i++) {
+        if (pending_mask & (1 << i)) {
+            Channel *channel = _channels[i];
+            // the edge is triggered, when FIFO level reaches block size; the blocks without edge are extrapolated
+            int edge_level = (edge_mask & (1 << i)) ? _block_size : 0;
+            channel->timestamper.update(edge_times_us[i], edge_level, n_read[i], channel->timestamps + channel->n_staged, overrun[i]);
+            channel->n_staged += n_read[i];
+        }
+    }
+
+    _deliver_blocks();
+
+    // watermark interrupt is edge-triggered, so INT2 of a read device stays high without a new edge,
+    // if its FIFO has reached the watermark again before the processing completion; such devices are read
+    // by the next event without edge time
+    uint32_t missed_edge_mask = 0;
+    for (int i = 0; i < _n_channels; i++) {
+        if ((pending_mask & (1 << i)) && _channels[i]->int2.read()) {
+            missed_edge_mask |= 1 << i;
+        }
+    }
+    if (missed_edge_mask && _running) {
+        core_util_critical_section_enter();
+        _missed_edge_mask |= missed_edge_mask;
+        bool post = !_event_posted;
+        _event_posted = true;
+        core_util_critical_section_exit();
+        if (post) {
+            _process_event.call();
+        }
+    }
+}
+
+void GyroscopeGroup::_deliver_blocks()
+{
+    // note: the group can be stopped from the block callback
+    while (_running) {
+        for (int i = 0; i < _n_channels; i++) {
+            if (_channels[i]->n_staged < _block_size) {
+                return;
+            }
+        }
+
+        // keep offsets of the first samples relative to the first device within a half of the sample period
+        // with small hysteresis, so the estimation jitter doesn't cause repeated drops
+        Channel *reference = _channels[0];
+        int64_t max_offset_us = (int64_t)(reference->timestamper.get_sample_period_us() * (0.5f + ALIGNMENT_HYSTERESIS));
+        bool aligned = true;
+        for (int i = 1; i < _n_channels; i++) {
+            Channel *channel = _channels[i];
+            int64_t offset_us = (int64_t)(channel->timestamps[0] - reference->timestamps[0]);
+            if (offset_us < -max_offset_us) {
+                // the device is ahead of the reference one
+                channel->drop(1);
+                _dropped_sample_count++;
+                aligned = false;
+            } else if (offset_us > max_offset_us) {
+                // the reference device is ahead of the device
+                reference->drop(1);
+                _dropped_sample_count++;
+                aligned = false;
+                break;
+            }
+        }
+        if (!aligned) {
+            // check sample numbers and offsets again
+            continue;
+        }
+
+        Block block;
+        block.n_gyroscopes = _n_channels;
+        block.n_samples = _block_size;
+        for (int i = 0; i < _n_channels; i++) {
+            block.samples[i] = _channels[i]->samples;
+            block.timestamps[i] = _channels[i]->timestamps;
+        }
+        _callback.call(block);
+        _block_count++;
+
+        for (int i = 0; i < _n_channels; i++) {
+            _channels[i]->drop(_block_size);
+        }
+    }
+}
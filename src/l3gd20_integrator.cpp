@@ -0,0 +1,293 @@
+#include "l3gd20_integrator.h"
+
+using namespace l3gd20;
+
+// Q16.16 rate * Q1.31 time = Q47, so the shift converts product into Q2.30 angle
+static const int RATE_TIME_SHIFT = 16 + 31 - FixedOrientationIntegrator::QUATERNION_FRAC_BITS;
+
+/**
+ * Multiply 32 bit values with 64 bit result (single SMULL instruction on Cortex-M3/M4).
+ */
+static inline int64_t mul_64(int32_t a, int32_t b)
+{
+    return (int64_t)a * b;
+}
+
+/*
+ * OrientationIntegrator
+ */
+
+static inline void add_cross(float out[3], float k, const float a[3], const float b[3])
+{
+    out[0] += k * (a[1] * b[2] - a[2] * b[1]);
+    out[1] += k * (a[2] * b[0] - a[0] * b[2]);
+    out[2] += k * (a[0] * b[1] - a[1] * b[0]);
+}
+
+/**
+ * Calculate rotation vector of a group of sample rotations with coning correction.
+ *
+ * @param th sample rotations
+ * @param m number of samples in the group (1 - 4)
+ * @param phi rotation vector
+ */
+static inline void group_rotation(const float th[4][3], int m, float phi[3])
+{
+    for (int k = 0; k < 3; k++) {
+        phi[k] = th[0][k];
+        for (int j = 1; j < m; j++) {
+            phi[k] += th[j][k];
+        }
+    }
+
+    switch (m) {
+        case 2:
+            add_cross(phi, 2.0f / 3.0f, th[0], th[1]);
+            break;
+        case 3: {
+            float d[3] = { th[2][0] - th[0][0], th[2][1] - th[0][1], th[2][2] - th[0][2] };
+            add_cross(phi, 33.0f / 80.0f, th[0], th[2]);
+            add_cross(phi, 57.0f / 80.0f, th[1], d);
+            break;
+        }
+        case 4:
+            add_cross(phi, 736.0f / 945.0f, th[0], th[1]);
+            add_cross(phi, 736.0f / 945.0f, th[2], th[3]);
+            add_cross(phi, 334.0f / 945.0f, th[0], th[2]);
+            add_cross(phi, 334.0f / 945.0f, th[1], th[3]);
+            add_cross(phi, 526.0f / 945.0f, th[0], th[3]);
+            add_cross(phi, 654.0f / 945.0f, th[1], th[2]);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Rotate quaternion by small angle rotation.
+ *
+ * @param q quaternion
+ * @param vx x component of the half rotation vector
+ * @param vy y component of the half rotation vector
+ * @param vz z component of the half rotation vector
+ */
+static MBED_FORCEINLINE void rotate_small_angle(float q[4], float vx, float vy, float vz)
+{
+    // cos(|v|) and sin(|v|) / |v| series, their errors are less than |v|^6 / 720
+    // (about 1e-13 for 2000 dps at 760 Hz)
+    float t = vx * vx + vy * vy + vz * vz;
+    float dw = 1.0f - t * (0.5f - t * (1.0f / 24.0f));
+    float k = 1.0f - t * (1.0f / 6.0f - t * (1.0f / 120.0f));
+    vx *= k;
+    vy *= k;
+    vz *= k;
+
+    // q = q * dq
+    float w = q[0] * dw - q[1] * vx - q[2] * vy - q[3] * vz;
+    float x = q[0] * vx + q[1] * dw + q[2] * vz - q[3] * vy;
+    float y = q[0] * vy - q[1] * vz + q[2] * dw + q[3] * vx;
+    float z = q[0] * vz + q[1] * vy - q[2] * vx + q[3] * dw;
+    q[0] = w;
+    q[1] = x;
+    q[2] = y;
+    q[3] = z;
+}
+
+/**
+ * Integrate block of samples.
+ *
+ * Sample rotation is `src[i] * scale - offset`.
+ */
+template <typename T>
+static void integrate_block(float q_out[4], const T (*src)[3], int n, float scale, const float offset[3], int group_size)
+{
+    float q[4] = { q_out[0], q_out[1], q_out[2], q_out[3] };
+
+    if (group_size <= 1) {
+        const float half_scale = 0.5f * scale;
+        const float half_offset[3] = { 0.5f * offset[0], 0.5f * offset[1], 0.5f * offset[2] };
+        for (int i = 0; i < n; i++) {
+            rotate_small_angle(q, src[i][0] * half_scale - half_offset[0], src[i][1] * half_scale - half_offset[1], src[i][2] * half_scale - half_offset[2]);
+        }
+    } else {
+        float th[4][3];
+        float phi[3];
+        for (int i = 0; i < n; i += group_size) {
+            int m = n - i < group_size ? n - i : group_size;
+            for (int j = 0; j < m; j++) {
+                for (int k = 0; k < 3; k++) {
+                    th[j][k] = src[i + j][k] * scale - offset[k];
+                }
+            }
+            group_rotation(th, m, phi);
+            rotate_small_angle(q, 0.5f * phi[0], 0.5f * phi[1], 0.5f * phi[2]);
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        q_out[i] = q[i];
+    }
+}
+
+OrientationIntegrator::OrientationIntegrator(float sample_rate_hz)
+    : _coning_mode(CONING_DISABLE)
+{
+    set_sample_rate(sample_rate_hz);
+    reset();
+}
+
+void OrientationIntegrator::set_sample_rate(float sample_rate_hz)
+{
+    if (sample_rate_hz <= 0.0f) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid sample rate");
+    }
+    _dt = 1.0f / sample_rate_hz;
+}
+
+void OrientationIntegrator::set_coning_mode(ConingMode mode)
+{
+    _coning_mode = mode;
+}
+
+OrientationIntegrator::ConingMode OrientationIntegrator::get_coning_mode()
+{
+    return _coning_mode;
+}
+
+void OrientationIntegrator::reset()
+{
+    _q[0] = 1.0f;
+    _q[1] = 0.0f;
+    _q[2] = 0.0f;
+    _q[3] = 0.0f;
+}
+
+void OrientationIntegrator::update(const float (*rates)[3], int n)
+{
+    const float no_offset[3] = { 0.0f, 0.0f, 0.0f };
+    integrate_block(_q, rates, n, _dt, no_offset, _coning_mode);
+    _normalize();
+}
+
+void OrientationIntegrator::update(const int16_t (*samples)[3], int n, float sensitivity, const float bias[3])
+{
+    float offset[3] = { 0.0f, 0.0f, 0.0f };
+    if (bias) {
+        for (int k = 0; k < 3; k++) {
+            offset[k] = bias[k] * _dt;
+        }
+    }
+    integrate_block(_q, samples, n, sensitivity * _dt, offset, _coning_mode);
+    _normalize();
+}
+
+void OrientationIntegrator::get_quaternion(float q[4])
+{
+    for (int i = 0; i < 4; i++) {
+        q[i] = _q[i];
+    }
+}
+
+void OrientationIntegrator::set_quaternion(const float q[4])
+{
+    for (int i = 0; i < 4; i++) {
+        _q[i] = q[i];
+    }
+}
+
+void OrientationIntegrator::_normalize()
+{
+    float k = 1.0f / sqrtf(_q[0] * _q[0] + _q[1] * _q[1] + _q[2] * _q[2] + _q[3] * _q[3]);
+    for (int i = 0; i < 4; i++) {
+        _q[i] *= k;
+    }
+}
+
+/*
+ * FixedOrientationIntegrator
+ */
+
+FixedOrientationIntegrator::FixedOrientationIntegrator(float sample_rate_hz)
+{
+    set_sample_rate(sample_rate_hz);
+    reset();
+}
+
+void FixedOrientationIntegrator::set_sample_rate(float sample_rate_hz)
+{
+    if (sample_rate_hz <= 0.0f) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid sample rate");
+    }
+    // note: it's the only floating point operation, so it can be done once during configuration
+    _half_dt = (int32_t)(2147483648.0f / (2.0f * sample_rate_hz) + 0.5f);
+}
+
+void FixedOrientationIntegrator::reset()
+{
+    _q[0] = QUATERNION_ONE;
+    _q[1] = 0;
+    _q[2] = 0;
+    _q[3] = 0;
+}
+
+void FixedOrientationIntegrator::update(const int32_t (*rates)[3], int n)
+{
+    const int shift = QUATERNION_FRAC_BITS;
+    int32_t qw = _q[0];
+    int32_t qx = _q[1];
+    int32_t qy = _q[2];
+    int32_t qz = _q[3];
+
+    for (int i = 0; i < n; i++) {
+        // half rotation angles
+        int32_t vx = (int32_t)(mul_64(rates[i][0], _half_dt) >> RATE_TIME_SHIFT);
+        int32_t vy = (int32_t)(mul_64(rates[i][1], _half_dt) >> RATE_TIME_SHIFT);
+        int32_t vz = (int32_t)(mul_64(rates[i][2], _half_dt) >> RATE_TIME_SHIFT);
+        // scalar part of the small angle rotation quaternion: 1 - |v|^2 / 2
+        int32_t dw = QUATERNION_ONE - (int32_t)((mul_64(vx, vx) + mul_64(vy, vy) + mul_64(vz, vz)) >> (shift + 1));
+
+        // q = q * dq
+        int32_t w = (int32_t)((mul_64(qw, dw) - mul_64(qx, vx) - mul_64(qy, vy) - mul_64(qz, vz)) >> shift);
+        int32_t x = (int32_t)((mul_64(qw, vx) + mul_64(qx, dw) + mul_64(qy, vz) - mul_64(qz, vy)) >> shift);
+        int32_t y = (int32_t)((mul_64(qw, vy) - mul_64(qx, vz) + mul_64(qy, dw) + mul_64(qz, vx)) >> shift);
+        int32_t z = (int32_t)((mul_64(qw, vz) + mul_64(qx, vy) - mul_64(qy, vx) + mul_64(qz, dw)) >> shift);
+        qw = w;
+        qx = x;
+        qy = y;
+        qz = z;
+    }
+
+    _q[0] = qw;
+    _q[1] = qx;
+    _q[2] = qy;
+    _q[3] = qz;
+    _normalize();
+}
+
+void FixedOrientationIntegrator::get_quaternion(int32_t q[4])
+{
+    for (int i = 0; i < 4; i++) {
+        q[i] = _q[i];
+    }
+}
+
+void FixedOrientationIntegrator::set_quaternion(const int32_t q[4])
+{
+    for (int i = 0; i < 4; i++) {
+        _q[i] = q[i];
+    }
+}
+
+void FixedOrientationIntegrator::_normalize()
+{
+    const int shift = QUATERNION_FRAC_BITS;
+    int64_t norm2 = 0;
+    for (int i = 0; i < 4; i++) {
+        norm2 += mul_64(_q[i], _q[i]);
+    }
+    // q * (3 - |q|^2) / 2 is the first order approximation of q / |q| for |q| close to 1
+    int32_t factor = (int32_t)((3 * (int64_t)QUATERNION_ONE - (norm2 >> shift)) >> 1);
+    for (int i = 0; i < 4; i++) {
+        _q[i] = (int32_t)(mul_64(_q[i], factor) >> shift);
+    }
+}
@@ -0,0 +1,124 @@
+#include "l3gd20_motion_wakeup.h"
+
+using namespace l3gd20;
+
+MotionWakeup::MotionWakeup(L3GD20Gyroscope *gyro, PinName int1_pin, EventQueue *queue)
+    : _gyro(gyro)
+    , _int1(int1_pin)
+    , _wakeup_event(queue, callback(this, &MotionWakeup::_wakeup))
+    , _sleeping(false)
+    , _wakeup_count(0)
+    , _wakeup_source(0)
+    , _odr(L3GD20Gyroscope::ODR_95_HZ)
+    , _fifo_mode(L3GD20Gyroscope::FIFO_DISABLE)
+    , _drdy_mode(L3GD20Gyroscope::DRDY_DISABLE)
+{
+    if (gyro == NULL || queue == NULL) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Gyroscope driver and event queue are required");
+    }
+    _int1.disable_irq();
+}
+
+MotionWakeup::~MotionWakeup()
+{
+    cancel();
+}
+
+int MotionWakeup::sleep(const L3GD20Gyroscope::MotionInterruptConfig &config, const wakeup_callback_t &wakeup_callback,
+                        L3GD20Gyroscope::OutputDataRate sleep_odr)
+{
+    if (!config.events || !wakeup_callback) {
+        return MBED_ERROR_CODE_INVALID_ARGUMENT;
+    }
+    if (_sleeping) {
+        return MBED_ERROR_CODE_EBUSY;
+    }
+    _callback = wakeup_callback;
+    _odr = _gyro->get_output_data_rate();
+    _fifo_mode = _gyro->get_fifo_mode();
+    _drdy_mode = _gyro->get_data_ready_interrupt_mode();
+
+    // stop all FIFO activity and wait with low output data rate
+    _gyro->set_data_ready_interrupt_mode(L3GD20Gyroscope::DRDY_DISABLE);
+    _gyro->set_fifo_mode(L3GD20Gyroscope::FIFO_DISABLE);
+    _gyro->set_output_data_rate(sleep_odr);
+    // latched request keeps pin level until wakeup processing, so the edge can't be missed
+    L3GD20Gyroscope::MotionInterruptConfig sleep_config = config;
+    sleep_config.latch = true;
+    _gyro->set_motion_interrupt(sleep_config);
+    // clear stale request
+    _gyro->read_motion_interrupt_source();
+
+    _sleeping = true;
+    _int1.rise(callback(this, &MotionWakeup::_on_interrupt));
+    _int1.enable_irq();
+    if (_int1.read()) {
+        // motion has been detected before interrupt enabling
+        _on_interrupt();
+    }
+    return MBED_SUCCESS;
+}
+
+void MotionWakeup::cancel()
+{
+    _leave_sleep();
+}
+
+bool MotionWakeup::is_sleeping()
+{
+    return _sleeping;
+}
+
+uint32_t MotionWakeup::get_wakeup_count()
+{
+    return _wakeup_count;
+}
+
+uint8_t MotionWakeup::get_wakeup_source()
+{
+    return _wakeup_source;
+}
+
+void MotionWakeup::_on_interrupt()
+{
+    // the latched request keeps the pin high, so the event is posted once
+    _int1.disable_irq();
+    _wakeup_event.call();
+}
+
+void MotionWakeup::_wakeup()
+{
+    // the source should be read before INT1 disabling, as it clears the request
+    if (!_sleeping) {
+        return;
+    }
+    uint8_t source = _gyro->read_motion_interrupt_source();
+    if (!_leave_sleep()) {
+        // cancelled
+        return;
+    }
+    _wakeup_source = source;
+    _wakeup_count++;
+    _callback.call(source);
+}
+
+bool MotionWakeup::_leave_sleep()
+{
+    core_util_critical_section_enter();
+    bool sleeping = _sleeping;
+    _sleeping = false;
+    core_util_critical_section_exit();
+    if (!sleeping) {
+        return false;
+    }
+    _int1.disable_irq();
+    _int1.rise(nullptr);
+    // pending wakeup shouldn't be processed after cancellation or destruction
+    _wakeup_event.cancel();
+
+    _gyro->set_motion_interrupt(L3GD20Gyroscope::MotionInterruptConfig());
+    _gyro->set_output_data_rate(_odr);
+    _gyro->set_fifo_mode(_fifo_mode);
+    _gyro->set_data_ready_interrupt_mode(_drdy_mode);
+    return true;
+}
@@ -0,0 +1,115 @@
+#include "l3gd20_temperature_bias.h"
+
+using namespace l3gd20;
+
+static int get_bin_index(int8_t temperature)
+{
+    return (temperature - INT8_MIN) / TemperatureBiasModel::BIN_WIDTH;
+}
+
+TemperatureBiasModel::TemperatureBiasModel()
+{
+    reset();
+}
+
+void TemperatureBiasModel::reset()
+{
+    memset(_bias, 0, sizeof(_bias));
+    memset(_temperature, 0, sizeof(_temperature));
+    memset(_weight, 0, sizeof(_weight));
+    _learned_bin_count = 0;
+    _min_temperature = INT8_MAX;
+    _max_temperature = INT8_MIN;
+    _cache_valid = false;
+    _cache_temperature = 0;
+    memset(_cache_bias, 0, sizeof(_cache_bias));
+}
+
+void TemperatureBiasModel::learn(int8_t temperature, const float bias[3])
+{
+    int k = get_bin_index(temperature);
+    if (_weight[k] == 0) {
+        _learned_bin_count++;
+    }
+    // running average, that becomes exponential after AVERAGING_WINDOWS observations
+    if (_weight[k] < AVERAGING_WINDOWS) {
+        _weight[k]++;
+    }
+    float gain = 1.0f / _weight[k];
+    for (int i = 0; i < 3; i++) {
+        _bias[k][i] += gain * (bias[i] - _bias[k][i]);
+    }
+    _temperature[k] += gain * (temperature - _temperature[k]);
+
+    if (temperature < _min_temperature) {
+        _min_temperature = temperature;
+    }
+    if (temperature > _max_temperature) {
+        _max_temperature = temperature;
+    }
+    _cache_valid = false;
+}
+
+bool TemperatureBiasModel::get_bias(int8_t temperature, float bias[3])
+{
+    if (_learned_bin_count == 0) {
+        return false;
+    }
+    if (!_cache_valid || temperature != _cache_temperature) {
+        _interpolate(temperature, _cache_bias);
+        _cache_temperature = temperature;
+        _cache_valid = true;
+    }
+    for (int i = 0; i < 3; i++) {
+        bias[i] = _cache_bias[i];
+    }
+    return true;
+}
+
+int TemperatureBiasModel::get_learned_bin_count()
+{
+    return _learned_bin_count;
+}
+
+bool TemperatureBiasModel::get_temperature_range(int8_t *min_temperature, int8_t *max_temperature)
+{
+    if (_learned_bin_count == 0) {
+        return false;
+    }
+    *min_temperature = _min_temperature;
+    *max_temperature = _max_temperature;
+    return true;
+}
+
+void TemperatureBiasModel::_interpolate(int8_t temperature, float bias[3])
+{
+    // find the nearest learned points below and above the temperature
+    int k = get_bin_index(temperature);
+    int lower = -1;
+    int upper = -1;
+    for (int j = k; j >= 0; j--) {
+        if (_weight[j] && _temperature[j] <= temperature) {
+            lower = j;
+            break;
+        }
+    }
+    for (int j = k; j < BIN_COUNT; j++) {
+        if (_weight[j] && _temperature[j] > temperature) {
+            upper = j;
+            break;
+        }
+    }
+
+    if (lower < 0 || upper < 0) {
+        // outside of the learned range
+        int nearest = lower < 0 ? upper : lower;
+        for (int i = 0; i < 3; i++) {
+            bias[i] = _bias[nearest][i];
+        }
+        return;
+    }
+    float frac = (temperature - _temperature[lower]) / (_temperature[upper] - _temperature[lower]);
+    for (int i = 0; i < 3; i++) {
+        bias[i] = _bias[lower][i] + frac * (_bias[upper][i] - _bias[lower][i]);
+    }
+}
@@ -0,0 +1,187 @@
+#include "l3gd20_timestamper.h"
+
+using namespace l3gd20;
+
+// maximal relative deviation of the estimated sample period from the nominal one
+static const float MAX_PERIOD_DEVIATION = 0.2f;
+// maximal deviation of the edge time after FIFO overrun from a whole number of lost samples relative to the sample period
+static const float MAX_LOST_SAMPLES_RESIDUAL = 0.25f;
+
+SampleTimestamper::SampleTimestamper(float nominal_odr_hz, int filter_length)
+    : _filter_length(filter_length < 2 ? 2 : filter_length)
+{
+    reset(nominal_odr_hz);
+}
+
+void SampleTimestamper::reset(float nominal_odr_hz)
+{
+    if (nominal_odr_hz <= 0.0f) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid output data rate");
+    }
+    _nominal_period_us = 1e6f / nominal_odr_hz;
+    _period_us = _nominal_period_us;
+    _anchor_time_us = 0;
+    _anchor_frac_us = 0.0f;
+    _anchor_index = 0;
+    _edge_index = 0;
+    _sample_index = 0;
+    _edge_count = 0;
+    _resume_edge_count = 0;
+    _resync_count = 0;
+    _lost_sample_count = 0;
+    _overrun_pending = false;
+}
+
+void SampleTimestamper::switch_odr(float nominal_odr_hz)
+{
+    if (nominal_odr_hz <= 0.0f) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid output data rate");
+    }
+    float scale = _period_us / _nominal_period_us;
+    _nominal_period_us = 1e6f / nominal_odr_hz;
+    _set_period(_nominal_period_us * scale);
+    // the next edge restarts the line with the filter gains of the current observations number
+    _resume_edge_count = _edge_count > _resume_edge_count ? _edge_count : _resume_edge_count;
+    _edge_count = 0;
+    _overrun_pending = false;
+}
+
+void SampleTimestamper::update(uint64_t edge_time_us, int edge_level, int n, uint64_t *timestamps, bool overrun)
+{
+    if (edge_level < 1) {
+        update(n, timestamps);
+        _overrun_pending |= overrun;
+        return;
+    }
+    uint32_t edge_index = _sample_index + edge_level - 1;
+
+    if (_edge_count == 0) {
+        _restart(edge_time_us, edge_index);
+        if (_resume_edge_count > 1) {
+            _edge_count = _resume_edge_count;
+        }
+        _resume_edge_count = 0;
+    } else {
+        float predicted_us = _anchor_frac_us + (int32_t)(edge_index - _anchor_index) * _period_us;
+        float residual_us = (float)(int64_t)(edge_time_us - _anchor_time_us) - predicted_us;
+
+        if (_overrun_pending && _edge_count >= 2 && residual_us > 0.5f * _period_us) {
+            // the oldest samples have been overwritten, so the edge is late by a whole number of samples
+            float lost = floorf(residual_us / _period_us + 0.5f);
+            if (fabsf(residual_us - lost * _period_us) <= MAX_LOST_SAMPLES_RESIDUAL * _period_us) {
+                uint32_t n_lost = (uint32_t)lost;
+                _lost_sample_count += n_lost;
+                _sample_index += n_lost;
+                edge_index += n_lost;
+                predicted_us += lost * _period_us;
+                residual_us -= lost * _period_us;
+            }
+        }
+        int32_t dk = (int32_t)(edge_index - _edge_index);
+
+        if (dk <= 0 || (_edge_count >= 2 && fabsf(residual_us) > 0.5f * _period_us)) {
+            // samples are lost or edge is missed, so the sample counter doesn't match the edge
+            _restart(edge_time_us, edge_index);
+            _resync_count++;
+        } else {
+            // alpha-beta filter with gains of the least squares line fit for k observations
+            _edge_count++;
+            float k = (float)(_edge_count < _filter_length ? _edge_count : _filter_length);
+            float alpha = 2.0f * (2.0f * k - 1.0f) / (k * (k + 1.0f));
+            float beta = 6.0f / (k * (k + 1.0f));
+
+            _set_period(_period_us + beta * residual_us / dk);
+            _set_anchor(_anchor_time_us, predicted_us + alpha * residual_us, edge_index);
+            _edge_index = edge_index;
+        }
+    }
+
+    update(n, timestamps);
+    _overrun_pending = overrun;
+}
+
+void SampleTimestamper::update(int n, uint64_t *timestamps)
+{
+    if (n <= 0) {
+        return;
+    }
+    if (_edge_count == 0) {
+        // there is no time reference yet
+        if (timestamps) {
+            memset(timestamps, 0, n * sizeof(uint64_t));
+        }
+        _sample_index += n;
+        return;
+    }
+
+    float offset_us = 0.0f;
+    for (int i = 0; i < n; i++) {
+        offset_us = _anchor_frac_us + (int32_t)(_sample_index + i - _anchor_index) * _period_us;
+        if (timestamps) {
+            timestamps[i] = _anchor_time_us + (int64_t)floorf(offset_us + 0.5f);
+        }
+    }
+    _sample_index += n;
+    // move anchor along the line to the last sample, so offsets remain small
+    _set_anchor(_anchor_time_us, offset_us, _sample_index - 1);
+}
+
+void SampleTimestamper::set_odr_hz(float odr_hz)
+{
+    if (odr_hz <= 0.0f) {
+        MBED_ERROR(MBED_ERROR_INVALID_ARGUMENT, "Invalid output data rate");
+    }
+    _set_period(1e6f / odr_hz);
+}
+
+float SampleTimestamper::get_odr_hz()
+{
+    return 1e6f / _period_us;
+}
+
+float SampleTimestamper::get_sample_period_us()
+{
+    return _period_us;
+}
+
+uint32_t SampleTimestamper::get_sample_count()
+{
+    return _sample_index - _lost_sample_count;
+}
+
+int SampleTimestamper::get_resync_count()
+{
+    return _resync_count;
+}
+
+uint32_t SampleTimestamper::get_lost_sample_count()
+{
+    return _lost_sample_count;
+}
+
+void SampleTimestamper::_set_period(float period_us)
+{
+    float min_period_us = _nominal_period_us * (1.0f - MAX_PERIOD_DEVIATION);
+    float max_period_us = _nominal_period_us * (1.0f + MAX_PERIOD_DEVIATION);
+    if (period_us < min_period_us) {
+        period_us = min_period_us;
+    } else if (period_us > max_period_us) {
+        period_us = max_period_us;
+    }
+    _period_us = period_us;
+}
+
+void SampleTimestamper::_set_anchor(uint64_t time_us, float offset_us, uint32_t index)
+{
+    float whole_us = floorf(offset_us);
+    _anchor_time_us = time_us + (int64_t)whole_us;
+    _anchor_frac_us = offset_us - whole_us;
+    _anchor_index = index;
+}
+
+void SampleTimestamper::_restart(uint64_t edge_time_us, uint32_t edge_index)
+{
+    _set_anchor(edge_time_us, 0.0f, edge_index);
+    _edge_index = edge_index;
+    _edge_count = 1;
+}
@@ -1,154 +1,229 @@
 #include "l3gd20_utils.h"
 using namespace l3gd20;
 
-RegisterDevice::RegisterDevice(mbed::I2C* i2c_ptr)
+template <typename Bus>
+uint8_t RegisterDeviceT<Bus>::read_register(uint8_t reg)
 {
-    _interface.i2c_ptr = i2c_ptr;
-    _state = I2C_DEVICE;
+    uint32_t cache_entry = _get_cache_entry(reg);
+
+    if (cache_entry & _cache_valid_mask) {
+        // use cached value
+        L3GD20_STATS_ADD(_stats, cache_hits, 1);
+        return _cache[reg - _CACHE_START_ADDR];
+    }
+
+    uint8_t val = read_volatile_register(reg);
+
+    if (cache_entry) {
+        _cache[reg - _CACHE_START_ADDR] = val;
+        _cache_valid_mask |= cache_entry;
+    }
+
+    return val;
 }
 
-RegisterDevice::RegisterDevice(PinName sda, PinName scl)
+template <typename Bus>
+void RegisterDeviceT<Bus>::write_register(uint8_t reg, uint8_t val)
 {
-    _interface.i2c_ptr = new I2C(sda, scl);
-    _state = I2C_DEVICE | CLEANUP_I2C_PTR;
+    L3GD20_STATS_ADD(_stats, register_writes, 1);
+    L3GD20_STATS_ADD(_stats, bytes_written, 1);
+    _bus.write_register(reg, val);
+
+    uint32_t cache_entry = _get_cache_entry(reg);
+    if (cache_entry) {
+        if (reg == _CTRL_REG5_ADDR && (val & _CTRL_REG5_BOOT)) {
+            // reboot memory content, so cache should be reloaded
+            _cache_valid_mask = 0;
+        } else {
+            _cache[reg - _CACHE_START_ADDR] = val;
+            _cache_valid_mask |= cache_entry;
+        }
+    }
 }
 
-RegisterDevice::RegisterDevice(mbed::SPI* spi_ptr, PinName ssel)
+template <typename Bus>
+void RegisterDeviceT<Bus>::update_register(uint8_t reg, uint8_t val, uint8_t mask)
 {
-    _interface.spi_ptr = spi_ptr;
-    spi_ptr->format(8, 3); // set data format
-    _state = SPI_DEVICE;
-    if (ssel == NC) {
-        _spi_ssel_ptr = NULL;
-    } else {
-        _spi_ssel_ptr = new DigitalOut(ssel, 1);
-        _state |= CLEANUP_SPI_SSEL;
-    }
+    uint8_t reg_val = read_register(reg);
+    reg_val &= ~mask;
+    val = val & mask;
+    reg_val |= val;
+    write_register(reg, reg_val);
 }
 
-RegisterDevice::RegisterDevice(PinName mosi, PinName miso, PinName sclk, PinName ssel)
+template <typename Bus>
+uint8_t RegisterDeviceT<Bus>::read_register(uint8_t reg, uint8_t mask)
 {
-    _interface.spi_ptr = new SPI(mosi, miso, sclk);
-    _interface.spi_ptr->frequency(10000000);
-    _interface.spi_ptr->format(8, 3);
-    _state = SPI_DEVICE | CLEANUP_SPI_PTR;
-    if (ssel == NC) {
-        _spi_ssel_ptr = NULL;
-    } else {
-        _spi_ssel_ptr = new DigitalOut(ssel, 1);
-        _state |= CLEANUP_SPI_SSEL;
-    }
+    return read_register(reg) & mask;
 }
 
-RegisterDevice::~RegisterDevice()
+template <typename Bus>
+void RegisterDeviceT<Bus>::read_registers(uint8_t reg, uint8_t* data, uint8_t length)
 {
-    if (_state & CLEANUP_I2C_PTR) {
-        delete _interface.i2c_ptr;
-    }
-    if (_state & CLEANUP_SPI_PTR) {
-        delete _interface.spi_ptr;
+    uint32_t cache_entries = _get_cache_entries(reg, length);
+
+    if (cache_entries && (cache_entries & _cache_valid_mask) == cache_entries) {
+        // use cached values
+        L3GD20_STATS_ADD(_stats, cache_hits, 1);
+        memcpy(data, _cache + (reg - _CACHE_START_ADDR), length);
+        return;
     }
-    if (_state & CLEANUP_SPI_SSEL) {
-        delete _spi_ssel_ptr;
+
+    read_volatile_registers(reg, data, length);
+
+    if (cache_entries) {
+        memcpy(_cache + (reg - _CACHE_START_ADDR), data, length);
+        _cache_valid_mask |= cache_entries;
     }
 }
 
-uint8_t RegisterDevice::read_register(uint8_t reg)
+template <typename Bus>
+void RegisterDeviceT<Bus>::write_registers(uint8_t reg, const uint8_t* data, uint8_t length)
 {
-    uint8_t val;
+    L3GD20_STATS_ADD(_stats, burst_writes, 1);
+    L3GD20_STATS_ADD(_stats, bytes_written, length);
+    _bus.write_registers(reg, data, length);
 
-    if (_state & SPI_DEVICE) {
-        // SPI is used
-        reg = reg | 0x80; // read mode
-        if (_spi_ssel_ptr != NULL) {
-            _spi_ssel_ptr->write(0);
-        }
-        _interface.spi_ptr->write(reg); // send register address
-        val = _interface.spi_ptr->write(0x00); // read register value
-        if (_spi_ssel_ptr != NULL) {
-            _spi_ssel_ptr->write(1);
+    uint32_t cache_entries = _get_cache_entries(reg, length);
+    if (cache_entries) {
+        uint8_t ctrl_reg5_offset = _CTRL_REG5_ADDR - reg;
+        if (ctrl_reg5_offset < length && (data[ctrl_reg5_offset] & _CTRL_REG5_BOOT)) {
+            // reboot memory content, so cache should be reloaded
+            _cache_valid_mask = 0;
+        } else {
+            memcpy(_cache + (reg - _CACHE_START_ADDR), data, length);
+            _cache_valid_mask |= cache_entries;
         }
+    }
+}
+
+template <typename Bus>
+int RegisterDeviceT<Bus>::read_registers_async(uint8_t reg, uint8_t* data, uint8_t length, const Callback<void(int)>& callback)
+{
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    // count transfer errors on completion
+    _async_callback = callback;
+    int err = _bus.read_registers_async(reg, data, length, mbed::callback(this, &RegisterDeviceT::_on_async_complete));
+    if (err) {
+        _stats.bus_errors++;
     } else {
-        // the I2C is used
-        int res;
-        res = _interface.i2c_ptr->write(_I2C_ADDRESS, (char*)&reg, 1, true); // send register address
-        if (res) {
-            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "register reading failed");
-        }
-        res = _interface.i2c_ptr->read(_I2C_ADDRESS, (char*)&val, 1); // read register value
-        if (res) {
-            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_READ_FAILED), "register reading failed");
-        }
+        _stats.async_reads++;
+        _stats.bytes_read += length;
     }
+    return err;
+#else
+    return _bus.read_registers_async(reg, data, length, callback);
+#endif
+}
 
-    return val;
+template <typename Bus>
+void RegisterDeviceT<Bus>::abort_async()
+{
+    _bus.abort_async();
 }
 
-void RegisterDevice::write_register(uint8_t reg, uint8_t val)
+template <typename Bus>
+RegisterDeviceStats RegisterDeviceT<Bus>::get_stats()
 {
-    if (_state & SPI_DEVICE) {
-        // the SPI is used
-        reg = reg & 0x7F; // write mode
-        if (_spi_ssel_ptr != NULL) {
-            _spi_ssel_ptr->write(0);
-        }
-        _interface.spi_ptr->write(reg); // send register address
-        _interface.spi_ptr->write(val); // send value
-        if (_spi_ssel_ptr != NULL) {
-            _spi_ssel_ptr->write(1);
-        }
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    return _stats;
+#else
+    RegisterDeviceStats stats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+#endif
+}
 
-    } else {
-        // the I2C is used
-        uint8_t data[2] = { reg, val };
-        // write register address and value
-        int res = _interface.i2c_ptr->write(_I2C_ADDRESS, (char*)data, 2);
-        if (res) {
-            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "register writing failed");
-        }
+template <typename Bus>
+void RegisterDeviceT<Bus>::reset_stats()
+{
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+    memset(&_stats, 0, sizeof(_stats));
+#endif
+}
+
+#if MBED_CONF_L3GD20_DRIVER_STATS_ENABLED
+template <typename Bus>
+void RegisterDeviceT<Bus>::_on_async_complete(int err)
+{
+    if (err) {
+        _stats.bus_errors++;
     }
+    _async_callback.call(err);
 }
+#endif
 
-void RegisterDevice::update_register(uint8_t reg, uint8_t val, uint8_t mask)
+template <typename Bus>
+void RegisterDeviceT<Bus>::set_cache_mode(bool enable)
 {
-    uint8_t reg_val = read_register(reg);
-    reg_val &= ~mask;
-    val = val & mask;
-    reg_val |= val;
-    write_register(reg, reg_val);
+    _cache_enabled = enable;
+    _cache_valid_mask = 0;
 }
 
-uint8_t RegisterDevice::read_register(uint8_t reg, uint8_t mask)
+template <typename Bus>
+bool RegisterDeviceT<Bus>::get_cache_mode()
 {
-    return read_register(reg) & mask;
+    return _cache_enabled;
 }
 
-void RegisterDevice::read_registers(uint8_t reg, uint8_t* data, uint8_t length)
+template <typename Bus>
+void RegisterDeviceT<Bus>::resync()
 {
+    _cache_valid_mask = 0;
+    if (!_cache_enabled) {
+        return;
+    }
 
-    if (_state & SPI_DEVICE) {
-        // the SPI is used
-        reg |= 0x60; // read multiple bytes
-        reg |= 0x80; // read mode
-        if (_spi_ssel_ptr != NULL) {
-            _spi_ssel_ptr->write(0);
+    // reload each continuous block of the cacheable registers with a single transaction
+    // (the read values are put into cache automatically)
+    uint8_t buf[_CACHE_SIZE];
+    int start = 0;
+    while (start < _CACHE_SIZE) {
+        if (!(_CACHEABLE_MASK & (1UL << start))) {
+            start++;
+            continue;
         }
-        _interface.spi_ptr->write(reg); // send register address
-        _interface.spi_ptr->write(NULL, 0, (char*)data, length); // read data
-        if (_spi_ssel_ptr != NULL) {
-            _spi_ssel_ptr->write(1);
-        }
-    } else {
-        // the I2C is used
-        reg |= 0x80; // read multiple bytes
-        int res;
-        res = _interface.i2c_ptr->write(_I2C_ADDRESS, (char*)&reg, 1, true); // send register address
-        if (res) {
-            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_WRITE_FAILED), "registers reading failed");
+        int end = start + 1;
+        while (end < _CACHE_SIZE && (_CACHEABLE_MASK & (1UL << end))) {
+            end++;
         }
-        res = _interface.i2c_ptr->read(_I2C_ADDRESS, (char*)data, length); // read data
-        if (res) {
-            MBED_ERROR(MBED_MAKE_ERROR(MBED_MODULE_DRIVER_I2C, MBED_ERROR_CODE_READ_FAILED), "registers reading failed");
+        if (end - start == 1) {
+            read_register(_CACHE_START_ADDR + start);
+        } else {
+            read_registers(_CACHE_START_ADDR + start, buf, end - start);
         }
+        start = end;
+    }
+}
+
+template <typename Bus>
+uint32_t RegisterDeviceT<Bus>::_get_cache_entry(uint8_t reg)
+{
+    if (!_cache_enabled || reg < _CACHE_START_ADDR || reg >= _CACHE_START_ADDR + _CACHE_SIZE) {
+        return 0;
     }
+    return _CACHEABLE_MASK & (1UL << (reg - _CACHE_START_ADDR));
 }
+
+template <typename Bus>
+uint32_t RegisterDeviceT<Bus>::_get_cache_entries(uint8_t reg, uint8_t length)
+{
+    if (!_cache_enabled || length == 0 || reg < _CACHE_START_ADDR || reg + length > _CACHE_START_ADDR + _CACHE_SIZE) {
+        return 0;
+    }
+    if (reg <= _OUT_Z_H_ADDR && reg + length > _OUT_Z_H_ADDR) {
+        // address can roll back to the OUT_X_L, if FIFO is enabled
+        return 0;
+    }
+    uint32_t mask = ((1UL << length) - 1) << (reg - _CACHE_START_ADDR);
+    if ((mask & _CACHEABLE_MASK) != mask) {
+        // range contains registers that cannot be cached
+        return 0;
+    }
+    return mask;
+}
+
+// supported bus policies
+template class l3gd20::RegisterDeviceT<DynamicBus>;
+template class l3gd20::RegisterDeviceT<SpiBus>;
+template class l3gd20::RegisterDeviceT<I2cBus>;